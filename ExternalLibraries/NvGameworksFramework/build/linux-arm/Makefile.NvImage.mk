@@ -1,11 +1,17 @@
 # Makefile generated by XPJ for linux-arm
 -include Makefile.custom
 ProjectName = NvImage
+NvImage_cppfiles   += ./../../src/NvImage/BPTCDecode.cpp
 NvImage_cppfiles   += ./../../src/NvImage/BlockDXT.cpp
 NvImage_cppfiles   += ./../../src/NvImage/ColorBlock.cpp
+NvImage_cppfiles   += ./../../src/NvImage/DXTCompress.cpp
+NvImage_cppfiles   += ./../../src/NvImage/DXTExpand.cpp
+NvImage_cppfiles   += ./../../src/NvImage/HalfFloat.cpp
+NvImage_cppfiles   += ./../../src/NvImage/MipGenerate.cpp
 NvImage_cppfiles   += ./../../src/NvImage/NvFilePtr.cpp
 NvImage_cppfiles   += ./../../src/NvImage/NvImage.cpp
 NvImage_cppfiles   += ./../../src/NvImage/NvImageDDS.cpp
+NvImage_cppfiles   += ./../../src/NvImage/SurfaceTransform.cpp
 
 NvImage_cpp_debug_dep    = $(addprefix $(DEPSDIR)/NvImage/debug/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.P, $(NvImage_cppfiles)))))
 NvImage_cc_debug_dep    = $(addprefix $(DEPSDIR)/, $(subst ./, , $(subst ../, , $(patsubst %.cc, %.cc.debug.P, $(NvImage_ccfiles)))))
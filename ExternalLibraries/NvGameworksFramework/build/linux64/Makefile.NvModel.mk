@@ -8,7 +8,9 @@ NvModel_cppfiles   += ./../../src/NvModel/NvModelExtBuilder.cpp
 NvModel_cppfiles   += ./../../src/NvModel/NvModelExtObj.cpp
 NvModel_cppfiles   += ./../../src/NvModel/NvModelMeshFace.cpp
 NvModel_cppfiles   += ./../../src/NvModel/NvModelObj.cpp
+NvModel_cppfiles   += ./../../src/NvModel/NvModelOptimizer.cpp
 NvModel_cppfiles   += ./../../src/NvModel/NvModelSubMeshObj.cpp
+NvModel_cppfiles   += ./../../src/NvModel/NvModelVertexFormat.cpp
 NvModel_cppfiles   += ./../../src/NvModel/NvSkeleton.cpp
 
 NvModel_cpp_debug_dep    = $(addprefix $(DEPSDIR)/NvModel/debug/, $(subst ./, , $(subst ../, , $(patsubst %.cpp, %.cpp.P, $(NvModel_cppfiles)))))
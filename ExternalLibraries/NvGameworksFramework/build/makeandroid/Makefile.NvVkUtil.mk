@@ -9,6 +9,7 @@ NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvAppNativeContextVK.cpp
 NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvAppWrapperContextVK.cpp
 NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvBitFontVK.cpp
 NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvGLFWContextVK.cpp
+NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvGPUProfilerVK.cpp
 NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvMaterialVK.cpp
 NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvMeshExtVK.cpp
 NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvModelExtVK.cpp
@@ -22,7 +23,11 @@ NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvUIShadersVK.cpp
 NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvUITextureRenderVK.cpp
 NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvUIVK.cpp
 NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvVkContext.cpp
+NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvVkMemoryAllocator.cpp
+NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvVkParallelRecorder.cpp
 NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvVkRenderTargetImpls.cpp
+NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvVkTextureManager.cpp
+NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvVkTextureStreamer.cpp
 NvVkUtil_cppfiles   += ./../../src/NvVkUtil/NvVkUtil.cpp
 NvVkUtil_GLSLC_hex_src_NvVkUtil_src_shaders_font_glslc   += ./../../src/NvVkUtil/src_shaders/font.glslc
 NvVkUtil_GLSLC_hex_src_NvVkUtil_src_shaders_fontOutline_glslc   += ./../../src/NvVkUtil/src_shaders/fontOutline.glslc
@@ -0,0 +1,114 @@
+//----------------------------------------------------------------------------------
+// File:        NV/NvHalfFloat.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef NV_HALFFLOAT_H
+#define NV_HALFFLOAT_H
+
+#include <NvSimpleTypes.h>
+#include <string.h>
+
+/// \file
+/// Conversions between 32-bit floats and IEEE half floats
+
+namespace nv
+{
+    /// Converts an IEEE half to float; denormals, infinities and NaNs are kept
+    inline float halfToFloat(uint16_t h)
+    {
+        uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+        uint32_t exponent = (h >> 10) & 0x1F;
+        uint32_t mantissa = h & 0x3FF;
+        uint32_t bits;
+
+        if (exponent == 0x1F) {
+            bits = sign | 0x7F800000 | (mantissa << 13);
+        } else if (exponent != 0) {
+            bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        } else if (mantissa != 0) {
+            // denormal: normalize into the float's wider exponent range
+            exponent = 113;
+            while (!(mantissa & 0x400)) {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+        } else {
+            bits = sign;
+        }
+
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+    /// Converts a float to an IEEE half with round-to-nearest-even.  Values
+    /// too large for a half become infinity; NaNs stay NaNs
+    inline uint16_t floatToHalf(float f)
+    {
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+
+        uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+        uint32_t abs = bits & 0x7FFFFFFF;
+
+        if (abs >= 0x7F800000)
+            return sign | 0x7C00 | ((abs > 0x7F800000) ? 0x200 : 0);
+        if (abs >= 0x477FF000)
+            return sign | 0x7C00;
+
+        if (abs < 0x38800000) {
+            // denormal or zero: shift the mantissa, with its implicit bit,
+            // down to the half's fixed exponent
+            if (abs < 0x33000000)
+                return sign;
+            uint32_t shift = 126 - (abs >> 23);
+            uint32_t mantissa = (abs & 0x7FFFFF) | 0x800000;
+            uint32_t half = mantissa >> shift;
+            uint32_t rest = mantissa & ((1u << shift) - 1);
+            uint32_t midpoint = 1u << (shift - 1);
+            if (rest > midpoint || (rest == midpoint && (half & 1)))
+                half++;
+            return sign | (uint16_t)half;
+        }
+
+        // normal: rebias the exponent and round the dropped 13 bits
+        uint32_t half = (abs - 0x38000000) >> 13;
+        uint32_t rest = abs & 0x1FFF;
+        if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+            half++;
+        return sign | (uint16_t)half;
+    }
+
+} // nv namespace
+
+#endif // NV_HALFFLOAT_H
@@ -0,0 +1,86 @@
+//----------------------------------------------------------------------------------
+// File:        NV/NvParallel.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_PARALLEL_H
+#define NV_PARALLEL_H
+
+#include <NvSimpleTypes.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace nv
+{
+    /// Number of threads to use when the caller asks for the default (0)
+    inline uint32_t defaultThreadCount()
+    {
+        uint32_t count = std::thread::hardware_concurrency();
+        return count ? count : 1;
+    }
+
+    /// Runs job(i) for every i in [0, count), handing indices out to up to
+    /// threadCount threads, the calling thread included.  Returns once every
+    /// job has completed.  Jobs must not depend on each other
+    template <class Job>
+    void parallelFor(uint32_t count, uint32_t threadCount, const Job& job)
+    {
+        if (threadCount > count)
+            threadCount = count;
+
+        if (threadCount <= 1) {
+            for (uint32_t i = 0; i < count; i++)
+                job(i);
+            return;
+        }
+
+        std::atomic<uint32_t> next(0);
+        auto worker = [&]() {
+            for (uint32_t i = next++; i < count; i = next++)
+                job(i);
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount - 1);
+        for (uint32_t t = 1; t < threadCount; t++)
+            threads.push_back(std::thread(worker));
+
+        worker();
+
+        for (size_t t = 0; t < threads.size(); t++)
+            threads[t].join();
+    }
+
+} // nv namespace
+
+#endif // NV_PARALLEL_H
@@ -49,6 +49,14 @@
 #define NV_MAX_TOKEN_LEN  1024
 #define NV_MAX_DELIM_COUNT  16
 
+// Character classes in the tokenizer's lookup table
+#define NV_TOKCHAR_WHITESPACE   0x01
+#define NV_TOKCHAR_EOL          0x02
+#define NV_TOKCHAR_DELIM        0x04
+#define NV_TOKCHAR_QUOTE        0x08
+#define NV_TOKCHAR_EOF          0x10
+#define NV_TOKCHAR_TOKEN_END    (NV_TOKCHAR_WHITESPACE | NV_TOKCHAR_EOL | NV_TOKCHAR_DELIM | NV_TOKCHAR_EOF)
+
 #ifdef DEBUG
 #define VERBOSE_TOKLOG(s)         if (mVerbose) LOGI(s)
 #define VERBOSE_TOKLOG_VAL(s,v)     if (mVerbose) LOGI(s,v)
@@ -62,23 +70,29 @@ class NvTokenizer
 protected:
     const char* mSrcBuf; /*< This holds a pointer to an immutable char buffer. */
     char mTokBuf[NV_MAX_TOKEN_LEN]; /*< This is a temporary buffer for collecting next token. */
+    const char* mTokStart; /*< This points at the current token's first character in the source buffer. */
     uint32_t mTokLen; /*< This is the character length of current token, not including null termination. */
     char mTermChar; /*< This is the character that caused us to stop parsing the current token. */
     char mDelims[NV_MAX_DELIM_COUNT];
     uint32_t mNumDelims;
+    uint8_t mCharClass[256]; /*< This holds the NV_TOKCHAR_ classes of every character. */
 private:
     bool mVerbose;
     bool mConsumeWS;
+    bool mTokCopied; /*< This is set once the current token has been copied to mTokBuf. */
 
 public:
     NvTokenizer(const char* src, const char* delims=NULL)
     : mSrcBuf(src)
+    , mTokStart(src)
     , mTokLen(0)
     , mTermChar(0)
     , mNumDelims(0)
     , mVerbose(false)
     , mConsumeWS(true)
+    , mTokCopied(true)
     {
+        mTokBuf[0] = 0;
         if (NULL==delims)
         { // built in delim set.
             mNumDelims = 3;
@@ -102,6 +116,17 @@ public:
                 mDelims[mNumDelims++] = c;
             }
         }
+
+        memset(mCharClass, 0, sizeof(mCharClass));
+        mCharClass[uint8_t(' ')] = NV_TOKCHAR_WHITESPACE;
+        mCharClass[uint8_t('\t')] = NV_TOKCHAR_WHITESPACE;
+        mCharClass[uint8_t('\n')] = NV_TOKCHAR_EOL;
+        mCharClass[uint8_t('\r')] = NV_TOKCHAR_EOL;
+        mCharClass[uint8_t('"')] = NV_TOKCHAR_QUOTE;
+        mCharClass[uint8_t('\'')] = NV_TOKCHAR_QUOTE;
+        mCharClass[0] = NV_TOKCHAR_EOF;
+        for (uint32_t i = 0; i < mNumDelims; i++)
+            mCharClass[uint8_t(mDelims[i])] |= NV_TOKCHAR_DELIM;
     }
 
     void setVerbose() { mVerbose = true; }
@@ -128,10 +153,8 @@ public:
     }
 
     inline bool isDelim(const char c)
-    { // TBD any other delims we want to call out.
-        for (uint32_t i=0; i<mNumDelims; i++)
-            if (c==mDelims[i]) return true;
-        return false;
+    {
+        return (mCharClass[uint8_t(c)] & NV_TOKCHAR_DELIM) != 0;
     }
 
 
@@ -145,7 +168,7 @@ public:
     {
         //VERBOSE_TOKEN_DEBUG("consuming whitespace");
         mTermChar = 0;
-        while (!atEOF() && isWhitespace(*mSrcBuf))
+        while (mCharClass[uint8_t(*mSrcBuf)] & NV_TOKCHAR_WHITESPACE)
             mTermChar = *mSrcBuf++;
         return mTermChar;
     }
@@ -168,9 +191,9 @@ public:
     void consumeToEOL()
     {
         VERBOSE_TOKLOG(".. EOL");
-        while (!atEOF() && !isEOL(*mSrcBuf)) // eat up to the EOL
+        while (!(mCharClass[uint8_t(*mSrcBuf)] & (NV_TOKCHAR_EOL | NV_TOKCHAR_EOF))) // eat up to the EOL
             mSrcBuf++;
-        while (!atEOF() && isEOL(*mSrcBuf)) // if not null, then eat EOL chars until gone, in case of /r/n type stuff...
+        while (mCharClass[uint8_t(*mSrcBuf)] & NV_TOKCHAR_EOL) // if not null, then eat EOL chars until gone, in case of /r/n type stuff...
             mSrcBuf++;
     }
 
@@ -179,8 +202,9 @@ public:
         VERBOSE_TOKLOG(".. readtok");
         char startedWithQuote = 0; // we'll store the character if we get a quote
         mTermChar = 0;
+        mTokStart = mSrcBuf;
         mTokLen = 0;
-        mTokBuf[0] = 0; // initialize
+        mTokCopied = false; // initialize
         if (atEOF())
             return false; // exit early...
 
@@ -190,35 +214,26 @@ public:
             startedWithQuote = *mSrcBuf; // save WHAT quote character so we match it.
             mSrcBuf++;
         }
-
-        while (!atEOF()) { // termchar is already null so fine to exit loop.
-            // look for hard terminations (EOL)
-            if (isEOL(*mSrcBuf)) {
-                mTermChar = *mSrcBuf;
-                break;
-            }
-            // look to handle quoted strings, which CAN have delimiters validly in their contents.
-            if (startedWithQuote) {
-                if (startedWithQuote==*mSrcBuf) {
-                    // consume and break.
-                    mSrcBuf++;
-                    mTermChar = startedWithQuote;
-                    break;
-                }
-            } else if (isDelim(*mSrcBuf) || isWhitespace(*mSrcBuf)) {
-                // just break, leave delim.
-                mTermChar = *mSrcBuf;
-                break;
-            }
-
-            mTokBuf[mTokLen] = *mSrcBuf; // copy char
-            mTokLen++; // inc length
-            mSrcBuf++; // inc buffer
+        mTokStart = mSrcBuf;
+
+        // Find the end of the token, leaving it where it is
+        if (startedWithQuote) {
+            while (!(mCharClass[uint8_t(*mSrcBuf)] & (NV_TOKCHAR_EOL | NV_TOKCHAR_EOF)) &&
+                   *mSrcBuf != startedWithQuote)
+                mSrcBuf++;
+        } else {
+            while (!(mCharClass[uint8_t(*mSrcBuf)] & NV_TOKCHAR_TOKEN_END))
+                mSrcBuf++;
         }
+        mTokLen = uint32_t(mSrcBuf - mTokStart);
+        if (mTokLen > NV_MAX_TOKEN_LEN - 1)
+            mTokLen = NV_MAX_TOKEN_LEN - 1; // only as much as the buffer can take.
 
-        // null-term buffer, do NOT inc length.
-        mTokBuf[mTokLen] = 0;
-        VERBOSE_TOKLOG_VAL("  > got: %s", (mTokLen==0)?(atEOF()?"{{EOF}}":"{{empty}}"):mTokBuf);
+        if (!atEOF())
+            mTermChar = *mSrcBuf; // the EOL, delimiter or whitespace is left in place...
+        if (startedWithQuote && *mSrcBuf == startedWithQuote)
+            mSrcBuf++; // ...but the closing quote is consumed.
+        VERBOSE_TOKLOG_VAL("  > got: %s", (mTokLen==0)?(atEOF()?"{{EOF}}":"{{empty}}"):getLastTokenPtr());
 
         return (mTokLen>0 || startedWithQuote); // false if empty string UNLESS quoted empty string...
     }
@@ -233,7 +248,7 @@ public:
         const size_t findlen = strlen(find);
         if (findlen != mTokLen)
             return false; // early out.
-        if (0!=memcmp(mTokBuf, find, findlen))
+        if (0!=memcmp(mTokStart, find, findlen))
             return false;
         // accepted.
         return true;
@@ -259,13 +274,20 @@ public:
     {
         // we just return what's already in the buffer.
         // handy for failure or unexpected cases.
-        returnTok.assign(mTokBuf);
+        returnTok.assign(mTokStart, mTokLen);
         return true;
     }
 
-    /// accessor to get last read token const char *
+    /// accessor to get last read token const char *.  The text is only copied
+    /// out of the source when asked for, so the pointer holds the last read
+    /// token as of this call, and not necessarily of later reads.
     const char* getLastTokenPtr()
     {
+        if (!mTokCopied) {
+            memcpy(mTokBuf, mTokStart, mTokLen);
+            mTokBuf[mTokLen] = 0;
+            mTokCopied = true;
+        }
         return mTokBuf;
     }
 
@@ -283,7 +305,7 @@ public:
             returnTok.clear();
             return false;
         }
-        returnTok.assign(mTokBuf);
+        returnTok.assign(mTokStart, mTokLen);
         return true;
     }
 
@@ -295,15 +317,18 @@ public:
             return false;
         }
 
-        // note mTokLen include the NULL terminator.
-        if (mTokLen>outmax)
+        // note mTokLen does not include the NULL terminator.
+        if (mTokLen>=outmax)
         {
             // just have to truncate.
-            memcpy(out, mTokBuf, outmax-1);
+            memcpy(out, mTokStart, outmax-1);
             out[outmax-1] = 0; // null terminate...
         }
         else
-            memcpy(out, mTokBuf, mTokLen+1); // copy null!
+        {
+            memcpy(out, mTokStart, mTokLen);
+            out[mTokLen] = 0;
+        }
         return true;
     }
 
@@ -314,7 +339,7 @@ public:
             out = 0;
             return false;
         }
-        out = (float)strtod(mTokBuf, NULL);
+        out = lastTokenAsFloat();
         return true;
     }
 
@@ -332,7 +357,7 @@ public:
             }
             if (!readToken())
                 break; // so we return what we've got.
-            out[i++] = (float)strtod(mTokBuf, NULL);
+            out[i++] = lastTokenAsFloat();
 
             // OPTIONALLY consume a delimiter between each number.
             delim = consumeOneDelim(); 
@@ -357,7 +382,7 @@ public:
             }
             if (!readToken())
                 break; // so we return what we've got.
-            out[i++] = (int32_t)strtol(mTokBuf, NULL, 0);
+            out[i++] = lastTokenAsInt();
 
             // OPTIONALLY consume a delimiter between each number.
             delim = consumeOneDelim(); 
@@ -375,7 +400,7 @@ public:
             out = 0;
             return false;
         }
-        out = (int32_t)strtol(mTokBuf, NULL, 0);
+        out = lastTokenAsInt();
         return true;
     }
 
@@ -386,7 +411,11 @@ public:
             out = 0;
             return false;
         }
-        out = (uint32_t)strtoul(mTokBuf, NULL, 0);
+        int32_t value;
+        if (mTokStart[0] != '-' && parseDecimalInt(mTokStart, mTokLen, value))
+            out = uint32_t(value);
+        else
+            out = (uint32_t)strtoul(getLastTokenPtr(), NULL, 0);
         return true;
     }
 
@@ -397,26 +426,155 @@ public:
             out = false;
             return false;
         }
+        const char* tokBuf = getLastTokenPtr();
         if (mTokLen==1 &&
-            (mTokBuf[0]=='0' || mTokBuf[0]=='1') ) {
-            out = (mTokBuf[0]=='1');
+            (tokBuf[0]=='0' || tokBuf[0]=='1') ) {
+            out = (tokBuf[0]=='1');
             return true;
-        } else if ( (0==strcmp(mTokBuf, "true")) ||
-                    (0==strcmp(mTokBuf, "TRUE")) ||
-                    (0==strcmp(mTokBuf, "yes")) ||
-                    (0==strcmp(mTokBuf, "YES")) ) {
+        } else if ( (0==strcmp(tokBuf, "true")) ||
+                    (0==strcmp(tokBuf, "TRUE")) ||
+                    (0==strcmp(tokBuf, "yes")) ||
+                    (0==strcmp(tokBuf, "YES")) ) {
             out = true;
             return true;
-        } else if ( (0==strcmp(mTokBuf, "false")) ||
-                    (0==strcmp(mTokBuf, "FALSE")) ||
-                    (0==strcmp(mTokBuf, "no")) ||
-                    (0==strcmp(mTokBuf, "NO")) ) {
+        } else if ( (0==strcmp(tokBuf, "false")) ||
+                    (0==strcmp(tokBuf, "FALSE")) ||
+                    (0==strcmp(tokBuf, "no")) ||
+                    (0==strcmp(tokBuf, "NO")) ) {
             out = false;
             return true;
         }
         // ... otherwise, no boolean value detected.
         return false;
     }
+
+private:
+    /// Converts the last read token as strtod would, then to float
+    float lastTokenAsFloat()
+    {
+        float value;
+        if (parseDecimalFloat(mTokStart, mTokLen, value))
+            return value;
+        return (float)strtod(getLastTokenPtr(), NULL);
+    }
+
+    /// Converts the last read token as strtol would with base 0
+    int32_t lastTokenAsInt()
+    {
+        int32_t value;
+        if (parseDecimalInt(mTokStart, mTokLen, value))
+            return value;
+        return (int32_t)strtol(getLastTokenPtr(), NULL, 0);
+    }
+
+    /// Converts a whole token of the form [sign]digits[.digits][(e|E)[sign]digits]
+    /// to the double nearest to it, then to float, which is what casting strtod's
+    /// result gives.  It handles the tokens whose digits fit a double exactly and
+    /// whose power of ten is exact as well, so that one multiply or divide rounds
+    /// correctly; that covers what exporters write.
+    /// \param[in] s the token's first character
+    /// \param[in] len the token's length
+    /// \param[out] out the converted value
+    /// \return false if the token is of another form, or too precise, so that
+    /// strtod has to convert it
+    static bool parseDecimalFloat(const char* s, uint32_t len, float& out)
+    {
+        static const double sPowersOf10[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+        const int32_t maxPower = 22;
+
+        const char* end = s + len;
+        bool negative = false;
+        if (s < end && (*s == '-' || *s == '+'))
+            negative = (*s++ == '-');
+
+        // Gather up to 19 significant digits, which always fit 64 bits
+        uint64_t mantissa = 0;
+        int32_t digits = 0;
+        int32_t exponent = 0;
+        bool anyDigits = false;
+        for (; s < end && uint32_t(*s - '0') < 10; s++) {
+            anyDigits = true;
+            if (mantissa == 0 && *s == '0')
+                continue;
+            if (++digits > 19)
+                return false;
+            mantissa = mantissa * 10 + uint32_t(*s - '0');
+        }
+        if (s < end && *s == '.') {
+            for (s++; s < end && uint32_t(*s - '0') < 10; s++) {
+                anyDigits = true;
+                exponent--;
+                if (mantissa == 0 && *s == '0')
+                    continue;
+                if (++digits > 19)
+                    return false;
+                mantissa = mantissa * 10 + uint32_t(*s - '0');
+            }
+        }
+        if (!anyDigits)
+            return false;
+
+        if (s < end && (*s == 'e' || *s == 'E')) {
+            s++;
+            bool negativeExponent = false;
+            if (s < end && (*s == '-' || *s == '+'))
+                negativeExponent = (*s++ == '-');
+            if (s == end || uint32_t(*s - '0') >= 10)
+                return false;
+            int32_t written = 0;
+            for (; s < end && uint32_t(*s - '0') < 10; s++) {
+                if (written < 10000)
+                    written = written * 10 + (*s - '0');
+            }
+            exponent += negativeExponent ? -written : written;
+        }
+        if (s != end)
+            return false;
+
+        if (mantissa == 0) {
+            out = negative ? -0.0f : 0.0f;
+            return true;
+        }
+        if (mantissa > (uint64_t(1) << 53) || exponent < -maxPower || exponent > maxPower)
+            return false;
+
+        double value = double(mantissa);
+        if (exponent < 0)
+            value /= sPowersOf10[-exponent];
+        else
+            value *= sPowersOf10[exponent];
+        out = float(negative ? -value : value);
+        return true;
+    }
+
+    /// Converts a whole token of the form [sign]digits with no leading zeros and
+    /// at most 9 digits, which strtol converts as decimal without overflow
+    /// \param[in] s the token's first character
+    /// \param[in] len the token's length
+    /// \param[out] out the converted value
+    /// \return false if the token is of another form, so that strtol has to
+    /// convert it
+    static bool parseDecimalInt(const char* s, uint32_t len, int32_t& out)
+    {
+        const char* end = s + len;
+        bool negative = false;
+        if (s < end && (*s == '-' || *s == '+'))
+            negative = (*s++ == '-');
+        if (s == end || end - s > 9 || (*s == '0' && end - s > 1))
+            return false;
+
+        int32_t value = 0;
+        for (; s < end; s++) {
+            uint32_t digit = uint32_t(*s - '0');
+            if (digit >= 10)
+                return false;
+            value = value * 10 + int32_t(digit);
+        }
+        out = negative ? -value : value;
+        return true;
+    }
 };
 
 #endif
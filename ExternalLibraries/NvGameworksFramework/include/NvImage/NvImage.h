@@ -201,6 +201,10 @@
 #define    NVIMAGE_COMPRESSED_SIGNED_RED_RGTC1    0x8DBC
 #define    NVIMAGE_COMPRESSED_RG_RGTC2    0x8DBD
 #define    NVIMAGE_COMPRESSED_SIGNED_RG_RGTC2    0x8DBE
+#define    NVIMAGE_COMPRESSED_RGBA_BPTC_UNORM    0x8E8C
+#define    NVIMAGE_COMPRESSED_SRGB_ALPHA_BPTC_UNORM    0x8E8D
+#define    NVIMAGE_COMPRESSED_RGB_BPTC_SIGNED_FLOAT    0x8E8E
+#define    NVIMAGE_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT    0x8E8F
 #define    NVIMAGE_RED_SNORM    0x8F90
 #define    NVIMAGE_RG_SNORM    0x8F91
 #define    NVIMAGE_RGB_SNORM    0x8F92
@@ -245,6 +249,17 @@
 /// \file
 /// Image-handling support (loading, editing, GL textures)
 
+/// Resampling filters for NvImage::generateMipmaps
+struct NvImageMipFilter
+{
+    enum Enum
+    {
+        BOX,        ///< area average; the classic 2x2 average for even sizes
+        TRIANGLE,   ///< tent filter; smoother, slightly blurrier
+        LANCZOS     ///< three-lobe windowed sinc; sharpest, may ring
+    };
+};
+
 /// Image loading, representation and handling
 /// Support loading of images from DDS files and data, including
 /// cube maps, arrays mipmap levels, formats, etc.
@@ -416,6 +431,88 @@ public:
     /// \return true on success, false on failure
     bool loadImageFromFileData(const uint8_t* fileData, size_t size, const char* fileExt);
 
+    /// Loads an image as a view of file-formatted data.
+    /// Like #loadImageFromFileData, but the pixel data is not copied: the image's
+    /// data block and level pointers refer directly into \p fileData, which may be
+    /// a heap buffer or a privately mapped file.  Flips and component swaps are
+    /// applied to the data in place, so the memory must be writable, and it must
+    /// outlive the image.  DXT images that must be expanded on load are decoded
+    /// from the file data into a block owned by the image
+    /// \param[in] fileData the block of memory representing the entire image file
+    /// \param[in] size the size of the data block in bytes
+    /// \param[in] fileExt the file extension string; must be "dds"
+    /// \return true on success, false on failure
+    bool loadImageFromFileDataInPlace(uint8_t* fileData, size_t size, const char* fileExt);
+
+    /// Whether the image owns its data block.
+    /// \return false if the data block is a view into memory passed to
+    /// #loadImageFromFileDataInPlace, true otherwise
+    bool ownsDataBlock() const { return _ownsDataBlock; }
+
+    /// Saves an image to file-formatted data.
+    /// Writes the image as it would be read back by #loadImageFromFileData;
+    /// only DDS files are supported, for block-compressed, 8-bit RGBA/BGRA/BGR
+    /// and luminance images.  Texture arrays are not supported
+    /// \param[out] fileData the contents of the file
+    /// \param[in] fileExt the file extension string; must be "dds"
+    /// \return true on success, false if the format cannot be written
+    bool saveImageToFileData(std::vector<uint8_t>& fileData, const char* fileExt);
+
+    /// Compresses an uncompressed 8-bit image in place, every face and level
+    /// \param[in] format the compressed format: NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1,
+    /// NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5, NVIMAGE_COMPRESSED_RED_RGTC1 or
+    /// NVIMAGE_COMPRESSED_RG_RGTC2
+    /// \param[in] highQuality false for the fast bounding-box fit suitable for
+    /// load time, true for the slower principal-axis fit for offline use
+    /// \param[in] threads the maximum number of threads, counting the calling
+    /// thread; 0 uses one per hardware thread
+    /// \param[out] psnr if non-NULL, receives the peak signal-to-noise ratio
+    /// of the compressed image in dB over the channels the format stores
+    /// \return true on success, false if the image or format is not supported
+    bool compress(uint32_t format, bool highQuality = false, uint32_t threads = 0, float* psnr = NULL);
+
+    /// Converts a 32-bit float image to 16-bit half floats in place, every
+    /// face and level, halving its size.  Values round to the nearest half;
+    /// those beyond the half range become infinity
+    /// \return true on success, false if the image is not 32-bit float or is
+    /// a depth format
+    bool convertToHalfFloat();
+
+    /// Converts a half float image to 32-bit floats, every face and level,
+    /// doubling its size.  The conversion is exact
+    /// \return true on success, false if the image is not half float
+    bool convertToFloat();
+
+    /// Generates a full mip chain from level 0 of every face or array layer,
+    /// replacing any levels the image already has.  Faces and layers are
+    /// filtered independently.  Supports uncompressed images with 8-bit,
+    /// half or float components; volume textures are not supported
+    /// \param[in] filter the resampling filter
+    /// \param[in] sRGB true if the color components of an 8-bit image are sRGB
+    /// encoded and must be averaged as linear values.  Images with an sRGB
+    /// internal format are always treated this way
+    /// \param[in] threads the maximum number of threads, counting the calling
+    /// thread; 0 uses one per hardware thread
+    /// \return true on success, false if the image is not supported
+    bool generateMipmaps(NvImageMipFilter::Enum filter = NvImageMipFilter::BOX, bool sRGB = false,
+        uint32_t threads = 0);
+
+    /// Fills another image with this one reduced by dropping its largest mip
+    /// levels, halving the width and height once per level dropped.  Levels
+    /// the image has are copied as they are, so compressed images need no
+    /// decoding.  Uncompressed images without enough levels are filtered down
+    /// from level 0 with #generateMipmaps and keep their number of levels
+    /// \param[out] dst the image to fill; its previous contents are freed
+    /// \param[in] levels the number of levels to drop.  Uncompressed images
+    /// stop at 1x1
+    /// \param[in] filter the resampling filter for levels that must be generated
+    /// \param[in] threads the maximum number of threads to filter on, counting
+    /// the calling thread; 0 uses one per hardware thread
+    /// \return true on success, false if the image has too few levels and
+    /// cannot generate them
+    bool downscale(NvImage& dst, int32_t levels, NvImageMipFilter::Enum filter = NvImageMipFilter::BOX,
+        uint32_t threads = 0) const;
+
     /// Convert a flat "cross" image to  a cubemap
     /// Convert a suitable image from a cubemap cross to a cubemap
     /// \return true on success or false for unsuitable source images
@@ -432,7 +529,8 @@ public:
     /// \return true if BGR images will be swapped, false if they will be passed through
     static bool getSupportsBGR() { return m_supportsBGR; }
 
-    /// Enables or disables automatic expansion of DXT images to RGBA
+    /// Enables or disables automatic expansion of DXT images to RGBA.  BC7
+    /// images are expanded to RGBA8 and BC6H images to RGBA16F along with them
     /// \param[in] expand true enables DXT-to-RGBA expansion.  False passes 
     /// DXT images through as-is
     static void setDXTExpansion(bool expand) { m_expandDXT = expand; }
@@ -441,6 +539,39 @@ public:
     /// \return true if DXT images will be expanded, false if they will be passed through
     static bool getDXTExpansion() { return m_expandDXT; }
 
+    /// Sets the number of threads used to expand DXT images.  Levels and bands
+    /// of large levels are decoded in parallel; small images are always
+    /// decoded on the loading thread
+    /// \param[in] threads the maximum number of threads, counting the loading
+    /// thread.  0 (the default) uses one per hardware thread
+    static void setDXTExpansionThreads(uint32_t threads) { m_expandDXTThreads = threads; }
+
+    /// Gets the number of threads used to expand DXT images
+    /// \return the thread count, or 0 for one per hardware thread
+    static uint32_t getDXTExpansionThreads() { return m_expandDXTThreads; }
+
+    /// Enables or disables compression of uncompressed 8-bit DDS images as
+    /// they load.  Images with alpha are compressed to DXT5, others to DXT1
+    /// \param[in] compress true enables compression at load time
+    /// \param[in] highQuality true selects the slower, higher quality fit
+    static void setDXTCompression(bool compress, bool highQuality = false) {
+        m_compressDXT = compress;
+        m_compressDXTHighQuality = highQuality;
+    }
+
+    /// Gets the status of load-time DXT compression
+    /// \return true if uncompressed images will be compressed as they load
+    static bool getDXTCompression() { return m_compressDXT; }
+
+    /// Enables or disables conversion of 32-bit float DDS images to half
+    /// floats as they load, halving their memory; see #convertToHalfFloat
+    /// \param[in] convert true enables conversion at load time
+    static void setHalfFloatConversion(bool convert) { m_convertToHalf = convert; }
+
+    /// Gets the status of load-time half float conversion
+    /// \return true if 32-bit float images will be converted as they load
+    static bool getHalfFloatConversion() { return m_convertToHalf; }
+
 protected:
     /// \privatesection
 
@@ -464,11 +595,15 @@ protected:
 	uint8_t** _data;
 	int32_t _dataArrayCount;
 	int32_t _dataBlockSize;
+	// false when _dataBlock points into caller-owned file data
+	bool _ownsDataBlock;
+	// set while a reader may take its texels straight from the file data
+	bool _loadInPlace;
 
     void freeData();
-    void flipSurface(uint8_t *surf, int32_t width, int32_t height, int32_t depth);
-    uint32_t componentSwapSurface(uint8_t *surf, int32_t width, int32_t height, int32_t depth);
-	void expandDXT(uint8_t *surf, int32_t width, int32_t height, int32_t depth, int32_t srcSize);
+    void copyLevels(const NvImage& src, int32_t firstLevel, int32_t levelCount);
+    uint32_t transformSurface(const uint8_t *src, uint8_t *dst, int32_t width, int32_t height, int32_t depth,
+        bool flip, bool swapRB);
 
     //
     // Static elements used to dispatch to proper sub-readers
@@ -477,21 +612,20 @@ protected:
     struct FormatInfo {
         const char* extension;
         bool (*reader)(const uint8_t* fileData, size_t size, NvImage& i);
-        bool (*writer)(uint8_t* fileData, size_t size, NvImage& i);
+        bool (*writer)(std::vector<uint8_t>& fileData, NvImage& i);
     };
 
     static FormatInfo formatTable[]; 
     static bool vertFlip;
     static bool m_expandDXT;
+    static uint32_t m_expandDXTThreads;
+    static bool m_compressDXT;
+    static bool m_compressDXTHighQuality;
+    static bool m_convertToHalf;
     static bool m_supportsBGR;
 
     static bool readDDS(const uint8_t* fileData, size_t size, NvImage& i);
-
-    static void flip_blocks_dxtc1(uint8_t *ptr, uint32_t numBlocks);
-    static void flip_blocks_dxtc3(uint8_t *ptr, uint32_t numBlocks);
-    static void flip_blocks_dxtc5(uint8_t *ptr, uint32_t numBlocks);
-    static void flip_blocks_bc4(uint8_t *ptr, uint32_t numBlocks);
-    static void flip_blocks_bc5(uint8_t *ptr, uint32_t numBlocks);
+    static bool writeDDS(std::vector<uint8_t>& fileData, NvImage& i);
 
     friend bool TranslateDX10Format( const void *ptr, NvImage &i, int32_t &bytesPerElement, bool &btcCompressed);
 };
@@ -93,6 +93,36 @@ namespace Nv
 		/// \param[in] pLoader Pointer to the file loader to request file data from
 		static void SetFileLoader(NvModelFileLoader* pLoader) { ms_pLoader = pLoader; }
 
+		/// Returns the file loader object used when requesting external files
+		/// \return Pointer to the current file loader, or NULL if none is set
+		static NvModelFileLoader* GetFileLoader() { return ms_pLoader; }
+
+		/// Sets the number of threads that OBJ data is parsed on, counting the
+		/// calling thread.  Files too small to split among them use fewer.
+		/// \param[in] threads the maximum number of threads; 1 parses the data in
+		/// a single pass on the calling thread and 0, the default, uses one per
+		/// hardware thread
+		static void SetObjLoadThreads(uint32_t threads) { ms_objLoadThreads = threads; }
+
+		/// Returns the number of threads that OBJ data is parsed on
+		/// \return the maximum number of threads; 0 uses one per hardware thread
+		static uint32_t GetObjLoadThreads() { return ms_objLoadThreads; }
+
+		/// Sets whether WritePreprocessedModel packs vertices into compact
+		/// per-attribute formats; see NvPackedVertexFormat::InitCompact.  Packed
+		/// models load with these formats, which NvMeshExtVK keeps on the GPU
+		/// except for octahedral normals and tangents; see
+		/// NvMeshExtVK::SetOctahedralNormals.
+		/// Indices are written as 16 bits whenever a mesh has at most 65535
+		/// vertices either way.
+		/// \param[in] pack true to pack vertices; false, the default, writes them
+		/// as 32-bit floats
+		static void SetVertexPacking(bool pack) { ms_packVertices = pack; }
+
+		/// Returns whether WritePreprocessedModel packs vertices
+		/// \return true if vertices are packed
+		static bool GetVertexPacking() { return ms_packVertices; }
+
 		/// Get the point defined by the minimum values in each axis contained
 		/// within the axis-aligned bounding box of the model.
 		/// \return Vector containing the minimum X,Y and Z of the bounding box
@@ -149,6 +179,13 @@ namespace Nv
         ///         False if an error occurred during file creation or writing.
 		bool WritePreprocessedModel(const char* filename);
 
+        /// Serializes the model, as #WritePreprocessedModel does, to a file
+        /// that is already open for binary writing
+        /// \param fp File in which to write the model's data
+        /// \return True if the model's data was written, False if an error
+        ///         occurred during writing.
+		bool WritePreprocessedModel(FILE* fp);
+
 	protected:
 		/// \privatesection
 		// Constructor is protected to force the factory method to be used to create a new NvModelExt
@@ -166,6 +203,12 @@ namespace Nv
 		// Pointer to the NvModelFileLoader object to use for all File I/O operations
 		static NvModelFileLoader* ms_pLoader;
 
+		// Maximum number of threads to parse OBJ data on; see SetObjLoadThreads
+		static uint32_t ms_objLoadThreads;
+
+		// Whether preprocessed models are written packed; see SetVertexPacking
+		static bool ms_packVertices;
+
         // Pointer to the skeleton for the model. NULL if it doesn't contain one.
         NvSkeleton* m_pSkeleton;
 
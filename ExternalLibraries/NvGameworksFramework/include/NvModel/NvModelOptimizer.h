@@ -0,0 +1,159 @@
+//----------------------------------------------------------------------------------
+// File:        NvModel/NvModelOptimizer.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef _NVMODELOPTIMIZER_H_
+#define _NVMODELOPTIMIZER_H_
+
+#include <NvSimpleTypes.h>
+#include <stddef.h>
+
+namespace Nv
+{
+    /// Post-transform vertex cache behavior of an indexed triangle list
+    struct NvModelCacheStats
+    {
+        float m_acmr;   ///< Average cache miss ratio: vertices transformed per triangle, ideally about 0.5
+        float m_atvr;   ///< Average transformed vertex ratio: vertices transformed per vertex referenced, ideally 1
+    };
+
+    /// Reorders indexed triangle lists for the GPU: triangles for the
+    /// post-transform vertex cache and, optionally, for less overdraw, then
+    /// vertices into the order the triangles first use them.  Reordering
+    /// changes neither the triangles nor their winding, only the order in which
+    /// they are drawn and where their vertices are stored.
+    ///
+    /// The model importers run OptimizeMesh on every mesh they compile from OBJ
+    /// data, so optimized meshes are also what WritePreprocessedModel writes.
+    class NvModelOptimizer
+    {
+    public:
+        /// FIFO cache size that the reported statistics are measured with
+        static const uint32_t MEASURED_CACHE_SIZE = 16;
+
+        /// Sets whether the model importers optimize the meshes they compile
+        /// \param[in] optimize true, the default, to optimize meshes
+        static void SetMeshOptimization(bool optimize) { ms_optimizeMeshes = optimize; }
+
+        /// Returns whether the model importers optimize the meshes they compile
+        /// \return true if meshes are optimized
+        static bool GetMeshOptimization() { return ms_optimizeMeshes; }
+
+        /// Sets how far the model importers may trade vertex cache efficiency
+        /// for less overdraw
+        /// \param[in] threshold the ACMR that overdraw ordering may grow each
+        /// cluster of triangles to, relative to its optimized ACMR, such as 1.05;
+        /// values of 1 or less, 0 being the default, disable overdraw ordering
+        static void SetOverdrawThreshold(float threshold) { ms_overdrawThreshold = threshold; }
+
+        /// Returns the threshold the model importers order for overdraw with
+        /// \return the threshold; 1 or less when overdraw ordering is disabled
+        static float GetOverdrawThreshold() { return ms_overdrawThreshold; }
+
+        /// Sets whether the model importers log the ACMR and ATVR of each mesh
+        /// before and after optimizing it
+        /// \param[in] report true to log the statistics
+        static void SetReportStats(bool report) { ms_reportStats = report; }
+
+        /// Returns whether the model importers log statistics of the meshes they optimize
+        /// \return true if statistics are logged
+        static bool GetReportStats() { return ms_reportStats; }
+
+        /// Measures the vertex cache behavior of a triangle list with a FIFO cache
+        /// \param[in] indices the triangle list's indices
+        /// \param[in] indexCount the number of indices, three per triangle
+        /// \param[in] vertexCount the number of vertices the indices refer to
+        /// \param[in] cacheSize the number of vertices the cache holds
+        /// \return the ACMR and ATVR; both are 0 for an empty list
+        static NvModelCacheStats MeasureVertexCache(const uint32_t* indices, uint32_t indexCount,
+            uint32_t vertexCount, uint32_t cacheSize = MEASURED_CACHE_SIZE);
+
+        /// Reorders triangles so that consecutive triangles share vertices still
+        /// in the post-transform cache, scoring candidates with Tom Forsyth's
+        /// linear-speed vertex cache optimization
+        /// \param[in,out] indices the triangle list's indices
+        /// \param[in] indexCount the number of indices, three per triangle
+        /// \param[in] vertexCount the number of vertices the indices refer to
+        static void OptimizeVertexCache(uint32_t* indices, uint32_t indexCount, uint32_t vertexCount);
+
+        /// Reorders a cache optimized triangle list to draw outward facing parts
+        /// of the mesh first, so that they hide those behind them.  The list is
+        /// cut into clusters where the cache restarts, and further where a
+        /// cluster's ACMR stays within threshold of its whole, and the clusters
+        /// are sorted without changing the triangles' order within them.
+        /// \param[in,out] indices the triangle list's indices
+        /// \param[in] indexCount the number of indices, three per triangle
+        /// \param[in] vertices the vertex data, starting with x, y and z
+        /// \param[in] vertexSize the size of a vertex in floats
+        /// \param[in] vertexCount the number of vertices
+        /// \param[in] threshold the ACMR each cluster may have, relative to its
+        /// whole hard cluster; values of 1 or less leave the list unchanged
+        static void OptimizeOverdraw(uint32_t* indices, uint32_t indexCount, const float* vertices,
+            uint32_t vertexSize, uint32_t vertexCount, float threshold);
+
+        /// Renumbers vertices in the order the triangles first use them and
+        /// moves their data to match, keeping vertices no triangle uses at the end
+        /// \param[in,out] vertices the vertex data
+        /// \param[in] vertexSize the size of a vertex in floats
+        /// \param[in] vertexCount the number of vertices
+        /// \param[in,out] indices the triangle list's indices
+        /// \param[in] indexCount the number of indices
+        static void OptimizeVertexFetch(float* vertices, uint32_t vertexSize, uint32_t vertexCount,
+            uint32_t* indices, uint32_t indexCount);
+
+        /// Runs the optimizations the settings above select on one mesh, logging
+        /// its statistics if asked to
+        /// \param[in,out] vertices the vertex data, starting with x, y and z
+        /// \param[in] vertexSize the size of a vertex in floats
+        /// \param[in] vertexCount the number of vertices
+        /// \param[in,out] indices the triangle list's indices
+        /// \param[in] indexCount the number of indices, three per triangle
+        /// \param[in] meshId the number of the mesh within its model, for the log
+        /// \param[out] pBefore if not NULL, receives the statistics before optimizing
+        /// \param[out] pAfter if not NULL, receives the statistics after optimizing
+        static void OptimizeMesh(float* vertices, uint32_t vertexSize, uint32_t vertexCount,
+            uint32_t* indices, uint32_t indexCount, uint32_t meshId,
+            NvModelCacheStats* pBefore = NULL, NvModelCacheStats* pAfter = NULL);
+
+    private:
+        // Whether the model importers optimize meshes; see SetMeshOptimization
+        static bool ms_optimizeMeshes;
+
+        // Overdraw threshold of the model importers; see SetOverdrawThreshold
+        static float ms_overdrawThreshold;
+
+        // Whether the model importers log statistics; see SetReportStats
+        static bool ms_reportStats;
+    };
+}
+
+#endif
@@ -36,6 +36,7 @@
 #include <NvSimpleTypes.h>
 #include <vector>
 #include "NV/NvMath.h"
+#include "NvModel/NvModelVertexFormat.h"
 
 namespace Nv
 {
@@ -156,6 +157,10 @@ namespace Nv
         int32_t m_boneIndexOffset;   // in floats (zero == no component)
         int32_t m_boneWeightOffset; //  in floats (zero == no component)
 		int32_t m_vertSize; // in floats
+
+        // Formats the vertices are stored in on the GPU and in preprocessed
+        // files; all FLOAT32 unless the mesh was loaded packed
+        NvPackedVertexFormat m_packedFormat;
 	};
 }
 #endif
\ No newline at end of file
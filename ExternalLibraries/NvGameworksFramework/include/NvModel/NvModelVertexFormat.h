@@ -0,0 +1,153 @@
+//----------------------------------------------------------------------------------
+// File:        NvModel/NvModelVertexFormat.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef _NVMODELVERTEXFORMAT_H_
+#define _NVMODELVERTEXFORMAT_H_
+
+#include <NvSimpleTypes.h>
+
+namespace Nv
+{
+    class SubMesh;
+
+    /// Vertex attributes of a submesh, in the order they are laid out
+    struct NvVertexAttrib {
+        enum Enum {
+            POSITION = 0,   ///< Position, always present
+            NORMAL,         ///< Normal
+            TEXCOORD,       ///< Texture coordinates
+            TANGENT,        ///< Tangent in the S direction
+            COLOR,          ///< Color
+            BONE_INDEX,     ///< Bone indices; stored as uint32_t in the floats of the vertex
+            BONE_WEIGHT,    ///< Bone weights
+            COUNT
+        };
+    };
+
+    /// Formats that vertex attributes are stored in when packed
+    struct NvVertexAttribFormat {
+        enum Enum {
+            FLOAT32 = 0,    ///< 32-bit float (or uint32_t bone index) per component, as unpacked
+            FLOAT16,        ///< IEEE half float per component
+            UNORM16,        ///< 16-bit unsigned normalized per component; values must lie in [0, 1]
+            UNORM8,         ///< 8-bit unsigned normalized per component; values must lie in [0, 1]
+            UINT8,          ///< 8-bit unsigned integer per component; bone indices below 256
+            SNORM16_OCT     ///< Unit 3-vector as two 16-bit signed normalized octahedral coordinates
+        };
+    };
+
+    /// Layout of packed vertices: the format and byte offset of each attribute
+    /// of a submesh's float vertices.  Each packed attribute starts on a 4-byte
+    /// boundary, and 3-component 8 and 16-bit attributes are padded to 4
+    /// components with a 1, since GPUs need not fetch 3 of them.  Packing is lossy for every format but FLOAT32, and
+    /// SNORM16_OCT attributes reach shaders as a 2-component vector that they
+    /// decode with:
+    ///
+    ///     vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    ///     if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    ///     n = normalize(n);
+    class NvPackedVertexFormat
+    {
+    public:
+        NvPackedVertexFormat();
+
+        /// Lays out the attributes of a submesh's float vertices in the given
+        /// formats.  Each attribute spans the floats up to the next one present.
+        /// \param[in] mesh the submesh whose vertex layout, in floats, to pack
+        /// \param[in] formats the format of each attribute, indexed by
+        /// #NvVertexAttrib::Enum, or NULL to keep every attribute as FLOAT32
+        void Init(const SubMesh& mesh, const NvVertexAttribFormat::Enum* formats);
+
+        /// Lays out the attributes of a submesh's float vertices in the most
+        /// compact formats that hold its data: positions stay 32-bit floats,
+        /// 3-component normals and tangents become octahedral, texture
+        /// coordinates 16-bit normalized or half floats, colors and bone weights
+        /// 8-bit normalized, and bone indices 8-bit integers, each as far as
+        /// the values allow
+        /// \param[in] mesh the submesh whose vertices to pack
+        void InitCompact(const SubMesh& mesh);
+
+        /// Returns whether any attribute is stored in another format than FLOAT32
+        /// \return true if packed vertices differ from the float vertices
+        bool IsPacked() const;
+
+        /// Returns the format an attribute is stored in
+        /// \param[in] attrib the attribute
+        /// \return the attribute's format
+        NvVertexAttribFormat::Enum GetFormat(NvVertexAttrib::Enum attrib) const { return NvVertexAttribFormat::Enum(m_attribs[attrib].m_format); }
+
+        /// Returns the number of floats an attribute has in the float vertices
+        /// \param[in] attrib the attribute
+        /// \return the component count; 0 if the vertices lack the attribute
+        int32_t GetComponentCount(NvVertexAttrib::Enum attrib) const { return m_attribs[attrib].m_componentCount; }
+
+        /// Returns the offset of an attribute in a packed vertex
+        /// \param[in] attrib the attribute
+        /// \return the offset in bytes; -1 if the vertices lack the attribute
+        int32_t GetOffset(NvVertexAttrib::Enum attrib) const { return m_attribs[attrib].m_packedOffset; }
+
+        /// Returns the size of a packed vertex
+        /// \return the size in bytes, a multiple of 4
+        uint32_t GetVertexSize() const { return m_packedVertexSize; }
+
+        /// Packs float vertices laid out like the submesh this was initialized from
+        /// \param[in] pSrc the float vertices
+        /// \param[in] vertexCount the number of vertices
+        /// \param[out] pDest receives vertexCount * GetVertexSize() bytes
+        void Pack(const float* pSrc, uint32_t vertexCount, uint8_t* pDest) const;
+
+        /// Unpacks vertices into float vertices laid out like the submesh this
+        /// was initialized from
+        /// \param[in] pSrc the packed vertices
+        /// \param[in] vertexCount the number of vertices
+        /// \param[out] pDest receives the float vertices
+        void Unpack(const uint8_t* pSrc, uint32_t vertexCount, float* pDest) const;
+
+    private:
+        // Lays the attributes out one after another, each on a 4-byte boundary
+        void ComputeOffsets();
+
+        struct Attrib {
+            uint32_t m_format;          // NvVertexAttribFormat::Enum
+            int32_t m_componentCount;   // in floats (zero == no attribute)
+            int32_t m_floatOffset;      // in floats
+            int32_t m_packedOffset;     // in bytes (-1 == no attribute)
+        };
+
+        Attrib m_attribs[NvVertexAttrib::COUNT];
+        uint32_t m_floatVertexSize;     // in floats
+        uint32_t m_packedVertexSize;    // in bytes
+    };
+}
+
+#endif
@@ -0,0 +1,168 @@
+//----------------------------------------------------------------------------------
+// File:        NvVkUtil/NvGPUProfilerVK.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef NV_GPUPROFILERVK_H
+#define NV_GPUPROFILERVK_H
+
+#include "NvVkUtil/NvPlatformVK.h"
+#include <NvSimpleTypes.h>
+#include <vector>
+#include <map>
+#include <string>
+
+class NvVkContext;
+
+/// \file
+/// Hierarchical GPU scope profiler.
+
+/// Times nested, named scopes of the main command buffer with timestamp queries.
+/// Each frame slot owns a range of one query pool that is reset once per frame;
+/// the results of a slot are read back without waiting when the slot is reused,
+/// i.e. after its fence has signalled.  Timings are aggregated per scope path and
+/// can be written as a Chrome trace (chrome://tracing) JSON file
+class NvGPUProfilerVK
+{
+public:
+	/// Aggregated timings of one scope path
+	struct ScopeStats {
+		std::string name; ///< Name the scope was opened with
+		std::string path; ///< Names of the enclosing scopes and this one, separated by '/'
+		uint32_t depth; ///< Nesting depth; the frame scope is depth 0
+		uint32_t count; ///< Number of timed instances
+		double minMs; ///< Shortest instance in milliseconds
+		double maxMs; ///< Longest instance in milliseconds
+		double totalMs; ///< Sum of all instances in milliseconds
+		ScopeStats() : depth(0), count(0), minMs(0.0), maxMs(0.0), totalMs(0.0) {}
+		/// Average instance duration in milliseconds
+		double avgMs() const { return count ? totalMs / count : 0.0; }
+	};
+
+	NvGPUProfilerVK();
+	~NvGPUProfilerVK();
+
+	/// Creates the query pool
+	/// \param[in] vk the context to profile
+	/// \param[in] frameSlots the number of frames the context keeps in flight
+	/// \param[in] maxScopesPerFrame scopes beyond this count in one frame are not timed
+	/// \return true on success, false if the queue does not support timestamps
+	bool init(NvVkContext& vk, uint32_t frameSlots, uint32_t maxScopesPerFrame = 256);
+
+	/// Releases the query pool
+	void deinit();
+
+	/// Turns profiling on or off; takes effect at the next frame
+	void setEnabled(bool enabled) { mEnabled = enabled; }
+
+	/// Returns whether profiling is on
+	bool isEnabled() const { return mEnabled; }
+
+	/// Starts a frame: collects the results of the last frame recorded in the slot,
+	/// resets the slot's queries and opens the frame scope.  The slot's fence must
+	/// have signalled
+	/// \param[in] cmd the frame's main command buffer, outside of any render pass
+	/// \param[in] slot the frame slot
+	void beginFrame(VkCommandBuffer cmd, uint32_t slot);
+
+	/// Closes the frame scope and any scope left open
+	/// \param[in] cmd the frame's main command buffer
+	void endFrame(VkCommandBuffer cmd);
+
+	/// Opens a nested scope.  Only scopes on the frame's main command buffer are timed
+	/// \param[in] cmd the command buffer the scope is recorded in
+	/// \param[in] name the name of the scope
+	void beginScope(VkCommandBuffer cmd, const char* name);
+
+	/// Closes the innermost open scope
+	/// \param[in] cmd the command buffer the scope is recorded in
+	void endScope(VkCommandBuffer cmd);
+
+	/// Collects the results of every slot; the queue must be idle
+	void collectAll();
+
+	/// Returns the aggregated timings, in order of first appearance
+	const std::vector<ScopeStats>& getStats() const { return mStats; }
+
+	/// Clears the aggregated timings and the trace
+	void clear();
+
+	/// Logs min/avg/max of every scope
+	void logStats() const;
+
+	/// Writes the collected scope instances as a Chrome trace event file
+	/// \param[in] filename the file to write
+	/// \return true on success and false on failure
+	bool writeChromeTrace(const char* filename) const;
+
+protected:
+	// A scope recorded in a frame slot; its queries are 2 * index and 2 * index + 1 of the slot
+	struct Scope {
+		uint32_t stat;
+		bool closed;
+	};
+
+	struct FrameSlot {
+		std::vector<Scope> scopes;
+	};
+
+	// An instance of a scope, kept for the trace
+	struct TraceEvent {
+		uint32_t stat;
+		uint64_t begin;
+		uint64_t end;
+	};
+
+	void collect(uint32_t slot);
+	uint32_t findStat(uint32_t parent, const char* name);
+
+	enum { MAX_TRACE_EVENTS = 200000 };
+
+	VkDevice mDevice;
+	VkQueryPool mPool;
+	uint32_t mMaxScopes;
+	double mPeriodMs; ///< Milliseconds per timestamp tick
+	uint64_t mTimestampMask;
+	bool mEnabled;
+
+	std::vector<FrameSlot> mSlots;
+	int32_t mCurrentSlot; ///< Slot being recorded, or -1 outside a frame
+	VkCommandBuffer mCurrentCmd;
+	std::vector<int32_t> mOpenScopes; ///< Indices into the slot's scopes; -1 for untimed scopes
+
+	std::vector<ScopeStats> mStats;
+	std::map<std::string, uint32_t> mStatIndices; ///< Keyed by path
+
+	std::vector<TraceEvent> mTrace;
+	uint64_t mTraceOrigin;
+};
+
+#endif
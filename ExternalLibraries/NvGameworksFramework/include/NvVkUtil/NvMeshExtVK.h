@@ -37,6 +37,7 @@
 
 #include "NV/NvMath.h"
 #include "NvVkUtil/NvVkContext.h"
+#include "NvModel/NvModelVertexFormat.h"
 #include <vector>
 
 
@@ -59,6 +60,18 @@ namespace Nv
 		const static int32_t c_MaxBonesPerVertex = 4;
 		const static int32_t c_MaxBonesPerMesh = 32;
 
+		/// Sets whether meshes initialized afterwards keep octahedral normals and
+		/// tangents of packed models on the GPU.  Their shaders must then decode
+		/// them, as NvPackedVertexFormat describes; otherwise they are widened
+		/// back to 32-bit floats and every other packed format is kept.
+		/// \param[in] octahedral true to bind them as two 16-bit signed normalized
+		/// components; false, the default, binds them as three floats
+		static void SetOctahedralNormals(bool octahedral) { ms_octahedralNormals = octahedral; }
+
+		/// Returns whether packed meshes keep octahedral normals and tangents
+		/// \return true if they are bound as two 16-bit signed normalized components
+		static bool GetOctahedralNormals() { return ms_octahedralNormals; }
+
 		/// Get the index count (for advanced rendering)
 		/// \return the index count
 		uint32_t getIndexCount() { return m_indexCount; }
@@ -144,6 +157,14 @@ namespace Nv
 		int32_t m_parentNode;
 		nv::matrix4f m_offsetMatrix;
 
+		// 16-bit when the mesh has at most 65535 vertices
+		VkIndexType m_indexType;
+
+		// Layout of the vertex buffer when it holds packed vertices
+		NvPackedVertexFormat m_vertexFormat;
+
+		static bool ms_octahedralNormals;
+
 		NvVkBuffer mVBO;
 		NvVkBuffer mIBO;
 
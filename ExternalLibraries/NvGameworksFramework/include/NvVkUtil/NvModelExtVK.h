@@ -41,6 +41,8 @@
 #include <vector>
 
 class NvVkContext;
+class NvVkTextureManager;
+class NvVkManagedTexture;
 
 namespace Nv
 {
@@ -57,8 +59,11 @@ namespace Nv
 		/// \param[in] vk the VK device/queue to use
 		/// \param[in] pSourceModel pointer to an NvModelExt to use for mesh data.  
 		/// WARNING!!! This pointer is cached in the object, and must not be freed after this call returns WARNING!!!
+		/// \param[in] pTextures if non-NULL, the model's textures are acquired from this
+		/// manager, shared with other models and evicted while the model is not drawn;
+		/// see #MarkTexturesUsed.  The manager must outlive the model
 		/// \return a pointer to the VK-specific object or NULL on failure
-		static NvModelExtVK* Create(NvVkContext& vk, NvModelExt* pSourceModel);
+		static NvModelExtVK* Create(NvVkContext& vk, NvModelExt* pSourceModel, NvVkTextureManager* pTextures = NULL);
 
 		/// Free the rendering resources held by this model
 		/// \param[in] vk the VK device/queue to use
@@ -127,6 +132,22 @@ namespace Nv
 			return m_textures[textureIndex];
 		}
 
+		/// Retrieves the managed texture behind a texture of the model, if the model was
+		/// created with a texture manager.  Descriptors using the texture must be
+		/// rewritten whenever its view version changes
+		/// \param[in] textureIndex Index of the texture within the model to retrieve
+		/// \return The managed texture at the requested index, if there is one.
+		NvVkManagedTexture* GetManagedTexture(uint32_t textureIndex)
+		{
+			if (textureIndex >= m_managedTextures.size())
+				return NULL;
+			return m_managedTextures[textureIndex];
+		}
+
+		/// Marks all of the model's textures as used in the current frame of its texture
+		/// manager; call every frame the model is drawn.  Does nothing without a manager
+		void MarkTexturesUsed();
+
 		VkSampler& GetSampler() { return m_linearSampler; }
 
 		bool InitVertexState();
@@ -157,6 +178,9 @@ namespace Nv
 		/// \param[in] computeNormals if set to true, then normal vectors will be computed.
 		void PrepareForRendering(NvVkContext& vk, NvModelExt* pModel);
 
+		// Releases the textures acquired from the texture manager
+		void ReleaseManagedTextures();
+
 		// Pointer to the original source model that contains the data which the
 		// VK model was derived from
 		NvModelExt* m_pSourceModel;
@@ -175,6 +199,10 @@ namespace Nv
 		// Array of all textures used by meshes within the model
 		std::vector<NvVkTexture*> m_textures;
 
+		// Manager the textures were acquired from, and its handles to them
+		NvVkTextureManager* m_pTextureManager;
+		std::vector<NvVkManagedTexture*> m_managedTextures;
+
 		bool m_instanced;
 	};
 }
@@ -119,7 +119,7 @@ public:
 	/// \return a pointer to the command buffer
 	operator VkCommandBuffer&(void)
 	{
-		return *(m_cbs[0][m_localSync.getIndex()]);
+		return m_cbs[0][m_localSync.getIndex()];
 	}
 
 	VkCommandBuffer& operator[] (const int item)
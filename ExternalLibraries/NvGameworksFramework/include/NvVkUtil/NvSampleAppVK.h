@@ -40,6 +40,7 @@
 
 #include "NvAppBase/NvSampleApp.h"
 #include "NvAppContextVK.h"
+#include "NvVkParallelRecorder.h"
 
 /// \file
 /// VK-based Sample app base class.
@@ -109,6 +110,24 @@ public:
 	/// context, false if not.
 	bool isLayerSupported(const char* ext) { return vk().isLayerSupported(ext); }
 
+	/// Records a list of items into secondary command buffers on several threads
+	/// and executes the results, in list order, into a primary command buffer.
+	/// The calling thread records the first slice and returns once all slices are done.
+	/// \param[in] cmd the primary command buffer; it must be inside renderPass, begun
+	/// with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+	/// \param[in] renderPass the render pass the secondaries continue
+	/// \param[in] framebuffer the framebuffer of the render pass, or VK_NULL_HANDLE if unknown
+	/// \param[in] itemCount the number of items in the list
+	/// \param[in] job the callback that records a slice of the list
+	/// \param[in] minItemsPerSlice slices are never cut smaller than this
+	/// \return true on success and false on failure
+	bool recordParallel(VkCommandBuffer cmd, VkRenderPass renderPass, VkFramebuffer framebuffer,
+		uint32_t itemCount, NvVkParallelRecorder::Job& job, uint32_t minItemsPerSlice = 1);
+
+	/// Returns the number of threads #recordParallel uses, including the calling thread.
+	/// Defaults to the number of CPU cores (up to 8); set with "-recordthreads <n>"
+	uint32_t recordingThreadCount();
+
 
 	/// \privatesection
 	virtual int32_t getUniqueTypeID();
@@ -123,9 +142,18 @@ protected:
 
     virtual void platformInitUI(void);
 
+    virtual void platformShutdownRendering(void);
+
     virtual void platformLogTestResults(float frameRate, int32_t frames);
 
 private:
+	NvStopWatch* mStartupTimer;
+	NvVkParallelRecorder* mRecorder;
+	uint32_t mRecordingThreads;
+	uint32_t mMaxTextureSize;
+	uint32_t mTextureBudgetMB;
+	bool mGPUProfile;
+	std::string mGPUTraceFile;
 	bool mUseWSI;
 	bool mUseGLUI;
 	bool mGLSupported;
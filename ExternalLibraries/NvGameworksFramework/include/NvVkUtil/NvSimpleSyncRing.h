@@ -38,11 +38,21 @@
 #include <NV/NvLogs.h>
 #include "NvVkUtil/NvVkContext.h"
 
+/// Round-robins m_items copies of a resource between the CPU and GPU.
+/// Each slot remembers the serial of the frame that last used it; BeginUpdate
+/// only blocks when the next slot is still referenced by a frame in flight, so
+/// any number of frames can be buffered without the CPU overwriting a copy
+/// that the GPU is still reading
 template <uint32_t m_items = 4>
 class NvSyncRing {
 public:
 	bool Initialize(NvVkContext& vk) {
+		m_vk = &vk;
 		m_index = 0;
+		for (uint32_t i = 0; i < m_items; i++)
+			m_serials[i] = 0;
+		m_updateCount = 0;
+		m_stallCount = 0;
 		return true;
 	}
 
@@ -50,19 +60,48 @@ public:
 		Finish();
 	}
 
-	void Finish() {  }
+	/// Waits until the GPU has finished with every submitted copy
+	void Finish() {
+		for (uint32_t i = 0; i < m_items; i++) {
+			if (m_serials[i])
+				m_vk->waitForSubmission(m_serials[i]);
+		}
+	}
 
+	/// Advances to the next copy, waiting for the GPU to release it if needed.
+	/// Fails if the copy is in use by the frame being recorded, i.e. if the
+	/// ring is cycled more than m_items times in one frame
 	bool BeginUpdate() {
 		// Next buffer in the cycle
-		m_index = (m_index + 1) % m_items;
+		uint32_t next = (m_index + 1) % m_items;
+		uint64_t serial = m_serials[next];
+
+		if (!m_vk->isSubmissionComplete(serial)) {
+			m_stallCount++;
+			if (!m_vk->waitForSubmission(serial))
+				return false;
+		}
+
+		m_index = next;
+		m_serials[m_index] = m_vk->currentSubmissionSerial();
+		m_updateCount++;
 		return true;
 	}
 
 	uint32_t getIndex() { return m_index; }
 
+	/// Number of successful calls to BeginUpdate
+	uint64_t getUpdateCount() const { return m_updateCount; }
+
+	/// Number of calls to BeginUpdate that had to wait for the GPU
+	uint64_t getStallCount() const { return m_stallCount; }
+
 protected:
+	NvVkContext* m_vk;
 	uint32_t	m_index;
-	int32_t		m_refCnt;
+	uint64_t	m_serials[m_items];
+	uint64_t	m_updateCount;
+	uint64_t	m_stallCount;
 };
 
 #endif // NV_SIMPLE_SYNC_RING
@@ -38,75 +38,12 @@
 #include <NvVkUtil/NvSimpleSyncRing.h>
 #include <NV/NvLogs.h>
 
-/// A simple, start to end allocator of UBO memory for multiple UBOs from a single memory allocation
-/// Does not support deletion - designed for allocations that last the lifetime of the app
-/// A simple method of implementing suballocation
-class NvSimpleUBOAllocator {
-public:
-	/// Initialize the allocator with the desired size
-	/// \param[in] vk the queue/device to use
-	/// \param[in] the size of the entire allocation pool in bytes
-	/// \return true on success and false on failure
-	bool Initialize(NvVkContext& vk, uint32_t size) {
-		m_size = size;
-		m_offset = 0;
-
-		VkResult result = vk.createAndFillBuffer(size,
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, m_buffer);
-		if (result != VK_SUCCESS)
-			return false;
-
-		result = vkMapMemory(vk.device(), m_buffer.mem, 0, size, 0, (void**)&m_mapped);
-		if (result != VK_SUCCESS)
-			return false;
-
-		return true;
-	}
-
-	/// Return the parent buffer used for all allocations
-	NvVkBuffer& buffer() { return m_buffer; }
-
-	/// Allocate a block of memory from the buffer, return its location in the buffer and a mapping if needed
-	/// \param[in] size thew size of the block to allocate, in bytes
-	/// \param[out] offset the offset into the buffer object of the resulting allocation
-	/// \param[in,out] mapped if non-NULL, a pointer to a void* into which the CPU mapped address of the block should be written
-	/// \return true on success and false on failure
-	bool Alloc(uint32_t size, uint32_t& offset, void** mapped = NULL) {
-		if (size + m_offset > m_size)
-			return false;
-
-		offset = m_offset;
-		m_offset += size;
-
-		if (mapped) {
-			*mapped = m_mapped;
-		}
-
-		m_mapped = (void*)(((unsigned char*)m_mapped) + size);
-
-		return true;
-	}
-
-protected:
-
-	NvVkBuffer m_buffer;
-	uint32_t m_size;
-	uint32_t m_offset;
-	void* m_mapped;
-};
-
 template <class UBOType, uint32_t m_copies = 4>
 class NvSimpleSharedUBO {
 public:
 	NvSimpleSharedUBO() { }
 	~NvSimpleSharedUBO() { }
 
-	/// Returns the buffer space required for an instance of this object.  
-	/// Used to estimate buffer sizes for shared allocation
-	static uint32_t GetBufferSpace() { 
-		return ((sizeof(UBOType) + 0xff) & 0xffffff00) * m_copies;
-	}
-
 	/// Initializes the UBO mapping, associating it with a queue and device
 	/// \param[in] vk the device and queue to associate with the UBO
 	/// an internal buffer can be safely re-used
@@ -114,11 +51,14 @@ public:
 	/// \return true on success and false on failure
 	bool Initialize(NvVkContext& vk, NvSyncRing<m_copies>* ring) {
 		m_ring = ring;
-		m_device = vk.device();
+		m_vk = &vk;
 
-		// round size up to 256 byte multiple - this is the stride
+		// round size up to the dynamic offset alignment - this is the stride
+		uint32_t alignment = (uint32_t)vk.physicalDeviceLimits().minUniformBufferOffsetAlignment;
+		if (!alignment)
+			alignment = 1;
 		m_stride = sizeof(UBOType);
-		m_stride = (m_stride + 0xff) & 0xffffff00;
+		m_stride = (m_stride + alignment - 1) / alignment * alignment;
 
 		uint32_t size = m_copies * m_stride;
 
@@ -128,34 +68,7 @@ public:
 			return false;
 
 		m_offset = 0;
-
-		result = vkMapMemory(m_device, m_ubo.mem, m_offset, size, 0, (void**)&m_mapped);
-		if (result != VK_SUCCESS)
-			return false;
-
-		return true;
-	}
-
-	/// Initializes the UBO mapping, associating it with a queue and device and using buffer sharing
-	/// \param[in] vk the device and queue to associate with the UBO
-	/// an internal buffer can be safely re-used
-	/// \param[in] alloc the shared allocator to use
-	/// \param[in] ring the sync ring to use to round-robin the copies
-	/// \return true on success and false on failure
-	bool Initialize(NvVkContext& vk, NvSimpleUBOAllocator& alloc, NvSyncRing<m_copies>* ring) {
-		m_ring = ring;
-		m_device = vk.device();
-
-		// round size up to 256 byte multiple - this is the stride
-		m_stride = sizeof(UBOType);
-		m_stride = (m_stride + 0xff) & 0xffffff00;
-
-		uint32_t size = m_copies * m_stride;
-
-		if (!alloc.Alloc(size, m_offset, (void**)&m_mapped))
-			return false;
-
-		m_ubo = alloc.buffer();
+		m_mapped = (UBOType*)m_ubo.mapped();
 
 		return true;
 	}
@@ -165,8 +78,13 @@ public:
 		m_ring->Finish();
 	}
 
+	/// Advances the sync ring, waiting if the next copy is still in use
+	/// by the GPU, then writes the CPU-accessible structure to it
+	/// \return true on success and false on failure
 	bool Update() {
-		// All updates are unsynchronized right now
+		if (!m_ring->BeginUpdate())
+			return false;
+
 		return UpdateUnsynchronized();
 	}
 
@@ -177,19 +95,12 @@ public:
 	/// updated via this function
 	/// \return true on success and false on failure
 	bool UpdateUnsynchronized() {
-		if (!m_ring->BeginUpdate())
-			return false;
-
 		uint32_t index = m_ring->getIndex();
 		VkResult result;
 
 		memcpy(((uint8_t*)m_mapped) + index * m_stride, &m_cpuCopy, sizeof(UBOType));
 
-		VkMappedMemoryRange range = { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
-		range.offset = m_offset + m_stride * index;
-		range.size = m_stride;
-		range.memory = m_ubo.mem;
-		result = vkFlushMappedMemoryRanges(m_device, 1, &range);
+		result = m_vk->flushBuffer(m_ubo, m_offset + m_stride * index, m_stride);
 
 		return result == VK_SUCCESS;
 	}
@@ -240,7 +151,7 @@ public:
 
 protected:
 	NvSyncRing<m_copies>*	m_ring;
-	VkDevice	m_device;
+	NvVkContext*	m_vk;
 	UBOType		m_cpuCopy;
 	UBOType*	m_mapped;
 	uint32_t	m_stride;
@@ -248,41 +159,27 @@ protected:
 	NvVkBuffer  m_ubo;
 };
 
-template <class UBOType, uint32_t m_copies = 4>
+/// A UBO whose contents are written to the context's per-frame uniform
+/// allocator.  Every update takes a fresh region of the shared buffer, so any
+/// number of updates per frame cost a pointer bump and a memcpy; the frame's
+/// regions are flushed together when it is submitted.  The descriptor from
+/// #GetDesc is the same for every copy and must be bound as
+/// VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC with #getDynamicOffset
+template <class UBOType>
 class NvSimpleUBO {
 public:
-	NvSimpleUBO() { }
+	NvSimpleUBO() : m_vk(NULL), m_offset(0), m_serial(0) { }
 	~NvSimpleUBO() { }
 
-	/// Returns the buffer space required for an instance of this object.  
-	/// Used to estimate buffer sizes for shared allocation
-	static uint32_t GetBufferSpace() {
-		return ((sizeof(UBOType) + 0xff) & 0xffffff00) * m_copies;
-	}
-
-	/// Initializes the UBO mapping, associating it with a queue and device
+	/// Initializes the UBO, associating it with the context's uniform allocator
 	/// \param[in] vk the device/queue to associate with the UBO
 	/// \return true on success and false on failure
 	bool Initialize(NvVkContext& vk) {
-		if (!m_localSync.Initialize(vk))
-			return false;
-		if (!m_ubo.Initialize(vk, &m_localSync))
-			return false;
-
-		return true;
-	}
-
-	/// Initializes the UBO mapping, associating it with a queue and device, sharing its buffer with other UBOs
-	/// \param[in] vk the device/queue to associate with the UBO
-	/// \param[in] alloc the shared allocator to use
-	/// \return true on success and false on failure
-	bool Initialize(NvVkContext& vk, NvSimpleUBOAllocator& alloc) {
-		if (!m_localSync.Initialize(vk))
-			return false;
-		if (!m_ubo.Initialize(vk, alloc, &m_localSync))
-			return false;
+		m_vk = &vk;
+		m_offset = 0;
+		m_serial = 0;
 
-		return true;
+		return vk.uniformAllocator().getBuffer() != VK_NULL_HANDLE;
 	}
 
 	/// Release all API resources associated with the UBO
@@ -292,25 +189,29 @@ public:
 	/// Updates the current CPU-accessible structure values to a UBO
 	/// copy.  Changes to the CPU-accessible structure will not appear
 	/// in rendering calls until after a subsequent update call.
-	/// Will fail if there is no buffer currently available for use, which
-	/// will happen if Update is called too frequently for the number of
-	/// buffers as set by the template parameter
+	/// Will fail if the uniform allocator has no space left for the frame
 	/// \return true on success and false on failure
 	bool Update() {
-		return m_ubo.Update();
+		m_committed = m_cpuCopy;
+		return Commit();
 	}
 
-	/// Return the address of the current UBO backing store to be used
-	/// in draw calls; this value will change with every call to #Update,
-	/// so take care when caching the value of this in a command buffer
-	/// \return the BufferAddress of the current copy
+	/// Return the address of the UBO backing store to be used in draw calls
+	/// along with #getDynamicOffset; this value does not change with updates
+	/// \return the BufferAddress of the shared uniform buffer
 	void GetDesc(VkDescriptorBufferInfo& desc) {
-		m_ubo.GetDesc(desc);
+		desc.buffer = m_vk->uniformAllocator().getBuffer();
+		desc.offset = 0;
+		desc.range = sizeof(UBOType);
 	}
 
-	/// Get the dynamic offset into the UBO of the current copy of the data
+	/// Get the dynamic offset into the UBO of the current copy of the data.
+	/// If the UBO was last updated in an earlier frame, the last updated values
+	/// are written again for this frame
 	uint32_t getDynamicOffset() {
-		return m_ubo.getDynamicOffset();
+		if (m_serial != m_vk->currentSubmissionSerial())
+			Commit();
+		return m_offset;
 	}
 
 	/// Accessor for easy mapping of the wrapper to the CPU-accessible
@@ -318,36 +219,48 @@ public:
 	/// Changes to the structure pointed to by this pointer will NOT be 
 	/// reflected in a bound UBO until after a subsequent call to Update
 	/// \return a pointer to the CPU accessible struct
-	UBOType* operator-> () { return m_ubo; }
+	UBOType* operator-> () { return &m_cpuCopy; }
 
 	/// Read-only Accessor for easy mapping of the wrapper to the
 	/// CPU-accessible structure
 	/// \return a const pointer to the CPU accessible struct
-	const UBOType* operator-> () const { return &m_ubo; }
+	const UBOType* operator-> () const { return &m_cpuCopy; }
 
 	/// Accessor for easy mapping of the wrapper to the CPU-accessible
 	/// structure
 	/// Changes to the structure pointed to by this reference will NOT be 
 	/// reflected in a bound UBO until after a subsequent call to Update
 	/// \return a reference to the CPU accessible struct
-	UBOType& operator* () { return *m_ubo; }
+	UBOType& operator* () { return m_cpuCopy; }
 
 	/// Read-only Accessor for easy mapping of the wrapper to the
 	/// CPU-accessible structure
 	/// \return a const reference to the CPU accessible struct
-	const UBOType& operator* () const { return m_ubo; }
+	const UBOType& operator* () const { return m_cpuCopy; }
 
 	/// Accessor for easy mapping of the wrapper to the CPU-accessible
 	/// structure
 	/// Changes to the structure pointed to by this pointer will NOT be 
 	/// reflected in a bound UBO until after a subsequent call to Update
 	/// \return a pointer to the CPU accessible struct
-	operator UBOType*() { return m_ubo; }
+	operator UBOType*() { return &m_cpuCopy; }
 
 protected:
-	NvSimpleSharedUBO<UBOType, m_copies> m_ubo;
-	NvSyncRing<m_copies> m_localSync;
-};
+	bool Commit() {
+		NvVkUniformRegion region;
+		if (!m_vk->uniformAllocator().append(sizeof(UBOType), &m_committed, region))
+			return false;
 
+		m_offset = region.offset;
+		m_serial = m_vk->currentSubmissionSerial();
+		return true;
+	}
+
+	NvVkContext*	m_vk;
+	UBOType		m_cpuCopy;
+	UBOType		m_committed; ///< Values as of the last Update
+	uint32_t	m_offset;
+	uint64_t	m_serial; ///< Frame the current copy was written for
+};
 
 #endif // NV_SIMPLE_UBO
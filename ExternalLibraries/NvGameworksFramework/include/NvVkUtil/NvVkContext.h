@@ -41,8 +41,11 @@
 #include "NvPlatformVK.h"
 #include <NV/NvGfxConfiguration.h>
 #include <NvVkUtil/NvVkUtil.h>
+#include <NvVkUtil/NvVkMemoryAllocator.h>
 #include <vector>
 #include <set>
+#include <map>
+#include <string>
 
 void checkVkResult(const char* file, int32_t line, VkResult result);
 #ifndef CHECK_VK_RESULT
@@ -89,6 +92,10 @@ struct NvVKConfiguration : public NvGfxConfiguration {
 
 	/// Features to enable during device create time 
 	VkPhysicalDeviceFeatures	featuresToEnable;
+
+	/// File the pipeline cache is loaded from at device creation and saved to at shutdown.
+	/// An empty string keeps the cache in memory only
+	std::string pipelineCacheFile;
 	
 	/// Features required by the framework which are enabled by default
 	static VkPhysicalDeviceFeatures requiredFeaturesToEnable()
@@ -96,6 +103,7 @@ struct NvVKConfiguration : public NvGfxConfiguration {
 		VkPhysicalDeviceFeatures result = { 0 };
 		result.shaderClipDistance = VK_TRUE;
 		result.shaderCullDistance = VK_TRUE;
+		result.textureCompressionBC = VK_TRUE;
 		return result;
 	}
 };
@@ -103,25 +111,28 @@ struct NvVKConfiguration : public NvGfxConfiguration {
 class NvImage;
 class NvVkContext;
 class NvGPUTimerVK;
+class NvGPUProfilerVK;
 
 /// A wrapper for a VkBuffer and its memory
 struct NvVkBuffer {
-	VkDeviceMemory mem; ///< Buffer memory object
+	NvVkAllocation mem; ///< Buffer memory, sub-allocated from the context's NvVkMemoryAllocator
 	VkBuffer buffer; ///< Buffer object
 	/// Value-of operator.  Returns the VkBuffer
 	/// \return the VkBuffer
 	VkBuffer& operator ()() { return buffer; }
-	NvVkBuffer() : mem(0), buffer(0) {}
+	/// Persistent CPU mapping of the buffer, or NULL if it is not host visible
+	void* mapped() { return mem.mapped; }
+	NvVkBuffer() : buffer(0) {}
 };
 
 /// A wrapper for a VkImage and its memory
 struct NvVkImage {
-	VkDeviceMemory mem; ///< Image memory object
+	NvVkAllocation mem; ///< Image memory, sub-allocated from the context's NvVkMemoryAllocator
 	VkImage image; ///< Image object
 	/// Value-of operator.  Returns the VkImage
 	/// \return the VkImage
 	VkImage& operator ()() { return image; }
-	NvVkImage() : mem(0), image(0) {}
+	NvVkImage() : image(0) {}
 };
 
 /// A "texture": a wrapper for a VkImage and its VkImageView
@@ -133,32 +144,188 @@ struct NvVkTexture {
 	VkImageView view; ///< Image view object
 };
 
-/// An allocatable staging buffer for transfers
+/// A range of staging memory returned by NvVkStagingBuffer
+struct NvVkStagingRegion {
+	VkBuffer buffer; ///< Buffer to use as the transfer source
+	VkDeviceSize offset; ///< Offset of the region within buffer
+	VkDeviceSize size; ///< Size of the region in bytes
+	void* mapping; ///< CPU pointer to the start of the region
+	NvVkAllocation mem; ///< Memory backing buffer, used for flushing
+	NvVkStagingRegion() : buffer(VK_NULL_HANDLE), offset(0), size(0), mapping(NULL) {}
+};
+
+/// Usage statistics of an NvVkStagingBuffer
+struct NvVkStagingStats {
+	VkDeviceSize ringSize; ///< Size of the persistent ring
+	VkDeviceSize highWaterMark; ///< Most ring bytes ever in flight at once
+	VkDeviceSize totalBytes; ///< Bytes staged through the ring
+	VkDeviceSize dedicatedBytes; ///< Bytes staged through dedicated buffers
+	uint32_t dedicatedCount; ///< Uploads that did not fit in the ring
+	NvVkStagingStats() : ringSize(0), highWaterMark(0), totalBytes(0), dedicatedBytes(0), dedicatedCount(0) {}
+};
+
+/// A persistently-mapped staging ring for transfers.
+/// The ring is split into per-frame regions: everything staged while a frame is
+/// being recorded is released once that frame's fence has signalled, so staging
+/// never stalls the queue and is never reallocated.  Uploads that do not fit in
+/// the free part of the ring go to a dedicated buffer that is released with the frame
 class NvVkStagingBuffer {
 public:
+	/// Default size of the ring
+	enum { DEFAULT_RING_SIZE = 32 * 1024 * 1024 };
+
+	/// Returns the persistent ring buffer
 	VkBuffer getBuffer(){
 		return mBuffer();
 	}
-	bool needSync(size_t sz) {
-		return (mAllocated && mUsed + sz > mAllocated);
-	}
 
-	size_t append(size_t sz, const void* data);
+	/// Reserves staging memory for the current frame.  The caller writes to
+	/// region.mapping and must call #flush before the copy is submitted
+	/// \param[in] sz the number of bytes to reserve
+	/// \param[in] alignment the required alignment of the region's offset
+	/// \param[out] region the reserved region
+	/// \return true on success
+	bool alloc(size_t sz, size_t alignment, NvVkStagingRegion& region);
+
+	/// Reserves staging memory for the current frame and copies data into it
+	/// \param[in] sz the number of bytes to copy
+	/// \param[in] data the source data
+	/// \param[out] region the filled (and flushed) region
+	/// \return true on success
+	bool append(size_t sz, const void* data, NvVkStagingRegion& region);
+
+	/// Makes CPU writes to a region visible to the device
+	void flush(const NvVkStagingRegion& region);
+
+	/// Prepares the ring
+	/// \param[in] vk the owning context
+	/// \param[in] frameCount the number of frames the context keeps in flight
+	/// \param[in] ringSize the size of the persistent ring in bytes
+	void init(NvVkContext* vk, uint32_t frameCount, size_t ringSize = DEFAULT_RING_SIZE);
+
+	void deinit();
+
+	/// Marks the end of the staging done for a frame slot; call before the frame's fence is submitted
+	void endFrame(uint32_t slot);
+
+	/// Releases the staging memory of a frame slot; call once the slot's fence has signalled
+	void retireFrame(uint32_t slot);
+
+	/// Releases all staging memory; the queue must be idle
+	void retireAll();
 
-	void reset(){
-		mUsed = 0;
+	/// Retrieves the usage statistics of the ring
+	const NvVkStagingStats& getStats() const { return mStats; }
+
+	/// Logs the usage statistics of the ring
+	void logStats() const;
+
+	NvVkStagingBuffer() : mVk(NULL), mBuffer(), mMapping(NULL), mAllocated(0), mHead(0), mTail(0) {}
+	~NvVkStagingBuffer() {
+		deinit();
 	}
 
-	void init(NvVkContext* vk){
-		mVk = vk;
-		mAllocated = 0;
-		mUsed = 0;
+private:
+	struct FrameRegion {
+		uint64_t mEnd; ///< Ring head when the frame ended
+		std::vector<NvVkBuffer> mDedicated;
+		FrameRegion() : mEnd(0) {}
+	};
+
+	bool createRing();
+	bool allocDedicated(size_t sz, NvVkStagingRegion& region);
+
+	NvVkContext* mVk;
+	NvVkBuffer   mBuffer;
+	char*        mMapping;
+	size_t       mAllocated;
+	// head and tail are monotonic; the ring offset is the value modulo mAllocated
+	uint64_t     mHead;
+	uint64_t     mTail;
+	std::vector<FrameRegion> mFrames;
+	std::vector<NvVkBuffer> mPending; ///< Dedicated buffers of the frame being recorded
+	NvVkStagingStats mStats;
+};
+
+/// A range of uniform memory returned by NvVkUniformAllocator
+struct NvVkUniformRegion {
+	VkBuffer buffer; ///< Buffer to bind; the same for every region of an allocator
+	uint32_t offset; ///< Dynamic offset of the region within buffer
+	uint32_t size; ///< Size of the region in bytes, rounded up to the offset alignment
+	void* mapping; ///< CPU pointer to the start of the region
+	NvVkUniformRegion() : buffer(VK_NULL_HANDLE), offset(0), size(0), mapping(NULL) {}
+};
+
+/// Usage statistics of an NvVkUniformAllocator
+struct NvVkUniformStats {
+	VkDeviceSize ringSize; ///< Size of the uniform buffer
+	VkDeviceSize highWaterMark; ///< Most bytes ever in flight at once
+	VkDeviceSize totalBytes; ///< Bytes handed out
+	uint32_t allocCount; ///< Number of successful allocations
+	uint32_t failedCount; ///< Allocations that did not fit
+	uint32_t flushCount; ///< Number of flushes issued
+	NvVkUniformStats() : ringSize(0), highWaterMark(0), totalBytes(0), allocCount(0), failedCount(0), flushCount(0) {}
+};
+
+/// A per-frame linear allocator of transient uniform data.
+/// All regions come from one persistently-mapped buffer, so a single dynamic
+/// uniform descriptor can address every one of them via its dynamic offset.
+/// Allocation is a pointer bump; the writes of a frame are flushed with one
+/// call before the frame is submitted, and the frame's space is reclaimed once
+/// its fence has signalled.  Data must be re-written every frame it is used in
+class NvVkUniformAllocator {
+public:
+	/// Default size of the buffer
+	enum { DEFAULT_RING_SIZE = 4 * 1024 * 1024 };
+
+	/// Returns the buffer all regions are allocated from
+	VkBuffer getBuffer() {
+		return mBuffer();
 	}
 
+	/// Returns the alignment of every region's offset
+	uint32_t getAlignment() const { return mAlignment; }
+
+	/// Reserves uniform memory for the frame being recorded.  The caller
+	/// writes to region.mapping; no flush is needed
+	/// \param[in] sz the number of bytes to reserve
+	/// \param[out] region the reserved region
+	/// \return true on success, false if the frames in flight use the whole buffer
+	bool alloc(uint32_t sz, NvVkUniformRegion& region);
+
+	/// Reserves uniform memory for the frame being recorded and copies data into it
+	/// \param[in] sz the number of bytes to copy
+	/// \param[in] data the source data
+	/// \param[out] region the filled region
+	/// \return true on success
+	bool append(uint32_t sz, const void* data, NvVkUniformRegion& region);
+
+	/// Makes all writes since the last flush visible to the device; called by the
+	/// context before any submission
+	void flush();
+
+	/// Prepares the buffer
+	/// \param[in] vk the owning context
+	/// \param[in] frameCount the number of frames the context keeps in flight
+	/// \param[in] ringSize the size of the buffer in bytes
+	void init(NvVkContext* vk, uint32_t frameCount, uint32_t ringSize = DEFAULT_RING_SIZE);
+
 	void deinit();
 
-	NvVkStagingBuffer() : mVk(NULL), mAllocated(0), mUsed(0), mBuffer() {}
-	~NvVkStagingBuffer() {
+	/// Marks the end of the allocations done for a frame slot; call before the frame's fence is submitted
+	void endFrame(uint32_t slot);
+
+	/// Releases the allocations of a frame slot; call once the slot's fence has signalled
+	void retireFrame(uint32_t slot);
+
+	/// Releases all allocations; the queue must be idle
+	void retireAll();
+
+	/// Retrieves the usage statistics of the allocator
+	const NvVkUniformStats& getStats() const { return mStats; }
+
+	NvVkUniformAllocator() : mVk(NULL), mBuffer(), mMapping(NULL), mAllocated(0), mAlignment(256), mHead(0), mTail(0), mFlushed(0) {}
+	~NvVkUniformAllocator() {
 		deinit();
 	}
 
@@ -166,8 +333,34 @@ private:
 	NvVkContext* mVk;
 	NvVkBuffer   mBuffer;
 	char*        mMapping;
-	size_t       mUsed;
-	size_t       mAllocated;
+	uint32_t     mAllocated;
+	uint32_t     mAlignment;
+	// head, tail and flushed are monotonic; the buffer offset is the value modulo mAllocated
+	uint64_t     mHead;
+	uint64_t     mTail;
+	uint64_t     mFlushed;
+	std::vector<uint64_t> mFrameEnds; ///< Head at the end of each frame slot
+	NvVkUniformStats mStats;
+};
+
+/// Identifies a batch of queued uploads; see NvVkContext::uploadTexture
+typedef uint64_t NvVkUploadTicket;
+
+/// Size limits of one texture passed to NvVkContext::uploadTexture.  A texture
+/// that exceeds them drops its largest mip levels until it fits
+struct NvVkTextureLimits {
+	uint32_t maxDimension; ///< Largest width or height to upload; 0 for no limit
+	VkDeviceSize maxBytes; ///< Most texel bytes to upload; 0 for no limit
+	NvVkTextureLimits(uint32_t dimension = 0, VkDeviceSize bytes = 0) : maxDimension(dimension), maxBytes(bytes) {}
+};
+
+/// Texture memory accounting of an NvVkContext; see NvVkContext::setTextureBudget
+struct NvVkTextureStats {
+	VkDeviceSize residentBytes; ///< Device memory held by live textures created by uploadTexture
+	VkDeviceSize highWaterMark; ///< Most bytes ever resident at once
+	VkDeviceSize savedBytes; ///< Texel bytes of the levels dropped to fit the limits
+	uint32_t reducedCount; ///< Textures uploaded below their full resolution
+	NvVkTextureStats() : residentBytes(0), highWaterMark(0), savedBytes(0), reducedCount(0) {}
 };
 
 /// A wrapper for all forms of render target
@@ -252,9 +445,25 @@ public:
 		_queue(NULL),
 		_queueFamilyIndex(0),
 		_queueIndex(0),
+		mPipelineCache(VK_NULL_HANDLE),
+		mPipelineCacheLoadedBytes(0),
+		mShaderCacheHits(0),
+		mShaderCacheMisses(0),
+		mCompletedSerial(0),
+		mTempCmdBufferCount(0),
+		mTempCmdBufferRequests(0),
+		mNextUploadTicket(1),
+		mCompletedUploadTicket(0),
+		mTextureMaxDimension(0),
+		mTextureBudgetBytes(0),
+		m_profiler(NULL),
 		mSupportsDebugMarkers(false)
 	{ }
 
+	/// Releases the uniform ring, the staging ring and every memory block while
+	/// the device is still alive
+	virtual ~NvVkContext();
+
 	/// VkInstance access
 	VkInstance instance() { return _instance; }
 
@@ -290,31 +499,148 @@ public:
 	/// Get the on-screen (or main) render target
 	virtual NvVkRenderTarget* mainRenderTarget() = 0;
 
-	VkResult allocMemAndBindImage(NvVkImage& image, VkFlags memProps = 0);
+	VkResult allocMemAndBindImage(NvVkImage& image, VkFlags memProps = 0, bool linear = false);
 	VkResult createImage(VkImageCreateInfo& info, NvVkImage& image, VkFlags memProps = 0);
 
 	VkResult allocMemAndBindBuffer(NvVkBuffer& buffer, VkFlags memProps = 0);
 	VkResult createAndFillBuffer(size_t size, VkFlags usage, VkFlags memProps, NvVkBuffer& buffer, const void* data = NULL, NvVkStagingBuffer* staging = NULL);
 
-	/// Creates a texture from an asset-based DDS file
+	/// Destroys the VkBuffer and returns its memory to the allocator
+	void destroyBuffer(NvVkBuffer& buffer);
+
+	/// Destroys the VkImage and returns its memory to the allocator
+	void destroyImage(NvVkImage& image);
+
+	/// Returns a sub-allocation to the allocator; the resource bound to it must already be destroyed
+	void freeMemory(NvVkAllocation& mem) { mAllocator.free(mem); }
+
+	/// Flushes a CPU-written range of a host visible buffer.  A no-op for coherent memory
+	/// \param[in] buffer the buffer to flush
+	/// \param[in] offset the offset of the range within the buffer
+	/// \param[in] size the size of the range in bytes
+	VkResult flushBuffer(NvVkBuffer& buffer, VkDeviceSize offset, VkDeviceSize size) { return mAllocator.flush(buffer.mem, offset, size); }
+
+	/// Device memory sub-allocator used by all buffers and images created through the context
+	NvVkMemoryAllocator& memoryAllocator() { return mAllocator; }
+
+	/// Pipeline cache to pass to every vkCreate*Pipelines call
+	/// \return the context's pipeline cache
+	VkPipelineCache pipelineCache() { return mPipelineCache; }
+
+	/// Writes the pipeline cache to the configured pipelineCacheFile.  The data is
+	/// written to a temporary file that then replaces the old one, so a crash
+	/// can never leave a truncated cache behind
+	/// \return true on success and false on failure
+	bool savePipelineCache();
+
+	/// Size of the pipeline cache data accepted from disk at startup; zero if
+	/// there was no file or it was created by a different device or driver
+	size_t pipelineCacheLoadedBytes() const { return mPipelineCacheLoadedBytes; }
+
+	/// Creates a texture from an asset-based DDS file.  The upload is queued; see #uploadTexture
 	/// \param[in] filename the asset-path of the DDS file to load
 	/// \param[out] tex the loaded texture
+	/// \param[out] ticket if non-NULL, receives the ticket of the upload
+	/// \param[in] limits if non-NULL, size limits of this texture; see #uploadTexture
 	/// \return true on success and false on failure
-	bool uploadTextureFromDDSFile(const char* filename, NvVkTexture& tex);
+	bool uploadTextureFromDDSFile(const char* filename, NvVkTexture& tex, NvVkUploadTicket* ticket = NULL,
+		const NvVkTextureLimits* limits = NULL);
 
-	/// Creates a texture from preloaded data in DDS file format
+	/// Creates a texture from preloaded data in DDS file format.  The upload is queued; see #uploadTexture
 	/// \param[in] ddsData pointer to the DDS file data to load
 	/// \param[out] tex the loaded texture
+	/// \param[out] ticket if non-NULL, receives the ticket of the upload
+	/// \param[in] limits if non-NULL, size limits of this texture; see #uploadTexture
 	/// \return true on success and false on failure
-	bool uploadTextureFromDDSData(const char* ddsData, int32_t length, NvVkTexture& tex);
-
-	/// Creates a texture from an in-memory NvImage
+	bool uploadTextureFromDDSData(const char* ddsData, int32_t length, NvVkTexture& tex, NvVkUploadTicket* ticket = NULL,
+		const NvVkTextureLimits* limits = NULL);
+
+	/// Creates a texture from an in-memory NvImage.
+	/// The image data is copied to the staging ring immediately, so the NvImage may be
+	/// deleted on return, but the transfer itself is only queued.  Queued uploads are
+	/// recorded into a single command buffer and submitted by #submitUploads, which
+	/// also happens implicitly before any temp command buffer or frame is submitted,
+	/// so queue order guarantees the texture is ready before it can be used.
+	/// Textures larger than the given limits or those of #setTextureBudget drop
+	/// their largest mip levels, which are simply not staged; uncompressed
+	/// images without enough levels are filtered down instead
 	/// \param[in] image the image to load
 	/// \param[out] tex the loaded texture
+	/// \param[out] ticket if non-NULL, receives the ticket of the upload
+	/// \param[in] limits if non-NULL, size limits of this texture, applied
+	/// along with the global ones
+	/// \return true on success and false on failure
+	bool uploadTexture(const NvImage* image, NvVkTexture& tex, NvVkUploadTicket* ticket = NULL,
+		const NvVkTextureLimits* limits = NULL);
+
+	/// Sets limits applied to every texture created by #uploadTexture and the
+	/// DDS upload functions
+	/// \param[in] maxDimension the largest width or height to upload; 0 for no limit
+	/// \param[in] budgetBytes the device memory all live textures may hold
+	/// together.  A new texture is reduced until its texels fit in what the
+	/// live ones leave free, down to its smallest level.  0 for no budget
+	void setTextureBudget(uint32_t maxDimension, VkDeviceSize budgetBytes) {
+		mTextureMaxDimension = maxDimension;
+		mTextureBudgetBytes = budgetBytes;
+	}
+
+	/// Texture memory resident and saved by the limits
+	const NvVkTextureStats& textureStats() const { return mTextureStats; }
+
+	/// Writes #textureStats to the log
+	void logTextureStats() const;
+
+	/// Queues the upload of a range of an NvImage's mip levels into an existing image.
+	/// As with #uploadTexture, the level data is copied to the staging ring immediately
+	/// and the transfer is recorded by #submitUploads.  The previous contents of the
+	/// destination levels are discarded, so the GPU must not be using them; other
+	/// levels of the image are left untouched and may be sampled meanwhile
+	/// \param[in] image the source image
+	/// \param[in] dst the image to upload to; it must have the format and layer count of the source
+	/// \param[in] srcLevel the first level of the source image to upload
+	/// \param[in] dstLevel the level of dst that receives srcLevel
+	/// \param[in] levelCount the number of levels to upload
+	/// \param[out] ticket if non-NULL, receives the ticket of the upload
 	/// \return true on success and false on failure
-	bool uploadTexture(const NvImage* image, NvVkTexture& tex);
+	bool uploadTextureLevels(const NvImage* image, NvVkImage& dst, uint32_t srcLevel, uint32_t dstLevel,
+		uint32_t levelCount, NvVkUploadTicket* ticket = NULL);
+
+	/// Returns the Vulkan format used for textures created from an NvImage
+	/// \param[in] image the image
+	/// \return the format, or VK_FORMAT_UNDEFINED if the image's format is not supported
+	static VkFormat getTextureFormat(const NvImage& image);
+
+	/// Returns whether images of a format can be created with optimal tiling
+	/// and sampled on this device
+	/// \param[in] format the format to query
+	/// \return true if the format can be sampled, false if not
+	bool isTextureFormatSupported(VkFormat format);
+
+	/// Chooses between uploading DXT, BC6H and BC7 DDS textures as they are and
+	/// expanding them as they load, and sets NvImage's DXT expansion to match.
+	/// Textures are uploaded as they are when the device was created with
+	/// textureCompressionBC and can sample every one of the formats
+	/// \return true if the textures will be uploaded as they are, false if
+	/// they will be expanded
+	bool configureTextureExpansion();
+
+	/// Records and submits all queued texture uploads as one batch, whose ticket
+	/// the uploads were handed when they were queued
+	/// \return the ticket of the submitted batch, or the last ticket if nothing was queued
+	NvVkUploadTicket submitUploads();
+
+	/// Polls whether the uploads of a ticket have completed on the GPU.  Never blocks
+	/// \param[in] ticket the ticket to query
+	/// \return true if the batch has completed
+	bool isUploadComplete(NvVkUploadTicket ticket);
+
+	/// Blocks until the uploads of a ticket have completed, submitting them if needed
+	/// \param[in] ticket the ticket to wait for
+	/// \return true on success and false on failure
+	bool waitForUpload(NvVkUploadTicket ticket);
 
-	/// Deprecated: Only supported on platforms/drivers that can accept GLSL directly
+	/// Deprecated: Only supported on platforms/drivers that can accept GLSL directly.
+	/// Modules come from the context's shader module cache; see #releaseShaders
 	uint32_t createShadersFromSourceString(const std::string& sourceText, VkPipelineShaderStageCreateInfo* shaders, uint32_t maxShaders);
 
 	/// Load SPIR-V shaders from binary file data (generated from the glsl2spirv tool)
@@ -324,8 +650,23 @@ public:
 	/// Array must be at least as large as the number of shader stages in the file
 	/// \param[in] maxShaders the number of shader structs in the array
 	/// \return the number of shader stages loaded, or zero on failure.
+	/// Modules come from the context's shader module cache, so loading the same code
+	/// again returns the same VkShaderModule; see #releaseShaders
 	uint32_t createShadersFromBinaryBlob(uint32_t* data, uint32_t leng, VkPipelineShaderStageCreateInfo* shaders, uint32_t maxShaders);
 
+	/// Drops the references taken by createShadersFrom*.  A module is destroyed once
+	/// its last reference is released, which is safe as soon as the pipelines using
+	/// it have been created
+	/// \param[in] shaders the stages returned by createShadersFrom*
+	/// \param[in] count the number of stages
+	void releaseShaders(const VkPipelineShaderStageCreateInfo* shaders, uint32_t count);
+
+	/// Number of shader stages served from the shader module cache
+	uint32_t shaderCacheHits() const { return mShaderCacheHits; }
+
+	/// Number of shader stages that had to create a new VkShaderModule
+	uint32_t shaderCacheMisses() const { return mShaderCacheMisses; }
+
 	VkResult transitionImageLayout(VkImage& image, VkImageAspectFlags aspect,
 		VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlagBits inSrcAccessmask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT,
 		VkAccessFlagBits inDstAccessmask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
@@ -344,23 +685,36 @@ public:
 
 	VkCommandBuffer   createCmdBuffer(VkCommandPool pool, bool primary);
 
+	/// Releases all one-shot command buffers and the memory of their pools.
+	/// Idles the queue, so only use it where a hitch does not matter
 	void purgeTempCmdBuffers() {
-		vkDeviceWaitIdle(_device);
+		vkQueueWaitIdle(queue());
 		for (int f = 0; f < MAX_BUFFERED_FRAMES; f++){
 			FrameInfo& frame = mFrames[f];
-			if (!frame.mSubmittedTempCmdBuffers.empty()){
-				vkFreeCommandBuffers(_device, mTempCmdPool, 
-					(uint32_t)frame.mSubmittedTempCmdBuffers.size(), &frame.mSubmittedTempCmdBuffers[0]);
-				frame.mSubmittedTempCmdBuffers.clear();
+			if (!frame.mTempCmdBuffers.empty()){
+				vkFreeCommandBuffers(_device, frame.mTempCmdPool,
+					(uint32_t)frame.mTempCmdBuffers.size(), &frame.mTempCmdBuffers[0]);
+				frame.mTempCmdBuffers.clear();
 			}
+			if (frame.mTempCmdPool != VK_NULL_HANDLE)
+				vkResetCommandPool(_device, frame.mTempCmdPool, VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT);
+			frame.mTempCmdBuffersUsed = 0;
 			frame.mOpen = false;
 		}
-		mCurrFrameIndex = 0;
+		mStaging.retireAll();
+		mUniforms.retireAll();
+		// Everything submitted so far is complete; serials keep increasing
+		mCompletedSerial = mCurrFrameIndex;
 	}
 
+	/// Returns a primary command buffer in the recording state for one-shot work.
+	/// The buffer belongs to the current frame and is recycled along with the
+	/// frame's command pool; submit it with #doneWithTempCmdBufferSubmit
 	VkCommandBuffer beginTempCmdBuffer()
 	{
-		VkCommandBuffer cmd = createCmdBuffer(mTempCmdPool, true);
+		VkCommandBuffer cmd = acquireTempCmdBuffer();
+		if (!cmd)
+			return 0;
 
 		// Record the commands.
 		VkCommandBufferInheritanceInfo inheritInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
@@ -376,6 +730,10 @@ public:
 	}
 
 	VkResult doneWithTempCmdBufferSubmit(VkCommandBuffer& cmd, VkFence* fence = NULL) {
+		// Queued uploads go first, so the work in cmd can rely on them
+		submitUploads();
+		mUniforms.flush();
+
 		VkResult result;
 		result = vkEndCommandBuffer(cmd);
 		if (result != VK_SUCCESS) {
@@ -390,37 +748,65 @@ public:
 		if (result != VK_SUCCESS)
 			return result;
 
-		doneWithTempCmdBuffer(cmd);
 		return VK_SUCCESS;
 	}
 
+	/// Kept for callers that submit temp command buffers themselves; buffers
+	/// from #beginTempCmdBuffer are tracked by their frame, so nothing is left to do
 	void doneWithTempCmdBuffer(VkCommandBuffer& cmd) {
-		int current = mCurrFrameIndex % MAX_BUFFERED_FRAMES;
-		mFrames[current].mSubmittedTempCmdBuffers.push_back(cmd);
 	}
 
-	void destroyPastFrameCmdBuffers()
-	{
-		int current = mCurrFrameIndex % MAX_BUFFERED_FRAMES;
-		int past = (mCurrFrameIndex + 1) % MAX_BUFFERED_FRAMES;
-
-		if (mCurrFrameIndex < MAX_BUFFERED_FRAMES){
-			return;
-		}
+	/// Number of one-shot command buffers ever allocated
+	uint32_t tempCmdBufferCount() const { return mTempCmdBufferCount; }
 
-		// not exactly efficient, should do per pool processing
-		std::vector<VkCommandBuffer>& pastCmds = mFrames[past].mSubmittedTempCmdBuffers;
-		if (pastCmds.size())
-			vkFreeCommandBuffers(_device, mTempCmdPool, (uint32_t)pastCmds.size(),	&pastCmds[0]);
-		pastCmds.clear();
-	}
+	/// Number of one-shot command buffers handed out
+	uint32_t tempCmdBufferRequests() const { return mTempCmdBufferRequests; }
 
 	NvVkStagingBuffer& stagingBuffer() {
 		return mStaging;
 	}
 
+	/// Returns the per-frame allocator of transient uniform data
+	NvVkUniformAllocator& uniformAllocator() {
+		return mUniforms;
+	}
+
+	enum {
+		/// The number of frames the CPU records ahead of the GPU.  The frame
+		/// this many serials back has retired once its slot is reused
+		MAX_BUFFERED_FRAMES = 2
+	};
+
+	/// Serial of the frame currently being recorded.  Serials start at 1 and
+	/// increase by one with every frame submitted by nextFrame, so zero never
+	/// refers to GPU work
+	uint64_t currentSubmissionSerial() const { return mCurrFrameIndex + 1; }
+
+	/// Polls whether the GPU has finished the frame with the given serial.  Never blocks
+	/// \param[in] serial the frame serial, as returned by #currentSubmissionSerial
+	/// \return true if the frame has completed
+	bool isSubmissionComplete(uint64_t serial);
+
+	/// Blocks until the GPU has finished the frame with the given serial
+	/// \param[in] serial the frame serial, as returned by #currentSubmissionSerial
+	/// \return true on success; false if the frame has not been submitted yet, as waiting would deadlock
+	bool waitForSubmission(uint64_t serial);
+
 	NvGPUTimerVK& getFrameTimer() { return *m_frameTimer; }
 
+	/// Returns the hierarchical GPU profiler; it is disabled until setEnabled(true)
+	NvGPUProfilerVK& gpuProfiler() { return *m_profiler; }
+
+	/// Opens a named scope: a debug marker region and, when the GPU profiler is
+	/// enabled and cmd is the frame's main command buffer, a timed profiler scope
+	/// \param[in] cmd the command buffer to record into
+	/// \param[in] name the name of the scope
+	void beginScope(VkCommandBuffer cmd, const char* name) const;
+
+	/// Closes the innermost scope opened with #beginScope
+	/// \param[in] cmd the command buffer to record into
+	void endScope(VkCommandBuffer cmd) const;
+
 	/// \privatesection
 	bool nextFrame();
 
@@ -515,12 +901,12 @@ public:
 			: _context(context)
 			, _cmd(cmd)
 		{
-			_context.debugMarkerBegin(_cmd, name);
+			_context.beginScope(_cmd, name);
 		}
 
 		~DebugMarkerScope()
 		{
-			_context.debugMarkerEnd(_cmd);
+			_context.endScope(_cmd);
 
 		}
 
@@ -532,12 +918,12 @@ private:
 
 
 protected:
-	enum {
-		MAX_BUFFERED_FRAMES = 2
-	};
-
 	VkResult fillBuffer(NvVkStagingBuffer* staging, NvVkBuffer& buffer, size_t offset, size_t size, const void* data);
-	VkShaderModule createShader(const char* shaderSource, VkShaderStageFlagBits inStage);
+	bool createTexture(const NvImage* image, int32_t firstLevel, NvVkTexture& tex, NvVkUploadTicket* ticket);
+	void retireUploads();
+	VkCommandBuffer acquireTempCmdBuffer();
+	bool initPipelineCache();
+	VkShaderModule createShader(const void* code, size_t size, VkShaderStageFlagBits inStage);
 
 	virtual bool reshape(int32_t& w, int32_t& h);
 
@@ -563,17 +949,69 @@ protected:
 
 	struct FrameInfo {
 		VkFence                      mFence;
-		std::vector<VkCommandBuffer> mSubmittedTempCmdBuffers;
+		uint64_t                     mSerial; ///< Serial of the frame mFence was last submitted for
+		VkCommandPool                mTempCmdPool; ///< Transient pool for the frame's one-shot command buffers
+		std::vector<VkCommandBuffer> mTempCmdBuffers; ///< Every buffer allocated from mTempCmdPool
+		uint32_t                     mTempCmdBuffersUsed; ///< Buffers handed out since the pool was reset
+		uint64_t                     mTempCmdSerial; ///< Serial of the frame the handed out buffers belong to
 		bool mOpen;
 		VkCommandBuffer mCmdBuffers;
 	};
 
 	FrameInfo mFrames[MAX_BUFFERED_FRAMES];
 	uint32_t mCurrFrameIndex;
+	uint64_t mCompletedSerial;
+	uint32_t mTempCmdBufferCount;
+	uint32_t mTempCmdBufferRequests;
 
+	NvVkMemoryAllocator mAllocator;
 	NvVkStagingBuffer mStaging;
+	NvVkUniformAllocator mUniforms;
+
+	// A texture upload waiting to be recorded by submitUploads
+	struct TextureUpload {
+		VkImage image;
+		VkBuffer buffer;
+		VkImageSubresourceRange range;
+		uint32_t firstRegion;
+		uint32_t regionCount;
+	};
+
+	struct UploadBatch {
+		NvVkUploadTicket ticket;
+		VkFence fence;
+	};
+
+	std::vector<TextureUpload> mPendingUploads;
+	std::vector<VkBufferImageCopy> mPendingUploadRegions;
+	std::vector<UploadBatch> mSubmittedUploads;
+	NvVkUploadTicket mNextUploadTicket;
+	NvVkUploadTicket mCompletedUploadTicket;
+
+	uint32_t mTextureMaxDimension;
+	VkDeviceSize mTextureBudgetBytes;
+	NvVkTextureStats mTextureStats;
+	std::map<VkImage, VkDeviceSize> mTextureBytes; ///< Memory of each live texture, released by destroyImage
 
 	NvGPUTimerVK* m_frameTimer;
+	NvGPUProfilerVK* m_profiler;
+
+	VkPipelineCache mPipelineCache;
+	size_t mPipelineCacheLoadedBytes;
+
+	struct ShaderModuleEntry {
+		VkShaderModule module;
+		uint32_t refCount;
+		VkShaderStageFlagBits stage;
+		std::vector<uint8_t> code; ///< Copy of the code, compared on a hit so that a hash collision never shares a module
+	};
+
+	// keyed by a hash of the stage and the shader code; a colliding module
+	// takes the next free key
+	std::map<uint64_t, ShaderModuleEntry> mShaderModules;
+	std::map<VkShaderModule, uint64_t> mShaderModuleKeys;
+	uint32_t mShaderCacheHits;
+	uint32_t mShaderCacheMisses;
 	
 	// extension and layer queries
 	std::vector<VkExtensionProperties> mInstanceExtensionsProperties;
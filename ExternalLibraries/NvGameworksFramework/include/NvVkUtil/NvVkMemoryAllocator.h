@@ -0,0 +1,130 @@
+//----------------------------------------------------------------------------------
+// File:        NvVkUtil/NvVkMemoryAllocator.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef NV_VKMEMORYALLOCATOR_H
+#define NV_VKMEMORYALLOCATOR_H
+
+/// \file
+/// Block-based sub-allocation of Vulkan device memory.
+
+#include <NvSimpleTypes.h>
+#include "NvPlatformVK.h"
+#include <vector>
+
+class NvVkMemoryBlock;
+
+/// A range of device memory handed out by NvVkMemoryAllocator.
+/// The VkDeviceMemory is shared with other allocations and owned by the allocator,
+/// so resources must be bound at #offset and never free #mem directly
+struct NvVkAllocation {
+	VkDeviceMemory mem; ///< Memory object of the block containing the allocation
+	VkDeviceSize offset; ///< Offset of the allocation within mem
+	VkDeviceSize size; ///< Size of the allocation in bytes
+	void* mapped; ///< Persistent CPU pointer to the allocation, or NULL if not host visible
+	NvVkMemoryBlock* block; ///< Opaque handle of the block the allocation came from
+	NvVkAllocation() : mem(VK_NULL_HANDLE), offset(0), size(0), mapped(NULL), block(NULL) {}
+};
+
+/// Memory usage of one VkMemoryHeap
+struct NvVkMemoryHeapStats {
+	VkDeviceSize blockBytes; ///< Bytes allocated from the driver
+	VkDeviceSize usedBytes; ///< Bytes handed out to resources
+	uint32_t blockCount; ///< Live VkDeviceMemory objects
+	uint32_t allocationCount; ///< Live sub-allocations
+	NvVkMemoryHeapStats() : blockBytes(0), usedBytes(0), blockCount(0), allocationCount(0) {}
+};
+
+/// Sub-allocates buffers and images out of large per-memory-type blocks.
+/// Host visible blocks are persistently mapped when they are created.
+/// Linear and optimal-tiling resources are kept in separate blocks whenever
+/// bufferImageGranularity is larger than one byte, so neighbouring
+/// resources can never alias a granularity page.
+/// Not thread safe; all calls must come from the thread owning the NvVkContext
+class NvVkMemoryAllocator {
+public:
+	NvVkMemoryAllocator();
+	~NvVkMemoryAllocator();
+
+	/// Default size of a block; heaps smaller than 8 blocks get proportionally smaller ones
+	enum { DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024 };
+
+	/// Prepares the allocator for use with a device
+	/// \param[in] device the device to allocate from
+	/// \param[in] memProps the memory properties of the physical device
+	/// \param[in] limits the limits of the physical device
+	void init(VkDevice device, const VkPhysicalDeviceMemoryProperties& memProps, const VkPhysicalDeviceLimits& limits);
+
+	/// Frees every block.  All resources bound to allocations must already be destroyed
+	void deinit();
+
+	/// Sub-allocates memory satisfying the given requirements
+	/// \param[in] reqs the requirements of the resource, as returned by vkGet*MemoryRequirements
+	/// \param[in] memProps the required VkMemoryPropertyFlags
+	/// \param[in] linear true for buffers and linear-tiled images, false for optimal-tiled images
+	/// \param[out] allocation the resulting allocation
+	/// \return VK_SUCCESS on success or the error of the failing call
+	VkResult alloc(const VkMemoryRequirements& reqs, VkFlags memProps, bool linear, NvVkAllocation& allocation);
+
+	/// Returns an allocation to its block and resets it; coalesces with free neighbours
+	void free(NvVkAllocation& allocation);
+
+	/// Flushes a CPU-written range of a host visible allocation.  A no-op for coherent memory
+	/// \param[in] allocation the allocation to flush
+	/// \param[in] offset the offset of the range relative to the start of the allocation
+	/// \param[in] size the size of the range in bytes
+	VkResult flush(const NvVkAllocation& allocation, VkDeviceSize offset, VkDeviceSize size);
+
+	/// Retrieves the current usage of a memory heap
+	void getHeapStats(uint32_t heapIndex, NvVkMemoryHeapStats& stats) const;
+
+	/// Logs the usage of every heap that has live blocks
+	void logStats() const;
+
+private:
+	uint32_t findMemoryType(uint32_t typeBits, VkFlags memProps) const;
+	VkDeviceSize blockSizeForType(uint32_t memoryTypeIndex) const;
+	NvVkMemoryBlock* createBlock(uint32_t memoryTypeIndex, uint32_t pool, VkDeviceSize size, bool dedicated);
+	void destroyBlock(NvVkMemoryBlock* block);
+
+	VkDevice mDevice;
+	VkPhysicalDeviceMemoryProperties mMemProps;
+	VkDeviceSize mBufferImageGranularity;
+	VkDeviceSize mNonCoherentAtomSize;
+	uint32_t mMaxAllocationCount;
+	uint32_t mDeviceAllocationCount;
+
+	// two pools per memory type: linear resources then optimal-tiled images
+	std::vector<NvVkMemoryBlock*> mPools[VK_MAX_MEMORY_TYPES * 2];
+};
+
+#endif
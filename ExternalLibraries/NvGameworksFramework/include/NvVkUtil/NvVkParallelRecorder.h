@@ -0,0 +1,143 @@
+//----------------------------------------------------------------------------------
+// File:        NvVkUtil/NvVkParallelRecorder.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef NV_VK_PARALLEL_RECORDER_H
+#define NV_VK_PARALLEL_RECORDER_H
+
+#include <NvSimpleTypes.h>
+#include "NvVkUtil/NvVkContext.h"
+#include "NvAppBase/NvThread.h"
+#include <vector>
+
+/// \file
+/// Multithreaded recording of secondary command buffers.
+
+/// Records a list of draws into secondary command buffers on several threads.
+/// The list is cut into one contiguous slice per thread; the calling thread
+/// records the first slice while worker threads record the rest, and the
+/// secondaries are then executed into the primary command buffer in list order.
+/// Every thread has its own command pools, one per frame in flight, which are
+/// reset as a whole once the frame that used them has retired
+class NvVkParallelRecorder {
+public:
+	/// Work to be recorded in parallel
+	class Job {
+	public:
+		virtual ~Job() { }
+
+		/// Records a slice of the item list.  Called concurrently from several
+		/// threads, so it may only touch state that is private to the slice or
+		/// read-only for the duration of the recording
+		/// \param[in] cmd the secondary command buffer to record into; it is
+		/// already begun and inherits the render pass, subpass and framebuffer
+		/// \param[in] first the index of the first item of the slice
+		/// \param[in] count the number of items in the slice
+		/// \param[in] slice the index of the slice, which is also the index of the recording thread
+		virtual void record(VkCommandBuffer cmd, uint32_t first, uint32_t count, uint32_t slice) = 0;
+	};
+
+	NvVkParallelRecorder();
+	~NvVkParallelRecorder();
+
+	/// Starts the worker threads
+	/// \param[in] vk the context whose device and frame serials are used
+	/// \param[in] threads the platform thread manager; if NULL, everything is recorded on the calling thread
+	/// \param[in] workerCount the number of threads to start in addition to the calling thread
+	/// \return true on success and false on failure
+	bool init(NvVkContext& vk, NvThreadManager* threads, uint32_t workerCount);
+
+	/// Stops the worker threads and releases the command pools; the GPU must
+	/// be done with all recorded command buffers
+	void deinit();
+
+	/// Returns the number of threads that record, including the calling thread
+	uint32_t threadCount() const { return (uint32_t)mThreads.size(); }
+
+	/// Records a list of items in parallel and executes the results into a primary command buffer
+	/// \param[in] primary the command buffer to execute the secondaries in.  It must be inside
+	/// a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+	/// \param[in] inheritance the render pass, subpass and framebuffer of primary
+	/// \param[in] itemCount the number of items to record
+	/// \param[in] job the recording callback
+	/// \param[in] minItemsPerSlice slices are never cut smaller than this, so short lists use fewer threads
+	/// \return true on success and false on failure
+	bool record(VkCommandBuffer primary, const VkCommandBufferInheritanceInfo& inheritance,
+		uint32_t itemCount, Job& job, uint32_t minItemsPerSlice = 1);
+
+protected:
+	// One pool per frame the context buffers, so a slot comes back around as
+	// the frame that last used it is retired
+	enum { FRAME_SLOTS = NvVkContext::MAX_BUFFERED_FRAMES };
+
+	// Command pools and buffers owned by one recording thread
+	struct ThreadState {
+		NvVkParallelRecorder* owner;
+		uint32_t index;
+		NvThread* thread;
+		VkCommandPool pools[FRAME_SLOTS];
+		std::vector<VkCommandBuffer> buffers[FRAME_SLOTS];
+		uint32_t used[FRAME_SLOTS];
+		uint64_t serials[FRAME_SLOTS];
+		VkCommandBuffer cmd; ///< Secondary of the current job
+		uint64_t generation; ///< Last job seen by the worker
+	};
+
+#ifdef _WIN32
+	static DWORD WINAPI workerEntry(LPVOID arg);
+#else
+	static void* workerEntry(void* arg);
+#endif
+	void workerLoop(ThreadState& state);
+	VkCommandBuffer acquireBuffer(ThreadState& state, uint64_t serial);
+	bool recordSlice(ThreadState& state);
+
+	NvVkContext* mVk;
+	NvThreadManager* mThreadManager;
+	std::vector<ThreadState*> mThreads;
+
+	NvMutex* mMutex;
+	NvConditionVariable* mWorkCond;
+	NvConditionVariable* mDoneCond;
+	uint64_t mGeneration; ///< Incremented to hand out a job
+	uint32_t mDoneCount; ///< Workers finished with the current job
+	bool mQuit;
+
+	// The job being recorded
+	Job* mJob;
+	const VkCommandBufferInheritanceInfo* mInheritance;
+	uint32_t mItemCount;
+	uint32_t mSliceCount;
+	bool mFailed;
+};
+
+#endif // NV_VK_PARALLEL_RECORDER_H
@@ -0,0 +1,223 @@
+//----------------------------------------------------------------------------------
+// File:        NvVkUtil/NvVkTextureManager.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef NV_VK_TEXTURE_MANAGER_H
+#define NV_VK_TEXTURE_MANAGER_H
+
+#include <NvSimpleTypes.h>
+#include "NvVkUtil/NvVkTextureStreamer.h"
+#include "NvAppBase/NvThread.h"
+#include <map>
+#include <string>
+#include <vector>
+
+/// \file
+/// Shared, budgeted texture residency with least recently used eviction.
+
+class NvImage;
+class NvVkTextureManager;
+
+/// A texture owned by an NvVkTextureManager and shared by everything that acquired it
+/// by name.  Its image and view change when the texture is evicted, reloaded or gains
+/// streamed levels; descriptors that reference it must be rewritten whenever
+/// #getViewVersion changes.  The NvVkTexture returned by #getTexture stays at the same
+/// address for the lifetime of the texture and always holds the current image and view
+class NvVkManagedTexture {
+public:
+	/// The view to sample
+	VkImageView getView() const { return mTexture.view; }
+
+	/// Incremented every time the view is replaced
+	uint32_t getViewVersion() const { return mViewVersion; }
+
+	/// The current image and view; owned by the manager and must not be destroyed
+	NvVkTexture& getTexture() { return mTexture; }
+
+	/// The asset path the texture was acquired with
+	const std::string& getName() const { return mName; }
+
+	/// Whether only the mip tail is resident, because the texture was evicted
+	bool isEvicted() const { return mEvicted; }
+
+	/// The last frame the texture was marked used in; see NvVkTextureManager::markUsed
+	uint64_t getLastUsedFrame() const { return mLastUsedFrame; }
+
+private:
+	friend class NvVkTextureManager;
+
+	NvVkManagedTexture();
+	~NvVkManagedTexture();
+
+	std::string mName;
+	NvVkStreamingTexture* mStream; ///< Streamed image the texture currently shows
+	NvImage* mTail; ///< Copy of the mip tail that evictions shrink to; NULL if all of the texture is tail
+	NvVkTexture mTexture; ///< Copy of mStream's texture at a fixed address
+	uint32_t mViewVersion;
+	uint32_t mRefCount;
+	uint64_t mLastUsedFrame;
+	bool mEvicted;
+	bool mLoading; ///< A reload has been requested and not yet finished
+	bool mLoadFailed; ///< The last reload failed, so it is not requested again
+};
+
+/// Texture memory accounting of an NvVkTextureManager
+struct NvVkTextureManagerStats {
+	VkDeviceSize residentBytes; ///< Device memory held by the managed textures
+	uint32_t textureCount; ///< Live textures
+	uint32_t evictedCount; ///< Live textures that are evicted to their mip tail
+	uint32_t evictions; ///< Textures evicted so far
+	uint32_t reloads; ///< Evicted textures reloaded so far
+	NvVkTextureManagerStats() : residentBytes(0), textureCount(0), evictedCount(0), evictions(0), reloads(0) {}
+};
+
+/// Central owner of DDS textures shared by name, which keeps them within a device
+/// memory budget.  Users mark the textures they draw with every frame; when the
+/// textures exceed the budget, those unused for the longest are evicted down to
+/// their mip tail, which is kept in system memory so eviction needs no loading.
+/// An evicted texture marked used again is reloaded from its file, on a loader
+/// thread if a thread manager is given, and its larger levels are then streamed
+/// smallest first by the manager's NvVkTextureStreamer.  Recently used textures
+/// are never evicted, so a working set larger than the budget exceeds it
+/// rather than being reloaded every frame
+class NvVkTextureManager {
+public:
+	/// Number of frames a texture must go unused before it may be evicted
+	enum { DEFAULT_IDLE_FRAMES = 3 };
+
+	NvVkTextureManager();
+	~NvVkTextureManager();
+
+	/// Prepares the manager and starts the loader thread
+	/// \param[in] vk the context to upload through
+	/// \param[in] budgetBytes the device memory all managed textures may hold together; 0 for no budget
+	/// \param[in] threads the platform thread manager; if NULL, reloads are done on the calling
+	/// thread by #update, one per frame
+	/// \param[in] frameBudget the number of bytes of level data streamed per frame
+	/// \param[in] tailSize the width or height, whichever is larger, of the largest level
+	/// an evicted texture keeps
+	/// \return true on success and false on failure
+	bool init(NvVkContext& vk, VkDeviceSize budgetBytes, NvThreadManager* threads = NULL,
+		size_t frameBudget = NvVkTextureStreamer::DEFAULT_FRAME_BUDGET,
+		uint32_t tailSize = NvVkTextureStreamer::DEFAULT_TAIL_SIZE);
+
+	/// Stops the loader thread and destroys every texture; the GPU must be done with them
+	void deinit();
+
+	/// Sets the device memory all managed textures may hold together; 0 for no budget.
+	/// It is enforced by the next #update
+	void setBudget(VkDeviceSize bytes) { mBudget = bytes; }
+
+	/// Returns the device memory all managed textures may hold together
+	VkDeviceSize getBudget() const { return mBudget; }
+
+	/// Sets the number of frames a texture must go unused before it may be evicted
+	void setIdleFrames(uint32_t frames) { mIdleFrames = frames; }
+
+	/// Returns a texture loaded from an asset-based DDS file, sharing it if the file is
+	/// already loaded.  A newly loaded texture counts as unused, so loading many
+	/// textures at once stays within the budget
+	/// \param[in] filename the asset-path of the DDS file to load
+	/// \return the texture, or NULL on failure.  Each successful call must be
+	/// matched by a call to #release
+	NvVkManagedTexture* acquire(const char* filename);
+
+	/// Releases a texture returned by #acquire, destroying it once the last user has released
+	/// it and the frames that may have used it have completed
+	/// \param[in] tex the texture to release
+	void release(NvVkManagedTexture* tex);
+
+	/// Records that a texture is used in the current frame, and requests a reload if it is evicted
+	/// \param[in] tex the texture to mark
+	void markUsed(NvVkManagedTexture* tex);
+
+	/// Advances the frame; call once per frame, before descriptors are written for it.
+	/// Replaces evicted textures whose reloads have finished, evicts the least recently
+	/// used textures while the budget is exceeded and streams more levels
+	/// \return the number of textures whose view changed
+	uint32_t update();
+
+	/// Returns the current frame, as recorded by #markUsed
+	uint64_t getFrame() const { return mFrame; }
+
+	/// Texture memory and eviction counters
+	const NvVkTextureManagerStats& getStats() const { return mStats; }
+
+	/// Writes #getStats to the log
+	void logStats() const;
+
+	/// The streamer that uploads the managed textures
+	NvVkTextureStreamer& getStreamer() { return mStreamer; }
+
+private:
+	// A file read handed to the loader
+	struct LoadRequest {
+		NvVkManagedTexture* tex; ///< Texture to reload; NULL once it has been released
+		std::string name;
+		NvImage* image; ///< Loaded image, a view of data; NULL on failure
+		char* data;
+	};
+
+#ifdef _WIN32
+	static DWORD WINAPI loaderEntry(LPVOID arg);
+#else
+	static void* loaderEntry(void* arg);
+#endif
+	void loaderLoop();
+	static void load(LoadRequest& request);
+	void finishLoad(LoadRequest* request);
+	bool evict(NvVkManagedTexture* tex);
+	void enforceBudget();
+	void replaceStream(NvVkManagedTexture* tex, NvVkStreamingTexture* stream);
+	VkDeviceSize residentBytes() const;
+	void updateStats();
+
+	NvVkContext* mVk;
+	NvVkTextureStreamer mStreamer;
+	VkDeviceSize mBudget;
+	uint32_t mIdleFrames;
+	uint64_t mFrame;
+	uint32_t mChangedCount; ///< Views replaced since the last #update
+	NvVkTextureManagerStats mStats;
+	std::map<std::string, NvVkManagedTexture*> mTextures;
+
+	NvThreadManager* mThreadManager;
+	NvThread* mLoader;
+	NvMutex* mMutex;
+	NvConditionVariable* mLoadCond;
+	bool mQuit;
+	std::vector<LoadRequest*> mQueued; ///< Requests not yet picked up by the loader
+	LoadRequest* mActive; ///< Request being loaded
+	std::vector<LoadRequest*> mLoaded; ///< Requests waiting for #update
+};
+
+#endif // NV_VK_TEXTURE_MANAGER_H
@@ -0,0 +1,199 @@
+//----------------------------------------------------------------------------------
+// File:        NvVkUtil/NvVkTextureStreamer.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef NV_VK_TEXTURE_STREAMER_H
+#define NV_VK_TEXTURE_STREAMER_H
+
+#include <NvSimpleTypes.h>
+#include "NvVkUtil/NvVkContext.h"
+#include <vector>
+
+/// \file
+/// Progressive, mip-tail-first texture uploads.
+
+class NvImage;
+class NvVkTextureStreamer;
+
+/// A texture whose mip levels are uploaded smallest first by an NvVkTextureStreamer.
+/// Its view covers only the levels that are resident, so the texture can be sampled
+/// as soon as its mip tail has been queued and gains detail as larger levels arrive.
+/// The view is replaced every time it widens; descriptors that reference it must be
+/// rewritten whenever #getViewVersion changes.  Replaced views are destroyed once the
+/// frames that may have used them have completed
+class NvVkStreamingTexture {
+public:
+	/// The view over the resident levels
+	VkImageView getView() const { return mTexture.view; }
+
+	/// Incremented every time the view is replaced
+	uint32_t getViewVersion() const { return mViewVersion; }
+
+	/// The underlying image and current view
+	NvVkTexture& getTexture() { return mTexture; }
+
+	/// The most detailed level of the source image that can be sampled
+	uint32_t getResidentLevel() const { return mResidentLevel; }
+
+	/// The most detailed level of the source image that is streamed at all;
+	/// it is level 0 of the Vulkan image
+	uint32_t getTopLevel() const { return mTopLevel; }
+
+	/// Whether every level down to #getTopLevel is resident
+	bool isFullyResident() const { return mResidentLevel == mTopLevel; }
+
+private:
+	friend class NvVkTextureStreamer;
+
+	NvVkStreamingTexture();
+	~NvVkStreamingTexture();
+
+	struct LevelUpload {
+		uint32_t level; ///< Source level
+		NvVkUploadTicket ticket;
+	};
+
+	NvImage* mImage; ///< Source of the levels still to be queued; freed once all are
+	char* mFileData; ///< Asset data mImage is a view of, if any
+	NvVkTexture mTexture;
+	VkFormat mFormat;
+	bool mCubeMap;
+	uint32_t mLevelCount; ///< Levels of the source image
+	uint32_t mTopLevel;
+	uint32_t mQueuedLevel; ///< Most detailed level queued for upload
+	uint32_t mResidentLevel;
+	uint32_t mViewVersion;
+	uint64_t mDestroySerial; ///< Frame after which a destroyed texture can be released
+	std::vector<LevelUpload> mUploads; ///< Levels in flight, in upload order
+};
+
+/// Streams the mip levels of textures to the GPU within a per-frame byte budget.
+/// A new texture gets its mip tail (the levels no larger than the tail size)
+/// uploaded at once and is usable immediately; #update then queues the larger
+/// levels, smallest first across all textures so detail improves evenly, and
+/// widens each texture's view once the levels have finished uploading.  Textures
+/// may be capped to a maximum size, in which case the larger levels are neither
+/// uploaded nor allocated
+class NvVkTextureStreamer {
+public:
+	/// Default number of bytes queued per frame
+	enum { DEFAULT_FRAME_BUDGET = 4 * 1024 * 1024 };
+
+	/// Default size of the largest level uploaded with the mip tail
+	enum { DEFAULT_TAIL_SIZE = 128 };
+
+	NvVkTextureStreamer();
+	~NvVkTextureStreamer();
+
+	/// Prepares the streamer
+	/// \param[in] vk the context to upload through
+	/// \param[in] frameBudget the number of bytes of level data queued per frame
+	/// \param[in] tailSize the width or height, whichever is larger, of the largest
+	/// level uploaded when a texture is created
+	void init(NvVkContext& vk, size_t frameBudget = DEFAULT_FRAME_BUDGET,
+		uint32_t tailSize = DEFAULT_TAIL_SIZE);
+
+	/// Destroys every texture; the GPU must be done with them
+	void deinit();
+
+	/// Sets the number of bytes of level data queued per frame.  A level larger than
+	/// the budget is queued on its own in a frame, so every texture still completes
+	void setFrameBudget(size_t bytes) { mFrameBudget = bytes; }
+
+	/// Returns the number of bytes of level data queued per frame
+	size_t getFrameBudget() const { return mFrameBudget; }
+
+	/// Creates a streaming texture from an image.  Only 2D textures and cube maps are supported
+	/// \param[in] image the image to stream; the streamer takes ownership of it and
+	/// deletes it once every level has been queued, or on failure
+	/// \param[in] maxSize if non-zero, the width or height, whichever is larger, of
+	/// the most detailed level that is streamed; larger levels are skipped
+	/// \return the texture, or NULL on failure
+	NvVkStreamingTexture* createTexture(NvImage* image, uint32_t maxSize = 0);
+
+	/// Creates a streaming texture from an asset-based DDS file.  The image is a view
+	/// of the file data, which is kept until every level has been queued
+	/// \param[in] filename the asset-path of the DDS file to load
+	/// \param[in] maxSize if non-zero, the width or height, whichever is larger, of
+	/// the most detailed level that is streamed; larger levels are skipped
+	/// \return the texture, or NULL on failure
+	NvVkStreamingTexture* createTextureFromDDSFile(const char* filename, uint32_t maxSize = 0);
+
+	/// Creates a streaming texture from an image that is a view of asset data, as
+	/// loaded by NvImage::loadImageFromFileDataInPlace from NvAssetLoaderRead
+	/// \param[in] image the image to stream; the streamer takes ownership of it
+	/// \param[in] fileData the asset data the image is a view of; the streamer takes
+	/// ownership of it and frees it with NvAssetLoaderFree along with the image
+	/// \param[in] maxSize if non-zero, the width or height, whichever is larger, of
+	/// the most detailed level that is streamed; larger levels are skipped
+	/// \return the texture, or NULL on failure
+	NvVkStreamingTexture* createTextureFromFileData(NvImage* image, char* fileData, uint32_t maxSize = 0);
+
+	/// Stops streaming a texture and destroys it once the frames that may have used it have completed
+	/// \param[in] tex the texture to destroy
+	void destroyTexture(NvVkStreamingTexture* tex);
+
+	/// Advances streaming; call once per frame, before descriptors are written for it.
+	/// Publishes the levels whose uploads have completed, releases replaced views and
+	/// destroyed textures that are no longer in use and queues more levels within the
+	/// frame budget.  The queued levels are submitted with the frame
+	/// \return the number of textures whose view changed
+	uint32_t update();
+
+	/// Returns the number of bytes of level data not yet queued
+	size_t getPendingBytes() const;
+
+	/// Returns the size of the largest level uploaded when a texture is created
+	uint32_t getTailSize() const { return mTailSize; }
+
+private:
+	struct RetiredView {
+		VkImageView view;
+		uint64_t serial; ///< Frame after which the view is unused
+	};
+
+	NvVkStreamingTexture* create(NvImage* image, char* fileData, uint32_t maxSize);
+	bool queueNextLevel(NvVkStreamingTexture* tex);
+	bool createView(NvVkStreamingTexture* tex);
+	void releaseSource(NvVkStreamingTexture* tex);
+	void releaseTexture(NvVkStreamingTexture* tex);
+	uint32_t levelBytes(const NvVkStreamingTexture* tex, uint32_t level) const;
+
+	NvVkContext* mVk;
+	size_t mFrameBudget;
+	uint32_t mTailSize;
+	std::vector<NvVkStreamingTexture*> mTextures;
+	std::vector<NvVkStreamingTexture*> mDestroyed;
+	std::vector<RetiredView> mRetiredViews;
+};
+
+#endif
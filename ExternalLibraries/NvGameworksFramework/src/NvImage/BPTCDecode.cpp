@@ -0,0 +1,500 @@
+//----------------------------------------------------------------------------------
+// File:        NvImage/BPTCDecode.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include "BPTCDecode.h"
+
+using namespace nv;
+
+namespace
+{
+    /// Reads the fields of a 128-bit block in order, least significant bit first
+    class BlockBits
+    {
+    public:
+        BlockBits(const uint8_t* block) : m_lo(read64(block)), m_hi(read64(block + 8)), m_position(0) { }
+
+        /// Reads the next count bits, up to 32
+        uint32_t read(uint32_t count)
+        {
+            uint64_t bits;
+            if (m_position >= 64)
+                bits = m_hi >> (m_position - 64);
+            else if (m_position == 0)
+                bits = m_lo;
+            else
+                bits = (m_lo >> m_position) | (m_hi << (64 - m_position));
+            m_position += count;
+            return (uint32_t)(bits & ((1ull << count) - 1));
+        }
+
+        void skip(uint32_t count)
+        {
+            m_position += count;
+        }
+
+    private:
+        static uint64_t read64(const uint8_t* p)
+        {
+            uint64_t v = 0;
+            for (int32_t i = 7; i >= 0; i--)
+                v = (v << 8) | p[i];
+            return v;
+        }
+
+        uint64_t m_lo;
+        uint64_t m_hi;
+        uint32_t m_position;
+    };
+
+    // Subset of each texel for the 64 two-subset partitions, one bit per texel
+    const uint16_t PARTITIONS_2[64] = {
+        0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+        0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+        0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+        0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+        0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+        0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+        0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+        0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+    };
+
+    // Subset of each texel for the 64 three-subset partitions, two bits per texel
+    const uint32_t PARTITIONS_3[64] = {
+        0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+        0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+        0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+        0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+        0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+        0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+        0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+        0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254
+    };
+
+    // Anchor texel of the second subset of each two-subset partition
+    const uint8_t ANCHORS_2[64] = {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+        15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+        15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+        6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15
+    };
+
+    // Anchor texels of the second and third subsets of each three-subset partition
+    const uint8_t ANCHORS_3A[64] = {
+        3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,
+        3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+        8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15,
+        3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3
+    };
+
+    const uint8_t ANCHORS_3B[64] = {
+        15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8,
+        15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+        15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,
+        15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8
+    };
+
+    const uint8_t WEIGHTS_2[4] = { 0, 21, 43, 64 };
+    const uint8_t WEIGHTS_3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+    const uint8_t WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    inline const uint8_t* indexWeights(uint32_t bits)
+    {
+        return (bits == 2) ? WEIGHTS_2 : ((bits == 3) ? WEIGHTS_3 : WEIGHTS_4);
+    }
+
+    inline int32_t interpolate(int32_t a, int32_t b, uint32_t weight)
+    {
+        return ((64 - (int32_t)weight) * a + (int32_t)weight * b + 32) >> 6;
+    }
+
+    /// Bit mask of the anchor texels, whose indices are stored one bit short
+    inline uint32_t anchorMask(uint32_t subsets, uint32_t partition)
+    {
+        if (subsets == 2)
+            return 1 | (1u << ANCHORS_2[partition]);
+        if (subsets == 3)
+            return 1 | (1u << ANCHORS_3A[partition]) | (1u << ANCHORS_3B[partition]);
+        return 1;
+    }
+
+    inline uint32_t subsetOf(uint32_t subsets, uint32_t partition, uint32_t texel)
+    {
+        if (subsets == 2)
+            return (PARTITIONS_2[partition] >> texel) & 1;
+        if (subsets == 3)
+            return (PARTITIONS_3[partition] >> (2 * texel)) & 3;
+        return 0;
+    }
+
+    struct BC7Mode
+    {
+        uint8_t subsets;
+        uint8_t partitionBits;
+        uint8_t rotationBits;
+        uint8_t selectorBits;       ///< picks which index set drives color in mode 4
+        uint8_t colorBits;
+        uint8_t alphaBits;          ///< 0 for opaque modes
+        uint8_t endpointPBits;      ///< one p-bit per endpoint
+        uint8_t sharedPBits;        ///< one p-bit per subset
+        uint8_t indexBits;
+        uint8_t secondaryIndexBits; ///< separate alpha (or color) indices in modes 4 and 5
+    };
+
+    const BC7Mode BC7_MODES[8] = {
+        { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+        { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+        { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+        { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+        { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+        { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+        { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+        { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+    };
+
+    /// Widens an endpoint component to 8 bits by replicating its high bits
+    inline uint32_t expandBits(uint32_t v, uint32_t bits)
+    {
+        v <<= 8 - bits;
+        return v | (v >> bits);
+    }
+
+    /// A run of bits of one BC6H endpoint component: the bits go to
+    /// [shift, shift + count) of component endpoint % 3 of endpoint endpoint / 3
+    struct BC6HField
+    {
+        uint8_t endpoint;
+        uint8_t shift;
+        uint8_t count;
+    };
+
+    struct BC6HMode
+    {
+        uint8_t regions;
+        bool transformed;           ///< endpoints after the first are deltas from it
+        uint8_t endpointBits;
+        uint8_t deltaBits[3];
+        uint8_t fieldCount;
+        BC6HField fields[24];
+    };
+
+    // The endpoint bit layout of each mode, in the order the bits are stored
+    const BC6HMode BC6H_MODES[14] = {
+        // mode 1 (00)
+        { 2, true, 10, { 5, 5, 5 }, 19, {
+            { 7, 4, 1 }, { 8, 4, 1 }, { 11, 4, 1 }, { 0, 0, 10 }, { 1, 0, 10 }, { 2, 0, 10 },
+            { 3, 0, 5 }, { 10, 4, 1 }, { 7, 0, 4 }, { 4, 0, 5 }, { 11, 0, 1 }, { 10, 0, 4 },
+            { 5, 0, 5 }, { 11, 1, 1 }, { 8, 0, 4 }, { 6, 0, 5 }, { 11, 2, 1 }, { 9, 0, 5 },
+            { 11, 3, 1 } } },
+        // mode 2 (01)
+        { 2, true, 7, { 6, 6, 6 }, 21, {
+            { 7, 5, 1 }, { 10, 4, 2 }, { 0, 0, 7 }, { 11, 0, 2 }, { 8, 4, 1 }, { 1, 0, 7 },
+            { 8, 5, 1 }, { 11, 2, 1 }, { 7, 4, 1 }, { 2, 0, 7 }, { 11, 3, 1 }, { 11, 5, 1 },
+            { 11, 4, 1 }, { 3, 0, 6 }, { 7, 0, 4 }, { 4, 0, 6 }, { 10, 0, 4 }, { 5, 0, 6 },
+            { 8, 0, 4 }, { 6, 0, 6 }, { 9, 0, 6 } } },
+        // mode 3 (00010)
+        { 2, true, 11, { 5, 4, 4 }, 18, {
+            { 0, 0, 10 }, { 1, 0, 10 }, { 2, 0, 10 }, { 3, 0, 5 }, { 0, 10, 1 }, { 7, 0, 4 },
+            { 4, 0, 4 }, { 1, 10, 1 }, { 11, 0, 1 }, { 10, 0, 4 }, { 5, 0, 4 }, { 2, 10, 1 },
+            { 11, 1, 1 }, { 8, 0, 4 }, { 6, 0, 5 }, { 11, 2, 1 }, { 9, 0, 5 }, { 11, 3, 1 } } },
+        // mode 4 (00110)
+        { 2, true, 11, { 4, 5, 4 }, 20, {
+            { 0, 0, 10 }, { 1, 0, 10 }, { 2, 0, 10 }, { 3, 0, 4 }, { 0, 10, 1 }, { 10, 4, 1 },
+            { 7, 0, 4 }, { 4, 0, 5 }, { 1, 10, 1 }, { 10, 0, 4 }, { 5, 0, 4 }, { 2, 10, 1 },
+            { 11, 1, 1 }, { 8, 0, 4 }, { 6, 0, 4 }, { 11, 0, 1 }, { 11, 2, 1 }, { 9, 0, 4 },
+            { 7, 4, 1 }, { 11, 3, 1 } } },
+        // mode 5 (01010)
+        { 2, true, 11, { 4, 4, 5 }, 19, {
+            { 0, 0, 10 }, { 1, 0, 10 }, { 2, 0, 10 }, { 3, 0, 4 }, { 0, 10, 1 }, { 8, 4, 1 },
+            { 7, 0, 4 }, { 4, 0, 4 }, { 1, 10, 1 }, { 11, 0, 1 }, { 10, 0, 4 }, { 5, 0, 5 },
+            { 2, 10, 1 }, { 8, 0, 4 }, { 6, 0, 4 }, { 11, 1, 2 }, { 9, 0, 4 }, { 11, 4, 1 },
+            { 11, 3, 1 } } },
+        // mode 6 (01110)
+        { 2, true, 9, { 5, 5, 5 }, 19, {
+            { 0, 0, 9 }, { 8, 4, 1 }, { 1, 0, 9 }, { 7, 4, 1 }, { 2, 0, 9 }, { 11, 4, 1 },
+            { 3, 0, 5 }, { 10, 4, 1 }, { 7, 0, 4 }, { 4, 0, 5 }, { 11, 0, 1 }, { 10, 0, 4 },
+            { 5, 0, 5 }, { 11, 1, 1 }, { 8, 0, 4 }, { 6, 0, 5 }, { 11, 2, 1 }, { 9, 0, 5 },
+            { 11, 3, 1 } } },
+        // mode 7 (10010)
+        { 2, true, 8, { 6, 5, 5 }, 18, {
+            { 0, 0, 8 }, { 10, 4, 1 }, { 8, 4, 1 }, { 1, 0, 8 }, { 11, 2, 1 }, { 7, 4, 1 },
+            { 2, 0, 8 }, { 11, 3, 2 }, { 3, 0, 6 }, { 7, 0, 4 }, { 4, 0, 5 }, { 11, 0, 1 },
+            { 10, 0, 4 }, { 5, 0, 5 }, { 11, 1, 1 }, { 8, 0, 4 }, { 6, 0, 6 }, { 9, 0, 6 } } },
+        // mode 8 (10110)
+        { 2, true, 8, { 5, 6, 5 }, 21, {
+            { 0, 0, 8 }, { 11, 0, 1 }, { 8, 4, 1 }, { 1, 0, 8 }, { 7, 5, 1 }, { 7, 4, 1 },
+            { 2, 0, 8 }, { 10, 5, 1 }, { 11, 4, 1 }, { 3, 0, 5 }, { 10, 4, 1 }, { 7, 0, 4 },
+            { 4, 0, 6 }, { 10, 0, 4 }, { 5, 0, 5 }, { 11, 1, 1 }, { 8, 0, 4 }, { 6, 0, 5 },
+            { 11, 2, 1 }, { 9, 0, 5 }, { 11, 3, 1 } } },
+        // mode 9 (11010)
+        { 2, true, 8, { 5, 5, 6 }, 21, {
+            { 0, 0, 8 }, { 11, 1, 1 }, { 8, 4, 1 }, { 1, 0, 8 }, { 8, 5, 1 }, { 7, 4, 1 },
+            { 2, 0, 8 }, { 11, 5, 1 }, { 11, 4, 1 }, { 3, 0, 5 }, { 10, 4, 1 }, { 7, 0, 4 },
+            { 4, 0, 5 }, { 11, 0, 1 }, { 10, 0, 4 }, { 5, 0, 6 }, { 8, 0, 4 }, { 6, 0, 5 },
+            { 11, 2, 1 }, { 9, 0, 5 }, { 11, 3, 1 } } },
+        // mode 10 (11110)
+        { 2, false, 6, { 6, 6, 6 }, 22, {
+            { 0, 0, 6 }, { 10, 4, 1 }, { 11, 0, 2 }, { 8, 4, 1 }, { 1, 0, 6 }, { 7, 5, 1 },
+            { 8, 5, 1 }, { 11, 2, 1 }, { 7, 4, 1 }, { 2, 0, 6 }, { 10, 5, 1 }, { 11, 3, 1 },
+            { 11, 5, 1 }, { 11, 4, 1 }, { 3, 0, 6 }, { 7, 0, 4 }, { 4, 0, 6 }, { 10, 0, 4 },
+            { 5, 0, 6 }, { 8, 0, 4 }, { 6, 0, 6 }, { 9, 0, 6 } } },
+        // mode 11 (00011)
+        { 1, false, 10, { 10, 10, 10 }, 6, {
+            { 0, 0, 10 }, { 1, 0, 10 }, { 2, 0, 10 }, { 3, 0, 10 }, { 4, 0, 10 }, { 5, 0, 10 } } },
+        // mode 12 (00111)
+        { 1, true, 11, { 9, 9, 9 }, 9, {
+            { 0, 0, 10 }, { 1, 0, 10 }, { 2, 0, 10 }, { 3, 0, 9 }, { 0, 10, 1 }, { 4, 0, 9 },
+            { 1, 10, 1 }, { 5, 0, 9 }, { 2, 10, 1 } } },
+        // mode 13 (01011)
+        { 1, true, 12, { 8, 8, 8 }, 12, {
+            { 0, 0, 10 }, { 1, 0, 10 }, { 2, 0, 10 }, { 3, 0, 8 }, { 0, 11, 1 }, { 0, 10, 1 },
+            { 4, 0, 8 }, { 1, 11, 1 }, { 1, 10, 1 }, { 5, 0, 8 }, { 2, 11, 1 }, { 2, 10, 1 } } },
+        // mode 14 (01111)
+        { 1, true, 16, { 4, 4, 4 }, 24, {
+            { 0, 0, 10 }, { 1, 0, 10 }, { 2, 0, 10 }, { 3, 0, 4 }, { 0, 15, 1 }, { 0, 14, 1 },
+            { 0, 13, 1 }, { 0, 12, 1 }, { 0, 11, 1 }, { 0, 10, 1 }, { 4, 0, 4 }, { 1, 15, 1 },
+            { 1, 14, 1 }, { 1, 13, 1 }, { 1, 12, 1 }, { 1, 11, 1 }, { 1, 10, 1 }, { 5, 0, 4 },
+            { 2, 15, 1 }, { 2, 14, 1 }, { 2, 13, 1 }, { 2, 12, 1 }, { 2, 11, 1 }, { 2, 10, 1 } } },
+    };
+
+    // Mode of each value of the low five bits of a block; the two-bit modes
+    // repeat and the reserved modes are -1
+    const int8_t BC6H_MODE_INDEX[32] = {
+        0, 1, 2, 10, 0, 1, 3, 11, 0, 1, 4, 12, 0, 1, 5, 13,
+        0, 1, 6, -1, 0, 1, 7, -1, 0, 1, 8, -1, 0, 1, 9, -1
+    };
+
+    inline int32_t signExtend(uint32_t v, uint32_t bits)
+    {
+        uint32_t sign = 1u << (bits - 1);
+        return (int32_t)((v ^ sign) - sign);
+    }
+
+    /// Scales an endpoint to the full 16-bit range the palette is built in
+    inline int32_t unquantize(int32_t v, uint32_t bits, bool isSigned)
+    {
+        if (!isSigned) {
+            if (bits >= 15 || v == 0)
+                return v;
+            if (v == (1 << bits) - 1)
+                return 0xFFFF;
+            return ((v << 16) + 0x8000) >> bits;
+        }
+
+        if (bits >= 16)
+            return v;
+
+        bool negative = v < 0;
+        if (negative)
+            v = -v;
+
+        int32_t u;
+        if (v == 0)
+            u = 0;
+        else if (v >= (1 << (bits - 1)) - 1)
+            u = 0x7FFF;
+        else
+            u = ((v << 15) + 0x4000) >> (bits - 1);
+
+        return negative ? -u : u;
+    }
+
+    /// Scales an interpolated value to the bits of a half float
+    inline uint16_t finishHalf(int32_t v, bool isSigned)
+    {
+        if (!isSigned)
+            return (uint16_t)((v * 31) >> 6);
+        if (v < 0)
+            return (uint16_t)(0x8000 | ((-v * 31) >> 5));
+        return (uint16_t)((v * 31) >> 5);
+    }
+}
+
+void nv::decodeBC7(const uint8_t* block, uint32_t texels[16])
+{
+    uint32_t mode = 0;
+    while (mode < 8 && !(block[0] & (1 << mode)))
+        mode++;
+
+    if (mode == 8) {
+        for (uint32_t i = 0; i < 16; i++)
+            texels[i] = 0;
+        return;
+    }
+
+    const BC7Mode& m = BC7_MODES[mode];
+    BlockBits bits(block);
+    bits.skip(mode + 1);
+
+    uint32_t partition = bits.read(m.partitionBits);
+    uint32_t rotation = bits.read(m.rotationBits);
+    uint32_t selector = bits.read(m.selectorBits);
+
+    // two RGBA endpoints per subset, stored channel by channel
+    uint32_t endpoints[6][4];
+    uint32_t endpointCount = 2 * m.subsets;
+    for (uint32_t c = 0; c < 3; c++) {
+        for (uint32_t e = 0; e < endpointCount; e++)
+            endpoints[e][c] = bits.read(m.colorBits);
+    }
+    for (uint32_t e = 0; e < endpointCount; e++)
+        endpoints[e][3] = m.alphaBits ? bits.read(m.alphaBits) : 0xFF;
+
+    uint32_t colorBits = m.colorBits;
+    uint32_t alphaBits = m.alphaBits;
+    if (m.endpointPBits || m.sharedPBits) {
+        uint32_t pbits[6];
+        for (uint32_t e = 0; e < endpointCount; e++) {
+            if (m.endpointPBits || !(e & 1))
+                pbits[e] = bits.read(1);
+            else
+                pbits[e] = pbits[e - 1];
+        }
+
+        for (uint32_t e = 0; e < endpointCount; e++) {
+            for (uint32_t c = 0; c < (alphaBits ? 4u : 3u); c++)
+                endpoints[e][c] = (endpoints[e][c] << 1) | pbits[e];
+        }
+        colorBits++;
+        if (alphaBits)
+            alphaBits++;
+    }
+
+    for (uint32_t e = 0; e < endpointCount; e++) {
+        for (uint32_t c = 0; c < 3; c++)
+            endpoints[e][c] = expandBits(endpoints[e][c], colorBits);
+        if (alphaBits)
+            endpoints[e][3] = expandBits(endpoints[e][3], alphaBits);
+    }
+
+    uint32_t anchors = anchorMask(m.subsets, partition);
+    uint32_t indices[16];
+    uint32_t secondaryIndices[16];
+    for (uint32_t i = 0; i < 16; i++)
+        indices[i] = bits.read(m.indexBits - ((anchors >> i) & 1));
+    if (m.secondaryIndexBits) {
+        for (uint32_t i = 0; i < 16; i++)
+            secondaryIndices[i] = bits.read(m.secondaryIndexBits - (i == 0));
+    }
+
+    // modes 4 and 5 interpolate alpha with the second index set, or in mode 4
+    // with the selector set, color
+    const uint32_t* colorIndices = indices;
+    const uint32_t* alphaIndices = indices;
+    const uint8_t* colorWeights = indexWeights(m.indexBits);
+    const uint8_t* alphaWeights = colorWeights;
+    if (m.secondaryIndexBits) {
+        if (selector) {
+            colorIndices = secondaryIndices;
+            colorWeights = indexWeights(m.secondaryIndexBits);
+        } else {
+            alphaIndices = secondaryIndices;
+            alphaWeights = indexWeights(m.secondaryIndexBits);
+        }
+    }
+
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t s = subsetOf(m.subsets, partition, i);
+        const uint32_t* e0 = endpoints[2 * s];
+        const uint32_t* e1 = endpoints[2 * s + 1];
+        uint32_t cw = colorWeights[colorIndices[i]];
+        uint32_t aw = alphaWeights[alphaIndices[i]];
+
+        uint32_t rgba[4];
+        rgba[0] = interpolate(e0[0], e1[0], cw);
+        rgba[1] = interpolate(e0[1], e1[1], cw);
+        rgba[2] = interpolate(e0[2], e1[2], cw);
+        rgba[3] = interpolate(e0[3], e1[3], aw);
+
+        // rotation swaps alpha with one of the color channels
+        if (rotation) {
+            uint32_t t = rgba[3];
+            rgba[3] = rgba[rotation - 1];
+            rgba[rotation - 1] = t;
+        }
+
+        texels[i] = rgba[0] | (rgba[1] << 8) | (rgba[2] << 16) | (rgba[3] << 24);
+    }
+}
+
+void nv::decodeBC6H(const uint8_t* block, bool isSigned, uint16_t texels[64])
+{
+    int32_t modeIndex = BC6H_MODE_INDEX[block[0] & 0x1F];
+
+    if (modeIndex < 0) {
+        for (uint32_t i = 0; i < 16; i++) {
+            texels[4 * i + 0] = 0;
+            texels[4 * i + 1] = 0;
+            texels[4 * i + 2] = 0;
+            texels[4 * i + 3] = 0x3C00;
+        }
+        return;
+    }
+
+    const BC6HMode& m = BC6H_MODES[modeIndex];
+    BlockBits bits(block);
+    bits.skip((modeIndex < 2) ? 2 : 5);
+
+    // the stored endpoint components, w, x, y and z, three each
+    uint32_t fields[12] = { 0 };
+    for (uint32_t f = 0; f < m.fieldCount; f++)
+        fields[m.fields[f].endpoint] |= bits.read(m.fields[f].count) << m.fields[f].shift;
+
+    uint32_t partition = (m.regions == 2) ? bits.read(5) : 0;
+    uint32_t endpointCount = 2 * m.regions;
+    uint32_t mask = (1u << m.endpointBits) - 1;
+
+    int32_t endpoints[4][3];
+    for (uint32_t c = 0; c < 3; c++) {
+        for (uint32_t e = 0; e < endpointCount; e++) {
+            uint32_t v = fields[3 * e + c];
+            if (e && m.transformed)
+                v = (fields[c] + signExtend(v, m.deltaBits[c])) & mask;
+
+            int32_t value = isSigned ? signExtend(v, m.endpointBits) : (int32_t)v;
+            endpoints[e][c] = unquantize(value, m.endpointBits, isSigned);
+        }
+    }
+
+    uint32_t indexBits = (m.regions == 2) ? 3 : 4;
+    const uint8_t* weights = indexWeights(indexBits);
+    uint32_t anchors = anchorMask(m.regions, partition);
+
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t weight = weights[bits.read(indexBits - ((anchors >> i) & 1))];
+        uint32_t s = subsetOf(m.regions, partition, i);
+        for (uint32_t c = 0; c < 3; c++)
+            texels[4 * i + c] = finishHalf(interpolate(endpoints[2 * s][c], endpoints[2 * s + 1][c], weight), isSigned);
+        texels[4 * i + 3] = 0x3C00;
+    }
+}
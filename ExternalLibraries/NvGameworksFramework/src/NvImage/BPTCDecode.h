@@ -0,0 +1,59 @@
+//----------------------------------------------------------------------------------
+// File:        NvImage/BPTCDecode.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_IMAGE_BPTCDECODE_H
+#define NV_IMAGE_BPTCDECODE_H
+
+#include <NvSimpleTypes.h>
+
+namespace nv
+{
+    /// Decodes a BC7 block to 16 RGBA8 texels in row order, laid out as
+    /// Color32 (red in the low byte).  Blocks with the reserved mode decode
+    /// to transparent black
+    /// \param[in] block the 16-byte block
+    /// \param[out] texels the decoded texels
+    void decodeBC7(const uint8_t* block, uint32_t texels[16]);
+
+    /// Decodes a BC6H block to 16 RGBA16F texels in row order, four halfs
+    /// per texel with an alpha of 1.  Blocks with a reserved mode decode to
+    /// opaque black
+    /// \param[in] block the 16-byte block
+    /// \param[in] isSigned true for BC6H_SF16 blocks, false for BC6H_UF16
+    /// \param[out] texels the decoded texels
+    void decodeBC6H(const uint8_t* block, bool isSigned, uint16_t texels[64]);
+
+} // nv namespace
+
+#endif // NV_IMAGE_BPTCDECODE_H
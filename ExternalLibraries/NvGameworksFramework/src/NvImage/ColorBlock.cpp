@@ -41,6 +41,14 @@ ColorBlock::ColorBlock()
 {
 }
 
+/// Init the color block from an array of 16 colors, in row order.
+ColorBlock::ColorBlock(const uint32_t * linearImage)
+{
+    for(uint32_t i = 0; i < 16; i++) {
+        color(i) = Color32(linearImage[i]);
+    }
+}
+
 /// Init the color block with the contents of the given block.
 ColorBlock::ColorBlock(const ColorBlock & block)
 {
@@ -45,6 +45,7 @@ namespace nv
     public:
         Color32() { }
         Color32(const Color32 & c) : u(c.u) { }
+        Color32 & operator=(const Color32 & c) { u = c.u; return *this; }
         Color32(uint8_t R, uint8_t G, uint8_t B) { setRGBA(R, G, B, 0xFF); }
         Color32(uint8_t R, uint8_t G, uint8_t B, uint8_t A) { setRGBA( R, G, B, A); }
         explicit Color32(uint32_t U) : u(U) { }
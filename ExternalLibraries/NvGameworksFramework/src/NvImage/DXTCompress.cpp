@@ -0,0 +1,580 @@
+//----------------------------------------------------------------------------------
+// File:        NvImage/DXTCompress.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "DXTCompress.h"
+#include "BlockDXT.h"
+#include "NV/NvParallel.h"
+
+using namespace nv;
+
+namespace
+{
+    // Surfaces are split into bands of about this many texels
+    const int32_t BAND_TEXELS = 16 * 1024;
+
+    // Images with fewer texels than this are compressed on the calling thread
+    const int32_t THREADED_TEXELS = 64 * 1024;
+
+    // BC1 texels with alpha below this are encoded as transparent
+    const uint32_t ALPHA_THRESHOLD = 128;
+
+    /// A band of block rows of one surface.  Rows are counted through all of
+    /// the surface's slices
+    struct BlockBand
+    {
+        const BlockSurface* surface;
+        int32_t firstRow;
+        int32_t rowCount;
+    };
+
+    inline int32_t minInt(int32_t a, int32_t b)
+    {
+        return (a < b) ? a : b;
+    }
+
+    inline int32_t clampByte(float v)
+    {
+        int32_t i = (int32_t)(v + 0.5f);
+        return (i < 0) ? 0 : ((i > 255) ? 255 : i);
+    }
+
+    inline uint32_t square(int32_t v)
+    {
+        return (uint32_t)(v * v);
+    }
+
+    inline uint32_t colorDistance(const Color32& a, const Color32& b)
+    {
+        return square(a.r - b.r) + square(a.g - b.g) + square(a.b - b.b);
+    }
+
+    /// Rounds an 888 color to 565
+    inline uint16_t to565(int32_t r, int32_t g, int32_t b)
+    {
+        return (uint16_t)((((r * 31 + 127) / 255) << 11) | (((g * 63 + 127) / 255) << 5) |
+            ((b * 31 + 127) / 255));
+    }
+
+    /// Loads the 4x4 block at (bx, by) of a slice, replicating the last row and
+    /// column of the surface into blocks that hang over its edge
+    void loadBlock(const BlockSurface& s, int32_t slice, int32_t bx, int32_t by, ColorBlock& block)
+    {
+        const uint32_t* plane = s.src + (size_t)slice * s.width * s.height;
+        for (int32_t y = 0; y < 4; y++) {
+            const uint32_t* row = plane + (size_t)minInt(4 * by + y, s.height - 1) * s.width;
+            for (int32_t x = 0; x < 4; x++)
+                block.color(x, y) = Color32(row[minInt(4 * bx + x, s.width - 1)]);
+        }
+    }
+
+    /// Orders two endpoints for four- or three-color mode, gives each texel
+    /// its nearest entry of the palette the decoder will build from them, and
+    /// returns the squared error.  Texels in the transparent mask get the
+    /// transparent entry of three-color mode
+    uint32_t fitColorIndices(const ColorBlock& block, uint32_t transparent, uint16_t c0, uint16_t c1,
+        bool threeColor, BlockDXT1& out)
+    {
+        if (threeColor ? (c0 > c1) : (c0 < c1)) {
+            uint16_t t = c0;
+            c0 = c1;
+            c1 = t;
+        }
+        out.col0.u = c0;
+        out.col1.u = c1;
+
+        // entry 3 of a three-color palette is transparent black
+        Color32 palette[4];
+        uint32_t usable = (out.evaluatePalette(palette) == 4) ? 4 : 3;
+
+        uint32_t error = 0;
+        uint32_t indices = 0;
+        for (uint32_t i = 0; i < 16; i++) {
+            uint32_t index = 3;
+            if (!(transparent & (1 << i))) {
+                uint32_t best = colorDistance(block.color(i), palette[0]);
+                index = 0;
+                for (uint32_t p = 1; p < usable; p++) {
+                    uint32_t d = colorDistance(block.color(i), palette[p]);
+                    if (d < best) {
+                        best = d;
+                        index = p;
+                    }
+                }
+                error += best;
+            }
+            indices |= index << (2 * i);
+        }
+        out.indices = indices;
+
+        return error;
+    }
+
+    inline uint32_t fitColorEndpoints(const ColorBlock& block, uint32_t transparent, const float e0[3],
+        const float e1[3], bool threeColor, BlockDXT1& out)
+    {
+        return fitColorIndices(block, transparent,
+            to565(clampByte(e0[0]), clampByte(e0[1]), clampByte(e0[2])),
+            to565(clampByte(e1[0]), clampByte(e1[1]), clampByte(e1[2])), threeColor, out);
+    }
+
+    /// Endpoints on the diagonal of the colors' bounding box that follows
+    /// their correlation, inset by 1/16 of the range to offset the rounding of
+    /// the box corners
+    void boundingBoxEndpoints(const ColorBlock& block, uint32_t transparent, float e0[3], float e1[3])
+    {
+        int32_t lo[3] = { 255, 255, 255 };
+        int32_t hi[3] = { 0, 0, 0 };
+        int32_t sum[3] = { 0, 0, 0 };
+        int32_t count = 0;
+        for (uint32_t i = 0; i < 16; i++) {
+            if (transparent & (1 << i))
+                continue;
+            const Color32 c = block.color(i);
+            int32_t ch[3] = { c.r, c.g, c.b };
+            for (int32_t k = 0; k < 3; k++) {
+                lo[k] = (ch[k] < lo[k]) ? ch[k] : lo[k];
+                hi[k] = (ch[k] > hi[k]) ? ch[k] : hi[k];
+                sum[k] += ch[k];
+            }
+            count++;
+        }
+
+        // the sign of red and blue against green picks the diagonal
+        int32_t covRG = 0, covBG = 0;
+        for (uint32_t i = 0; i < 16; i++) {
+            if (transparent & (1 << i))
+                continue;
+            const Color32 c = block.color(i);
+            int32_t g = c.g * count - sum[1];
+            covRG += (c.r * count - sum[0]) * g / 16;
+            covBG += (c.b * count - sum[2]) * g / 16;
+        }
+
+        for (int32_t k = 0; k < 3; k++) {
+            float inset = (hi[k] - lo[k]) / 16.0f;
+            e0[k] = hi[k] - inset;
+            e1[k] = lo[k] + inset;
+        }
+        if (covRG < 0) {
+            float t = e0[0]; e0[0] = e1[0]; e1[0] = t;
+        }
+        if (covBG < 0) {
+            float t = e0[2]; e0[2] = e1[2]; e1[2] = t;
+        }
+    }
+
+    /// Endpoints at the extremes of the colors projected on their principal
+    /// axis, found by power iteration on the covariance matrix
+    void principalAxisEndpoints(const ColorBlock& block, uint32_t transparent, float e0[3], float e1[3])
+    {
+        float mean[3] = { 0.0f, 0.0f, 0.0f };
+        float count = 0.0f;
+        for (uint32_t i = 0; i < 16; i++) {
+            if (transparent & (1 << i))
+                continue;
+            const Color32 c = block.color(i);
+            mean[0] += c.r;
+            mean[1] += c.g;
+            mean[2] += c.b;
+            count += 1.0f;
+        }
+        for (int32_t k = 0; k < 3; k++)
+            mean[k] /= count;
+
+        float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        for (uint32_t i = 0; i < 16; i++) {
+            if (transparent & (1 << i))
+                continue;
+            const Color32 c = block.color(i);
+            float r = c.r - mean[0], g = c.g - mean[1], b = c.b - mean[2];
+            cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+            cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+        }
+
+        float axis[3] = { 1.0f, 1.0f, 1.0f };
+        for (int32_t iter = 0; iter < 8; iter++) {
+            float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+            float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+            float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+            float len = sqrtf(x * x + y * y + z * z);
+            if (len < 1e-6f)
+                break;
+            axis[0] = x / len;
+            axis[1] = y / len;
+            axis[2] = z / len;
+        }
+
+        float tMin = 1e9f, tMax = -1e9f;
+        for (uint32_t i = 0; i < 16; i++) {
+            if (transparent & (1 << i))
+                continue;
+            const Color32 c = block.color(i);
+            float t = (c.r - mean[0]) * axis[0] + (c.g - mean[1]) * axis[1] + (c.b - mean[2]) * axis[2];
+            tMin = (t < tMin) ? t : tMin;
+            tMax = (t > tMax) ? t : tMax;
+        }
+
+        for (int32_t k = 0; k < 3; k++) {
+            e0[k] = mean[k] + axis[k] * tMax;
+            e1[k] = mean[k] + axis[k] * tMin;
+        }
+    }
+
+    /// Solves for the endpoints that best reproduce the colors given the
+    /// palette index each texel already uses
+    /// \return false if the indices leave the endpoints undetermined
+    bool leastSquaresEndpoints(const ColorBlock& block, uint32_t transparent, const BlockDXT1& fit,
+        float e0[3], float e1[3])
+    {
+        static const float weights4[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+        static const float weights3[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+        bool fourColor = fit.isFourColorMode();
+        const float* weights = fourColor ? weights4 : weights3;
+
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[3] = { 0.0f, 0.0f, 0.0f };
+        float bx[3] = { 0.0f, 0.0f, 0.0f };
+        for (uint32_t i = 0; i < 16; i++) {
+            uint32_t index = (fit.indices >> (2 * i)) & 3;
+            if ((transparent & (1 << i)) || (!fourColor && index == 3))
+                continue;
+            const Color32 c = block.color(i);
+            float a = weights[index], b = 1.0f - a;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            ax[0] += a * c.r; ax[1] += a * c.g; ax[2] += a * c.b;
+            bx[0] += b * c.r; bx[1] += b * c.g; bx[2] += b * c.b;
+        }
+
+        float det = aa * bb - ab * ab;
+        if (fabsf(det) < 1e-6f)
+            return false;
+
+        for (int32_t k = 0; k < 3; k++) {
+            e0[k] = (ax[k] * bb - bx[k] * ab) / det;
+            e1[k] = (bx[k] * aa - ax[k] * ab) / det;
+        }
+        return true;
+    }
+
+    /// Compresses the color of a block.  Three-color mode is used for blocks
+    /// with transparent texels, and tried for opaque ones in quality mode
+    /// when allowed (BC1 only; BC3 decoders may ignore the endpoint order)
+    void compressColor(const ColorBlock& block, uint32_t transparent, bool highQuality,
+        bool allowThreeColor, BlockDXT1& out)
+    {
+        if (transparent == 0xFFFF) {
+            out.col0.u = 0;
+            out.col1.u = 0;
+            out.indices = 0xFFFFFFFF;
+            return;
+        }
+
+        bool threeColor = (transparent != 0);
+        float e0[3], e1[3];
+        boundingBoxEndpoints(block, transparent, e0, e1);
+        uint32_t error = fitColorEndpoints(block, transparent, e0, e1, threeColor, out);
+        if (!highQuality || error == 0)
+            return;
+
+        BlockDXT1 trial;
+        principalAxisEndpoints(block, transparent, e0, e1);
+        uint32_t trialError = fitColorEndpoints(block, transparent, e0, e1, threeColor, trial);
+        if (trialError < error) {
+            error = trialError;
+            out = trial;
+        }
+
+        for (int32_t mode = 0; mode < ((allowThreeColor && !threeColor) ? 2 : 1); mode++) {
+            bool tryThree = threeColor || (mode == 1);
+            BlockDXT1 current = out;
+            if (tryThree != threeColor) {
+                // re-fit the best endpoints so far in three-color mode
+                trialError = fitColorIndices(block, transparent, out.col0.u, out.col1.u, true, current);
+                if (trialError < error) {
+                    error = trialError;
+                    out = current;
+                }
+            }
+
+            for (int32_t iter = 0; iter < 3; iter++) {
+                if (!leastSquaresEndpoints(block, transparent, current, e0, e1))
+                    break;
+                trialError = fitColorEndpoints(block, transparent, e0, e1, tryThree, trial);
+                if (trialError >= error)
+                    break;
+                error = trialError;
+                out = trial;
+                current = trial;
+            }
+        }
+    }
+
+    /// Gives each value its nearest entry of the alpha palette the decoder will
+    /// build from a0 and a1 and returns the squared error.  a0 > a1 selects
+    /// the 8-value mode, otherwise the 6-value mode with 0 and 255
+    uint32_t fitAlphaIndices(const uint8_t values[16], uint32_t a0, uint32_t a1, AlphaBlockDXT5& out)
+    {
+        out.u = a0 | (a1 << 8);
+
+        uint8_t palette[8];
+        out.evaluatePalette(palette);
+
+        uint64_t bits = 0;
+        uint32_t error = 0;
+        for (uint32_t i = 0; i < 16; i++) {
+            uint32_t best = square(values[i] - palette[0]);
+            uint32_t index = 0;
+            for (uint32_t p = 1; p < 8 && best; p++) {
+                uint32_t d = square(values[i] - palette[p]);
+                if (d < best) {
+                    best = d;
+                    index = p;
+                }
+            }
+            bits |= (uint64_t)index << (16 + 3 * i);
+            error += best;
+        }
+        out.u |= bits;
+
+        return error;
+    }
+
+    /// Compresses 16 values of one channel into a DXT5 alpha (BC4) block
+    void compressAlpha(const uint8_t values[16], bool highQuality, AlphaBlockDXT5& out)
+    {
+        int32_t lo = 255, hi = 0;
+        for (uint32_t i = 0; i < 16; i++) {
+            lo = (values[i] < lo) ? values[i] : lo;
+            hi = (values[i] > hi) ? values[i] : hi;
+        }
+
+        uint32_t error = fitAlphaIndices(values, hi, lo, out);
+        if (!highQuality || error == 0)
+            return;
+
+        AlphaBlockDXT5 trial;
+
+        // pull the 8-value endpoints in a few steps from the extremes
+        int32_t step = (hi - lo + 15) / 16;
+        for (int32_t d0 = 0; d0 < 3; d0++) {
+            for (int32_t d1 = 0; d1 < 3; d1++) {
+                int32_t a0 = hi - d0 * step, a1 = lo + d1 * step;
+                if ((d0 == 0 && d1 == 0) || a0 <= a1)
+                    continue;
+                uint32_t trialError = fitAlphaIndices(values, a0, a1, trial);
+                if (trialError < error) {
+                    error = trialError;
+                    out = trial;
+                }
+            }
+        }
+
+        // the 6-value mode covers 0 and 255 for free, so its endpoints only
+        // need to span the other values
+        int32_t lo6 = 255, hi6 = 0;
+        for (uint32_t i = 0; i < 16; i++) {
+            if (values[i] != 0 && values[i] != 255) {
+                lo6 = (values[i] < lo6) ? values[i] : lo6;
+                hi6 = (values[i] > hi6) ? values[i] : hi6;
+            }
+        }
+        if (lo6 > hi6)
+            lo6 = hi6 = lo;
+        uint32_t trialError = fitAlphaIndices(values, lo6, hi6, trial);
+        if (trialError < error)
+            out = trial;
+    }
+
+    void compressBlock(BlockFormat format, bool highQuality, const ColorBlock& block, uint8_t* dst)
+    {
+        uint8_t values[16];
+
+        switch (format) {
+        case BLOCK_FORMAT_BC1: {
+            uint32_t transparent = 0;
+            for (uint32_t i = 0; i < 16; i++)
+                transparent |= (block.color(i).a < ALPHA_THRESHOLD) ? (1 << i) : 0;
+            BlockDXT1 color;
+            compressColor(block, transparent, highQuality, true, color);
+            memcpy(dst, &color, sizeof(color));
+            break;
+        }
+        case BLOCK_FORMAT_BC3: {
+            BlockDXT5 result;
+            for (uint32_t i = 0; i < 16; i++)
+                values[i] = block.color(i).a;
+            compressAlpha(values, highQuality, result.alpha);
+            compressColor(block, 0, highQuality, false, result.color);
+            memcpy(dst, &result, sizeof(result));
+            break;
+        }
+        case BLOCK_FORMAT_BC4:
+        case BLOCK_FORMAT_BC5: {
+            AlphaBlockDXT5 channel;
+            for (uint32_t i = 0; i < 16; i++)
+                values[i] = block.color(i).r;
+            compressAlpha(values, highQuality, channel);
+            memcpy(dst, &channel, sizeof(channel));
+            if (format == BLOCK_FORMAT_BC5) {
+                for (uint32_t i = 0; i < 16; i++)
+                    values[i] = block.color(i).g;
+                compressAlpha(values, highQuality, channel);
+                memcpy(dst + 8, &channel, sizeof(channel));
+            }
+            break;
+        }
+        }
+    }
+
+    void compressBand(BlockFormat format, bool highQuality, const BlockBand& band)
+    {
+        const BlockSurface& s = *band.surface;
+        const int32_t bw = (s.width + 3) / 4;
+        const int32_t bh = (s.height + 3) / 4;
+        const uint32_t bytes = blockBytes(format);
+        uint8_t* dst = s.dst + (size_t)band.firstRow * bw * bytes;
+        ColorBlock block;
+
+        for (int32_t row = band.firstRow; row < band.firstRow + band.rowCount; row++) {
+            for (int32_t i = 0; i < bw; i++, dst += bytes) {
+                loadBlock(s, row / bh, i, row % bh, block);
+                compressBlock(format, highQuality, block, dst);
+            }
+        }
+    }
+}
+
+void nv::compressDXT(BlockFormat format, bool highQuality, const BlockSurface* surfaces,
+    uint32_t count, uint32_t threadCount)
+{
+    std::vector<BlockBand> bands;
+    int64_t texels = 0;
+
+    for (uint32_t s = 0; s < count; s++) {
+        const BlockSurface& surface = surfaces[s];
+        int32_t depth = surface.depth ? surface.depth : 1;
+        int32_t bw = (surface.width + 3) / 4;
+        int32_t rows = ((surface.height + 3) / 4) * depth;
+        int32_t bandRows = BAND_TEXELS / (16 * bw);
+        if (bandRows < 1)
+            bandRows = 1;
+
+        for (int32_t row = 0; row < rows; row += bandRows) {
+            BlockBand band = { &surface, row, minInt(bandRows, rows - row) };
+            bands.push_back(band);
+        }
+
+        texels += (int64_t)surface.width * surface.height * depth;
+    }
+
+    if (threadCount == 0)
+        threadCount = defaultThreadCount();
+    if (texels < THREADED_TEXELS)
+        threadCount = 1;
+
+    parallelFor((uint32_t)bands.size(), threadCount, [&](uint32_t b) {
+        compressBand(format, highQuality, bands[b]);
+    });
+}
+
+uint64_t nv::compressionError(BlockFormat format, const BlockSurface* surfaces,
+    uint32_t count, uint32_t& channels)
+{
+    static const uint32_t channelCounts[] = { 3, 4, 1, 2 };
+    channels = channelCounts[format];
+
+    uint64_t error = 0;
+    for (uint32_t s = 0; s < count; s++) {
+        const BlockSurface& surface = surfaces[s];
+        const int32_t depth = surface.depth ? surface.depth : 1;
+        const int32_t bw = (surface.width + 3) / 4;
+        const int32_t bh = (surface.height + 3) / 4;
+        const uint8_t* src = surface.dst;
+        ColorBlock source, decoded, decoded2;
+
+        for (int32_t slice = 0; slice < depth; slice++) {
+            for (int32_t j = 0; j < bh; j++) {
+                for (int32_t i = 0; i < bw; i++, src += blockBytes(format)) {
+                    loadBlock(surface, slice, i, j, source);
+
+                    switch (format) {
+                    case BLOCK_FORMAT_BC1:
+                        ((const BlockDXT1*)src)->decodeBlock(&decoded);
+                        break;
+                    case BLOCK_FORMAT_BC3:
+                        ((const BlockDXT5*)src)->decodeBlock(&decoded);
+                        break;
+                    case BLOCK_FORMAT_BC4:
+                        ((const AlphaBlockDXT5*)src)->decodeBlock(&decoded);
+                        break;
+                    case BLOCK_FORMAT_BC5:
+                        ((const AlphaBlockDXT5*)src)->decodeBlock(&decoded);
+                        ((const AlphaBlockDXT5*)(src + 8))->decodeBlock(&decoded2);
+                        break;
+                    }
+
+                    // only texels inside the surface count
+                    for (int32_t y = 0; y < minInt(4, surface.height - 4 * j); y++) {
+                        for (int32_t x = 0; x < minInt(4, surface.width - 4 * i); x++) {
+                            const Color32 a = source.color(x, y);
+                            const Color32 b = decoded.color(x, y);
+                            switch (format) {
+                            case BLOCK_FORMAT_BC1:
+                                if (a.a >= ALPHA_THRESHOLD)
+                                    error += colorDistance(a, b);
+                                break;
+                            case BLOCK_FORMAT_BC3:
+                                error += colorDistance(a, b) + square(a.a - b.a);
+                                break;
+                            case BLOCK_FORMAT_BC4:
+                                error += square(a.r - b.a);
+                                break;
+                            case BLOCK_FORMAT_BC5:
+                                error += square(a.r - b.a) + square(a.g - decoded2.color(x, y).a);
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return error;
+}
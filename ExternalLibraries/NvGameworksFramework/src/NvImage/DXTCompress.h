@@ -0,0 +1,93 @@
+//----------------------------------------------------------------------------------
+// File:        NvImage/DXTCompress.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_IMAGE_DXTCOMPRESS_H
+#define NV_IMAGE_DXTCOMPRESS_H
+
+#include <NvSimpleTypes.h>
+
+namespace nv
+{
+    /// Block formats produced by the DXT compressor.
+    enum BlockFormat
+    {
+        BLOCK_FORMAT_BC1,   ///< DXT1: RGB with 1-bit alpha
+        BLOCK_FORMAT_BC3,   ///< DXT5: RGB with interpolated alpha
+        BLOCK_FORMAT_BC4,   ///< one channel (red)
+        BLOCK_FORMAT_BC5    ///< two channels (red, green)
+    };
+
+    /// An RGBA8 surface (one level of one face) and the blocks it
+    /// compresses into.
+    struct BlockSurface
+    {
+        const uint32_t* src;    ///< width * height * depth RGBA8 texels
+        uint8_t* dst;           ///< 4x4 blocks, one slice after another
+        int32_t width;
+        int32_t height;
+        int32_t depth;
+    };
+
+    /// Size in bytes of one 4x4 block of the format
+    inline uint32_t blockBytes(BlockFormat format)
+    {
+        return (format == BLOCK_FORMAT_BC1 || format == BLOCK_FORMAT_BC4) ? 8 : 16;
+    }
+
+    /// Compresses RGBA8 surfaces to BC1/3/4/5.  Like #expandDXT, surfaces are
+    /// cut into bands of block rows that are shared out across threads.
+    /// \param[in] format the block format to produce
+    /// \param[in] highQuality false fits each block to its bounding box, which
+    /// is fast enough for load time; true fits colors along their principal
+    /// axis with least-squares refinement and searches more alpha modes
+    /// \param[in] surfaces the surfaces to compress
+    /// \param[in] count the number of surfaces
+    /// \param[in] threadCount the maximum number of threads, counting the
+    /// caller; 0 uses one per hardware thread
+    void compressDXT(BlockFormat format, bool highQuality, const BlockSurface* surfaces,
+        uint32_t count, uint32_t threadCount);
+
+    /// Measures the error of compressed surfaces by decoding them with the
+    /// BlockDXT decoders and comparing against their sources
+    /// \param[in] format the block format of the surfaces
+    /// \param[in] surfaces the compressed surfaces and their sources
+    /// \param[in] count the number of surfaces
+    /// \param[out] channels the number of channels the error covers
+    /// \return the summed squared error over all texels and channels
+    uint64_t compressionError(BlockFormat format, const BlockSurface* surfaces,
+        uint32_t count, uint32_t& channels);
+
+} // nv namespace
+
+#endif // NV_IMAGE_DXTCOMPRESS_H
@@ -0,0 +1,359 @@
+//----------------------------------------------------------------------------------
+// File:        NvImage/DXTExpand.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include <string.h>
+#include <vector>
+#include "DXTExpand.h"
+#include "BPTCDecode.h"
+#include "NV/NvParallel.h"
+
+// The row decoder uses SSE2 on x86 targets and plain C elsewhere.  Both
+// produce the same texels.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NV_DXT_SSE2 1
+#endif
+
+using namespace nv;
+
+namespace
+{
+    // Surfaces are split into bands of about this many texels
+    const int32_t BAND_TEXELS = 64 * 1024;
+
+    // Images with fewer texels than this are expanded on the calling thread
+    const int32_t THREADED_TEXELS = 256 * 1024;
+
+    /// A band of block rows of one surface.  Rows are counted through all of
+    /// the surface's slices
+    struct DXTBand
+    {
+        const DXTSurface* surface;
+        int32_t firstRow;
+        int32_t rowCount;
+    };
+
+    inline int32_t minInt(int32_t a, int32_t b)
+    {
+        return (a < b) ? a : b;
+    }
+
+    inline uint32_t read16(const uint8_t* p)
+    {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+    }
+
+    inline uint32_t read32(const uint8_t* p)
+    {
+        return read16(p) | (read16(p + 2) << 16);
+    }
+
+    /// Bit-expands a 565 color to 888, laid out as Color32 (r in the low byte)
+    inline uint32_t expand565(uint32_t c)
+    {
+        uint32_t r = (c >> 11) & 0x1F;
+        uint32_t g = (c >> 5) & 0x3F;
+        uint32_t b = c & 0x1F;
+        r = (r << 3) | (r >> 2);
+        g = (g << 2) | (g >> 4);
+        b = (b << 3) | (b >> 2);
+        return r | (g << 8) | (b << 16);
+    }
+
+    /// Per-channel (wa * a + wb * b) / div of two 888 colors
+    inline uint32_t mix888(uint32_t a, uint32_t b, uint32_t wa, uint32_t wb, uint32_t div)
+    {
+        uint32_t r = ((a & 0xFF) * wa + (b & 0xFF) * wb) / div;
+        uint32_t g = (((a >> 8) & 0xFF) * wa + ((b >> 8) & 0xFF) * wb) / div;
+        uint32_t bl = (((a >> 16) & 0xFF) * wa + ((b >> 16) & 0xFF) * wb) / div;
+        return r | (g << 8) | (bl << 16);
+    }
+
+    /// Builds the four-entry palette of a DXT1 color block with the same
+    /// arithmetic as BlockDXT1::evaluatePalette
+    inline void colorPalette(const uint8_t* block, uint32_t pal[4])
+    {
+        uint32_t c0 = read16(block);
+        uint32_t c1 = read16(block + 2);
+        uint32_t p0 = expand565(c0);
+        uint32_t p1 = expand565(c1);
+
+        pal[0] = p0 | 0xFF000000;
+        pal[1] = p1 | 0xFF000000;
+        if (c0 > c1) {
+            pal[2] = mix888(p0, p1, 2, 1, 3) | 0xFF000000;
+            pal[3] = mix888(p0, p1, 1, 2, 3) | 0xFF000000;
+        } else {
+            pal[2] = mix888(p0, p1, 1, 1, 2) | 0xFF000000;
+            pal[3] = 0;
+        }
+    }
+
+    /// Explicit 4-bit alphas of a DXT3 block, shifted into the alpha byte
+    inline void alphaDXT3(const uint8_t* block, uint32_t alpha[16])
+    {
+#if NV_DXT_SSE2
+        // Split the bytes into nibbles, interleave them back into texel order,
+        // widen each 4-bit alpha to 8 bits and move it to the top of its lane
+        const __m128i nibble = _mm_set1_epi8(0x0F);
+        const __m128i zero = _mm_setzero_si128();
+        __m128i bytes = _mm_loadl_epi64((const __m128i*)block);
+        __m128i a = _mm_unpacklo_epi8(_mm_and_si128(bytes, nibble),
+            _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble));
+        a = _mm_or_si128(a, _mm_slli_epi16(a, 4));
+        __m128i lo = _mm_unpacklo_epi8(zero, a);
+        __m128i hi = _mm_unpackhi_epi8(zero, a);
+        _mm_storeu_si128((__m128i*)(alpha + 0), _mm_unpacklo_epi16(zero, lo));
+        _mm_storeu_si128((__m128i*)(alpha + 4), _mm_unpackhi_epi16(zero, lo));
+        _mm_storeu_si128((__m128i*)(alpha + 8), _mm_unpacklo_epi16(zero, hi));
+        _mm_storeu_si128((__m128i*)(alpha + 12), _mm_unpackhi_epi16(zero, hi));
+#else
+        for (uint32_t i = 0; i < 16; i++) {
+            uint32_t a = (block[i >> 1] >> (4 * (i & 1))) & 0xF;
+            alpha[i] = ((a << 4) | a) << 24;
+        }
+#endif
+    }
+
+    /// Interpolated alphas of a DXT5 block, shifted into the alpha byte.  The
+    /// palette matches AlphaBlockDXT5::evaluatePalette
+    inline void alphaDXT5(const uint8_t* block, uint32_t alpha[16])
+    {
+        uint32_t a0 = block[0];
+        uint32_t a1 = block[1];
+        uint32_t pal[8];
+        pal[0] = a0 << 24;
+        pal[1] = a1 << 24;
+        if (a0 > a1) {
+            for (uint32_t i = 1; i < 7; i++)
+                pal[i + 1] = (((7 - i) * a0 + i * a1) / 7) << 24;
+        } else {
+            for (uint32_t i = 1; i < 5; i++)
+                pal[i + 1] = (((5 - i) * a0 + i * a1) / 5) << 24;
+            pal[6] = 0x00;
+            pal[7] = 0xFFu << 24;
+        }
+
+        // 48 bits of 3-bit indices, in two runs of 24 bits
+        uint32_t lo = block[2] | (block[3] << 8) | (block[4] << 16);
+        uint32_t hi = block[5] | (block[6] << 8) | (block[7] << 16);
+        for (uint32_t i = 0; i < 8; i++) {
+            alpha[i] = pal[(lo >> (3 * i)) & 7];
+            alpha[i + 8] = pal[(hi >> (3 * i)) & 7];
+        }
+    }
+
+#if NV_DXT_SSE2
+    inline __m128i select128(__m128i mask, __m128i clear, __m128i set)
+    {
+        return _mm_or_si128(_mm_and_si128(mask, set), _mm_andnot_si128(mask, clear));
+    }
+#endif
+
+    /// Looks the 16 2-bit indices of a block up in its palette, ORs in the
+    /// per-texel alpha if any, and writes the four rows of four texels to dst
+    inline void writeBlock(const uint32_t pal[4], uint32_t indices, const uint32_t* alpha,
+        uint32_t* dst, int32_t pitch)
+    {
+#if NV_DXT_SSE2
+        // One row per step: the two index bits of each lane become masks that
+        // select between the palette entries
+        const __m128i p0 = _mm_set1_epi32((int32_t)pal[0]);
+        const __m128i p1 = _mm_set1_epi32((int32_t)pal[1]);
+        const __m128i p2 = _mm_set1_epi32((int32_t)pal[2]);
+        const __m128i p3 = _mm_set1_epi32((int32_t)pal[3]);
+        const __m128i lowBits = _mm_setr_epi32(0x01, 0x04, 0x10, 0x40);
+        const __m128i highBits = _mm_setr_epi32(0x02, 0x08, 0x20, 0x80);
+        for (int32_t y = 0; y < 4; y++) {
+            __m128i idx = _mm_set1_epi32((int32_t)(indices >> (8 * y)));
+            __m128i low = _mm_cmpeq_epi32(_mm_and_si128(idx, lowBits), lowBits);
+            __m128i high = _mm_cmpeq_epi32(_mm_and_si128(idx, highBits), highBits);
+            __m128i texels = select128(high, select128(low, p0, p1), select128(low, p2, p3));
+            if (alpha)
+                texels = _mm_or_si128(texels, _mm_loadu_si128((const __m128i*)(alpha + 4 * y)));
+            _mm_storeu_si128((__m128i*)(dst + y * pitch), texels);
+        }
+#else
+        for (int32_t y = 0; y < 4; y++) {
+            for (int32_t x = 0; x < 4; x++) {
+                uint32_t i = 4 * y + x;
+                dst[y * pitch + x] = pal[(indices >> (2 * i)) & 3] | (alpha ? alpha[i] : 0);
+            }
+        }
+#endif
+    }
+
+    /// Decodes a band of block rows, writing each block's texels straight
+    /// into the destination rows
+    template <DXTFormat F>
+    void expandRows(const DXTSurface& s, int32_t firstRow, int32_t rowCount)
+    {
+        const int32_t blockBytes = (F == DXT_FORMAT_DXT1) ? 8 : 16;
+        const int32_t bw = (s.width + 3) / 4;
+        const int32_t bh = (s.height + 3) / 4;
+        const uint8_t* src = s.src + (size_t)firstRow * bw * blockBytes;
+        uint32_t alphaTexels[16];
+        uint32_t edge[16];
+
+        for (int32_t row = firstRow; row < firstRow + rowCount; row++) {
+            int32_t j = row % bh;
+            int32_t ySize = minInt(4, s.height - 4 * j);
+            uint32_t* plane = (uint32_t*)s.dst + (size_t)(row / bh) * s.width * s.height;
+            int32_t pitch = s.width;
+            uint32_t* dstRow = plane + (size_t)4 * j * s.width;
+
+            if (s.flipped) {
+                pitch = -s.width;
+                dstRow = plane + (size_t)(s.height - 1 - 4 * j) * s.width;
+            }
+
+            for (int32_t i = 0; i < bw; i++, src += blockBytes) {
+                const uint8_t* color = src + blockBytes - 8;
+                const uint32_t* alpha = NULL;
+                uint32_t pal[4];
+                colorPalette(color, pal);
+
+                if (F != DXT_FORMAT_DXT1) {
+                    if (F == DXT_FORMAT_DXT3)
+                        alphaDXT3(src, alphaTexels);
+                    else
+                        alphaDXT5(src, alphaTexels);
+                    alpha = alphaTexels;
+                    for (int32_t k = 0; k < 4; k++)
+                        pal[k] &= 0x00FFFFFF;
+                }
+
+                int32_t xSize = minInt(4, s.width - 4 * i);
+                if (xSize == 4 && ySize == 4) {
+                    writeBlock(pal, read32(color + 4), alpha, dstRow + 4 * i, pitch);
+                } else {
+                    writeBlock(pal, read32(color + 4), alpha, edge, 4);
+                    for (int32_t y = 0; y < ySize; y++)
+                        memcpy(dstRow + y * pitch + 4 * i, edge + 4 * y, xSize * sizeof(uint32_t));
+                }
+            }
+        }
+    }
+
+    /// Decodes a band of BC6H or BC7 block rows.  Each block is decoded to a
+    /// 4x4 tile that is then copied into the destination rows
+    template <DXTFormat F>
+    void expandRowsBPTC(const DXTSurface& s, int32_t firstRow, int32_t rowCount)
+    {
+        const size_t texelBytes = (F == DXT_FORMAT_BC7) ? 4 : 8;
+        const int32_t bw = (s.width + 3) / 4;
+        const int32_t bh = (s.height + 3) / 4;
+        const size_t rowBytes = s.width * texelBytes;
+        const uint8_t* src = s.src + (size_t)firstRow * bw * 16;
+        uint64_t tile[16];
+
+        for (int32_t row = firstRow; row < firstRow + rowCount; row++) {
+            int32_t j = row % bh;
+            int32_t ySize = minInt(4, s.height - 4 * j);
+            uint8_t* plane = (uint8_t*)s.dst + (size_t)(row / bh) * s.height * rowBytes;
+
+            for (int32_t i = 0; i < bw; i++, src += 16) {
+                if (F == DXT_FORMAT_BC7)
+                    decodeBC7(src, (uint32_t*)tile);
+                else
+                    decodeBC6H(src, F == DXT_FORMAT_BC6H_SF16, (uint16_t*)tile);
+
+                int32_t xSize = minInt(4, s.width - 4 * i);
+                for (int32_t y = 0; y < ySize; y++) {
+                    int32_t dstY = s.flipped ? (s.height - 1 - (4 * j + y)) : (4 * j + y);
+                    memcpy(plane + dstY * rowBytes + 4 * i * texelBytes,
+                        (const uint8_t*)tile + 4 * y * texelBytes, xSize * texelBytes);
+                }
+            }
+        }
+    }
+
+    void expandBand(DXTFormat format, const DXTBand& band)
+    {
+        const DXTSurface& s = *band.surface;
+        switch (format) {
+        case DXT_FORMAT_DXT1:
+            expandRows<DXT_FORMAT_DXT1>(s, band.firstRow, band.rowCount);
+            break;
+        case DXT_FORMAT_DXT3:
+            expandRows<DXT_FORMAT_DXT3>(s, band.firstRow, band.rowCount);
+            break;
+        case DXT_FORMAT_DXT5:
+            expandRows<DXT_FORMAT_DXT5>(s, band.firstRow, band.rowCount);
+            break;
+        case DXT_FORMAT_BC6H_UF16:
+            expandRowsBPTC<DXT_FORMAT_BC6H_UF16>(s, band.firstRow, band.rowCount);
+            break;
+        case DXT_FORMAT_BC6H_SF16:
+            expandRowsBPTC<DXT_FORMAT_BC6H_SF16>(s, band.firstRow, band.rowCount);
+            break;
+        case DXT_FORMAT_BC7:
+            expandRowsBPTC<DXT_FORMAT_BC7>(s, band.firstRow, band.rowCount);
+            break;
+        }
+    }
+}
+
+void nv::expandDXT(DXTFormat format, const DXTSurface* surfaces, uint32_t count,
+    uint32_t threadCount)
+{
+    std::vector<DXTBand> bands;
+    int64_t texels = 0;
+
+    for (uint32_t s = 0; s < count; s++) {
+        const DXTSurface& surface = surfaces[s];
+        int32_t depth = surface.depth ? surface.depth : 1;
+        int32_t bw = (surface.width + 3) / 4;
+        int32_t rows = ((surface.height + 3) / 4) * depth;
+        int32_t bandRows = BAND_TEXELS / (16 * bw);
+        if (bandRows < 1)
+            bandRows = 1;
+
+        for (int32_t row = 0; row < rows; row += bandRows) {
+            DXTBand band = { &surface, row, minInt(bandRows, rows - row) };
+            bands.push_back(band);
+        }
+
+        texels += (int64_t)surface.width * surface.height * depth;
+    }
+
+    if (threadCount == 0)
+        threadCount = defaultThreadCount();
+    if (texels < THREADED_TEXELS)
+        threadCount = 1;
+
+    parallelFor((uint32_t)bands.size(), threadCount, [&](uint32_t b) {
+        expandBand(format, bands[b]);
+    });
+}
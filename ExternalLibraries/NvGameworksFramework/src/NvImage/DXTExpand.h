@@ -0,0 +1,82 @@
+//----------------------------------------------------------------------------------
+// File:        NvImage/DXTExpand.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#ifndef NV_IMAGE_DXTEXPAND_H
+#define NV_IMAGE_DXTEXPAND_H
+
+#include <NvSimpleTypes.h>
+
+namespace nv
+{
+    /// Block formats handled by the DXT expander.
+    enum DXTFormat
+    {
+        DXT_FORMAT_DXT1,
+        DXT_FORMAT_DXT3,
+        DXT_FORMAT_DXT5,
+        DXT_FORMAT_BC6H_UF16,
+        DXT_FORMAT_BC6H_SF16,
+        DXT_FORMAT_BC7
+    };
+
+    /// A compressed surface (one level of one face) and the texels it expands
+    /// into: RGBA8 (as Color32), or RGBA16F for BC6H.
+    struct DXTSurface
+    {
+        const uint8_t* src;     ///< 4x4 blocks, one slice after another
+        void* dst;              ///< width * height * depth texels
+        int32_t width;
+        int32_t height;
+        int32_t depth;
+        bool flipped;           ///< write the rows bottom to top
+    };
+
+    /// Expands DXT1/3/5 and BC7 surfaces to RGBA8 and BC6H surfaces to
+    /// RGBA16F.  Surfaces are cut into bands of block rows, and the bands of
+    /// all surfaces are shared out across the worker threads.  The source and
+    /// destination must not overlap.  Flipped surfaces are written upside down
+    /// as they are decoded, so no separate flip pass over the compressed or
+    /// expanded data is needed
+    /// \param[in] format the block format of every surface
+    /// \param[in] surfaces the surfaces to expand
+    /// \param[in] count the number of surfaces
+    /// \param[in] threadCount the maximum number of threads to decode on,
+    /// counting the caller; 0 uses one per hardware thread.  Small images are
+    /// always decoded on the calling thread
+    void expandDXT(DXTFormat format, const DXTSurface* surfaces, uint32_t count,
+        uint32_t threadCount);
+
+} // nv namespace
+
+#endif // NV_IMAGE_DXTEXPAND_H
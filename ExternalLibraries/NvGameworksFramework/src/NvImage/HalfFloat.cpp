@@ -0,0 +1,220 @@
+//----------------------------------------------------------------------------------
+// File:        NvImage/HalfFloat.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "HalfFloat.h"
+
+// Four values are converted at a time on x86 targets: with the F16C
+// instructions when the CPU has them, which is checked once at startup, and
+// with SSE2 integer and float arithmetic otherwise.  Other targets convert
+// one value at a time.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NV_HALF_SSE2 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#define NV_HALF_F16C 1
+#define NV_TARGET_F16C
+#elif defined(__GNUC__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define NV_HALF_F16C 1
+#define NV_TARGET_F16C __attribute__((target("f16c")))
+#else
+#include <emmintrin.h>
+#endif
+#endif
+
+namespace
+{
+#if NV_HALF_F16C
+    /// Returns true if the CPU has F16C and the OS saves the AVX registers
+    /// its VEX encoding uses
+    bool cpuHasF16C()
+    {
+        uint32_t ecx;
+#if defined(_MSC_VER)
+        int32_t info[4];
+        __cpuid(info, 1);
+        ecx = (uint32_t)info[2];
+#else
+        uint32_t eax, ebx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+            return false;
+#endif
+        const uint32_t osxsave = 1u << 27, avx = 1u << 28, f16c = 1u << 29;
+        if ((ecx & (osxsave | avx | f16c)) != (osxsave | avx | f16c))
+            return false;
+
+        // XMM and YMM state enabled in XCR0
+#if defined(_MSC_VER)
+        uint64_t xcr0 = _xgetbv(0);
+#else
+        uint32_t xcr0Lo, xcr0Hi;
+        __asm__("xgetbv" : "=a"(xcr0Lo), "=d"(xcr0Hi) : "c"(0));
+        uint64_t xcr0 = xcr0Lo | ((uint64_t)xcr0Hi << 32);
+#endif
+        return (xcr0 & 6) == 6;
+    }
+
+    const bool s_hasF16C = cpuHasF16C();
+
+    /// Converts the floats four at a time with F16C and returns how many
+    /// were converted; the caller converts the remainder
+    NV_TARGET_F16C size_t floatsToHalvesF16C(const float* src, uint16_t* dst, size_t count)
+    {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+            _mm_storel_epi64((__m128i*)(dst + i), _mm_cvtps_ph(_mm_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+        return i;
+    }
+
+    /// Converts the halves four at a time with F16C and returns how many
+    /// were converted
+    NV_TARGET_F16C size_t halvesToFloatsF16C(const uint16_t* src, float* dst, size_t count)
+    {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+            _mm_storeu_ps(dst + i, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)(src + i))));
+        return i;
+    }
+#endif
+
+#if NV_HALF_SSE2
+    /// Converts four floats to halves in the low 64 bits, rounding to nearest
+    /// even.  Results that are normal halves have their exponent rebiased and
+    /// the dropped 13 bits rounded with an integer add; denormal results are
+    /// rounded by the float adder itself, by adding a constant that lines the
+    /// half's last mantissa bit up with the float's
+    inline __m128i floatsToHalves4(__m128 f)
+    {
+        const __m128i signMask = _mm_set1_epi32((int32_t)0x80000000);
+        const __m128i infinityThreshold = _mm_set1_epi32((127 + 16) << 23);
+        const __m128i normalThreshold = _mm_set1_epi32((127 - 14) << 23);
+        const __m128i denormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+        const __m128i normalBias = _mm_set1_epi32(0xFFF - ((127 - 15) << 23));
+
+        __m128i bits = _mm_castps_si128(f);
+        __m128i sign = _mm_and_si128(bits, signMask);
+        __m128i abs = _mm_xor_si128(bits, sign);
+        __m128 absf = _mm_castsi128_ps(abs);
+
+        // infinity, or a quiet NaN for NaNs, for everything too large to round below infinity
+        __m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(absf, absf));
+        __m128i special = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+        __m128i isRegular = _mm_cmpgt_epi32(infinityThreshold, abs);
+
+        __m128i isDenormal = _mm_cmpgt_epi32(normalThreshold, abs);
+        __m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absf, _mm_castsi128_ps(denormalMagic))),
+            denormalMagic);
+
+        // round half to even: ties round up only when the last kept bit is odd
+        __m128i odd = _mm_srai_epi32(_mm_slli_epi32(abs, 31 - 13), 31);
+        __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(abs, normalBias), odd), 13);
+
+        __m128i result = _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, normal));
+        result = _mm_or_si128(_mm_and_si128(isRegular, result), _mm_andnot_si128(isRegular, special));
+
+        // the sign is shifted arithmetically, so the pack's signed saturation keeps it
+        result = _mm_or_si128(result, _mm_srai_epi32(sign, 16));
+        return _mm_packs_epi32(result, result);
+    }
+
+    /// Converts four halves in the low 64 bits to floats.  The exponent and
+    /// mantissa are moved into place and rescaled by a float multiply, which
+    /// also normalizes denormals; infinities and NaNs get the float's all-ones
+    /// exponent
+    inline __m128 halvesToFloats4(__m128i h)
+    {
+        const __m128i magnitudeMask = _mm_set1_epi32(0x7FFF);
+        const __m128 scale = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+        const __m128i largestFinite = _mm_set1_epi32(0x7BFF);
+        const __m128i specialExponent = _mm_set1_epi32(255 << 23);
+
+        h = _mm_unpacklo_epi16(h, _mm_setzero_si128());
+        __m128i magnitude = _mm_and_si128(h, magnitudeMask);
+        __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, magnitude), 16);
+
+        __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(magnitude, 13)), scale);
+        __m128i isSpecial = _mm_cmpgt_epi32(magnitude, largestFinite);
+        __m128i high = _mm_or_si128(sign, _mm_and_si128(isSpecial, specialExponent));
+
+        return _mm_or_ps(scaled, _mm_castsi128_ps(high));
+    }
+#endif
+
+    /// One value at a time; memcpy keeps in-place conversion well defined
+    void floatsToHalvesScalar(const float* src, uint16_t* dst, size_t count)
+    {
+        for (size_t i = 0; i < count; i++) {
+            float f;
+            memcpy(&f, src + i, sizeof(f));
+            uint16_t h = nv::floatToHalf(f);
+            memcpy(dst + i, &h, sizeof(h));
+        }
+    }
+}
+
+namespace nv
+{
+    void floatsToHalves(const float* src, uint16_t* dst, size_t count)
+    {
+        size_t i = 0;
+#if NV_HALF_SSE2
+        // four floats are loaded before their halves are stored, so a
+        // conversion in place never overwrites values still to be read
+#if NV_HALF_F16C
+        if (s_hasF16C)
+            i = floatsToHalvesF16C(src, dst, count);
+#endif
+        for (; i + 4 <= count; i += 4)
+            _mm_storel_epi64((__m128i*)(dst + i), floatsToHalves4(_mm_loadu_ps(src + i)));
+#endif
+        floatsToHalvesScalar(src + i, dst + i, count - i);
+    }
+
+    void halvesToFloats(const uint16_t* src, float* dst, size_t count)
+    {
+        size_t i = 0;
+#if NV_HALF_SSE2
+#if NV_HALF_F16C
+        if (s_hasF16C)
+            i = halvesToFloatsF16C(src, dst, count);
+#endif
+        for (; i + 4 <= count; i += 4)
+            _mm_storeu_ps(dst + i, halvesToFloats4(_mm_loadl_epi64((const __m128i*)(src + i))));
+#endif
+        for (; i < count; i++)
+            dst[i] = halfToFloat(src[i]);
+    }
+
+} // nv namespace
@@ -0,0 +1,61 @@
+//----------------------------------------------------------------------------------
+// File:        NvImage/HalfFloat.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef NV_IMAGE_HALFFLOAT_H
+#define NV_IMAGE_HALFFLOAT_H
+
+#include <NvSimpleTypes.h>
+#include "NV/NvHalfFloat.h"
+
+namespace nv
+{
+    /// Converts an array of floats to IEEE halves with the same rounding as
+    /// #floatToHalf.  Four values are converted at a time with F16C on CPUs
+    /// that have it and SSE2 on any other x86 target.  The paths give
+    /// the same halves, except that NaN payloads may differ
+    /// \param[in] src the floats
+    /// \param[out] dst the halves; may be src itself, converting in place
+    /// \param[in] count the number of values
+    void floatsToHalves(const float* src, uint16_t* dst, size_t count);
+
+    /// Converts an array of IEEE halves to floats exactly, like #halfToFloat,
+    /// four at a time with F16C or SSE2 where available.  F16C returns
+    /// signaling NaNs quieted
+    /// \param[in] src the halves
+    /// \param[out] dst the floats; must not overlap src
+    /// \param[in] count the number of values
+    void halvesToFloats(const uint16_t* src, float* dst, size_t count);
+
+} // nv namespace
+
+#endif // NV_IMAGE_HALFFLOAT_H
@@ -0,0 +1,399 @@
+//----------------------------------------------------------------------------------
+// File:        NvImage/MipGenerate.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include "MipGenerate.h"
+#include "HalfFloat.h"
+#include "NV/NvParallel.h"
+
+// The filter kernels work on four floats per texel and use SSE when the
+// compiler targets x86, plain C elsewhere
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define NV_MIP_SSE 1
+#endif
+
+using namespace nv;
+
+namespace
+{
+    // Levels are split into bands of about this many destination texels
+    const int32_t BAND_TEXELS = 16 * 1024;
+
+    // Images with fewer texels than this are filtered on the calling thread
+    const int32_t THREADED_TEXELS = 64 * 1024;
+
+    // Index bits of the linear-to-sRGB table
+    const int32_t SRGB_ENCODE_BITS = 16;
+
+    /// sRGB transfer tables for 8-bit texels
+    struct SRGBTables
+    {
+        float decode[256];
+        uint8_t encode[1 << SRGB_ENCODE_BITS];
+
+        SRGBTables()
+        {
+            for (int32_t i = 0; i < 256; i++) {
+                float c = i / 255.0f;
+                decode[i] = (c <= 0.04045f) ? (c / 12.92f) : powf((c + 0.055f) / 1.055f, 2.4f);
+            }
+            const int32_t last = (1 << SRGB_ENCODE_BITS) - 1;
+            for (int32_t i = 0; i <= last; i++) {
+                float l = (float)i / last;
+                float c = (l <= 0.0031308f) ? (l * 12.92f) : (1.055f * powf(l, 1.0f / 2.4f) - 0.055f);
+                encode[i] = (uint8_t)(c * 255.0f + 0.5f);
+            }
+        }
+    };
+
+    /// Built on the calling thread before any worker reads it
+    const SRGBTables& srgbTables()
+    {
+        static SRGBTables tables;
+        return tables;
+    }
+
+    /// The taps of a 1D resampling: for each destination texel, the first
+    /// source texel and the weights of the run of texels that follows.  Taps
+    /// that fall outside the source are folded onto its edge texels
+    struct FilterTaps
+    {
+        int32_t stride;
+        std::vector<int32_t> first;
+        std::vector<int32_t> count;
+        std::vector<float> weights;
+    };
+
+    float filterRadius(MipFilter filter)
+    {
+        switch (filter) {
+        case MIP_FILTER_TRIANGLE:
+            return 1.0f;
+        case MIP_FILTER_LANCZOS:
+            return 3.0f;
+        default:
+            return 0.5f;
+        }
+    }
+
+    inline float sinc(float x)
+    {
+        x *= 3.14159265f;
+        return (fabsf(x) < 1e-5f) ? 1.0f : sinf(x) / x;
+    }
+
+    /// Weight of a source texel whose center is x destination texels away
+    float filterWeight(MipFilter filter, float x)
+    {
+        x = fabsf(x);
+        switch (filter) {
+        case MIP_FILTER_TRIANGLE:
+            return (x < 1.0f) ? (1.0f - x) : 0.0f;
+        case MIP_FILTER_LANCZOS:
+            return (x < 3.0f) ? (sinc(x) * sinc(x / 3.0f)) : 0.0f;
+        default:
+            return (x <= 0.5f) ? 1.0f : 0.0f;
+        }
+    }
+
+    void buildTaps(MipFilter filter, int32_t srcSize, int32_t dstSize, FilterTaps& taps)
+    {
+        const float scale = (float)srcSize / dstSize;
+        const float support = filterRadius(filter) * scale;
+        taps.stride = (int32_t)ceilf(2.0f * support) + 2;
+        taps.first.resize(dstSize);
+        taps.count.resize(dstSize);
+        taps.weights.assign((size_t)dstSize * taps.stride, 0.0f);
+
+        for (int32_t i = 0; i < dstSize; i++) {
+            const float center = (i + 0.5f) * scale;
+            const int32_t lo = (int32_t)floorf(center - support);
+            const int32_t hi = (int32_t)ceilf(center + support);
+            const int32_t first = (lo > 0) ? lo : 0;
+            const int32_t last = (hi < srcSize) ? (hi - 1) : (srcSize - 1);
+            float* w = &taps.weights[(size_t)i * taps.stride];
+            float sum = 0.0f;
+
+            for (int32_t j = lo; j < hi; j++) {
+                float weight;
+                if (filter == MIP_FILTER_BOX) {
+                    // the box weighs each texel by how much of it is covered
+                    float a = (j > center - support) ? (float)j : (center - support);
+                    float b = (j + 1 < center + support) ? (float)(j + 1) : (center + support);
+                    weight = (b > a) ? (b - a) : 0.0f;
+                } else {
+                    weight = filterWeight(filter, (j + 0.5f - center) / scale);
+                }
+                int32_t k = (j < first) ? first : ((j > last) ? last : j);
+                w[k - first] += weight;
+                sum += weight;
+            }
+
+            taps.first[i] = first;
+            taps.count[i] = last - first + 1;
+            for (int32_t k = 0; k < taps.count[i]; k++)
+                w[k] /= sum;
+        }
+    }
+
+    /// dst = weight * src over count floats (a multiple of 4)
+    inline void scaleRow(float* dst, const float* src, float weight, int32_t count)
+    {
+#if NV_MIP_SSE
+        const __m128 w = _mm_set1_ps(weight);
+        for (int32_t i = 0; i < count; i += 4)
+            _mm_storeu_ps(dst + i, _mm_mul_ps(w, _mm_loadu_ps(src + i)));
+#else
+        for (int32_t i = 0; i < count; i++)
+            dst[i] = weight * src[i];
+#endif
+    }
+
+    /// dst += weight * src over count floats (a multiple of 4)
+    inline void accumulateRow(float* dst, const float* src, float weight, int32_t count)
+    {
+#if NV_MIP_SSE
+        const __m128 w = _mm_set1_ps(weight);
+        for (int32_t i = 0; i < count; i += 4)
+            _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(w, _mm_loadu_ps(src + i))));
+#else
+        for (int32_t i = 0; i < count; i++)
+            dst[i] += weight * src[i];
+#endif
+    }
+
+    /// Weighted sum of count consecutive four-float texels
+    inline void filterTexel(float* dst, const float* src, const float* weights, int32_t count)
+    {
+#if NV_MIP_SSE
+        __m128 sum = _mm_mul_ps(_mm_set1_ps(weights[0]), _mm_loadu_ps(src));
+        for (int32_t k = 1; k < count; k++)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(src + 4 * k)));
+        _mm_storeu_ps(dst, sum);
+#else
+        float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (int32_t k = 0; k < count; k++)
+            for (int32_t c = 0; c < 4; c++)
+                sum[c] += weights[k] * src[4 * k + c];
+        memcpy(dst, sum, sizeof(sum));
+#endif
+    }
+
+    /// Widens a row of stored texels to linear four-float texels
+    void loadRow(const MipTexelFormat& format, const uint8_t* src, float* dst, int32_t width)
+    {
+        const int32_t channels = format.channels;
+        const int32_t colors = format.sRGB ? format.colorChannels : 0;
+
+        // four-channel halves are already laid out as four-float texels
+        if (format.component == MIP_COMPONENT_HALF && channels == 4) {
+            halvesToFloats((const uint16_t*)src, dst, 4 * width);
+            return;
+        }
+
+        memset(dst, 0, sizeof(float) * 4 * width);
+        for (int32_t x = 0; x < width; x++, dst += 4) {
+            for (int32_t c = 0; c < channels; c++) {
+                switch (format.component) {
+                case MIP_COMPONENT_UNORM8: {
+                    uint8_t v = src[x * channels + c];
+                    dst[c] = (c < colors) ? srgbTables().decode[v] : (v / 255.0f);
+                    break;
+                }
+                case MIP_COMPONENT_HALF: {
+                    uint16_t v;
+                    memcpy(&v, src + 2 * (x * channels + c), sizeof(v));
+                    dst[c] = halfToFloat(v);
+                    break;
+                }
+                case MIP_COMPONENT_FLOAT:
+                    memcpy(&dst[c], src + 4 * (x * channels + c), sizeof(float));
+                    break;
+                }
+            }
+        }
+    }
+
+    /// Narrows a row of linear four-float texels to the stored format
+    void storeRow(const MipTexelFormat& format, const float* src, uint8_t* dst, int32_t width)
+    {
+        const int32_t channels = format.channels;
+        const int32_t colors = format.sRGB ? format.colorChannels : 0;
+        const float encodeScale = (float)((1 << SRGB_ENCODE_BITS) - 1);
+
+        if (format.component == MIP_COMPONENT_HALF && channels == 4) {
+            floatsToHalves(src, (uint16_t*)dst, 4 * width);
+            return;
+        }
+
+        for (int32_t x = 0; x < width; x++, src += 4) {
+            for (int32_t c = 0; c < channels; c++) {
+                float v = src[c];
+                switch (format.component) {
+                case MIP_COMPONENT_UNORM8:
+                    // filters with negative lobes can overshoot
+                    v = (v < 0.0f) ? 0.0f : ((v > 1.0f) ? 1.0f : v);
+                    dst[x * channels + c] = (c < colors) ? srgbTables().encode[(int32_t)(v * encodeScale + 0.5f)] :
+                        (uint8_t)(v * 255.0f + 0.5f);
+                    break;
+                case MIP_COMPONENT_HALF: {
+                    uint16_t h = floatToHalf(v);
+                    memcpy(dst + 2 * (x * channels + c), &h, sizeof(h));
+                    break;
+                }
+                case MIP_COMPONENT_FLOAT:
+                    memcpy(dst + 4 * (x * channels + c), &v, sizeof(float));
+                    break;
+                }
+            }
+        }
+    }
+
+    inline int32_t componentBytes(MipComponent component)
+    {
+        return (component == MIP_COMPONENT_UNORM8) ? 1 : ((component == MIP_COMPONENT_HALF) ? 2 : 4);
+    }
+
+    inline int32_t levelSize(int32_t size, int32_t level)
+    {
+        return ((size >> level) > 1) ? (size >> level) : 1;
+    }
+
+    /// A band of rows of one chain's level
+    struct MipBand
+    {
+        uint32_t chain;
+        int32_t firstRow;
+        int32_t rowCount;
+    };
+
+    /// Splits the rows of one level of every chain into bands
+    void buildBands(const MipChain* chains, uint32_t count, int32_t level, std::vector<MipBand>& bands)
+    {
+        bands.clear();
+        for (uint32_t c = 0; c < count; c++) {
+            int32_t w = levelSize(chains[c].width, level);
+            int32_t h = levelSize(chains[c].height, level);
+            int32_t bandRows = BAND_TEXELS / w;
+            if (bandRows < 1)
+                bandRows = 1;
+            for (int32_t row = 0; row < h; row += bandRows) {
+                MipBand band = { c, row, (bandRows < h - row) ? bandRows : (h - row) };
+                bands.push_back(band);
+            }
+        }
+    }
+}
+
+void nv::generateMips(MipFilter filter, const MipTexelFormat& format, const MipChain* chains,
+    uint32_t count, int32_t levelCount, uint32_t threadCount)
+{
+    if (levelCount < 2 || count == 0)
+        return;
+
+    if (format.sRGB)
+        srgbTables();
+
+    const int32_t texelBytes = componentBytes(format.component) * format.channels;
+
+    int64_t texels = 0;
+    for (uint32_t c = 0; c < count; c++)
+        texels += (int64_t)chains[c].width * chains[c].height;
+    if (threadCount == 0)
+        threadCount = defaultThreadCount();
+    if (texels < THREADED_TEXELS)
+        threadCount = 1;
+
+    // each chain filters between two linear float buffers: level 0 and every
+    // even level in the first, odd levels in the second
+    std::vector<std::vector<float> > buffers(2 * count);
+    for (uint32_t c = 0; c < count; c++) {
+        buffers[2 * c].resize((size_t)4 * chains[c].width * chains[c].height);
+        buffers[2 * c + 1].resize((size_t)4 * levelSize(chains[c].width, 1) * levelSize(chains[c].height, 1));
+    }
+
+    std::vector<MipBand> bands;
+    buildBands(chains, count, 0, bands);
+    parallelFor((uint32_t)bands.size(), threadCount, [&](uint32_t b) {
+        const MipBand& band = bands[b];
+        const MipChain& chain = chains[band.chain];
+        for (int32_t y = band.firstRow; y < band.firstRow + band.rowCount; y++) {
+            loadRow(format, chain.levels[0] + (size_t)y * chain.width * texelBytes,
+                &buffers[2 * band.chain][(size_t)4 * y * chain.width], chain.width);
+        }
+    });
+
+    std::vector<FilterTaps> horizontalTaps(count), verticalTaps(count);
+    for (int32_t level = 1; level < levelCount; level++) {
+        for (uint32_t c = 0; c < count; c++) {
+            buildTaps(filter, levelSize(chains[c].width, level - 1), levelSize(chains[c].width, level),
+                horizontalTaps[c]);
+            buildTaps(filter, levelSize(chains[c].height, level - 1), levelSize(chains[c].height, level),
+                verticalTaps[c]);
+        }
+
+        buildBands(chains, count, level, bands);
+        parallelFor((uint32_t)bands.size(), threadCount, [&](uint32_t b) {
+            const MipBand& band = bands[b];
+            const MipChain& chain = chains[band.chain];
+            const FilterTaps& vertical = verticalTaps[band.chain];
+            const FilterTaps& horizontal = horizontalTaps[band.chain];
+            const int32_t srcWidth = levelSize(chain.width, level - 1);
+            const int32_t dstWidth = levelSize(chain.width, level);
+            const float* src = &buffers[2 * band.chain + ((level - 1) & 1)][0];
+            float* dst = &buffers[2 * band.chain + (level & 1)][0];
+            std::vector<float> column((size_t)4 * srcWidth);
+
+            for (int32_t y = band.firstRow; y < band.firstRow + band.rowCount; y++) {
+                // filter the source rows down to one row, then along it
+                const float* w = &vertical.weights[(size_t)y * vertical.stride];
+                const float* srcRow = src + (size_t)4 * vertical.first[y] * srcWidth;
+                scaleRow(&column[0], srcRow, w[0], 4 * srcWidth);
+                for (int32_t k = 1; k < vertical.count[y]; k++)
+                    accumulateRow(&column[0], srcRow + (size_t)4 * k * srcWidth, w[k], 4 * srcWidth);
+
+                float* dstRow = dst + (size_t)4 * y * dstWidth;
+                for (int32_t x = 0; x < dstWidth; x++) {
+                    filterTexel(dstRow + 4 * x, &column[4 * horizontal.first[x]],
+                        &horizontal.weights[(size_t)x * horizontal.stride], horizontal.count[x]);
+                }
+
+                storeRow(format, dstRow, chain.levels[level] + (size_t)y * dstWidth * texelBytes, dstWidth);
+            }
+        });
+    }
+}
@@ -0,0 +1,92 @@
+//----------------------------------------------------------------------------------
+// File:        NvImage/MipGenerate.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef NV_IMAGE_MIPGENERATE_H
+#define NV_IMAGE_MIPGENERATE_H
+
+#include <NvSimpleTypes.h>
+
+namespace nv
+{
+    /// Resampling filters for mip generation
+    enum MipFilter
+    {
+        MIP_FILTER_BOX,         ///< area average of the texels each texel covers
+        MIP_FILTER_TRIANGLE,    ///< tent of one destination texel's radius
+        MIP_FILTER_LANCZOS      ///< windowed sinc with three lobes
+    };
+
+    /// Component types of the texels
+    enum MipComponent
+    {
+        MIP_COMPONENT_UNORM8,
+        MIP_COMPONENT_HALF,
+        MIP_COMPONENT_FLOAT
+    };
+
+    /// Layout of the texels being filtered
+    struct MipTexelFormat
+    {
+        MipComponent component;
+        int32_t channels;       ///< 1 to 4 interleaved components per texel
+        int32_t colorChannels;  ///< leading components that are sRGB encoded
+        bool sRGB;              ///< whether colorChannels are sRGB (8-bit only)
+    };
+
+    /// One face or array layer: the pointers to each of its levels.  Level 0
+    /// holds the source; the others are written
+    struct MipChain
+    {
+        uint8_t* const* levels;
+        int32_t width;
+        int32_t height;
+    };
+
+    /// Fills levels 1 to levelCount - 1 of each chain by filtering the level
+    /// above.  Filtering runs in linear float, so 8-bit sRGB texels are
+    /// decoded before averaging and encoded after, and no level is rounded
+    /// to the storage format before the next is filtered from it.  Bands of
+    /// rows of every chain are shared out across threads one level at a time
+    /// \param[in] filter the resampling filter
+    /// \param[in] format the layout of the texels
+    /// \param[in] chains the faces or layers to fill
+    /// \param[in] count the number of chains
+    /// \param[in] levelCount the number of levels in each chain
+    /// \param[in] threadCount the maximum number of threads, counting the
+    /// caller; 0 uses one per hardware thread
+    void generateMips(MipFilter filter, const MipTexelFormat& format, const MipChain* chains,
+        uint32_t count, int32_t levelCount, uint32_t threadCount);
+
+} // nv namespace
+
+#endif // NV_IMAGE_MIPGENERATE_H
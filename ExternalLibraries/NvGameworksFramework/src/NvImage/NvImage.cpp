@@ -33,25 +33,34 @@
 //----------------------------------------------------------------------------------
 
 #include <string.h>
+#include <math.h>
 #include <algorithm>
 #include <NvAssert.h>
 #include "NvAssetLoader/NvAssetLoader.h"
 #include "NvImage/NvImage.h"
-#include "BlockDXT.h"
+#include "DXTCompress.h"
+#include "HalfFloat.h"
+#include "MipGenerate.h"
+#include "SurfaceTransform.h"
 
 using std::vector;
 using std::max;
+using std::min;
 
 #ifdef _WIN32
 #define strcasecmp _stricmp
 #endif
 
 NvImage::FormatInfo NvImage::formatTable[] = {
-    { "dds", NvImage::readDDS, 0}
+    { "dds", NvImage::readDDS, NvImage::writeDDS}
 };
 
 bool NvImage::vertFlip = true;
 bool NvImage::m_expandDXT = true;
+uint32_t NvImage::m_expandDXTThreads = 0;
+bool NvImage::m_compressDXT = false;
+bool NvImage::m_compressDXTHighQuality = false;
+bool NvImage::m_convertToHalf = false;
 bool NvImage::m_supportsBGR = true;
 
 //
@@ -71,6 +80,8 @@ NvImage::NvImage() : _width(0), _height(0), _depth(0), _levelCount(0), _layers(0
 	_dataArrayCount = 0;
 	_data = NULL;
 	_dataBlockSize = 0;
+	_ownsDataBlock = true;
+	_loadInPlace = false;
 }
 
 //
@@ -85,7 +96,11 @@ NvImage::~NvImage() {
 ////////////////////////////////////////////////////////////
 void NvImage::freeData() {
     delete[] _data;
-    delete[] _dataBlock;
+    if (_ownsDataBlock)
+        delete[] _dataBlock;
+    _data = NULL;
+    _dataBlock = NULL;
+    _ownsDataBlock = true;
 }
 
 //
@@ -229,243 +244,464 @@ bool NvImage::loadImageFromFileData(const uint8_t* fileData, size_t size, const
 //
 //
 ////////////////////////////////////////////////////////////
-void NvImage::flipSurface(uint8_t *surf, int32_t width, int32_t height, int32_t depth)
-{
-    uint32_t lineSize;
+bool NvImage::loadImageFromFileDataInPlace(uint8_t* fileData, size_t size, const char* fileExt) {
+    _loadInPlace = true;
+    bool result = loadImageFromFileData(fileData, size, fileExt);
+    _loadInPlace = false;
 
-    depth = (depth) ? depth : 1;
+    return result;
+}
 
-    if (!isCompressed()) {
-        lineSize = _elementSize * width;
-        uint32_t sliceSize = lineSize * height;
+//
+//
+////////////////////////////////////////////////////////////
+bool NvImage::saveImageToFileData(std::vector<uint8_t>& fileData, const char* fileExt) {
+    int32_t formatCount = sizeof(NvImage::formatTable) / sizeof(NvImage::FormatInfo);
 
-        uint8_t *tempBuf = new uint8_t[lineSize];
+    for ( int32_t ii = 0; ii < formatCount; ii++) {
+        if ( ! strcasecmp( formatTable[ii].extension, fileExt)) {
+            if (!formatTable[ii].writer)
+                return false;
+            return formatTable[ii].writer( fileData, *this);
+        }
+    }
 
-        for ( int32_t ii = 0; ii < depth; ii++) {
-            uint8_t *top = surf + ii*sliceSize;
-            uint8_t *bottom = top + (sliceSize - lineSize);
-    
-            for ( int32_t jj = 0; jj < (height >> 1); jj++) {
-                memcpy( tempBuf, top, lineSize);
-                memcpy( top, bottom, lineSize);
-                memcpy( bottom, tempBuf, lineSize);
+    return false;
+}
 
-                top += lineSize;
-                bottom -= lineSize;
+//
+//
+////////////////////////////////////////////////////////////
+bool NvImage::compress(uint32_t format, bool highQuality, uint32_t threads, float* psnr) {
+    nv::BlockFormat blockFormat;
+    switch (format) {
+        case NVIMAGE_COMPRESSED_RGB_S3TC_DXT1:
+        case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1:
+            blockFormat = nv::BLOCK_FORMAT_BC1;
+            break;
+        case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5:
+            blockFormat = nv::BLOCK_FORMAT_BC3;
+            break;
+        case NVIMAGE_COMPRESSED_RED_RGTC1:
+            blockFormat = nv::BLOCK_FORMAT_BC4;
+            break;
+        case NVIMAGE_COMPRESSED_RG_RGTC2:
+            blockFormat = nv::BLOCK_FORMAT_BC5;
+            break;
+        default:
+            return false;
+    }
+
+    if (isCompressed() || _type != NVIMAGE_UNSIGNED_BYTE || !_dataArrayCount)
+        return false;
+
+    // source texels are widened to RGBA8 for the block compressor
+    int32_t channels;
+    switch (_format) {
+        case NVIMAGE_LUMINANCE:
+            channels = 1;
+            break;
+        case NVIMAGE_RGB:
+        case NVIMAGE_BGR:
+            channels = 3;
+            break;
+        case NVIMAGE_RGBA:
+        case NVIMAGE_BGRA:
+            channels = 4;
+            break;
+        default:
+            return false;
+    }
+    bool bgr = (_format == NVIMAGE_BGR) || (_format == NVIMAGE_BGRA);
+
+    size_t texelCount = 0;
+    size_t blockSize = 0;
+    for (int32_t level = 0; level < _levelCount; level++) {
+        int32_t w = max(_width >> level, 1);
+        int32_t h = max(_height >> level, 1);
+        int32_t d = max(_depth >> level, 1);
+        texelCount += (size_t)w * h * d;
+        blockSize += (size_t)((w + 3) / 4) * ((h + 3) / 4) * d * nv::blockBytes(blockFormat);
+    }
+    texelCount *= _dataArrayCount / _levelCount;
+    blockSize *= _dataArrayCount / _levelCount;
+
+    uint32_t* rgba = new uint32_t[texelCount];
+    uint8_t* dataBlock = new uint8_t[blockSize];
+    vector<nv::BlockSurface> surfaces(_dataArrayCount);
+
+    uint32_t* dst = rgba;
+    uint8_t* blocks = dataBlock;
+    for (int32_t index = 0; index < _dataArrayCount; index++) {
+        int32_t level = index % _levelCount;
+        nv::BlockSurface& surface = surfaces[index];
+        surface.width = max(_width >> level, 1);
+        surface.height = max(_height >> level, 1);
+        surface.depth = max(_depth >> level, 1);
+        surface.src = dst;
+        surface.dst = blocks;
+
+        const uint8_t* src = _data[index];
+        size_t count = (size_t)surface.width * surface.height * surface.depth;
+        for (size_t t = 0; t < count; t++, src += channels) {
+            uint32_t r = src[0], g = src[0], b = src[0], a = 0xFF;
+            if (channels >= 3) {
+                r = src[bgr ? 2 : 0];
+                g = src[1];
+                b = src[bgr ? 0 : 2];
             }
+            if (channels == 4)
+                a = src[3];
+            *(dst++) = r | (g << 8) | (b << 16) | (a << 24);
         }
 
-        delete []tempBuf;
+        blocks += ((surface.width + 3) / 4) * ((surface.height + 3) / 4) * surface.depth *
+            nv::blockBytes(blockFormat);
     }
-    else
-    {
-        void (*flipblocks)(uint8_t*, uint32_t);
-        width = (width + 3) / 4;
-        height = (height + 3) / 4;
-        uint32_t blockSize = 0;
 
-        switch (_format)
-        {
-            case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1: 
-                blockSize = 8;
-                flipblocks = &NvImage::flip_blocks_dxtc1; 
-                break;
-            case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT3: 
-                blockSize = 16;
-                flipblocks = &NvImage::flip_blocks_dxtc3; 
-                break;
-            case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5: 
-                blockSize = 16;
-                flipblocks = &NvImage::flip_blocks_dxtc5; 
-                break;
-            case NVIMAGE_COMPRESSED_LUMINANCE_LATC1:
-            case NVIMAGE_COMPRESSED_SIGNED_LUMINANCE_LATC1:
-            case NVIMAGE_COMPRESSED_RED_RGTC1:
-            case NVIMAGE_COMPRESSED_SIGNED_RED_RGTC1:
-                blockSize = 8;
-                flipblocks = &NvImage::flip_blocks_bc4;
-                break;
-            case NVIMAGE_COMPRESSED_LUMINANCE_ALPHA_LATC2:
-            case NVIMAGE_COMPRESSED_SIGNED_LUMINANCE_ALPHA_LATC2:
-            case NVIMAGE_COMPRESSED_RG_RGTC2:
-            case NVIMAGE_COMPRESSED_SIGNED_RG_RGTC2:
-                blockSize = 16;
-                flipblocks = &NvImage::flip_blocks_bc5;
-                break;
-            default:
-                return;
-        }
+    nv::compressDXT(blockFormat, highQuality, &surfaces[0], (uint32_t)surfaces.size(), threads);
 
-        lineSize = width * blockSize;
-        uint8_t *tempBuf = new uint8_t[lineSize];
+    if (psnr) {
+        uint32_t errorChannels;
+        uint64_t error = nv::compressionError(blockFormat, &surfaces[0], (uint32_t)surfaces.size(),
+            errorChannels);
+        double mse = (double)error / ((double)texelCount * errorChannels);
+        *psnr = (mse > 0.0) ? (float)(10.0 * log10(255.0 * 255.0 / mse)) : 100.0f;
+    }
 
-        uint8_t *top = surf;
-        uint8_t *bottom = surf + (height-1) * lineSize;
+    delete[] rgba;
 
-        for (uint32_t j = 0; j < std::max( (uint32_t)height >> 1, (uint32_t)1); j++)
-        {
-            if (top == bottom)
-            {
-                flipblocks(top, width);
-                break;
-            }
+    if (_ownsDataBlock)
+        delete[] _dataBlock;
+    _dataBlock = dataBlock;
+    _ownsDataBlock = true;
+    _dataBlockSize = (int32_t)blockSize;
+    for (int32_t index = 0; index < _dataArrayCount; index++)
+        _data[index] = surfaces[index].dst;
 
-            flipblocks(top, width);
-            flipblocks(bottom, width);
+    _format = format;
+    _internalFormat = format;
+    // as when loaded, compressed data keeps the type of its source components
+    _type = NVIMAGE_UNSIGNED_BYTE;
+    _elementSize = nv::blockBytes(blockFormat);
+    _blockSize_x = 4;
+    _blockSize_y = 4;
 
-            memcpy( tempBuf, top, lineSize);
-            memcpy( top, bottom, lineSize);
-            memcpy( bottom, tempBuf, lineSize);
+    return true;
+}
 
-            top += lineSize;
-            bottom -= lineSize;
-        }
-        delete []tempBuf;
+// The 32-bit and 16-bit float internal formats of a format
+static bool floatInternalFormats(uint32_t format, uint32_t& floatFormat, uint32_t& halfFormat) {
+    switch (format) {
+        case NVIMAGE_RGBA:
+            floatFormat = NVIMAGE_RGBA32F;
+            halfFormat = NVIMAGE_RGBA16F;
+            return true;
+        case NVIMAGE_RGB:
+            floatFormat = NVIMAGE_RGB32F;
+            halfFormat = NVIMAGE_RGB16F;
+            return true;
+        case NVIMAGE_RG:
+            floatFormat = NVIMAGE_RG32F;
+            halfFormat = NVIMAGE_RG16F;
+            return true;
+        case NVIMAGE_RED:
+            floatFormat = NVIMAGE_R32F;
+            halfFormat = NVIMAGE_R16F;
+            return true;
+        case NVIMAGE_LUMINANCE:
+            floatFormat = NVIMAGE_LUMINANCE32F;
+            halfFormat = NVIMAGE_LUMINANCE16F;
+            return true;
+        case NVIMAGE_ALPHA:
+            floatFormat = NVIMAGE_ALPHA32F;
+            halfFormat = NVIMAGE_ALPHA16F;
+            return true;
+        case NVIMAGE_LUMINANCE_ALPHA:
+            floatFormat = NVIMAGE_LUMINANCE_ALPHA32F;
+            halfFormat = NVIMAGE_LUMINANCE_ALPHA16F;
+            return true;
+        default:
+            return false;
     }
-}    
+}
 
 //
 //
 ////////////////////////////////////////////////////////////
-uint32_t NvImage::componentSwapSurface(uint8_t *surf, int32_t width, int32_t height, int32_t depth)
-{
-    depth = (depth) ? depth : 1;
+bool NvImage::convertToHalfFloat() {
+    uint32_t floatFormat, halfFormat;
+    if (!floatInternalFormats(_format, floatFormat, halfFormat))
+        return false;
 
-    if (_type != NVIMAGE_UNSIGNED_BYTE)
-        return _format;
-    if (isCompressed())
-        return _format;
+    if (_type != NVIMAGE_FLOAT || (_elementSize % 4) || !_dataArrayCount)
+        return false;
 
-    if (_format == NVIMAGE_BGR) {
-        for ( int32_t ii = 0; ii < depth; ii++) {    
-            for ( int32_t jj = 0; jj < height; jj++) {
-                for ( int32_t kk = 0; kk < width; kk++) {
-                    uint8_t tmp = surf[0];
-                    surf[0] = surf[2];
-                    surf[2] = tmp;
-                    surf += 3;
-                }
-            }
-        }
-        return NVIMAGE_RGB;
-    } else if (_format == NVIMAGE_BGRA) {
-        for ( int32_t ii = 0; ii < depth; ii++) {    
-            for ( int32_t jj = 0; jj < height; jj++) {
-                for ( int32_t kk = 0; kk < width; kk++) {
-                    uint8_t tmp = surf[0];
-                    surf[0] = surf[2];
-                    surf[2] = tmp;
-                    surf += 4;
-                }
-            }
-        }
-        return NVIMAGE_RGBA;
-    }
-    return _format;
-}    
+    // every surface lies in the data block, so the whole block is narrowed
+    // from the front and each surface moves to half its offset
+    nv::floatsToHalves((const float*)_dataBlock, (uint16_t*)_dataBlock, _dataBlockSize / sizeof(float));
+    for (int32_t index = 0; index < _dataArrayCount; index++)
+        _data[index] = _dataBlock + (_data[index] - _dataBlock) / 2;
 
-static inline int32_t min(int32_t a, int32_t b) {
-    return (a <= b) ? a : b;
+    _dataBlockSize /= 2;
+    _elementSize /= 2;
+    _type = NVIMAGE_HALF_FLOAT;
+    _internalFormat = halfFormat;
+
+    return true;
 }
 
 //
 //
 ////////////////////////////////////////////////////////////
-void NvImage::expandDXT(uint8_t *surf, int32_t width, int32_t height, int32_t depth, int32_t srcSize)
-{
-    depth = (depth) ? depth : 1;
+bool NvImage::convertToFloat() {
+    uint32_t floatFormat, halfFormat;
+    if (!floatInternalFormats(_format, floatFormat, halfFormat))
+        return false;
 
-	uint32_t* dest = (uint32_t*)surf;
-    uint32_t* plane = dest;
+    if (_type != NVIMAGE_HALF_FLOAT || (_elementSize % 2) || !_dataArrayCount)
+        return false;
 
-	uint8_t* srcBlock = new uint8_t[srcSize];
-	uint8_t* src = srcBlock;
-	memcpy(src, surf, srcSize);
+    // the surfaces keep their order, each at twice its offset
+    uint8_t* dataBlock = new uint8_t[_dataBlockSize * 2];
+    nv::halvesToFloats((const uint16_t*)_dataBlock, (float*)dataBlock, _dataBlockSize / sizeof(uint16_t));
+    for (int32_t index = 0; index < _dataArrayCount; index++)
+        _data[index] = dataBlock + (_data[index] - _dataBlock) * 2;
+
+    if (_ownsDataBlock)
+        delete[] _dataBlock;
+    _dataBlock = dataBlock;
+    _ownsDataBlock = true;
+    _dataBlockSize *= 2;
+    _elementSize *= 2;
+    _type = NVIMAGE_FLOAT;
+    _internalFormat = floatFormat;
 
-    int32_t bh = (height + 3) / 4;
-    int32_t bw = (width + 3) / 4;
+    return true;
+}
 
-    if (_format == NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1) {
-        for (int32_t k = 0; k < depth; k++) {
+//
+//
+////////////////////////////////////////////////////////////
+bool NvImage::generateMipmaps(NvImageMipFilter::Enum filter, bool sRGB, uint32_t threads) {
+    if (isCompressed() || isVolume() || !_dataArrayCount)
+        return false;
 
-            for (int32_t j = 0; j < bh; j++) {
-                int32_t yBlockSize = min(4, height - 4 * j);
+    nv::MipTexelFormat texelFormat;
+    switch (_type) {
+        case NVIMAGE_UNSIGNED_BYTE:
+            texelFormat.component = nv::MIP_COMPONENT_UNORM8;
+            break;
+        case NVIMAGE_HALF_FLOAT:
+            texelFormat.component = nv::MIP_COMPONENT_HALF;
+            break;
+        case NVIMAGE_FLOAT:
+            texelFormat.component = nv::MIP_COMPONENT_FLOAT;
+            break;
+        default:
+            return false;
+    }
 
-                for (int32_t i = 0; i < bw; i++) {
-                    int32_t xBlockSize = min(4, width - 4 * i);
-                    nv::BlockDXT1* block = (nv::BlockDXT1*)src;
-                    nv::ColorBlock color;
+    switch (_format) {
+        case NVIMAGE_RGBA:
+        case NVIMAGE_BGRA:
+            texelFormat.channels = 4;
+            texelFormat.colorChannels = 3;
+            break;
+        case NVIMAGE_RGB:
+        case NVIMAGE_BGR:
+            texelFormat.channels = 3;
+            texelFormat.colorChannels = 3;
+            break;
+        case NVIMAGE_RG:
+            texelFormat.channels = 2;
+            texelFormat.colorChannels = 2;
+            break;
+        case NVIMAGE_LUMINANCE_ALPHA:
+            texelFormat.channels = 2;
+            texelFormat.colorChannels = 1;
+            break;
+        case NVIMAGE_RED:
+        case NVIMAGE_LUMINANCE:
+            texelFormat.channels = 1;
+            texelFormat.colorChannels = 1;
+            break;
+        case NVIMAGE_ALPHA:
+            texelFormat.channels = 1;
+            texelFormat.colorChannels = 0;
+            break;
+        default:
+            return false;
+    }
 
-                    block->decodeBlock(&color);
+    // packed types share the enums of the formats above but not their sizes
+    int32_t componentSize = (_type == NVIMAGE_UNSIGNED_BYTE) ? 1 : ((_type == NVIMAGE_HALF_FLOAT) ? 2 : 4);
+    if (_elementSize != componentSize * texelFormat.channels)
+        return false;
 
-                    // Write color block.
-                    for (int32_t y = 0; y < yBlockSize; y++) {
-                        for (int32_t x = 0; x < xBlockSize; x++) {
-                            plane[4*i+x + (4*j+y)*width] = (uint32_t)color.color(x, y);
-                        }
-                    }
+    texelFormat.sRGB = (_type == NVIMAGE_UNSIGNED_BYTE) &&
+        (sRGB || _internalFormat == NVIMAGE_SRGB8 || _internalFormat == NVIMAGE_SRGB8_ALPHA8);
 
-                    src += sizeof(nv::BlockDXT1); // 64bits
-                }
-            }
+    int32_t levelCount = 1;
+    while ((_width >> levelCount) || (_height >> levelCount))
+        levelCount++;
+
+    int32_t layerSize = 0;
+    for (int32_t level = 0; level < levelCount; level++)
+        layerSize += max(_width >> level, 1) * max(_height >> level, 1) * _elementSize;
+
+    // level 0 of each layer moves into a block laid out for the new chain
+    uint8_t* dataBlock = new uint8_t[layerSize * _layers];
+    uint8_t** data = new uint8_t*[_layers * levelCount];
+    vector<nv::MipChain> chains(_layers);
 
-            plane += width * height;
+    for (int32_t layer = 0; layer < _layers; layer++) {
+        uint8_t* ptr = dataBlock + layer * layerSize;
+        for (int32_t level = 0; level < levelCount; level++) {
+            data[layer * levelCount + level] = ptr;
+            ptr += max(_width >> level, 1) * max(_height >> level, 1) * _elementSize;
         }
-    } else if (_format == NVIMAGE_COMPRESSED_RGBA_S3TC_DXT3) {
-        for (int32_t k = 0; k < depth; k++) {
+        memcpy(data[layer * levelCount], _data[layer * _levelCount], _width * _height * _elementSize);
 
-            for (int32_t j = 0; j < bh; j++) {
-                int32_t yBlockSize = min(4, height - 4 * j);
+        chains[layer].levels = &data[layer * levelCount];
+        chains[layer].width = _width;
+        chains[layer].height = _height;
+    }
 
-                for (int32_t i = 0; i < bw; i++) {
-                    int32_t xBlockSize = min(4, width - 4 * i);
-                    nv::BlockDXT3* block = (nv::BlockDXT3*)src;
-                    nv::ColorBlock color;
+    nv::MipFilter mipFilter = (filter == NvImageMipFilter::TRIANGLE) ? nv::MIP_FILTER_TRIANGLE :
+        ((filter == NvImageMipFilter::LANCZOS) ? nv::MIP_FILTER_LANCZOS : nv::MIP_FILTER_BOX);
+    nv::generateMips(mipFilter, texelFormat, &chains[0], (uint32_t)_layers, levelCount, threads);
 
-                    block->decodeBlock(&color);
+    freeData();
+    _dataBlock = dataBlock;
+    _dataBlockSize = layerSize * _layers;
+    _data = data;
+    _dataArrayCount = _layers * levelCount;
+    _levelCount = levelCount;
 
-                    // Write color block.
-                    for (int32_t y = 0; y < yBlockSize; y++) {
-                        for (int32_t x = 0; x < xBlockSize; x++) {
-                            plane[4*i+x + (4*j+y)*width] = (uint32_t)color.color(x, y);
-                        }
-                    }
+    return true;
+}
 
-                    src += sizeof(nv::BlockDXT3); // 64bits
-                }
-            }
+//
+//
+////////////////////////////////////////////////////////////
+uint32_t NvImage::transformSurface(const uint8_t *src, uint8_t *dst, int32_t width, int32_t height, int32_t depth,
+    bool flip, bool swapRB)
+{
+    nv::SurfaceTransform transform;
+    transform.elementSize = _elementSize;
+    transform.flip = flip;
+    transform.swapRB = swapRB && (_type == NVIMAGE_UNSIGNED_BYTE) &&
+        ((_format == NVIMAGE_BGR) || (_format == NVIMAGE_BGRA));
 
-            plane += width * height;
-        }
+    size_t rowBytes = (size_t)width * _elementSize;
+    int32_t rows = height;
+
+    if (!isCompressed()) {
+        transform.layout = nv::SURFACE_LAYOUT_TEXELS;
     } else {
-        for (int32_t k = 0; k < depth; k++) {
+        rowBytes = (size_t)((width + _blockSize_x - 1) / _blockSize_x) * _elementSize;
+        rows = (height + _blockSize_y - 1) / _blockSize_y;
+
+        switch (_format)
+        {
+            case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1:
+                transform.layout = nv::SURFACE_LAYOUT_DXT1;
+                break;
+            case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT3:
+                transform.layout = nv::SURFACE_LAYOUT_DXT3;
+                break;
+            case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5:
+                transform.layout = nv::SURFACE_LAYOUT_DXT5;
+                break;
+            case NVIMAGE_COMPRESSED_LUMINANCE_LATC1:
+            case NVIMAGE_COMPRESSED_SIGNED_LUMINANCE_LATC1:
+            case NVIMAGE_COMPRESSED_RED_RGTC1:
+            case NVIMAGE_COMPRESSED_SIGNED_RED_RGTC1:
+                transform.layout = nv::SURFACE_LAYOUT_BC4;
+                break;
+            case NVIMAGE_COMPRESSED_LUMINANCE_ALPHA_LATC2:
+            case NVIMAGE_COMPRESSED_SIGNED_LUMINANCE_ALPHA_LATC2:
+            case NVIMAGE_COMPRESSED_RG_RGTC2:
+            case NVIMAGE_COMPRESSED_SIGNED_RG_RGTC2:
+                transform.layout = nv::SURFACE_LAYOUT_BC5;
+                break;
+            default:
+                transform.layout = nv::SURFACE_LAYOUT_OTHER;
+                break;
+        }
+    }
+
+    nv::transformSurface(transform, src, dst, rowBytes, rows, (depth) ? depth : 1);
 
-            for (int32_t j = 0; j < bh; j++) {
-                int32_t yBlockSize = min(4U, height - 4 * j);
+    if (!transform.swapRB)
+        return _format;
 
-                for (int32_t i = 0; i < bw; i++) {
-                    int32_t xBlockSize = min(4, width - 4 * i);
-                    nv::BlockDXT5* block = (nv::BlockDXT5*)src;
-                    nv::ColorBlock color;
+    return (_format == NVIMAGE_BGR) ? NVIMAGE_RGB : NVIMAGE_RGBA;
+}
 
-                    block->decodeBlock(&color);
+//
+//
+////////////////////////////////////////////////////////////
+bool NvImage::downscale(NvImage& dst, int32_t levels, NvImageMipFilter::Enum filter, uint32_t threads) const {
+    if (&dst == this || levels < 0 || isVolume() || !_dataArrayCount)
+        return false;
 
-                    // Write color block.
-                    for (int32_t y = 0; y < yBlockSize; y++) {
-                        for (int32_t x = 0; x < xBlockSize; x++) {
-                            plane[4*i+x + (4*j+y)*width] = (uint32_t)color.color(x, y);
-                        }
-                    }
+    if (levels < _levelCount) {
+        dst.copyLevels(*this, levels, _levelCount - levels);
+        return true;
+    }
 
-                    src += sizeof(nv::BlockDXT5); // 64bits
-                }
-            }
+    if (isCompressed())
+        return false;
 
-            plane += width * height;
+    NvImage chain;
+    chain.copyLevels(*this, 0, 1);
+    if (!chain.generateMipmaps(filter, false, threads))
+        return false;
+
+    levels = min(levels, chain._levelCount - 1);
+    dst.copyLevels(chain, levels, min(_levelCount, chain._levelCount - levels));
+    return true;
+}
+
+//
+//
+////////////////////////////////////////////////////////////
+void NvImage::copyLevels(const NvImage& src, int32_t firstLevel, int32_t levelCount) {
+    freeData();
+
+    _width = max(src._width >> firstLevel, 1);
+    _height = max(src._height >> firstLevel, 1);
+    _depth = src._depth;
+    _layers = src._layers;
+    _levelCount = levelCount;
+    _format = src._format;
+    _internalFormat = src._internalFormat;
+    _type = src._type;
+    _elementSize = src._elementSize;
+    _blockSize_x = src._blockSize_x;
+    _blockSize_y = src._blockSize_y;
+    _cubeMap = src._cubeMap;
+
+    int32_t layerSize = 0;
+    for (int32_t level = 0; level < levelCount; level++)
+        layerSize += src.getImageSize(firstLevel + level);
+
+    _dataArrayCount = _layers * levelCount;
+    _data = new uint8_t*[_dataArrayCount];
+    _dataBlockSize = layerSize * _layers;
+    _dataBlock = new uint8_t[_dataBlockSize];
+
+    uint8_t* ptr = _dataBlock;
+    for (int32_t layer = 0; layer < _layers; layer++) {
+        for (int32_t level = 0; level < levelCount; level++) {
+            int32_t size = src.getImageSize(firstLevel + level);
+            _data[layer * levelCount + level] = ptr;
+            memcpy(ptr, src.getLayerLevel(firstLevel + level, layer), size);
+            ptr += size;
         }
     }
-
-	delete[] srcBlock;
 }
 
 //
@@ -490,6 +726,7 @@ bool NvImage::convertCrossToCubemap() {
 
     //get the source data
     uint8_t *data = _data[0];
+    bool ownsData = _ownsDataBlock;
 
     int32_t fWidth = _width / 3;
     int32_t fHeight = _height / 4;
@@ -501,6 +738,7 @@ bool NvImage::convertCrossToCubemap() {
 
 	_dataBlockSize = fWidth * fHeight * _elementSize * 6;
 	_dataBlock = new uint8_t[_dataBlockSize];
+	_ownsDataBlock = true;
     
     //extract the faces
 	uint8_t *ptr = _dataBlock;
@@ -556,7 +794,8 @@ bool NvImage::convertCrossToCubemap() {
     _cubeMap = true;
 
     //delete the old pointer
-    delete []data;
+    if (ownsData)
+        delete []data;
 
     return true;
 }
@@ -727,6 +966,10 @@ bool NvImage::isCompressed() const {
         case NVIMAGE_COMPRESSED_RED_RGTC1:
         case NVIMAGE_COMPRESSED_SIGNED_RG_RGTC2:
         case NVIMAGE_COMPRESSED_SIGNED_RED_RGTC1:
+        case NVIMAGE_COMPRESSED_RGBA_BPTC_UNORM:
+        case NVIMAGE_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+        case NVIMAGE_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+        case NVIMAGE_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
 		case NVIMAGE_COMPRESSED_RGBA_ASTC_4x4:
 		case NVIMAGE_COMPRESSED_RGBA_ASTC_5x4:
 		case NVIMAGE_COMPRESSED_RGBA_ASTC_5x5:
@@ -770,6 +1013,8 @@ bool NvImage::hasAlpha() const {
         case NVIMAGE_COMPRESSED_SIGNED_LUMINANCE_LATC1:
         case NVIMAGE_COMPRESSED_LUMINANCE_ALPHA_LATC2:
         case NVIMAGE_COMPRESSED_SIGNED_LUMINANCE_ALPHA_LATC2:
+        case NVIMAGE_COMPRESSED_RGBA_BPTC_UNORM:
+        case NVIMAGE_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
         case NVIMAGE_ALPHA:
         case NVIMAGE_LUMINANCE_ALPHA:
         case NVIMAGE_RGBA:
@@ -37,6 +37,7 @@
 
 #include "NvImage/NvImage.h"
 #include "NvFilePtr.h"
+#include "DXTExpand.h"
 #include "NV/NvLogs.h"
 
 using std::vector;
@@ -302,27 +303,6 @@ const uint32_t DDS10_RESOURCE_DIMENSION_TEXTURE2D = 3;
 const uint32_t DDS10_RESOURCE_DIMENSION_TEXTURE3D = 4;
 
 
-struct DXTColBlock
-{
-    uint16_t col0;
-    uint16_t col1;
-
-    uint8_t row[4];
-};
-
-struct DXT3AlphaBlock
-{
-    uint16_t row[4];
-};
-
-struct DXT5AlphaBlock
-{
-    uint8_t alpha0;
-    uint8_t alpha1;
-    
-    uint8_t row[6];
-};
-
 struct DDS_PIXELFORMAT
 {
     uint32_t dwSize;
@@ -629,15 +609,15 @@ bool TranslateDX10Format( const void *ptr, NvImage &i, int32_t &bytesPerElement,
             break;
 
         case DDS10_FORMAT_BC2_UNORM_SRGB:
-            SET_COMPRESSED_TYPE_INFO( NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1, NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1, NVIMAGE_UNSIGNED_BYTE, 16);
+            SET_COMPRESSED_TYPE_INFO( NVIMAGE_COMPRESSED_RGBA_S3TC_DXT3, NVIMAGE_COMPRESSED_RGBA_S3TC_DXT3, NVIMAGE_UNSIGNED_BYTE, 16);
             break;
 
         case DDS10_FORMAT_BC3_UNORM:
-            SET_COMPRESSED_TYPE_INFO( NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1, NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1, NVIMAGE_UNSIGNED_BYTE, 16);
+            SET_COMPRESSED_TYPE_INFO( NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5, NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5, NVIMAGE_UNSIGNED_BYTE, 16);
             break;
 
         case DDS10_FORMAT_BC3_UNORM_SRGB:
-            SET_COMPRESSED_TYPE_INFO( NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1, NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1, NVIMAGE_UNSIGNED_BYTE, 16);
+            SET_COMPRESSED_TYPE_INFO( NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5, NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5, NVIMAGE_UNSIGNED_BYTE, 16);
             break;
 
         case DDS10_FORMAT_BC4_UNORM:
@@ -656,6 +636,22 @@ bool TranslateDX10Format( const void *ptr, NvImage &i, int32_t &bytesPerElement,
             SET_COMPRESSED_TYPE_INFO( NVIMAGE_COMPRESSED_SIGNED_RG_RGTC2, NVIMAGE_COMPRESSED_SIGNED_RG_RGTC2, NVIMAGE_UNSIGNED_BYTE, 16);
             break;
 
+        case DDS10_FORMAT_BC6H_UF16:
+            SET_COMPRESSED_TYPE_INFO( NVIMAGE_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, NVIMAGE_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, NVIMAGE_UNSIGNED_BYTE, 16);
+            break;
+
+        case DDS10_FORMAT_BC6H_SF16:
+            SET_COMPRESSED_TYPE_INFO( NVIMAGE_COMPRESSED_RGB_BPTC_SIGNED_FLOAT, NVIMAGE_COMPRESSED_RGB_BPTC_SIGNED_FLOAT, NVIMAGE_UNSIGNED_BYTE, 16);
+            break;
+
+        case DDS10_FORMAT_BC7_UNORM:
+            SET_COMPRESSED_TYPE_INFO( NVIMAGE_COMPRESSED_RGBA_BPTC_UNORM, NVIMAGE_COMPRESSED_RGBA_BPTC_UNORM, NVIMAGE_UNSIGNED_BYTE, 16);
+            break;
+
+        case DDS10_FORMAT_BC7_UNORM_SRGB:
+            SET_COMPRESSED_TYPE_INFO( NVIMAGE_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, NVIMAGE_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, NVIMAGE_UNSIGNED_BYTE, 16);
+            break;
+
         case DDS10_FORMAT_B5G6R5_UNORM:
             SET_TYPE_INFO( NVIMAGE_RGB5, NVIMAGE_BGR, NVIMAGE_UNSIGNED_SHORT_5_6_5, 2);
             break;
@@ -830,6 +826,8 @@ bool TranslateDX10Format( const void *ptr, NvImage &i, int32_t &bytesPerElement,
         case DDS10_FORMAT_BC4_TYPELESS:
         case DDS10_FORMAT_BC2_TYPELESS:
         case DDS10_FORMAT_BC5_TYPELESS:
+        case DDS10_FORMAT_BC6H_TYPELESS:
+        case DDS10_FORMAT_BC7_TYPELESS:
         case DDS10_FORMAT_B8G8R8A8_TYPELESS:
         case DDS10_FORMAT_B8G8R8X8_TYPELESS:
 		case DDS10_FORMAT_ASTC_5X4_TYPELESS:
@@ -851,12 +849,6 @@ bool TranslateDX10Format( const void *ptr, NvImage &i, int32_t &bytesPerElement,
 
         case DDS10_FORMAT_R10G10B10_XR_BIAS_A2_UNORM:
         case DDS10_FORMAT_R1_UNORM:
-        case DDS10_FORMAT_BC6H_TYPELESS:
-        case DDS10_FORMAT_BC6H_UF16:
-        case DDS10_FORMAT_BC6H_SF16:
-        case DDS10_FORMAT_BC7_TYPELESS:
-        case DDS10_FORMAT_BC7_UNORM:
-        case DDS10_FORMAT_BC7_UNORM_SRGB:
             //these formats are unsupported presently
             return false;
 
@@ -905,6 +897,7 @@ bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
     
     //fread(&ddsh, sizeof(DDS_HEADER), 1, fp);
     fp->Read( sizeof(DDS_HEADER), &ddsh);
+    size_t headerSize = 4 + sizeof(DDS_HEADER);
 
     // check if image is a volume texture
     if ((ddsh.dwCaps2 & DDSF_VOLUME) && (ddsh.dwDepth > 0))
@@ -916,6 +909,7 @@ bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
         //This DDS file uses the DX10 header extension
         //fread(&ddsh10, sizeof(DDS_HEADER_10), 1, fp);
         fp->Read( sizeof(DDS_HEADER_10), &ddsh10);
+        headerSize += sizeof(DDS_HEADER_10);
     }
 
     // There are flags that are supposed to mark these fields as valid, but some dds files don't set them properly
@@ -1353,18 +1347,44 @@ bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
 
     i._elementSize = bytesPerElement;
 
-	delete[] i._dataBlock;
-	delete[] i._data;
+	i.freeData();
 
-    bool mustExpandDXT = m_expandDXT &&
-        ((i._format == NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1) ||
-        (i._format == NVIMAGE_COMPRESSED_RGBA_S3TC_DXT3) ||
-        (i._format == NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5));
+    // the block formats the expander decodes, to RGBA8 or, for BC6H, RGBA16F
+    bool mustExpandDXT = m_expandDXT;
+    nv::DXTFormat dxtFormat = nv::DXT_FORMAT_DXT1;
+    int32_t expandedSize = 4;
+    switch (i._format) {
+        case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1:
+            dxtFormat = nv::DXT_FORMAT_DXT1;
+            break;
+        case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT3:
+            dxtFormat = nv::DXT_FORMAT_DXT3;
+            break;
+        case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5:
+            dxtFormat = nv::DXT_FORMAT_DXT5;
+            break;
+        case NVIMAGE_COMPRESSED_RGBA_BPTC_UNORM:
+        case NVIMAGE_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+            dxtFormat = nv::DXT_FORMAT_BC7;
+            break;
+        case NVIMAGE_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+            dxtFormat = nv::DXT_FORMAT_BC6H_UF16;
+            expandedSize = 8;
+            break;
+        case NVIMAGE_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+            dxtFormat = nv::DXT_FORMAT_BC6H_SF16;
+            expandedSize = 8;
+            break;
+        default:
+            mustExpandDXT = false;
+            break;
+    }
 
 	i._dataArrayCount = i._layers * i._levelCount;
 	i._data = new uint8_t*[i._dataArrayCount];
 
 	int32_t totalSize = 0;
+	int32_t packedSize = 0;
 	{
 		for (int32_t face = 0; face < i._layers; face++) {
 			int32_t w = i._width, h = i._height, d = (i._depth) ? i._depth : 1;
@@ -1372,29 +1392,49 @@ bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
 				int32_t bw = (btcCompressed) ? (w - 1) / i._blockSize_x + 1 : w;
 				int32_t bh = (btcCompressed) ? (h - 1) / i._blockSize_y + 1 : h;
 				int32_t readSize = bw*bh*d*bytesPerElement;
-				int32_t allocSize = mustExpandDXT ? (w * h * 4) : readSize;
+				int32_t allocSize = mustExpandDXT ? (w * h * d * expandedSize) : readSize;
 
 				totalSize += allocSize;
+				packedSize += readSize;
 
 				//reduce mip sizes
-				if (!btcCompressed) {
-					w = (w > 1) ? w >> 1 : 1;
-					h = (h > 1) ? h >> 1 : 1;
-					d = (d > 1) ? d >> 1 : 1;
-				}
+				w = (w > 1) ? w >> 1 : 1;
+				h = (h > 1) ? h >> 1 : 1;
+				d = (d > 1) ? d >> 1 : 1;
 			}
 		}
 	}
 
-	i._dataBlock = new uint8_t[totalSize];
+	// the texels are taken straight from the file data, so it must hold
+	// every level
+	if (headerSize + packedSize > length) {
+		delete fp;
+		return false;
+	}
+	const uint8_t* source = (const uint8_t*)data + headerSize;
+
+	// in-place loads that need no expansion keep the file data as the image;
+	// any flip or swap is then applied where the texels lie
+	if (i._loadInPlace && !mustExpandDXT) {
+		i._dataBlock = (uint8_t*)source;
+		i._ownsDataBlock = false;
+	} else {
+		i._dataBlock = new uint8_t[totalSize];
+		i._ownsDataBlock = true;
+	}
 	i._dataBlockSize = totalSize;
 	uint8_t* ptr = i._dataBlock;
 	int currentLevel = 0;
 
+	// DXT levels are expanded from the file data once they have all been
+	// gathered, so the levels can be decoded in parallel
+	vector<nv::DXTSurface> surfaces;
+
     // Use the original format when performing component swaps, but store any new
     // format in the image once the loop over all faces/levels is complete
     uint32_t originalFormat = i._format;
     uint32_t finalFormat = i._format;
+    bool flip = NvImage::vertFlip && !i._cubeMap;
 
     for (int32_t face = 0; face < i._layers; face++) {
         int32_t w = i._width, h = i._height, d = (i._depth) ? i._depth : 1;
@@ -1402,24 +1442,20 @@ bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
 			int32_t bw = (btcCompressed) ? (w-1)/i._blockSize_x+1 : w;
 			int32_t bh = (btcCompressed) ? (h-1)/i._blockSize_y+1 : h;
             int32_t readSize = bw*bh*d*bytesPerElement;
-			int32_t allocSize = mustExpandDXT ? (w * h * 4) : readSize;
+			int32_t allocSize = mustExpandDXT ? (w * h * d * expandedSize) : readSize;
 
-			uint8_t *pixels = ptr;
 			i._data[currentLevel++] = ptr;
-			ptr += allocSize;
-
-            //fread( data, size, 1, fp);
-			fp->Read(readSize, pixels);
-			
-            if ( NvImage::vertFlip && !i._cubeMap)
-                i.flipSurface( pixels, w, h, d);
 
-            if (!m_supportsBGR)
-                finalFormat = i.componentSwapSurface(pixels, w, h, d);
-
-            // do we need to expand DXT?
-            if (mustExpandDXT)
-				i.expandDXT(pixels, w, h, d, readSize);
+            // expansion flips as it decodes; everything else is copied, flipped
+            // and swizzled in a single pass
+            if (mustExpandDXT) {
+                nv::DXTSurface surface = { source, ptr, w, h, d, flip };
+                surfaces.push_back(surface);
+            } else {
+                finalFormat = i.transformSurface(source, ptr, w, h, d, flip, !m_supportsBGR);
+            }
+			source += readSize;
+			ptr += allocSize;
 
             //reduce mip sizes
             w = ( w > 1) ? w >> 1 : 1;
@@ -1429,206 +1465,158 @@ bool NvImage::readDDS(const uint8_t* data, size_t length, NvImage& i) {
     }
 
     if (mustExpandDXT) {
+        nv::expandDXT(dxtFormat, &surfaces[0], (uint32_t)surfaces.size(),
+            m_expandDXTThreads);
+
         i._format = NVIMAGE_RGBA;
-        i._type = NVIMAGE_UNSIGNED_BYTE;
-		i._internalFormat = NVIMAGE_RGBA8;
+        if (expandedSize == 8) {
+            i._type = NVIMAGE_HALF_FLOAT;
+            i._internalFormat = NVIMAGE_RGBA16F;
+        } else {
+            i._type = NVIMAGE_UNSIGNED_BYTE;
+            i._internalFormat = (originalFormat == NVIMAGE_COMPRESSED_SRGB_ALPHA_BPTC_UNORM) ?
+                NVIMAGE_SRGB8_ALPHA8 : NVIMAGE_RGBA8;
+        }
+        i._elementSize = expandedSize;
     }
     else
     {
         i._format = finalFormat;
     }
 
+    // uncompressed 8-bit images are compressed as they load if requested;
+    // formats the compressor does not take are left as they are
+    if (m_compressDXT && !btcCompressed)
+        i.compress(i.hasAlpha() ? NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5 : NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1,
+            m_compressDXTHighQuality, m_expandDXTThreads);
+
+    // and 32-bit float images are narrowed to half floats
+    if (m_convertToHalf && i._type == NVIMAGE_FLOAT)
+        i.convertToHalfFloat();
+
     //fclose(fp);
     delete fp;
     return true;
 }
 
 //
-// flip a DXT1 color block
-////////////////////////////////////////////////////////////
-void NvImage::flip_blocks_dxtc1(uint8_t *ptr, uint32_t numBlocks)
-{
-    DXTColBlock *curblock = (DXTColBlock*)ptr;
-    uint8_t temp;
-
-    for (uint32_t i = 0; i < numBlocks; i++) {
-        temp = curblock->row[0];
-        curblock->row[0] = curblock->row[3];
-        curblock->row[3] = temp;
-        temp = curblock->row[1];
-        curblock->row[1] = curblock->row[2];
-        curblock->row[2] = temp;
-
-        curblock++;
-    }
-}
-
 //
-// flip a DXT3 color block
 ////////////////////////////////////////////////////////////
-void NvImage::flip_blocks_dxtc3(uint8_t *ptr, uint32_t numBlocks)
-{
-    DXTColBlock *curblock = (DXTColBlock*)ptr;
-    DXT3AlphaBlock *alphablock;
-    uint16_t tempS;
-    uint8_t tempB;
-
-    for (uint32_t i = 0; i < numBlocks; i++)
-    {
-        alphablock = (DXT3AlphaBlock*)curblock;
-
-        tempS = alphablock->row[0];
-        alphablock->row[0] = alphablock->row[3];
-        alphablock->row[3] = tempS;
-        tempS = alphablock->row[1];
-        alphablock->row[1] = alphablock->row[2];
-        alphablock->row[2] = tempS;
-
-        curblock++;
+bool NvImage::writeDDS(vector<uint8_t>& fileData, NvImage& i) {
+    DDS_HEADER ddsh;
+    memset(&ddsh, 0, sizeof(ddsh));
 
-        tempB = curblock->row[0];
-        curblock->row[0] = curblock->row[3];
-        curblock->row[3] = tempB;
-        tempB = curblock->row[1];
-        curblock->row[1] = curblock->row[2];
-        curblock->row[2] = tempB;
+    bool compressed = i.isCompressed();
+    DDS_PIXELFORMAT& pf = ddsh.ddspf;
+    pf.dwSize = sizeof(DDS_PIXELFORMAT);
 
-        curblock++;
+    switch (i._format) {
+        case NVIMAGE_COMPRESSED_RGB_S3TC_DXT1:
+        case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1:
+            pf.dwFlags = DDSF_FOURCC;
+            pf.dwFourCC = FOURCC_DXT1;
+            break;
+        case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT3:
+            pf.dwFlags = DDSF_FOURCC;
+            pf.dwFourCC = FOURCC_DXT3;
+            break;
+        case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5:
+            pf.dwFlags = DDSF_FOURCC;
+            pf.dwFourCC = FOURCC_DXT5;
+            break;
+        case NVIMAGE_COMPRESSED_RED_RGTC1:
+            pf.dwFlags = DDSF_FOURCC;
+            pf.dwFourCC = FOURCC_ATI1;
+            break;
+        case NVIMAGE_COMPRESSED_RG_RGTC2:
+            pf.dwFlags = DDSF_FOURCC;
+            pf.dwFourCC = FOURCC_ATI2;
+            break;
+        case NVIMAGE_RGBA:
+        case NVIMAGE_BGRA:
+            if (i._type != NVIMAGE_UNSIGNED_BYTE)
+                return false;
+            pf.dwFlags = DDSF_RGBA;
+            pf.dwRGBBitCount = 32;
+            pf.dwRBitMask = (i._format == NVIMAGE_RGBA) ? 0x000000ff : 0x00ff0000;
+            pf.dwGBitMask = 0x0000ff00;
+            pf.dwBBitMask = (i._format == NVIMAGE_RGBA) ? 0x00ff0000 : 0x000000ff;
+            pf.dwABitMask = 0xff000000;
+            break;
+        case NVIMAGE_BGR:
+            if (i._type != NVIMAGE_UNSIGNED_BYTE)
+                return false;
+            pf.dwFlags = DDSF_RGB;
+            pf.dwRGBBitCount = 24;
+            pf.dwRBitMask = 0x00ff0000;
+            pf.dwGBitMask = 0x0000ff00;
+            pf.dwBBitMask = 0x000000ff;
+            break;
+        case NVIMAGE_LUMINANCE:
+            if (i._type != NVIMAGE_UNSIGNED_BYTE)
+                return false;
+            pf.dwFlags = DDSF_RGB;
+            pf.dwRGBBitCount = 8;
+            pf.dwRBitMask = 0x000000ff;
+            break;
+        default:
+            return false;
     }
-}
-
-//
-// flip a DXT5 alpha block
-////////////////////////////////////////////////////////////
-void flip_dxt5_alpha(DXT5AlphaBlock *block)
-{
-    uint8_t gBits[4][4];
-    
-    const uint32_t mask = 0x00000007;          // bits = 00 00 01 11
-    uint32_t bits = 0;
-    memcpy(&bits, &block->row[0], sizeof(uint8_t) * 3);
-
-    gBits[0][0] = (uint8_t)(bits & mask);
-    bits >>= 3;
-    gBits[0][1] = (uint8_t)(bits & mask);
-    bits >>= 3;
-    gBits[0][2] = (uint8_t)(bits & mask);
-    bits >>= 3;
-    gBits[0][3] = (uint8_t)(bits & mask);
-    bits >>= 3;
-    gBits[1][0] = (uint8_t)(bits & mask);
-    bits >>= 3;
-    gBits[1][1] = (uint8_t)(bits & mask);
-    bits >>= 3;
-    gBits[1][2] = (uint8_t)(bits & mask);
-    bits >>= 3;
-    gBits[1][3] = (uint8_t)(bits & mask);
-
-    bits = 0;
-    memcpy(&bits, &block->row[3], sizeof(uint8_t) * 3);
-
-    gBits[2][0] = (uint8_t)(bits & mask);
-    bits >>= 3;
-    gBits[2][1] = (uint8_t)(bits & mask);
-    bits >>= 3;
-    gBits[2][2] = (uint8_t)(bits & mask);
-    bits >>= 3;
-    gBits[2][3] = (uint8_t)(bits & mask);
-    bits >>= 3;
-    gBits[3][0] = (uint8_t)(bits & mask);
-    bits >>= 3;
-    gBits[3][1] = (uint8_t)(bits & mask);
-    bits >>= 3;
-    gBits[3][2] = (uint8_t)(bits & mask);
-    bits >>= 3;
-    gBits[3][3] = (uint8_t)(bits & mask);
-
-    // clear existing alpha bits
-    memset(block->row, 0, sizeof(uint8_t) * 6);
-
-    uint32_t *pBits = ((uint32_t*) &(block->row[0]));
-
-    *pBits = *pBits | (gBits[3][0] << 0);
-    *pBits = *pBits | (gBits[3][1] << 3);
-    *pBits = *pBits | (gBits[3][2] << 6);
-    *pBits = *pBits | (gBits[3][3] << 9);
-
-    *pBits = *pBits | (gBits[2][0] << 12);
-    *pBits = *pBits | (gBits[2][1] << 15);
-    *pBits = *pBits | (gBits[2][2] << 18);
-    *pBits = *pBits | (gBits[2][3] << 21);
-
-    pBits = ((uint32_t*) &(block->row[3]));
-
-    *pBits = *pBits | (gBits[1][0] << 0);
-    *pBits = *pBits | (gBits[1][1] << 3);
-    *pBits = *pBits | (gBits[1][2] << 6);
-    *pBits = *pBits | (gBits[1][3] << 9);
-
-    *pBits = *pBits | (gBits[0][0] << 12);
-    *pBits = *pBits | (gBits[0][1] << 15);
-    *pBits = *pBits | (gBits[0][2] << 18);
-    *pBits = *pBits | (gBits[0][3] << 21);
-}
-
-//
-// flip a DXT5 color block
-////////////////////////////////////////////////////////////
-void NvImage::flip_blocks_dxtc5(uint8_t *ptr, uint32_t numBlocks)
-{
-    DXTColBlock *curblock = (DXTColBlock*)ptr;
-    DXT5AlphaBlock *alphablock;
-    uint8_t temp;
-    
-    for (uint32_t i = 0; i < numBlocks; i++)
-    {
-        alphablock = (DXT5AlphaBlock*)curblock;
-        
-        flip_dxt5_alpha(alphablock);
-
-        curblock++;
 
-        temp = curblock->row[0];
-        curblock->row[0] = curblock->row[3];
-        curblock->row[3] = temp;
-        temp = curblock->row[1];
-        curblock->row[1] = curblock->row[2];
-        curblock->row[2] = temp;
+    // arrays need the DX10 header extension
+    if (i._layers > 1 && !i._cubeMap)
+        return false;
 
-        curblock++;
+    ddsh.dwSize = sizeof(DDS_HEADER);
+    ddsh.dwFlags = DDSF_CAPS | DDSF_HEIGHT | DDSF_WIDTH | DDSF_PIXELFORMAT |
+        (compressed ? DDSF_LINEARSIZE : DDSF_PITCH);
+    ddsh.dwWidth = i._width;
+    ddsh.dwHeight = i._height;
+    ddsh.dwPitchOrLinearSize = compressed ? i.getImageSize(0) : i._width * i._elementSize;
+    ddsh.dwCaps1 = DDSF_TEXTURE;
+
+    if (i._levelCount > 1) {
+        ddsh.dwFlags |= DDSF_MIPMAPCOUNT;
+        ddsh.dwMipMapCount = i._levelCount;
+        ddsh.dwCaps1 |= DDSF_COMPLEX | DDSF_MIPMAP;
+    }
+    if (i._depth > 0) {
+        ddsh.dwFlags |= DDSF_DEPTH;
+        ddsh.dwDepth = i._depth;
+        ddsh.dwCaps1 |= DDSF_COMPLEX;
+        ddsh.dwCaps2 |= DDSF_VOLUME;
+    }
+    if (i._cubeMap) {
+        ddsh.dwCaps1 |= DDSF_COMPLEX;
+        ddsh.dwCaps2 |= DDSF_CUBEMAP | DDSF_CUBEMAP_ALL_FACES;
     }
-}
 
-//
-// flip a BC4 block
-////////////////////////////////////////////////////////////
-void NvImage::flip_blocks_bc4(uint8_t *ptr, uint32_t numBlocks)
-{
-    DXT5AlphaBlock *alphablock = (DXT5AlphaBlock*)ptr;
-    
-    for (uint32_t i = 0; i < numBlocks; i++)
-    {
-        flip_dxt5_alpha(alphablock);
+    size_t dataSize = 0;
+    for (int32_t face = 0; face < i._layers; face++)
+        for (int32_t level = 0; level < i._levelCount; level++)
+            dataSize += i.getImageSize(level);
 
-        alphablock++;
-    }
-}
+    fileData.resize(4 + sizeof(DDS_HEADER) + dataSize);
+    uint8_t* ptr = &fileData[0];
+    memcpy(ptr, "DDS ", 4);
+    memcpy(ptr + 4, &ddsh, sizeof(DDS_HEADER));
+    ptr += 4 + sizeof(DDS_HEADER);
 
-//
-// flip a BC5 block
-////////////////////////////////////////////////////////////
-void NvImage::flip_blocks_bc5(uint8_t *ptr, uint32_t numBlocks)
-{
-    DXT5AlphaBlock *alphablock = (DXT5AlphaBlock*)ptr;
-    
-    for (uint32_t i = 0; i < numBlocks; i++)
-    {
-        flip_dxt5_alpha(alphablock);
+    for (int32_t face = 0; face < i._layers; face++) {
+        int32_t w = i._width, h = i._height, d = (i._depth) ? i._depth : 1;
+        for (int32_t level = 0; level < i._levelCount; level++) {
+            int32_t size = i.getImageSize(level);
 
-        alphablock++;
-        flip_dxt5_alpha(alphablock);
+            // undo the flip applied by the reader as the level is copied out
+            i.transformSurface(i._data[face * i._levelCount + level], ptr, w, h, d,
+                NvImage::vertFlip && !i._cubeMap, false);
+            ptr += size;
 
-        alphablock++;
+            w = ( w > 1) ? w >> 1 : 1;
+            h = ( h > 1) ? h >> 1 : 1;
+            d = ( d > 1) ? d >> 1 : 1;
+        }
     }
-}
 
+    return true;
+}
@@ -0,0 +1,367 @@
+//----------------------------------------------------------------------------------
+// File:        NvImage/SurfaceTransform.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include <string.h>
+#include "SurfaceTransform.h"
+
+// Rows are transformed with SSE2 on x86 targets and plain 64-bit integers
+// elsewhere.  Both produce the same bytes.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NV_FLIP_SSE2 1
+#endif
+
+using namespace nv;
+
+namespace
+{
+    inline uint64_t load64(const uint8_t* p)
+    {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline void store64(uint8_t* p, uint64_t v)
+    {
+        memcpy(p, &v, sizeof(v));
+    }
+
+    inline uint64_t shl(uint64_t x, int n)
+    {
+        return x << n;
+    }
+
+    inline uint64_t shr(uint64_t x, int n)
+    {
+        return x >> n;
+    }
+
+#if NV_FLIP_SSE2
+    /// An SSE2 vector, seen as 64-bit lanes so that the lane transforms below
+    /// can be written once for it and for uint64_t
+    struct Vec
+    {
+        __m128i v;
+        explicit Vec(__m128i x) : v(x) {}
+        explicit Vec(uint64_t c) : v(_mm_set_epi32((int32_t)(c >> 32), (int32_t)c, (int32_t)(c >> 32), (int32_t)c)) {}
+        static Vec load(const uint8_t* p) { return Vec(_mm_loadu_si128((const __m128i*)p)); }
+        void store(uint8_t* p) const { _mm_storeu_si128((__m128i*)p, v); }
+        /// All ones in the first 8 bytes of every 16
+        static Vec firstLanes() { return Vec(_mm_setr_epi32(-1, -1, 0, 0)); }
+    };
+
+    inline Vec operator&(Vec a, Vec b) { return Vec(_mm_and_si128(a.v, b.v)); }
+    inline Vec operator|(Vec a, Vec b) { return Vec(_mm_or_si128(a.v, b.v)); }
+    inline Vec shl(Vec x, int n) { return Vec(_mm_sll_epi64(x.v, _mm_cvtsi32_si128(n))); }
+    inline Vec shr(Vec x, int n) { return Vec(_mm_srl_epi64(x.v, _mm_cvtsi32_si128(n))); }
+    inline Vec select(Vec mask, Vec a, Vec b) { return Vec(_mm_or_si128(_mm_and_si128(mask.v, a.v), _mm_andnot_si128(mask.v, b.v))); }
+#endif
+
+    // Lane transforms.  A lane is 8 bytes: a whole DXT1 or BC4 block, one half
+    // of a 16-byte block, or two RGBA texels
+
+    /// Reverses the four rows of 2-bit indices of a DXT color block
+    template <class T>
+    inline T flipColorLane(T x)
+    {
+        return (x & T(0x00000000FFFFFFFFULL)) |
+            (shl(x, 24) & T(0xFF00000000000000ULL)) | (shl(x, 8) & T(0x00FF000000000000ULL)) |
+            (shr(x, 8) & T(0x0000FF0000000000ULL)) | (shr(x, 24) & T(0x000000FF00000000ULL));
+    }
+
+    /// Reverses the four 16-bit rows of a DXT3 alpha block
+    template <class T>
+    inline T flipExplicitAlphaLane(T x)
+    {
+        return shl(x, 48) | (shl(x, 16) & T(0x0000FFFF00000000ULL)) |
+            (shr(x, 16) & T(0x00000000FFFF0000ULL)) | shr(x, 48);
+    }
+
+    /// Reverses the four 12-bit rows of 3-bit indices of a DXT5 alpha or BC4 block
+    template <class T>
+    inline T flipInterpolatedLane(T x)
+    {
+        return (x & T(0x000000000000FFFFULL)) |
+            (shl(x, 36) & T(0xFFF0000000000000ULL)) | (shl(x, 12) & T(0x000FFF0000000000ULL)) |
+            (shr(x, 12) & T(0x000000FFF0000000ULL)) | (shr(x, 36) & T(0x000000000FFF0000ULL));
+    }
+
+    /// Exchanges the first and third byte of each 4-byte texel
+    template <class T>
+    inline T swapRBLane(T x)
+    {
+        return (x & T(0xFF00FF00FF00FF00ULL)) | (shl(x, 16) & T(0x00FF000000FF0000ULL)) |
+            (shr(x, 16) & T(0x000000FF000000FFULL));
+    }
+
+    // Per-layout operations: first and second transform the first and second
+    // lane of every 16 bytes, which are the same for 8-byte blocks and texels
+
+    struct CopyOp
+    {
+        enum { UNIFORM = 1 };
+        template <class T> static T first(T x) { return x; }
+        template <class T> static T second(T x) { return x; }
+    };
+
+    struct SwapRBOp
+    {
+        enum { UNIFORM = 1 };
+        template <class T> static T first(T x) { return swapRBLane(x); }
+        template <class T> static T second(T x) { return swapRBLane(x); }
+    };
+
+    struct FlipDXT1Op
+    {
+        enum { UNIFORM = 1 };
+        template <class T> static T first(T x) { return flipColorLane(x); }
+        template <class T> static T second(T x) { return flipColorLane(x); }
+    };
+
+    struct FlipDXT3Op
+    {
+        enum { UNIFORM = 0 };
+        template <class T> static T first(T x) { return flipExplicitAlphaLane(x); }
+        template <class T> static T second(T x) { return flipColorLane(x); }
+    };
+
+    struct FlipDXT5Op
+    {
+        enum { UNIFORM = 0 };
+        template <class T> static T first(T x) { return flipInterpolatedLane(x); }
+        template <class T> static T second(T x) { return flipColorLane(x); }
+    };
+
+    /// BC4 and BC5, which is two BC4 blocks
+    struct FlipBC4Op
+    {
+        enum { UNIFORM = 1 };
+        template <class T> static T first(T x) { return flipInterpolatedLane(x); }
+        template <class T> static T second(T x) { return flipInterpolatedLane(x); }
+    };
+
+    /// Transforms rows with one of the operations above.  With PAIR, the rows
+    /// at srcA and srcB trade places: dstA receives srcB and dstB receives srcA.
+    /// Both sources are read before either destination is written, so the rows
+    /// may be transformed in place
+    template <class Op>
+    struct LaneRows
+    {
+        template <bool PAIR>
+        void run(const uint8_t* srcA, const uint8_t* srcB, uint8_t* dstA, uint8_t* dstB, size_t bytes) const
+        {
+            size_t x = 0;
+#if NV_FLIP_SSE2
+            const Vec firstLanes = Vec::firstLanes();
+            for (; x + sizeof(Vec) <= bytes; x += sizeof(Vec)) {
+                Vec a = Vec::load(srcA + x);
+                a = Op::UNIFORM ? Op::first(a) : select(firstLanes, Op::first(a), Op::second(a));
+                if (PAIR) {
+                    Vec b = Vec::load(srcB + x);
+                    b = Op::UNIFORM ? Op::first(b) : select(firstLanes, Op::first(b), Op::second(b));
+                    b.store(dstA + x);
+                }
+                a.store(PAIR ? dstB + x : dstA + x);
+            }
+#endif
+            // Vectors are a multiple of 16 bytes, so x & 8 tells the lanes apart
+            for (; x + 8 <= bytes; x += 8) {
+                bool first = Op::UNIFORM || !(x & 8);
+                uint64_t a = load64(srcA + x);
+                a = first ? Op::first(a) : Op::second(a);
+                if (PAIR) {
+                    uint64_t b = load64(srcB + x);
+                    b = first ? Op::first(b) : Op::second(b);
+                    store64(dstA + x, b);
+                }
+                store64(PAIR ? dstB + x : dstA + x, a);
+            }
+
+            // Rows of texels may end part way into a lane; block rows never do
+            if (x < bytes) {
+                uint8_t a[8] = { 0 };
+                uint8_t b[8] = { 0 };
+                memcpy(a, srcA + x, bytes - x);
+                store64(a, Op::first(load64(a)));
+                if (PAIR) {
+                    memcpy(b, srcB + x, bytes - x);
+                    store64(b, Op::first(load64(b)));
+                    memcpy(dstA + x, b, bytes - x);
+                }
+                memcpy(PAIR ? dstB + x : dstA + x, a, bytes - x);
+            }
+        }
+    };
+
+    /// Exchanges the first and third byte of each 3-byte texel, the same way
+    /// as LaneRows.  Sixteen texels fill three vectors exactly, so the vector
+    /// loop works on 48 bytes at a time
+    struct SwapRB24Rows
+    {
+#if NV_FLIP_SSE2
+        // For each of the three vectors: the bytes that keep their value, and
+        // the ones that take the byte two places after or before them
+        __m128i keep[3];
+        __m128i fromNext[3];
+        __m128i fromPrev[3];
+
+        SwapRB24Rows()
+        {
+            for (int32_t k = 0; k < 3; k++) {
+                uint8_t masks[3][16];
+                for (int32_t i = 0; i < 16; i++) {
+                    int32_t position = (16 * k + i) % 3;
+                    masks[0][i] = (position == 1) ? 0xFF : 0;
+                    masks[1][i] = (position == 0) ? 0xFF : 0;
+                    masks[2][i] = (position == 2) ? 0xFF : 0;
+                }
+                keep[k] = _mm_loadu_si128((const __m128i*)masks[0]);
+                fromNext[k] = _mm_loadu_si128((const __m128i*)masks[1]);
+                fromPrev[k] = _mm_loadu_si128((const __m128i*)masks[2]);
+            }
+        }
+
+        void swap(__m128i v[3]) const
+        {
+            __m128i next[3];
+            __m128i prev[3];
+            next[0] = _mm_or_si128(_mm_srli_si128(v[0], 2), _mm_slli_si128(v[1], 14));
+            next[1] = _mm_or_si128(_mm_srli_si128(v[1], 2), _mm_slli_si128(v[2], 14));
+            next[2] = _mm_srli_si128(v[2], 2);
+            prev[0] = _mm_slli_si128(v[0], 2);
+            prev[1] = _mm_or_si128(_mm_slli_si128(v[1], 2), _mm_srli_si128(v[0], 14));
+            prev[2] = _mm_or_si128(_mm_slli_si128(v[2], 2), _mm_srli_si128(v[1], 14));
+            for (int32_t k = 0; k < 3; k++) {
+                v[k] = _mm_or_si128(_mm_and_si128(v[k], keep[k]),
+                    _mm_or_si128(_mm_and_si128(next[k], fromNext[k]), _mm_and_si128(prev[k], fromPrev[k])));
+            }
+        }
+#endif
+
+        template <bool PAIR>
+        void run(const uint8_t* srcA, const uint8_t* srcB, uint8_t* dstA, uint8_t* dstB, size_t bytes) const
+        {
+            size_t x = 0;
+#if NV_FLIP_SSE2
+            for (; x + 48 <= bytes; x += 48) {
+                __m128i a[3];
+                __m128i b[3];
+                for (int32_t k = 0; k < 3; k++)
+                    a[k] = _mm_loadu_si128((const __m128i*)(srcA + x + 16 * k));
+                swap(a);
+                if (PAIR) {
+                    for (int32_t k = 0; k < 3; k++)
+                        b[k] = _mm_loadu_si128((const __m128i*)(srcB + x + 16 * k));
+                    swap(b);
+                    for (int32_t k = 0; k < 3; k++)
+                        _mm_storeu_si128((__m128i*)(dstA + x + 16 * k), b[k]);
+                }
+                uint8_t* dst = PAIR ? dstB : dstA;
+                for (int32_t k = 0; k < 3; k++)
+                    _mm_storeu_si128((__m128i*)(dst + x + 16 * k), a[k]);
+            }
+#endif
+            for (; x + 3 <= bytes; x += 3) {
+                uint8_t a[3] = { srcA[x + 2], srcA[x + 1], srcA[x] };
+                if (PAIR) {
+                    uint8_t b[3] = { srcB[x + 2], srcB[x + 1], srcB[x] };
+                    memcpy(dstA + x, b, 3);
+                }
+                memcpy(PAIR ? dstB + x : dstA + x, a, 3);
+            }
+        }
+    };
+
+    /// Applies a row transform to every slice, swapping the rows top to bottom
+    /// if the surface is flipped
+    template <class Rows>
+    void transformSlices(const Rows& op, const uint8_t* src, uint8_t* dst, size_t rowBytes,
+        int32_t rows, int32_t slices, bool flip)
+    {
+        size_t sliceBytes = rowBytes * rows;
+
+        for (int32_t s = 0; s < slices; s++, src += sliceBytes, dst += sliceBytes) {
+            if (!flip) {
+                op.template run<false>(src, src, dst, dst, sliceBytes);
+                continue;
+            }
+
+            // the middle row of an odd count is its own pair
+            for (int32_t top = 0, bottom = rows - 1; top <= bottom; top++, bottom--) {
+                op.template run<true>(src + top * rowBytes, src + bottom * rowBytes,
+                    dst + top * rowBytes, dst + bottom * rowBytes, rowBytes);
+            }
+        }
+    }
+}
+
+void nv::transformSurface(const SurfaceTransform& transform, const uint8_t* src, uint8_t* dst,
+    size_t rowBytes, int32_t rows, int32_t slices)
+{
+    bool texels = (transform.layout == SURFACE_LAYOUT_TEXELS);
+    bool swap = texels && transform.swapRB && (transform.elementSize == 3 || transform.elementSize == 4);
+    bool flip = transform.flip && (transform.layout != SURFACE_LAYOUT_OTHER);
+
+    if (!flip && !swap) {
+        if (src != dst)
+            memcpy(dst, src, rowBytes * rows * slices);
+        return;
+    }
+
+    switch (transform.layout) {
+    case SURFACE_LAYOUT_TEXELS:
+        if (!swap)
+            transformSlices(LaneRows<CopyOp>(), src, dst, rowBytes, rows, slices, flip);
+        else if (transform.elementSize == 4)
+            transformSlices(LaneRows<SwapRBOp>(), src, dst, rowBytes, rows, slices, flip);
+        else
+            transformSlices(SwapRB24Rows(), src, dst, rowBytes, rows, slices, flip);
+        break;
+    case SURFACE_LAYOUT_DXT1:
+        transformSlices(LaneRows<FlipDXT1Op>(), src, dst, rowBytes, rows, slices, flip);
+        break;
+    case SURFACE_LAYOUT_DXT3:
+        transformSlices(LaneRows<FlipDXT3Op>(), src, dst, rowBytes, rows, slices, flip);
+        break;
+    case SURFACE_LAYOUT_DXT5:
+        transformSlices(LaneRows<FlipDXT5Op>(), src, dst, rowBytes, rows, slices, flip);
+        break;
+    case SURFACE_LAYOUT_BC4:
+    case SURFACE_LAYOUT_BC5:
+        transformSlices(LaneRows<FlipBC4Op>(), src, dst, rowBytes, rows, slices, flip);
+        break;
+    default:
+        break;
+    }
+}
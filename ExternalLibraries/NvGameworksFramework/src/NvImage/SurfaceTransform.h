@@ -0,0 +1,80 @@
+//----------------------------------------------------------------------------------
+// File:        NvImage/SurfaceTransform.h
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef NV_IMAGE_SURFACETRANSFORM_H
+#define NV_IMAGE_SURFACETRANSFORM_H
+
+#include <NvSimpleTypes.h>
+
+namespace nv
+{
+    /// Memory layouts understood by transformSurface.
+    enum SurfaceLayout
+    {
+        SURFACE_LAYOUT_TEXELS,  ///< rows of uncompressed texels
+        SURFACE_LAYOUT_DXT1,    ///< 8-byte color blocks
+        SURFACE_LAYOUT_DXT3,    ///< 16-byte blocks of explicit alpha and color
+        SURFACE_LAYOUT_DXT5,    ///< 16-byte blocks of interpolated alpha and color
+        SURFACE_LAYOUT_BC4,     ///< 8-byte blocks of one interpolated channel
+        SURFACE_LAYOUT_BC5,     ///< 16-byte blocks of two interpolated channels
+        SURFACE_LAYOUT_OTHER    ///< any other block format; copied, never flipped
+    };
+
+    /// What transformSurface does to a surface (one level of one face).
+    struct SurfaceTransform
+    {
+        SurfaceLayout layout;
+        int32_t elementSize;    ///< bytes per texel, for SURFACE_LAYOUT_TEXELS
+        bool flip;              ///< reverse the rows of every slice
+        bool swapRB;            ///< exchange the first and third byte of every
+                                ///< 3 or 4 byte texel; ignored for blocks
+    };
+
+    /// Flips a surface vertically and swaps its red and blue channels in a
+    /// single pass.  Rows are swapped pairwise, 16 or 32 bytes at a time, and
+    /// compressed blocks have their rows reversed on the way, so the surface
+    /// is read and written once.  A compressed surface is flipped a whole
+    /// block row at a time.
+    /// \param[in] transform the transform to apply
+    /// \param[in] src the surface, one slice after another
+    /// \param[out] dst where the transformed surface is written; either src,
+    /// to transform in place, or a block that does not overlap it
+    /// \param[in] rowBytes the size of a row of texels or blocks in bytes
+    /// \param[in] rows the number of rows of texels or blocks in a slice
+    /// \param[in] slices the number of slices
+    void transformSurface(const SurfaceTransform& transform, const uint8_t* src, uint8_t* dst,
+        size_t rowBytes, int32_t rows, int32_t slices);
+
+} // nv namespace
+
+#endif // NV_IMAGE_SURFACETRANSFORM_H
@@ -47,6 +47,8 @@
 namespace Nv
 {
 	NvModelFileLoader* NvModelExt::ms_pLoader = NULL;
+	uint32_t NvModelExt::ms_objLoadThreads = 0;
+	bool NvModelExt::ms_packVertices = false;
 
 	NvModelExt* NvModelExt::CreateFromObj(const char* filename, float scale,
 		bool generateNormals, bool generateTangents,
@@ -110,7 +112,23 @@ namespace Nv
 			LOGE("Unable to write file: %s\n", filename);
 			return false;
 		}
+#else
+		FILE* fp = fopen(filename, "wb");
+		if (!fp)
+		{
+			LOGE("Unable to write file: %s\n", filename);
+			return false;
+		}
+#endif
 
+		bool result = WritePreprocessedModel(fp);
+		
+        fclose(fp);
+
+		return result;
+	}
+
+	bool NvModelExt::WritePreprocessedModel(FILE* fp) {
         // File structure:
         // NvModelExtFileHeader
         // NvModelTextureBlock
@@ -123,13 +141,8 @@ namespace Nv
         totalBytesWritten += WriteSkeletonBlock(fp);
         totalBytesWritten += WriteMaterials(fp);
         WriteMeshes(fp);
-		
-        fclose(fp);
 
-		return true;
-#else
-		return false;
-#endif
+		return !ferror(fp);
 	}
 
     int32_t NvModelExt::WriteFileHeader(FILE* fp) const {
@@ -325,12 +338,37 @@ namespace Nv
         // write mesh data blocks
         for (uint32_t i = 0; i < meshCount; i++) {
             SubMesh* pMesh = GetSubMesh(i);
-            
+
+            NvPackedVertexFormat format;
+            if (ms_packVertices)
+                format.InitCompact(*pMesh);
+            else
+                format.Init(*pMesh, NULL);
+
+            // Vertex data is packed, and indices narrowed to 16 bits when they fit
+            uint32_t vertexCount = pMesh->getVertexCount();
+            uint32_t indexCount = pMesh->getIndexCount();
+            std::vector<uint8_t> vertexData(vertexCount * format.GetVertexSize());
+            if (!vertexData.empty())
+                format.Pack(pMesh->getVertices(), vertexCount, &vertexData[0]);
+
+            uint32_t indexSize = (vertexCount <= 0xFFFF) ? sizeof(uint16_t) : sizeof(uint32_t);
+            std::vector<uint8_t> indexData((indexCount * indexSize + 3) & ~3u, 0);
+            for (uint32_t j = 0; j < indexCount; j++) {
+                if (indexSize == sizeof(uint16_t)) {
+                    uint16_t index = uint16_t(pMesh->getIndices()[j]);
+                    memcpy(&indexData[j * indexSize], &index, indexSize);
+                }
+                else {
+                    memcpy(&indexData[j * indexSize], pMesh->getIndices() + j, indexSize);
+                }
+            }
+
             NvModelSubMeshHeader mhdr;
-            mhdr._vertexCount = pMesh->getVertexCount();
-            mhdr._indexCount = pMesh->getIndexCount();
+            mhdr._vertexCount = vertexCount;
+            mhdr._indexCount = indexCount;
             mhdr._vertexSize = pMesh->getVertexSize();
-            mhdr._indexSize = sizeof(uint32_t);
+            mhdr._indexSize = indexSize;
             mhdr._pOffset = 0;
             mhdr._nOffset = pMesh->getNormalOffset();
             mhdr._tcOffset = pMesh->getTexCoordOffset();
@@ -339,14 +377,20 @@ namespace Nv
             mhdr._cOffset = pMesh->getColorOffset();
             mhdr._boneIndexOffset = pMesh->getBoneIndexOffset();
             mhdr._boneWeightOffset = pMesh->getBoneWeightOffset();
+            mhdr._posSize = format.GetComponentCount(NvVertexAttrib::POSITION);
             mhdr._colorCount = pMesh->getColorCount();
             mhdr._bonesPerVertex = pMesh->getBonesPerVertex();
             NV_ASSERT(pMesh->m_boneMap.size() == pMesh->m_meshToBoneTransforms.size());
             mhdr._boneMapCount = pMesh->m_boneMap.size();
             mhdr._vertArrayBase = sizeof(NvModelSubMeshHeader) + ((sizeof(int32_t) + sizeof(nv::matrix4f)) * mhdr._boneMapCount);
-            mhdr._indexArrayBase = mhdr._vertArrayBase + (pMesh->getVertexCount() * pMesh->getVertexSize() * sizeof(float));
+            mhdr._indexArrayBase = mhdr._vertArrayBase + vertexData.size();
             mhdr._matIndex = pMesh->m_materialId;
             mhdr._parentBone = pMesh->m_parentBone;
+            for (int32_t a = 0; a < NvVertexAttrib::COUNT; a++) {
+                mhdr._attribFormats[a] = format.GetFormat(NvVertexAttrib::Enum(a));
+                mhdr._packedOffsets[a] = format.GetOffset(NvVertexAttrib::Enum(a));
+            }
+            mhdr._packedVertexSize = format.GetVertexSize();
 
             // Write out the header
             totalBytesWritten += fwrite(&mhdr, sizeof(NvModelSubMeshHeader), 1, fp) * sizeof(NvModelSubMeshHeader);
@@ -359,10 +403,12 @@ namespace Nv
             }
 
             // write vertex data
-            totalBytesWritten += fwrite(pMesh->getVertices(), sizeof(float), pMesh->getVertexCount() * pMesh->getVertexSize(), fp) * sizeof(float);
+            if (!vertexData.empty())
+                totalBytesWritten += fwrite(&vertexData[0], 1, vertexData.size(), fp);
 
             // write index data
-            totalBytesWritten += fwrite(pMesh->getIndices(), sizeof(uint32_t), pMesh->getIndexCount(), fp) * sizeof(uint32_t);
+            if (!indexData.empty())
+                totalBytesWritten += fwrite(&indexData[0], 1, indexData.size(), fp);
         }
         return totalBytesWritten;
     }
@@ -103,8 +103,10 @@ namespace Nv
         case 3:
             return LoadFromPreprocessed_v3(data);
         case 4:
-        default:
             return LoadFromPreprocessed_v4(data);
+        case 5:
+        default:
+            return LoadFromPreprocessed_v5(data);
         }
     }
 
@@ -401,6 +403,29 @@ namespace Nv
         m_subMeshes = new SubMeshBin[m_meshCount];
         m_materials = new Material[m_materialCount];
 
+        uint8_t* pCurrentBufferPointer = ReadTextureBlock(data + hdr->_headerSize);
+        pCurrentBufferPointer = ReadSkeletonBlock(pCurrentBufferPointer);
+        pCurrentBufferPointer = ReadMaterials(pCurrentBufferPointer);
+        pCurrentBufferPointer = ReadMeshes_v4(pCurrentBufferPointer);
+
+        return true;
+    }
+
+    bool NvModelExtBin::LoadFromPreprocessed_v5(uint8_t* data) {
+        NvModelExtFileHeader* hdr = (NvModelExtFileHeader*)data;
+
+        for (int i = 0; i < 3; i++) {
+            m_boundingBoxMin[i] = hdr->_boundingBoxMin[i];
+            m_boundingBoxMax[i] = hdr->_boundingBoxMax[i];
+            m_boundingBoxCenter[i] = hdr->_boundingBoxCenter[i];
+        }
+
+        m_meshCount = hdr->_subMeshCount;
+        m_materialCount = hdr->_matCount;
+
+        m_subMeshes = new SubMeshBin[m_meshCount];
+        m_materials = new Material[m_materialCount];
+
         uint8_t* pCurrentBufferPointer = ReadTextureBlock(data + hdr->_headerSize);
         pCurrentBufferPointer = ReadSkeletonBlock(pCurrentBufferPointer);
         pCurrentBufferPointer = ReadMaterials(pCurrentBufferPointer);
@@ -564,13 +589,13 @@ namespace Nv
         return pMeshes;
     }
 
-    uint8_t* NvModelExtBin::ReadMeshes(uint8_t* pMeshes)
+    uint8_t* NvModelExtBin::ReadMeshes_v4(uint8_t* pMeshes)
     {
 
         // read mesh headers
         for (uint32_t i = 0; i < m_meshCount; i++)
         {
-            NvModelSubMeshHeader* pSrcMesh = reinterpret_cast<NvModelSubMeshHeader*>(pMeshes);
+            NvModelSubMeshHeader_v4* pSrcMesh = reinterpret_cast<NvModelSubMeshHeader_v4*>(pMeshes);
             SubMesh* pDestMesh = m_subMeshes + i;
 
             pDestMesh->m_vertexCount = pSrcMesh->_vertexCount;
@@ -592,7 +617,7 @@ namespace Nv
             int32_t boneCount = pSrcMesh->_boneMapCount;
             if (boneCount > 0)
             {
-                uint8_t* pBoneMap = pMeshes + sizeof(NvModelSubMeshHeader);
+                uint8_t* pBoneMap = pMeshes + sizeof(NvModelSubMeshHeader_v4);
                 uint32_t boneMapSize = sizeof(int32_t) * boneCount;
                 pDestMesh->m_boneMap.resize(boneCount);
                 memcpy(&(pDestMesh->m_boneMap[0]), pBoneMap, boneMapSize);
@@ -616,6 +641,81 @@ namespace Nv
         return pMeshes;
     }
 
+    uint8_t* NvModelExtBin::ReadMeshes(uint8_t* pMeshes)
+    {
+
+        // read mesh headers
+        for (uint32_t i = 0; i < m_meshCount; i++)
+        {
+            NvModelSubMeshHeader* pSrcMesh = reinterpret_cast<NvModelSubMeshHeader*>(pMeshes);
+            SubMesh* pDestMesh = m_subMeshes + i;
+
+            pDestMesh->m_vertexCount = pSrcMesh->_vertexCount;
+            pDestMesh->m_indexCount = pSrcMesh->_indexCount;
+            pDestMesh->m_vertSize = pSrcMesh->_vertexSize;
+            pDestMesh->m_normalOffset = pSrcMesh->_nOffset;
+            pDestMesh->m_texCoordOffset = pSrcMesh->_tcOffset;
+            pDestMesh->m_texCoordCount = pSrcMesh->_tcSize;
+            pDestMesh->m_tangentOffset = pSrcMesh->_sTanOffset;
+            pDestMesh->m_colorOffset = pSrcMesh->_cOffset;
+            pDestMesh->m_colorCount = pSrcMesh->_colorCount;
+            pDestMesh->m_boneIndexOffset = pSrcMesh->_boneIndexOffset;
+            pDestMesh->m_boneWeightOffset = pSrcMesh->_boneWeightOffset;
+            pDestMesh->m_bonesPerVertex = pSrcMesh->_bonesPerVertex;
+            pDestMesh->m_materialId = pSrcMesh->_matIndex;
+            pDestMesh->m_parentBone = pSrcMesh->_parentBone;
+
+            // Read in the bone map
+            int32_t boneCount = pSrcMesh->_boneMapCount;
+            if (boneCount > 0)
+            {
+                uint8_t* pBoneMap = pMeshes + sizeof(NvModelSubMeshHeader);
+                uint32_t boneMapSize = sizeof(int32_t) * boneCount;
+                pDestMesh->m_boneMap.resize(boneCount);
+                memcpy(&(pDestMesh->m_boneMap[0]), pBoneMap, boneMapSize);
+
+                uint8_t* pBoneTransforms = pBoneMap + boneMapSize;
+                uint32_t boneTransformsSize = sizeof(nv::matrix4f) * boneCount;
+                pDestMesh->m_meshToBoneTransforms.resize(boneCount);
+                memcpy(&(pDestMesh->m_meshToBoneTransforms[0]), pBoneTransforms, boneTransformsSize);
+            }
+
+            // Unpack the vertices to floats, keeping the formats they were
+            // packed in for the GPU
+            NvVertexAttribFormat::Enum formats[NvVertexAttrib::COUNT];
+            for (int32_t a = 0; a < NvVertexAttrib::COUNT; a++)
+            {
+                formats[a] = NvVertexAttribFormat::Enum(pSrcMesh->_attribFormats[a]);
+            }
+            pDestMesh->m_packedFormat.Init(*pDestMesh, formats);
+            NV_ASSERT(pDestMesh->m_packedFormat.GetVertexSize() == pSrcMesh->_packedVertexSize);
+
+            pDestMesh->m_vertices = new float[pDestMesh->m_vertSize * pDestMesh->m_vertexCount];
+            pDestMesh->m_packedFormat.Unpack(pMeshes + pSrcMesh->_vertArrayBase, pDestMesh->m_vertexCount, pDestMesh->m_vertices);
+
+            // Widen 16-bit indices
+            uint8_t* pSrcIndices = pMeshes + pSrcMesh->_indexArrayBase;
+            pDestMesh->m_indices = new uint32_t[pDestMesh->m_indexCount];
+            if (pSrcMesh->_indexSize == sizeof(uint16_t))
+            {
+                for (uint32_t j = 0; j < pDestMesh->m_indexCount; j++)
+                {
+                    uint16_t index;
+                    memcpy(&index, pSrcIndices + j * sizeof(uint16_t), sizeof(uint16_t));
+                    pDestMesh->m_indices[j] = index;
+                }
+            }
+            else
+            {
+                memcpy(pDestMesh->m_indices, pSrcIndices, pDestMesh->m_indexCount * sizeof(uint32_t));
+            }
+
+            uint32_t indexBufferSize = (pDestMesh->m_indexCount * pSrcMesh->_indexSize + 3) & ~3u;
+            pMeshes += pSrcMesh->_indexArrayBase + indexBufferSize;
+        }
+        return pMeshes;
+    }
+
 
 
 }
@@ -99,11 +99,13 @@ namespace Nv
         bool LoadFromPreprocessed_v2(uint8_t* data);
         bool LoadFromPreprocessed_v3(uint8_t* data);
         bool LoadFromPreprocessed_v4(uint8_t* data);
+        bool LoadFromPreprocessed_v5(uint8_t* data);
 
         uint8_t* ReadTextureBlock(uint8_t* pTextureBlock);
         uint8_t* ReadSkeletonBlock(uint8_t* pSkeletonBlock);
         uint8_t* ReadMaterials(uint8_t* pMaterials);
         uint8_t* ReadMeshes_v3(uint8_t* pMeshes);
+        uint8_t* ReadMeshes_v4(uint8_t* pMeshes);
         uint8_t* ReadMeshes(uint8_t* pMeshes);
 
 
@@ -34,11 +34,13 @@
 #ifndef NVMODELEXTFILE_H_
 #define NVMODELEXTFILE_H_
 
+#include "NvModel/NvModelVertexFormat.h"
+
 namespace Nv
 {
-    static const uint32_t NVMODEL_FILE_VERSION = 4;
+    static const uint32_t NVMODEL_FILE_VERSION = 5;
 
-    // File structure (v4):
+    // File structure (v5):
     // All structures and component elements MUST be 4-byte aligned
     // NvModelExtFileHeader
     // NvModelTextureBlock
@@ -164,7 +166,7 @@ namespace Nv
         int32_t _matIndex;
     };
 
-    struct NvModelSubMeshHeader {
+    struct NvModelSubMeshHeader_v4 {
         uint32_t _vertexCount;
         uint32_t _indexCount;
         uint32_t _vertexSize; // size of each vert IN BYTES!
@@ -196,6 +198,45 @@ namespace Nv
         int32_t _parentBone;
     };
 
+    struct NvModelSubMeshHeader {
+        uint32_t _vertexCount;
+        uint32_t _indexCount;
+        uint32_t _vertexSize; // size of each unpacked vert in floats
+        uint32_t _indexSize; // size of each index IN BYTES! (2 or 4)
+        int32_t _pOffset;
+        int32_t _nOffset;
+        int32_t _tcOffset;
+        int32_t _sTanOffset;
+        int32_t _cOffset;
+        int32_t _boneIndexOffset;
+        int32_t _boneWeightOffset;
+        int32_t _posSize;
+        int32_t _tcSize;
+        int32_t _colorCount;
+        int32_t _bonesPerVertex;
+        int32_t _boneMapCount;
+
+        // offset in bytes from the start of the block
+        // (in version 1, this was the offset in bytes 
+        //  from the start of the file)
+        int32_t _vertArrayBase;
+
+        // offset in bytes from the start of the block
+        // (in version 1, this was the offset in bytes 
+        //  from the start of the file)
+        int32_t _indexArrayBase;
+        int32_t _matIndex;
+
+        int32_t _parentBone;
+
+        // Packed vertex layout, indexed by NvVertexAttrib::Enum; the vertex
+        // array holds _vertexCount verts of _packedVertexSize bytes each,
+        // and the index array is padded to a multiple of 4 bytes
+        uint32_t _attribFormats[NvVertexAttrib::COUNT]; // NvVertexAttribFormat::Enum
+        int32_t _packedOffsets[NvVertexAttrib::COUNT]; // in bytes, -1 if absent
+        uint32_t _packedVertexSize; // size of each packed vert IN BYTES!
+    };
+
     struct NvModelMaterialHeader_v1 {
 		float _ambient[3];
 		float _diffuse[3];
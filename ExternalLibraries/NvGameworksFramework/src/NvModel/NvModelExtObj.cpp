@@ -37,6 +37,9 @@
 #include <NV/NvTokenizer.h>
 #include "NvModelMeshFace.h"
 #include "NvModelSubMeshObj.h"
+#include "NvModel/NvModelOptimizer.h"
+#include "NV/NvParallel.h"
+#include <string.h>
 
 namespace Nv
 {
@@ -47,6 +50,11 @@ namespace Nv
 // which can often explain odd normals and lighting.
 #define DEBUG_SMOOTHING_AS_MATS 0
 
+// OBJ data is split among threads in pieces of at least this many bytes, up to
+// this many pieces per thread to balance the load
+static const size_t OBJ_MIN_CHUNK_SIZE = 256 * 1024;
+static const uint32_t OBJ_CHUNKS_PER_THREAD = 4;
+
 #if DEBUG_SMOOTHING_AS_MATS
     static const uint32_t sColorCount = 23;
     static const nv::vec3f sColors[sColorCount] =
@@ -97,6 +105,12 @@ namespace Nv
 		for (uint32_t i = 0; i < pModel->m_subMeshes.size(); i++) {
 			pModel->InitProcessedVerts(i);
 			pModel->InitProcessedIndices(i);
+
+			if (NvModelOptimizer::GetMeshOptimization()) {
+				SubMeshObj* pSubMesh = pModel->m_subMeshes[i];
+				NvModelOptimizer::OptimizeMesh(pSubMesh->m_vertices, pSubMesh->m_vertSize, pSubMesh->m_vertexCount,
+					pSubMesh->m_indices, pSubMesh->m_indexCount, i);
+			}
 		}
 
 		return pModel;
@@ -213,6 +227,24 @@ namespace Nv
 
 	bool NvModelExtObj::LoadObjFromMemory(const char* pFileData)
     {
+#if !DEBUG_SMOOTHING_AS_MATS
+        // Parse large files in pieces on several threads
+        uint32_t threadCount = (ms_objLoadThreads != 0) ? ms_objLoadThreads : nv::defaultThreadCount();
+        if (threadCount > 1)
+        {
+            size_t size = strlen(pFileData);
+            size_t chunkCount = size / OBJ_MIN_CHUNK_SIZE;
+            if (chunkCount > threadCount * OBJ_CHUNKS_PER_THREAD)
+            {
+                chunkCount = threadCount * OBJ_CHUNKS_PER_THREAD;
+            }
+            if (chunkCount > 1)
+            {
+                return LoadObjChunksFromMemory(pFileData, size, uint32_t(chunkCount), threadCount);
+            }
+        }
+#endif
+
         NvTokenizer tok(pFileData, "/");
 
         int32_t currentMaterial = 0;
@@ -759,21 +791,7 @@ namespace Nv
                     return false;
                 }
 
-                // See if the material already exists
-                MaterialMap::iterator fIt = m_materialMap.find(materialName);
-                if (fIt == m_materialMap.end())
-                {
-                    // We need to add the material
-                    currentMaterial = int32_t(m_rawMaterials.size());
-                    m_materialMap[materialName] = currentMaterial;
-
-                    Material newMaterial;
-                    m_rawMaterials.push_back(newMaterial);
-                }
-                else
-                {
-                    currentMaterial = fIt->second;
-                }
+                currentMaterial = GetMaterialId(materialName);
 
                 // Switch to the submesh that uses the active material
                 currentSubMesh = GetSubMeshForMaterial(currentMaterial);
@@ -796,6 +814,467 @@ namespace Nv
         return true;
     }
 
+    // Everything one line-aligned piece of an OBJ file defines.  The vertex
+    // components are kept in the order they were read, and the faces and changes
+    // of state as records in the order they were read, with face indices still
+    // as written in the file.
+    struct NvModelExtObj::ObjChunk
+    {
+        enum RecordType
+        {
+            Record_Face,            // m_index is the face in m_faces
+            Record_Smoothing,       // m_index is the smoothing group
+            Record_MaterialLib,     // m_index is the library name in m_names
+            Record_UseMaterial,     // m_index is the material name in m_names
+            Record_Error            // Parsing stopped here on malformed data
+        };
+
+        struct Record
+        {
+            RecordType m_type;
+            int32_t m_index;
+        };
+
+        struct Face
+        {
+            OBJFaceFormat m_format;
+            uint32_t m_firstVert;       // Index of the face's first vertex in m_faceVerts
+            uint32_t m_vertCount;       // Number of vertices read completely
+            int32_t m_posCount;         // Number of positions the chunk defined before the face
+            int32_t m_normalCount;      // Number of normals the chunk defined before the face
+            int32_t m_texCoordCount;    // Number of texture coordinates the chunk defined before the face
+        };
+
+        // File indices of a face vertex's components; those its face's format lacks are unused
+        struct FaceVert
+        {
+            int32_t m_pos;
+            int32_t m_texCoord;
+            int32_t m_normal;
+        };
+
+        ObjChunk() : m_has4CompPos(false), m_has3CompTex(false) {}
+
+        std::vector<nv::vec4f> m_positions;
+        std::vector<nv::vec3f> m_normals;
+        std::vector<nv::vec3f> m_texCoords;
+        std::vector<Face> m_faces;
+        std::vector<FaceVert> m_faceVerts;
+        std::vector<std::string> m_names;
+        std::vector<Record> m_records;
+        bool m_has4CompPos;
+        bool m_has3CompTex;
+    };
+
+    // Tokenizer that reports how far into its buffer it has read
+    class NvObjChunkTokenizer : public NvTokenizer
+    {
+    public:
+        NvObjChunkTokenizer(const char* src, const char* delims) : NvTokenizer(src, delims) {}
+
+        const char* getPosition() const { return mSrcBuf; }
+    };
+
+    // Remaps a face's file index the way LoadObjFromMemory does when it has read count
+    // components, including returning -1 for components it has not read yet
+    template <class Compactor>
+    static int32_t RemapChunkIndex(Compactor& compactor, int32_t objIndex, int32_t count)
+    {
+        int32_t index = (objIndex > 0) ? (objIndex - 1) : (count + objIndex);
+        if (index >= count)
+        {
+            NV_ASSERT(0);
+            return -1;
+        }
+        return compactor.Remap(index);
+    }
+
+	bool NvModelExtObj::LoadObjChunksFromMemory(const char* pFileData, size_t size, uint32_t chunkCount,
+        uint32_t threadCount)
+    {
+        // Split the data into pieces of about equal size, each starting at the first
+        // character of a line.  LoadObjFromMemory reads every line through to the
+        // end of line characters following it, so it starts reading at each of these
+        // points as well.
+        std::vector<const char*> bounds(chunkCount + 1);
+        bounds[0] = pFileData;
+        bounds[chunkCount] = pFileData + size;
+        for (uint32_t i = 1; i < chunkCount; i++)
+        {
+            const char* pBound = pFileData + (size * i) / chunkCount;
+            if (pBound < bounds[i - 1])
+            {
+                pBound = bounds[i - 1];
+            }
+            while ((*pBound != '\0') && (*pBound != '\n') && (*pBound != '\r'))
+            {
+                ++pBound;
+            }
+            while ((*pBound == '\n') || (*pBound == '\r'))
+            {
+                ++pBound;
+            }
+            bounds[i] = pBound;
+        }
+
+        std::vector<ObjChunk> chunks(chunkCount);
+        nv::parallelFor(chunkCount, threadCount, [&](uint32_t i) {
+            ParseObjChunk(bounds[i], bounds[i + 1], chunks[i]);
+        });
+
+        // Add the pieces in order, offsetting each one's counts of vertex components by
+        // those defined before it
+        int32_t currentMaterial = 0;
+        int32_t currentSmoothingGroup = 0;
+        SubMeshObj* currentSubMesh = GetSubMeshForMaterial(0);
+
+        bool bHas4CompPos = false;
+        bool bHas3CompTex = false;
+        bool bBoundingBoxInitialized = false;
+        int32_t nextPosIndex = 0;
+        int32_t nextNormalIndex = 0;
+        int32_t nextTexCoordIndex = 0;
+
+        for (uint32_t i = 0; i < chunkCount; i++)
+        {
+            const ObjChunk& chunk = chunks[i];
+
+            // Faces only use components defined before them, so the whole piece's
+            // components can be added ahead of its faces
+            std::vector<nv::vec4f>::const_iterator posIt = chunk.m_positions.begin();
+            for (; posIt != chunk.m_positions.end(); ++posIt)
+            {
+                const nv::vec4f& pos = *posIt;
+                if (bBoundingBoxInitialized)
+                {
+                    m_boundingBoxMin = nv::min(m_boundingBoxMin, (nv::vec3f)pos);
+                    m_boundingBoxMax = nv::max(m_boundingBoxMax, (nv::vec3f)pos);
+                }
+                else
+                {
+                    m_boundingBoxMin = (nv::vec3f)pos;
+                    m_boundingBoxMax = (nv::vec3f)pos;
+                    bBoundingBoxInitialized = true;
+                }
+
+                int32_t index = m_positions.Append(pos);
+                NV_ASSERT(index != -1);
+            }
+
+            std::vector<nv::vec3f>::const_iterator normIt = chunk.m_normals.begin();
+            for (; normIt != chunk.m_normals.end(); ++normIt)
+            {
+                int32_t index = m_normals.Append(*normIt);
+                NV_ASSERT(index != -1);
+            }
+
+            std::vector<nv::vec3f>::const_iterator texIt = chunk.m_texCoords.begin();
+            for (; texIt != chunk.m_texCoords.end(); ++texIt)
+            {
+                int32_t index = m_texCoords.Append(*texIt);
+                NV_ASSERT(index != -1);
+            }
+
+            bHas4CompPos |= chunk.m_has4CompPos;
+            bHas3CompTex |= chunk.m_has3CompTex;
+
+            std::vector<ObjChunk::Record>::const_iterator recIt = chunk.m_records.begin();
+            for (; recIt != chunk.m_records.end(); ++recIt)
+            {
+                switch (recIt->m_type)
+                {
+                case ObjChunk::Record_Face:
+                {
+                    const ObjChunk::Face& src = chunk.m_faces[recIt->m_index];
+                    int32_t posCount = nextPosIndex + src.m_posCount;
+                    int32_t normalCount = nextNormalIndex + src.m_normalCount;
+                    int32_t texCoordCount = nextTexCoordIndex + src.m_texCoordCount;
+                    bool bHasTexCoords = (src.m_format == Face_PosTex) || (src.m_format == Face_PosTexNormal);
+                    bool bHasNormals = (src.m_format == Face_PosTexNormal) || (src.m_format == Face_PosNormal);
+
+                    MeshFace face;
+                    MeshVertex vert;
+
+                    face.m_material = uint32_t(currentMaterial);
+                    face.m_smoothingGroup = currentSmoothingGroup;
+                    face.m_pSubMesh = currentSubMesh;
+
+                    // Build the same triangle fan that LoadObjFromMemory does, generating
+                    // the face normal for faces without normals once it has three vertices
+                    bool bGeneratedFaceNormal = bHasNormals;
+                    for (uint32_t v = 0; v < src.m_vertCount; v++)
+                    {
+                        const ObjChunk::FaceVert& fv = chunk.m_faceVerts[src.m_firstVert + v];
+                        vert.m_pos = RemapChunkIndex(m_positions, fv.m_pos, posCount);
+                        if (bHasTexCoords)
+                        {
+                            vert.m_texcoord = RemapChunkIndex(m_texCoords, fv.m_texCoord, texCoordCount);
+                        }
+                        if (bHasNormals)
+                        {
+                            vert.m_normal = RemapChunkIndex(m_normals, fv.m_normal, normalCount);
+                        }
+                        NV_ASSERT((src.m_format != Face_PosNormal) || (v < 2) ||
+                            (RemapObjIndex(fv.m_pos, posCount) == (fv.m_pos - 1)));
+
+                        int32_t vertIndex = currentSubMesh->FindOrAddVertex(vert);
+                        if (v < 2)
+                        {
+                            face.m_verts[v] = vertIndex;
+                            continue;
+                        }
+
+                        face.m_verts[2] = vertIndex;
+                        if (!bGeneratedFaceNormal)
+                        {
+                            face.CalculateFaceNormal(m_positions.GetVectors());
+                            bGeneratedFaceNormal = true;
+                        }
+
+                        currentSubMesh->m_rawFaces.push_back(face);
+                        face.m_verts[1] = face.m_verts[2];
+                    }
+                    break;
+                }
+                case ObjChunk::Record_Smoothing:
+                    currentSmoothingGroup = recIt->m_index;
+                    break;
+                case ObjChunk::Record_MaterialLib:
+                    LoadMaterialLibraryFromFile(chunk.m_names[recIt->m_index]);
+                    break;
+                case ObjChunk::Record_UseMaterial:
+                    currentMaterial = GetMaterialId(chunk.m_names[recIt->m_index]);
+                    currentSubMesh = GetSubMeshForMaterial(currentMaterial);
+                    break;
+                case ObjChunk::Record_Error:
+                    return false;
+                }
+            }
+
+            nextPosIndex += int32_t(chunk.m_positions.size());
+            nextNormalIndex += int32_t(chunk.m_normals.size());
+            nextTexCoordIndex += int32_t(chunk.m_texCoords.size());
+        }
+
+        m_numPositionComponents = bHas4CompPos ? 4 : 3;
+        m_numTexCoordComponents = bHas3CompTex ? 3 : 2;
+
+        OptimizeModel();
+
+        return true;
+    }
+
+	void NvModelExtObj::ParseObjChunk(const char* pStart, const char* pEnd, ObjChunk& chunk)
+    {
+        NvObjChunkTokenizer tok(pStart, "/");
+
+        while (!tok.atEOF() && (tok.getPosition() < pEnd))
+        {
+            if (!tok.readToken())
+            {
+                tok.consumeToEOL();
+                continue;
+            }
+
+            const char* tmp = tok.getLastTokenPtr();
+            uint32_t compCount = 0;
+            ObjChunk::Record record;
+
+            switch (tmp[0])
+            {
+            case 'v':
+            {
+                switch (tmp[1])
+                {
+                case '\0':
+                {
+                    nv::vec4f pos;
+                    pos.w = 1.0f;
+                    compCount = tok.getTokenFloatArray((float*)pos, 4);
+                    NV_ASSERT(compCount > 2 && compCount < 5);
+                    chunk.m_positions.push_back(pos);
+                    chunk.m_has4CompPos |= (compCount == 4);
+                    break;
+                }
+                case 'n':
+                {
+                    nv::vec3f norm;
+                    compCount = tok.getTokenFloatArray((float*)norm, 3);
+                    NV_ASSERT(compCount == 3);
+                    chunk.m_normals.push_back(norm);
+                    break;
+                }
+                case 't':
+                {
+                    nv::vec3f texCoord;
+                    texCoord.z = 0.0f;
+                    compCount = tok.getTokenFloatArray((float*)texCoord, 3);
+                    NV_ASSERT(compCount > 1 && compCount < 4);
+                    if ((compCount == 3) && (texCoord.z > -0.0001f) && (texCoord.z < 0.0001f))
+                    {
+                        compCount = 2;
+                    }
+                    chunk.m_texCoords.push_back(texCoord);
+                    chunk.m_has3CompTex |= (compCount == 3);
+                    break;
+                }
+                }
+                tok.consumeToEOL();
+                break;
+            }
+            case 'f':
+            {
+                // Read the first vertex to determine the face's format, exactly as
+                // LoadObjFromMemory does; see it for the formats
+                ObjChunk::Face face;
+                face.m_format = Face_Invalid;
+                face.m_firstVert = uint32_t(chunk.m_faceVerts.size());
+                face.m_vertCount = 0;
+                face.m_posCount = int32_t(chunk.m_positions.size());
+                face.m_normalCount = int32_t(chunk.m_normals.size());
+                face.m_texCoordCount = int32_t(chunk.m_texCoords.size());
+
+                record.m_type = ObjChunk::Record_Face;
+                record.m_index = int32_t(chunk.m_faces.size());
+
+                ObjChunk::FaceVert vert = { 0, 0, 0 };
+                bool bTrailingDelimiter = false;
+                bool bError = !tok.getTokenInt(vert.m_pos);
+                if (!bError && tok.consumeOneDelim())
+                {
+                    if (tok.consumeOneDelim())
+                    {
+                        face.m_format = Face_PosNormal;
+                        bError = !tok.getTokenInt(vert.m_normal);
+                    }
+                    else if (!tok.getTokenInt(vert.m_texCoord))
+                    {
+                        bError = true;
+                    }
+                    else if (tok.consumeOneDelim())
+                    {
+                        tok.setConsumeWS(false);
+                        if (tok.getTokenInt(vert.m_normal))
+                        {
+                            face.m_format = Face_PosTexNormal;
+                        }
+                        else
+                        {
+                            bTrailingDelimiter = true;
+                            face.m_format = Face_PosTex;
+                        }
+                        tok.setConsumeWS(true);
+                    }
+                    else
+                    {
+                        face.m_format = Face_PosTex;
+                    }
+                }
+                else
+                {
+                    face.m_format = Face_PosOnly;
+                }
+
+                // Read the remaining vertices, the second of which is required
+                for (uint32_t v = 1; !bError; v++)
+                {
+                    chunk.m_faceVerts.push_back(vert);
+                    ++face.m_vertCount;
+
+                    if (!tok.getTokenInt(vert.m_pos))
+                    {
+                        bError = (v == 1);
+                        break;
+                    }
+
+                    switch (face.m_format)
+                    {
+                    case Face_PosTex:
+                        bError = !tok.consumeOneDelim() || !tok.getTokenInt(vert.m_texCoord) ||
+                            ((v == 1) && bTrailingDelimiter && !tok.consumeOneDelim());
+                        break;
+                    case Face_PosTexNormal:
+                        bError = !tok.consumeOneDelim() || !tok.getTokenInt(vert.m_texCoord) ||
+                            !tok.consumeOneDelim() || !tok.getTokenInt(vert.m_normal);
+                        break;
+                    case Face_PosNormal:
+                        bError = !tok.consumeOneDelim() || !tok.consumeOneDelim() ||
+                            !tok.getTokenInt(vert.m_normal);
+                        break;
+                    default:
+                        break;
+                    }
+                }
+
+                chunk.m_faces.push_back(face);
+                chunk.m_records.push_back(record);
+                if (bError)
+                {
+                    NV_ASSERT(0);
+                    record.m_type = ObjChunk::Record_Error;
+                    chunk.m_records.push_back(record);
+                    return;
+                }
+                tok.consumeToEOL();
+                break;
+            }
+            case 's':
+            {
+                record.m_type = ObjChunk::Record_Smoothing;
+                if (!tok.getTokenInt(record.m_index))
+                {
+                    NV_ASSERT(0);
+                    record.m_type = ObjChunk::Record_Error;
+                    chunk.m_records.push_back(record);
+                    return;
+                }
+                chunk.m_records.push_back(record);
+                tok.consumeToEOL();
+                break;
+            }
+            case 'm':
+            case 'u':
+            {
+                // mtllib or usemtl.  Reading the name replaces the last token.
+                record.m_type = (tmp[0] == 'm') ? ObjChunk::Record_MaterialLib : ObjChunk::Record_UseMaterial;
+                std::string name;
+                if (!tok.getTokenString(name))
+                {
+                    NV_ASSERT(0);
+                    record.m_type = ObjChunk::Record_Error;
+                    chunk.m_records.push_back(record);
+                    return;
+                }
+                record.m_index = int32_t(chunk.m_names.size());
+                chunk.m_names.push_back(name);
+                chunk.m_records.push_back(record);
+                tok.consumeToEOL();
+                break;
+            }
+            default:
+                tok.consumeToEOL();
+            }
+        }
+    }
+
+	int32_t NvModelExtObj::GetMaterialId(const std::string& materialName)
+    {
+        // See if the material already exists
+        MaterialMap::iterator fIt = m_materialMap.find(materialName);
+        if (fIt != m_materialMap.end())
+        {
+            return fIt->second;
+        }
+
+        // We need to add the material
+        int32_t materialId = int32_t(m_rawMaterials.size());
+        m_materialMap[materialName] = materialId;
+
+        Material newMaterial;
+        m_rawMaterials.push_back(newMaterial);
+        return materialId;
+    }
+
 	void NvModelExtObj::OptimizeModel()
     {
         RemoveEmptySubmeshes();
@@ -155,9 +155,37 @@ namespace Nv
             Face_PosNormal = 4
         };
 
+        // Everything one line-aligned piece of an OBJ file defines; see ParseObjChunk
+        struct ObjChunk;
+
+        /// Parses the OBJ data in pieces on several threads, then adds what the
+        /// pieces define to the model in file order, building the same model
+        /// that LoadObjFromMemory would in a single pass
+        /// \param[in] pLoadData Pointer to the buffer containing the OBJ definition to load
+        /// \param[in] size Length of the OBJ definition, not counting its terminator
+        /// \param[in] chunkCount Number of pieces to split the OBJ definition into
+        /// \param[in] threadCount Maximum number of threads to parse on, counting the calling thread
+        /// \return True if the OBJ was parsed successfully and the model now contains
+        ///         the processed data.  False if there was a problem processing the data.
+        bool LoadObjChunksFromMemory(const char* pLoadData, size_t size, uint32_t chunkCount,
+            uint32_t threadCount);
+
+        /// Parses the OBJ lines between the given pointers without modifying the model,
+        /// reading as many as LoadObjFromMemory would before it stopped on an error
+        /// \param[in] pStart First character of a line
+        /// \param[in] pEnd First character of the line following the last one to parse
+        /// \param[out] chunk The vertex components, faces and state changes parsed
+        static void ParseObjChunk(const char* pStart, const char* pEnd, ObjChunk& chunk);
+
         // Creates a default material to be used by any mesh that doesn't specify one
         void InitializeDefaultMaterial();
 
+        /// Returns the index of the material with the given name, adding an empty
+        /// definition for it if no material library has defined it
+        /// \param[in] materialName Name of the material
+        /// \return Index of the material in the raw materials array
+        int32_t GetMaterialId(const std::string& materialName);
+
         // Clears out all data to prepare for loading a new model
         void ResetModel();
 
@@ -33,6 +33,7 @@
 //----------------------------------------------------------------------------------
 
 #include "NvModelObj.h"
+#include "NvModel/NvModelOptimizer.h"
 
 #include <iostream>
 #include <sstream>
@@ -710,6 +711,8 @@ void NvModelObj::compileModel(NvModelPrimType::Enum prim) {
 		vertices.clear();
 	}
 
+	if (Nv::NvModelOptimizer::GetMeshOptimization())
+		Nv::NvModelOptimizer::OptimizeMesh(_vertices, _vtxSize, _vertexCount, _indices, _indexCount, 0);
 }
 
 //
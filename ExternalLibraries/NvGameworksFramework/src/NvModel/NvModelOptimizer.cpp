@@ -0,0 +1,475 @@
+//----------------------------------------------------------------------------------
+// File:        NvModel/NvModelOptimizer.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvModel/NvModelOptimizer.h"
+#include "NV/NvMath.h"
+#include <NV/NvLogs.h>
+#include <NvAssert.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+namespace Nv
+{
+    bool NvModelOptimizer::ms_optimizeMeshes = true;
+    float NvModelOptimizer::ms_overdrawThreshold = 0.0f;
+    bool NvModelOptimizer::ms_reportStats = false;
+
+    static const uint32_t INVALID_INDEX = 0xffffffff;
+
+    // Size of the LRU cache that the vertex cache scoring models
+    static const uint32_t FORSYTH_CACHE_SIZE = 32;
+
+    // Score of a vertex used by the last triangle, and the falloff of the
+    // scores of those further back in the cache
+    static const float FORSYTH_LAST_TRI_SCORE = 0.75f;
+    static const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+
+    // Boost given to vertices with few triangles left, so that they are
+    // finished off rather than left behind as lone triangles
+    static const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+    static const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+    // Valences up to which the boost is looked up rather than computed
+    static const uint32_t FORSYTH_VALENCE_TABLE_SIZE = 32;
+
+    // Size of the FIFO cache that overdraw ordering finds cache restarts with
+    static const uint32_t OVERDRAW_CACHE_SIZE = 16;
+
+    // Adds a triangle's vertices to a FIFO cache that holds each vertex's
+    // insertion time; a vertex is cached while fewer than cacheSize others
+    // have been inserted after it.  Advancing time by cacheSize + 1 empties it.
+    // Returns the number of the triangle's vertices that had to be transformed.
+    static uint32_t UpdateFifoCache(const uint32_t* tri, uint32_t cacheSize,
+        std::vector<uint32_t>& timestamps, uint32_t& time)
+    {
+        uint32_t misses = 0;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            uint32_t& timestamp = timestamps[tri[i]];
+            if (time - timestamp > cacheSize)
+            {
+                timestamp = time++;
+                misses++;
+            }
+        }
+        return misses;
+    }
+
+    NvModelCacheStats NvModelOptimizer::MeasureVertexCache(const uint32_t* indices, uint32_t indexCount,
+        uint32_t vertexCount, uint32_t cacheSize)
+    {
+        NvModelCacheStats stats = { 0.0f, 0.0f };
+        uint32_t triCount = indexCount / 3;
+        if (triCount == 0)
+        {
+            return stats;
+        }
+
+        std::vector<uint32_t> timestamps(vertexCount, 0);
+        std::vector<uint8_t> referenced(vertexCount, 0);
+        uint32_t time = cacheSize + 1;
+        uint32_t misses = 0;
+        uint32_t referencedCount = 0;
+        for (uint32_t t = 0; t < triCount; t++)
+        {
+            const uint32_t* tri = indices + t * 3;
+            misses += UpdateFifoCache(tri, cacheSize, timestamps, time);
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                NV_ASSERT(tri[i] < vertexCount);
+                referencedCount += 1 - referenced[tri[i]];
+                referenced[tri[i]] = 1;
+            }
+        }
+
+        stats.m_acmr = float(misses) / float(triCount);
+        stats.m_atvr = float(misses) / float(referencedCount);
+        return stats;
+    }
+
+    void NvModelOptimizer::OptimizeVertexCache(uint32_t* indices, uint32_t indexCount, uint32_t vertexCount)
+    {
+        uint32_t triCount = indexCount / 3;
+        if (triCount < 2)
+        {
+            return;
+        }
+
+        // Scores by position in the cache and by the number of triangles left
+        float cacheScores[FORSYTH_CACHE_SIZE];
+        for (uint32_t i = 0; i < FORSYTH_CACHE_SIZE; i++)
+        {
+            cacheScores[i] = (i < 3) ? FORSYTH_LAST_TRI_SCORE :
+                powf(1.0f - float(i - 3) / float(FORSYTH_CACHE_SIZE - 3), FORSYTH_CACHE_DECAY_POWER);
+        }
+        float valenceScores[FORSYTH_VALENCE_TABLE_SIZE];
+        for (uint32_t i = 1; i < FORSYTH_VALENCE_TABLE_SIZE; i++)
+        {
+            valenceScores[i] = FORSYTH_VALENCE_BOOST_SCALE * powf(float(i), -FORSYTH_VALENCE_BOOST_POWER);
+        }
+        valenceScores[0] = 0.0f;
+
+        // Lists of the triangles using each vertex; a vertex's first remaining[v]
+        // entries are the triangles still to be emitted
+        std::vector<uint32_t> remaining(vertexCount, 0);
+        for (uint32_t i = 0; i < triCount * 3; i++)
+        {
+            NV_ASSERT(indices[i] < vertexCount);
+            remaining[indices[i]]++;
+        }
+        std::vector<uint32_t> triListStart(vertexCount + 1, 0);
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            triListStart[v + 1] = triListStart[v] + remaining[v];
+        }
+        std::vector<uint32_t> triLists(triCount * 3);
+        std::vector<uint32_t> fill(triListStart.begin(), triListStart.end() - 1);
+        for (uint32_t i = 0; i < triCount * 3; i++)
+        {
+            triLists[fill[indices[i]]++] = i / 3;
+        }
+
+        std::vector<float> vertexScores(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            uint32_t valence = remaining[v];
+            vertexScores[v] = (valence < FORSYTH_VALENCE_TABLE_SIZE) ? valenceScores[valence] :
+                FORSYTH_VALENCE_BOOST_SCALE * powf(float(valence), -FORSYTH_VALENCE_BOOST_POWER);
+        }
+
+        // Start with the best scoring triangle
+        uint32_t bestTri = 0;
+        float bestScore = -1.0f;
+        for (uint32_t t = 0; t < triCount; t++)
+        {
+            const uint32_t* tri = indices + t * 3;
+            float score = vertexScores[tri[0]] + vertexScores[tri[1]] + vertexScores[tri[2]];
+            if (score > bestScore)
+            {
+                bestScore = score;
+                bestTri = t;
+            }
+        }
+
+        std::vector<int32_t> cachePositions(vertexCount, -1);
+        std::vector<uint8_t> emitted(triCount, 0);
+        std::vector<uint32_t> output(triCount * 3);
+        uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+        uint32_t cacheCount = 0;
+        uint32_t nextInputTri = 0;
+
+        for (uint32_t outTri = 0; outTri < triCount; outTri++)
+        {
+            if (bestTri == INVALID_INDEX)
+            {
+                // None of the cached vertices has triangles left, so carry on
+                // with the next triangle of the input
+                while (emitted[nextInputTri])
+                {
+                    nextInputTri++;
+                }
+                bestTri = nextInputTri;
+            }
+
+            const uint32_t* tri = indices + bestTri * 3;
+            memcpy(&output[outTri * 3], tri, 3 * sizeof(uint32_t));
+            emitted[bestTri] = 1;
+
+            // Take the triangle off its vertices' lists
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                uint32_t v = tri[i];
+                uint32_t* triList = &triLists[triListStart[v]];
+                uint32_t count = remaining[v];
+                for (uint32_t j = 0; j < count; j++)
+                {
+                    if (triList[j] == bestTri)
+                    {
+                        triList[j] = triList[count - 1];
+                        break;
+                    }
+                }
+                remaining[v] = count - 1;
+            }
+
+            // The triangle's vertices move to the front of the cache, pushing
+            // back the others, and the last ones out of it
+            uint32_t newCache[FORSYTH_CACHE_SIZE + 3];
+            uint32_t newCount = 0;
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                if ((i == 0 || tri[i] != tri[0]) && (i < 2 || tri[i] != tri[1]))
+                {
+                    newCache[newCount++] = tri[i];
+                }
+            }
+            for (uint32_t i = 0; i < cacheCount; i++)
+            {
+                uint32_t v = cache[i];
+                if (v != tri[0] && v != tri[1] && v != tri[2])
+                {
+                    newCache[newCount++] = v;
+                }
+            }
+
+            // Rescore the vertices that moved, then their triangles, choosing
+            // the best of those as the next triangle
+            for (uint32_t i = 0; i < newCount; i++)
+            {
+                uint32_t v = newCache[i];
+                uint32_t valence = remaining[v];
+                float score = 0.0f;
+                if (valence > 0)
+                {
+                    score = (valence < FORSYTH_VALENCE_TABLE_SIZE) ? valenceScores[valence] :
+                        FORSYTH_VALENCE_BOOST_SCALE * powf(float(valence), -FORSYTH_VALENCE_BOOST_POWER);
+                    if (i < FORSYTH_CACHE_SIZE)
+                    {
+                        score += cacheScores[i];
+                    }
+                }
+                cachePositions[v] = (i < FORSYTH_CACHE_SIZE) ? int32_t(i) : -1;
+                vertexScores[v] = score;
+            }
+
+            bestTri = INVALID_INDEX;
+            bestScore = -1.0f;
+            for (uint32_t i = 0; i < newCount; i++)
+            {
+                uint32_t v = newCache[i];
+                const uint32_t* triList = &triLists[triListStart[v]];
+                for (uint32_t j = 0; j < remaining[v]; j++)
+                {
+                    const uint32_t* candidate = indices + triList[j] * 3;
+                    float score = vertexScores[candidate[0]] + vertexScores[candidate[1]] + vertexScores[candidate[2]];
+                    if (score > bestScore)
+                    {
+                        bestScore = score;
+                        bestTri = triList[j];
+                    }
+                }
+            }
+
+            cacheCount = std::min(newCount, FORSYTH_CACHE_SIZE);
+            memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+        }
+
+        memcpy(indices, &output[0], triCount * 3 * sizeof(uint32_t));
+    }
+
+    void NvModelOptimizer::OptimizeOverdraw(uint32_t* indices, uint32_t indexCount, const float* vertices,
+        uint32_t vertexSize, uint32_t vertexCount, float threshold)
+    {
+        uint32_t triCount = indexCount / 3;
+        if (threshold <= 1.0f || triCount < 2)
+        {
+            return;
+        }
+
+        // Hard cluster boundaries are where the cache restarts, the triangle
+        // sharing no vertex with those before it
+        std::vector<uint32_t> timestamps(vertexCount, 0);
+        uint32_t time = OVERDRAW_CACHE_SIZE + 1;
+        std::vector<uint32_t> hardClusters;
+        for (uint32_t t = 0; t < triCount; t++)
+        {
+            if (UpdateFifoCache(indices + t * 3, OVERDRAW_CACHE_SIZE, timestamps, time) == 3 || t == 0)
+            {
+                hardClusters.push_back(t);
+            }
+        }
+        hardClusters.push_back(triCount);
+
+        // Split the hard clusters further wherever a run of their triangles,
+        // with the cache restarted for it, is within threshold of the whole
+        // cluster's ACMR
+        std::vector<uint32_t> clusters;
+        for (uint32_t c = 0; c + 1 < hardClusters.size(); c++)
+        {
+            uint32_t start = hardClusters[c];
+            uint32_t end = hardClusters[c + 1];
+
+            time += OVERDRAW_CACHE_SIZE + 1;
+            uint32_t clusterMisses = 0;
+            for (uint32_t t = start; t < end; t++)
+            {
+                clusterMisses += UpdateFifoCache(indices + t * 3, OVERDRAW_CACHE_SIZE, timestamps, time);
+            }
+            float targetAcmr = threshold * float(clusterMisses) / float(end - start);
+
+            size_t firstCluster = clusters.size();
+            clusters.push_back(start);
+            time += OVERDRAW_CACHE_SIZE + 1;
+            uint32_t runMisses = 0;
+            uint32_t runTris = 0;
+            for (uint32_t t = start; t < end; t++)
+            {
+                runMisses += UpdateFifoCache(indices + t * 3, OVERDRAW_CACHE_SIZE, timestamps, time);
+                runTris++;
+                if (float(runMisses) <= targetAcmr * float(runTris) && t + 1 < end)
+                {
+                    clusters.push_back(t + 1);
+                    time += OVERDRAW_CACHE_SIZE + 1;
+                    runMisses = 0;
+                    runTris = 0;
+                }
+            }
+
+            // The triangles after the last split seldom reach the target on
+            // their own, so they join the run before them instead
+            if (clusters.size() - firstCluster > 1 && float(runMisses) > targetAcmr * float(runTris))
+            {
+                clusters.pop_back();
+            }
+        }
+        clusters.push_back(triCount);
+        uint32_t clusterCount = uint32_t(clusters.size() - 1);
+
+        // Clusters facing away from the middle of the mesh are the ones most
+        // likely to hide others, so they are drawn first
+        nv::vec3f meshCentroid(0.0f, 0.0f, 0.0f);
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            meshCentroid += nv::vec3f(vertices + v * vertexSize);
+        }
+        meshCentroid *= 1.0f / float(std::max(vertexCount, 1u));
+
+        std::vector<std::pair<float, uint32_t> > sortKeys(clusterCount);
+        for (uint32_t c = 0; c < clusterCount; c++)
+        {
+            nv::vec3f centroid(0.0f, 0.0f, 0.0f);
+            nv::vec3f normal(0.0f, 0.0f, 0.0f);
+            float area = 0.0f;
+            for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++)
+            {
+                const uint32_t* tri = indices + t * 3;
+                nv::vec3f p0(vertices + tri[0] * vertexSize);
+                nv::vec3f p1(vertices + tri[1] * vertexSize);
+                nv::vec3f p2(vertices + tri[2] * vertexSize);
+                nv::vec3f areaNormal = cross(p1 - p0, p2 - p0);
+                float triArea = length(areaNormal);
+                centroid += (p0 + p1 + p2) * (triArea / 3.0f);
+                normal += areaNormal;
+                area += triArea;
+            }
+
+            float key = 0.0f;
+            float normalLength = length(normal);
+            if (area > 0.0f && normalLength > 0.0f)
+            {
+                centroid *= 1.0f / area;
+                key = dot(centroid - meshCentroid, normal) / normalLength;
+            }
+            sortKeys[c] = std::make_pair(-key, c);
+        }
+        std::stable_sort(sortKeys.begin(), sortKeys.end());
+
+        std::vector<uint32_t> output;
+        output.reserve(triCount * 3);
+        for (uint32_t i = 0; i < clusterCount; i++)
+        {
+            uint32_t c = sortKeys[i].second;
+            output.insert(output.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+        }
+        memcpy(indices, &output[0], triCount * 3 * sizeof(uint32_t));
+    }
+
+    void NvModelOptimizer::OptimizeVertexFetch(float* vertices, uint32_t vertexSize, uint32_t vertexCount,
+        uint32_t* indices, uint32_t indexCount)
+    {
+        if (vertexCount == 0)
+        {
+            return;
+        }
+
+        std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+        uint32_t nextVertex = 0;
+        for (uint32_t i = 0; i < indexCount; i++)
+        {
+            uint32_t& newIndex = remap[indices[i]];
+            if (newIndex == INVALID_INDEX)
+            {
+                newIndex = nextVertex++;
+            }
+            indices[i] = newIndex;
+        }
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            if (remap[v] == INVALID_INDEX)
+            {
+                remap[v] = nextVertex++;
+            }
+        }
+
+        std::vector<float> original(vertices, vertices + vertexCount * vertexSize);
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            memcpy(vertices + remap[v] * vertexSize, &original[v * vertexSize], vertexSize * sizeof(float));
+        }
+    }
+
+    void NvModelOptimizer::OptimizeMesh(float* vertices, uint32_t vertexSize, uint32_t vertexCount,
+        uint32_t* indices, uint32_t indexCount, uint32_t meshId,
+        NvModelCacheStats* pBefore, NvModelCacheStats* pAfter)
+    {
+        NvModelCacheStats before = MeasureVertexCache(indices, indexCount, vertexCount);
+
+        // Keep the original order should it already be the better one
+        std::vector<uint32_t> original(indices, indices + indexCount);
+        OptimizeVertexCache(indices, indexCount, vertexCount);
+        if (MeasureVertexCache(indices, indexCount, vertexCount).m_acmr > before.m_acmr)
+        {
+            memcpy(indices, &original[0], indexCount * sizeof(uint32_t));
+        }
+
+        OptimizeOverdraw(indices, indexCount, vertices, vertexSize, vertexCount, ms_overdrawThreshold);
+        OptimizeVertexFetch(vertices, vertexSize, vertexCount, indices, indexCount);
+
+        NvModelCacheStats after = MeasureVertexCache(indices, indexCount, vertexCount);
+        if (ms_reportStats)
+        {
+            LOGI("Mesh %d (%d triangles, %d vertices): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+                meshId, indexCount / 3, vertexCount, before.m_acmr, after.m_acmr, before.m_atvr, after.m_atvr);
+        }
+        if (pBefore)
+        {
+            *pBefore = before;
+        }
+        if (pAfter)
+        {
+            *pAfter = after;
+        }
+    }
+}
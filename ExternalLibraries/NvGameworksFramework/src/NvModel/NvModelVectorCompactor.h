@@ -37,6 +37,8 @@
 
 #include <NvAssert.h>
 #include <NV/NvLogs.h>
+#include <math.h>
+#include <string.h>
 #include <vector>
 #include <map>
 
@@ -48,6 +50,11 @@ namespace Nv
     // by the order in which it was added to the compactor, to its position in the 
     // compacted set.  The container may be given a comparator object to control
     // the methods used to compare the vectors for merging.  
+    // Candidates for merging are found through a hashed grid over the first three
+    // components of the vectors, so each addition only examines the vectors in the
+    // few cells around it.  Should a vector be added whose merges the comparator
+    // can not bound, the container falls back to searching the vectors sorted
+    // along x.
     template <class T, typename Cmp >
     class VectorCompactor
     {
@@ -57,8 +64,25 @@ namespace Nv
         VectorCompactor(float epsilon, uint32_t reserveSize, Cmp comp = Cmp()) :
             m_mappedIndices(0, -1),
             m_epsilon(epsilon),
-            m_comp(comp)
+            m_comp(comp),
+            m_sorted(false)
         {
+            // Pad the reach so that rounding in the comparator cannot place a vector
+            // that would merge outside of the searched cells
+            m_reach = m_comp.Reach(m_epsilon) * 1.001f;
+            if (!(m_reach > 0.0f))
+            {
+                m_reach = 0.0f;
+            }
+
+            // Cells twice as wide as the search on each axis mean it spans at most two
+            // cells per axis.  Candidates are also limited to an x within epsilon, which
+            // may be the narrower bound on that axis.
+            float reachX = (m_epsilon < m_reach) ? m_epsilon : m_reach;
+            m_invCellSize[0] = (reachX > 0.0f) ? (0.5 / reachX) : 0.0;
+            m_invCellSize[1] = (m_reach > 0.0f) ? (0.5 / m_reach) : 0.0;
+            m_invCellSize[2] = m_invCellSize[1];
+
             Reserve(reserveSize);
         }
 
@@ -68,6 +92,9 @@ namespace Nv
             m_vecs.resize(0);
             m_mappedIndices.resize(0);
             m_vecMap.clear();
+            m_cellHeads.assign(m_cellHeads.size(), -1);
+            m_cellNext.resize(0);
+            m_sorted = false;
         }
 
         // Reserve an initial size for the container and its underlying structures.
@@ -78,6 +105,7 @@ namespace Nv
         {
             m_vecs.reserve(size);
             m_mappedIndices.reserve(size);
+            m_cellNext.reserve(size);
         }
 
         // Adds a vector to the container.  The vector's original index will be 
@@ -129,10 +157,11 @@ namespace Nv
         // Returns the number of vectors in the compacted set of vectors
         uint32_t GetVectorCount() { return (uint32_t)(m_vecs.size()); }
 
-        // Note that the key can not be modified once added, so doing this rescale
-        // causes the keys to be out of sync with the vectors themselves.  No new
-        // vectors should be added after this method is called, or they may be
-        // sorted incorrectly.
+        // The grid is rebuilt around the rescaled vectors, but the tolerance is not
+        // rescaled, so vectors added after this method is called are merged by the
+        // epsilon in the new scale.  The sorted search's keys can not be modified once
+        // added, so with it no new vectors should be added after this method is
+        // called, or they may be sorted incorrectly.
         // \param[in] scale Scale factor to multiply all vectors by
         // \param[in] center Object space point about which center the vectors before scaling them
         void RescaleToOrigin(float scale, const T& center)
@@ -145,6 +174,11 @@ namespace Nv
                 (*it) = scale * ((*it) - center);
                 ++it;
             }
+
+            if (!m_sorted && !m_vecs.empty())
+            {
+                RebuildGrid();
+            }
         }
 
     protected:
@@ -167,6 +201,9 @@ namespace Nv
         typedef typename std::pair<T, int32_t> VecMapPair;
         typedef typename std::multimap<T, int32_t, VecCompare> VecMap;
 
+        // Number of leading vector components the grid is built over
+        enum { GRID_DIMS = (sizeof(T) / sizeof(float) < 3) ? (sizeof(T) / sizeof(float)) : 3 };
+
         // Finds an existing vector in the set of compacted vectors that is
         // close enough to the given vector to merge and returns the index
         // of that vector.  If none is within the current tolerance, the new
@@ -176,10 +213,102 @@ namespace Nv
         // \return The index of the vector in the compacted set
         int32_t FindOrAddObject(const T& v)
         {
+            if (!m_sorted && !m_comp.HasReach(v))
+            {
+                UseSortedSearch();
+            }
+
+            if (m_sorted)
+            {
+                return FindOrAddObjectSorted(v);
+            }
+
             // If we have nothing yet, then we simply add this vector to the set
             if (m_vecs.empty())
             {
-                return Add(v, m_vecMap.begin());
+                return Add(v);
+            }
+
+            // Candidates are limited to those whose x is within epsilon of the given
+            // vector, as the sorted search limits them, so both pick the same match.
+            // Any vector that can merge also lies within the comparator's reach of
+            // the given vector in every component, which bounds the cells to search.
+            float minX = v[0] - m_epsilon;
+            float maxX = v[0] + m_epsilon;
+
+            float searchMin[3];
+            float searchMax[3];
+            for (uint32_t i = 0; i < GRID_DIMS; i++)
+            {
+                searchMin[i] = v[i] - m_reach;
+                searchMax[i] = v[i] + m_reach;
+            }
+            searchMin[0] = (minX > searchMin[0]) ? minX : searchMin[0];
+            searchMax[0] = (maxX < searchMax[0]) ? maxX : searchMax[0];
+            if (!(searchMin[0] <= searchMax[0]))
+            {
+                return Add(v);
+            }
+
+            int64_t cellMin[3] = { 0, 0, 0 };
+            int64_t cellMax[3] = { 0, 0, 0 };
+            for (uint32_t i = 0; i < GRID_DIMS; i++)
+            {
+                cellMin[i] = CellCoord(searchMin[i], i);
+                cellMax[i] = CellCoord(searchMax[i], i);
+            }
+
+            int32_t closest = -1;
+            float bestDist2 = 0.0f;
+            for (int64_t z = cellMin[2]; z <= cellMax[2]; z++)
+            {
+                for (int64_t y = cellMin[1]; y <= cellMax[1]; y++)
+                {
+                    for (int64_t x = cellMin[0]; x <= cellMax[0]; x++)
+                    {
+                        int32_t index = m_cellHeads[Bucket(x, y, z)];
+                        for (; index != -1; index = m_cellNext[index])
+                        {
+                            const T& candidate = m_vecs[index];
+                            if ((candidate[0] < minX) || (candidate[0] > maxX))
+                            {
+                                continue;
+                            }
+
+                            // Equally close candidates resolve to the earliest added
+                            float dist2 = m_comp.Diff(v, candidate);
+                            if ((closest == -1) || (dist2 < bestDist2) ||
+                                ((dist2 == bestDist2) && (index < closest)))
+                            {
+                                bestDist2 = dist2;
+                                closest = index;
+                            }
+                        }
+                    }
+                }
+            }
+
+            // Once we have our closest match, see if it's close enough
+            if ((closest == -1) || !m_comp.ShouldMerge(bestDist2, m_epsilon))
+            {
+                // It wasn't, so we need to add the given vector as a new one
+                return Add(v);
+            }
+
+            // We found a suitable vector for re-use
+            return closest;
+        }
+
+        // Searches the vectors sorted by their first component, comparing against
+        // every vector within epsilon of the given one in that component
+        // \param[in] v Vector to be added to the container
+        // \return The index of the vector in the compacted set
+        int32_t FindOrAddObjectSorted(const T& v)
+        {
+            // If we have nothing yet, then we simply add this vector to the set
+            if (m_vecs.empty())
+            {
+                return AddSorted(v, m_vecMap.begin());
             }
 
             // We'll need to find the subset of existing vectors that are potential candidates
@@ -198,7 +327,7 @@ namespace Nv
             {
                 // All existing positions are "below" our minimum point, so insert a 
                 // new vector at the end of the map
-                return Add(v, --rangeStart);
+                return AddSorted(v, --rangeStart);
             }
 
             // Find the first vector whose x is greater than our maximum, thus out of our 
@@ -210,7 +339,7 @@ namespace Nv
             {
                 // No positions are in the range we're looking for, so insert one 
                 // at the closest point in the map
-                return Add(v, --rangeStart);
+                return AddSorted(v, --rangeStart);
             }
 
             // Use the first candidate within our possible range to initialize 
@@ -223,7 +352,8 @@ namespace Nv
             for (++currentIt; currentIt != rangeEnd; ++currentIt)
             {
                 float dist2 = m_comp.Diff(v, currentIt->first);
-                if (dist2 < bestDist2)
+                if ((dist2 < bestDist2) ||
+                    ((dist2 == bestDist2) && (currentIt->second < closestPosition->second)))
                 {
                     bestDist2 = dist2;
                     closestPosition = currentIt;
@@ -234,16 +364,53 @@ namespace Nv
             if (!m_comp.ShouldMerge(bestDist2, m_epsilon))
             {
                 // It wasn't, so we need to add the given vector as a new one
-                return Add(v, rangeStart);
+                return AddSorted(v, rangeStart);
             }
 
             // We found a suitable vector for re-use
             return closestPosition->second;
         }
 
+        // Switches from the grid to the sorted search, sorting the vectors already added
+        void UseSortedSearch()
+        {
+            m_sorted = true;
+            for (int32_t index = 0; index < (int32_t)m_vecs.size(); index++)
+            {
+                m_vecMap.insert(VecMapPair(m_vecs[index], index));
+            }
+            m_cellHeads.clear();
+            m_cellNext.clear();
+        }
+
+        // Adds the given vector to the compacted set and links it into its grid cell
+        int32_t Add(const T& v)
+        {
+            // The remapped index will be the current number of vectors in the compacted set
+            int32_t index = int32_t(m_vecs.size());
+            m_vecs.push_back(v);
+            m_cellNext.push_back(-1);
+
+            // Keep at least one bucket per vector, re-linking every vector when the
+            // table grows
+            if (m_vecs.size() > m_cellHeads.size())
+            {
+                RebuildGrid();
+            }
+            else
+            {
+                uint32_t bucket = Bucket(v);
+                m_cellNext[index] = m_cellHeads[bucket];
+                m_cellHeads[bucket] = index;
+            }
+
+            // Return the new, compacted set index to the caller to be added to the remapping vector
+            return index;
+        }
+
         // Adds the given vector to the compacted set, using the given hint
-        // to find the right spot
-        int32_t Add(const T& v, const typename VecMap::iterator& hint)
+        // to find the right spot in the sorted map
+        int32_t AddSorted(const T& v, const typename VecMap::iterator& hint)
         {
             // The remapped index will be the current number of vectors in the compacted set
             int32_t index = int32_t(m_vecs.size());
@@ -257,11 +424,84 @@ namespace Nv
             return index;
         }
 
+        // Sizes the bucket table to the number of vectors and links every vector
+        // into the bucket of its cell
+        void RebuildGrid()
+        {
+            size_t bucketCount = 1024;
+            while (bucketCount < m_vecs.size())
+            {
+                bucketCount *= 2;
+            }
+            m_cellHeads.assign(bucketCount, -1);
+            m_cellNext.resize(m_vecs.size());
+
+            for (int32_t index = 0; index < (int32_t)m_vecs.size(); index++)
+            {
+                uint32_t bucket = Bucket(m_vecs[index]);
+                m_cellNext[index] = m_cellHeads[bucket];
+                m_cellHeads[bucket] = index;
+            }
+        }
+
+        // Returns the grid cell coordinate of a vector component.  Huge, infinite
+        // and NaN components are clamped, so they only share cells.  Where nothing
+        // but equal components can merge, each value gets a cell of its own.
+        int64_t CellCoord(float c, uint32_t axis) const
+        {
+            if (m_invCellSize[axis] == 0.0)
+            {
+                float value = c + 0.0f;     // Folds -0 into +0
+                uint32_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                return (int64_t)bits;
+            }
+
+            double cell = floor(c * m_invCellSize[axis]);
+            if (!(cell > -1.0e18))
+            {
+                return (int64_t)-1.0e18;
+            }
+            return (cell < 1.0e18) ? (int64_t)cell : (int64_t)1.0e18;
+        }
+
+        // Returns the bucket holding the grid cell with the given coordinates.
+        // Distinct cells may share a bucket, which only adds candidates that the
+        // comparator then rejects.
+        uint32_t Bucket(int64_t x, int64_t y, int64_t z) const
+        {
+            uint64_t h = ((uint64_t)x * 0x9E3779B97F4A7C15ULL) ^
+                ((uint64_t)y * 0xC2B2AE3D27D4EB4FULL) ^
+                ((uint64_t)z * 0x165667B19E3779F9ULL);
+            return (uint32_t)((h ^ (h >> 29)) & (m_cellHeads.size() - 1));
+        }
+
+        // Returns the bucket holding the grid cell that contains the given vector
+        uint32_t Bucket(const T& v) const
+        {
+            int64_t cell[3] = { 0, 0, 0 };
+            for (uint32_t i = 0; i < GRID_DIMS; i++)
+            {
+                cell[i] = CellCoord(v[i], i);
+            }
+            return Bucket(cell[0], cell[1], cell[2]);
+        }
+
         Cmp m_comp;         // The comparator object used to evaluate vectors for merging
         float m_epsilon;    // The tolerance to be used when evaluating vectors for merging
+        float m_reach;      // Largest difference in any component between vectors that may merge
+        double m_invCellSize[3];    // Per axis, the reciprocal of the width of the grid
+                                    // cells, or 0 to give each value its own cell
+        bool m_sorted;      // The sorted search is in use, as a fallback from the grid
 
         VecArray m_vecs;    // The compacted set of vectors
-        VecMap m_vecMap;    // The map of existing vectors to their index in the compacted set
+        VecMap m_vecMap;    // The map of existing vectors to their index in the compacted set,
+                            // used only by the sorted search
+
+        std::vector<int32_t> m_cellHeads;   // Per grid bucket, the most recently added vector
+                                            // in it, or -1 if it is empty
+        std::vector<int32_t> m_cellNext;    // Per compacted vector, the vector added before it
+                                            // to the same bucket, or -1 if it was the first
 
         std::vector<int32_t> m_mappedIndices;   // One entry per vector added to the container, 
                                                 // containing the index in the compacted set that 
@@ -285,6 +525,17 @@ namespace Nv
         {
             return diff < (epsilon * epsilon);
         }
+
+        // Points closer than epsilon differ by less than epsilon in every component
+        float Reach(float epsilon)
+        {
+            return epsilon;
+        }
+
+        bool HasReach(const T& v)
+        {
+            return true;
+        }
     };
 
     // Normal Comparator
@@ -302,6 +553,21 @@ namespace Nv
         {
             return (diff < epsilon);
         }
+
+        // For vectors no longer than the tolerance in HasReach() allows,
+        // |v1 - v2|^2 = |v1|^2 + |v2|^2 - 2 * dot(v1, v2) < 2 * (epsilon + tolerance),
+        // which bounds the difference in every component of normals that merge
+        float Reach(float epsilon)
+        {
+            return sqrtf(2.0f * (epsilon + 0.001f));
+        }
+
+        // Only normals of about unit length can be bounded; longer vectors can have
+        // a large dot product with vectors pointing anywhere
+        bool HasReach(const T& v)
+        {
+            return square_norm(v) <= 1.001f;
+        }
     };
 
     // Helper struct to simplify declarations of compactors for different vector usages
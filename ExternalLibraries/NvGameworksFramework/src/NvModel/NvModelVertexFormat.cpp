@@ -0,0 +1,469 @@
+//----------------------------------------------------------------------------------
+// File:        NvModel/NvModelVertexFormat.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvModel/NvModelVertexFormat.h"
+#include "NvModel/NvModelSubMesh.h"
+#include "NV/NvHalfFloat.h"
+#include <NvAssert.h>
+#include <math.h>
+#include <string.h>
+
+namespace Nv
+{
+    // Largest texture coordinate magnitude stored as half floats; beyond it
+    // their precision falls below about a texel of a 1024 texel texture
+    static const float MAX_HALF_TEXCOORD = 2.0f;
+
+    // Largest finite half float
+    static const float MAX_HALF = 65504.0f;
+
+    // Returns the size of an attribute in a packed vertex, padded to 4 bytes
+    static uint32_t GetPackedAttribSize(uint32_t format, int32_t componentCount)
+    {
+        uint32_t size = 0;
+        switch (format)
+        {
+        case NvVertexAttribFormat::FLOAT16:
+        case NvVertexAttribFormat::UNORM16:
+            size = 2 * componentCount;
+            break;
+        case NvVertexAttribFormat::UNORM8:
+        case NvVertexAttribFormat::UINT8:
+            size = componentCount;
+            break;
+        case NvVertexAttribFormat::SNORM16_OCT:
+            size = 2 * sizeof(int16_t);
+            break;
+        case NvVertexAttribFormat::FLOAT32:
+        default:
+            size = componentCount * sizeof(float);
+            break;
+        }
+        return (size + 3) & ~3u;
+    }
+
+    // Returns true if every component of an attribute lies in [minValue, maxValue]
+    static bool IsAttribInRange(const SubMesh& mesh, int32_t offset, int32_t componentCount,
+        float minValue, float maxValue)
+    {
+        for (uint32_t v = 0; v < mesh.m_vertexCount; v++)
+        {
+            const float* pValues = mesh.m_vertices + v * mesh.m_vertSize + offset;
+            for (int32_t c = 0; c < componentCount; c++)
+            {
+                // written so that NaNs are out of range
+                if (!(pValues[c] >= minValue && pValues[c] <= maxValue))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static float Clamp(float value, float minValue, float maxValue)
+    {
+        return (value < minValue) ? minValue : ((value > maxValue) ? maxValue : value);
+    }
+
+    static float SignNotZero(float value)
+    {
+        return (value >= 0.0f) ? 1.0f : -1.0f;
+    }
+
+    // Projects a vector onto the octahedron |x| + |y| + |z| = 1, unfolding the
+    // lower half onto the corners of the upper one; zero vectors become (0, 0)
+    static void EncodeOctahedral(const float* pVector, int16_t* pEncoded)
+    {
+        float x = 0.0f;
+        float y = 0.0f;
+        float sum = fabsf(pVector[0]) + fabsf(pVector[1]) + fabsf(pVector[2]);
+        if (sum > 0.0f)
+        {
+            x = pVector[0] / sum;
+            y = pVector[1] / sum;
+            if (pVector[2] < 0.0f)
+            {
+                float foldedX = (1.0f - fabsf(y)) * SignNotZero(x);
+                y = (1.0f - fabsf(x)) * SignNotZero(y);
+                x = foldedX;
+            }
+        }
+        pEncoded[0] = int16_t(floorf(Clamp(x, -1.0f, 1.0f) * 32767.0f + 0.5f));
+        pEncoded[1] = int16_t(floorf(Clamp(y, -1.0f, 1.0f) * 32767.0f + 0.5f));
+    }
+
+    static void DecodeOctahedral(const int16_t* pEncoded, float* pVector)
+    {
+        float x = Clamp(pEncoded[0] / 32767.0f, -1.0f, 1.0f);
+        float y = Clamp(pEncoded[1] / 32767.0f, -1.0f, 1.0f);
+        float z = 1.0f - fabsf(x) - fabsf(y);
+        if (z < 0.0f)
+        {
+            float unfoldedX = (1.0f - fabsf(y)) * SignNotZero(x);
+            y = (1.0f - fabsf(x)) * SignNotZero(y);
+            x = unfoldedX;
+        }
+        float scale = 1.0f / sqrtf(x * x + y * y + z * z);
+        pVector[0] = x * scale;
+        pVector[1] = y * scale;
+        pVector[2] = z * scale;
+    }
+
+    static void PackAttrib(uint32_t format, const float* pSrc, int32_t componentCount, uint8_t* pDest)
+    {
+        // 3-component 8 and 16-bit attributes are read as 4 components, as
+        // GPUs need not fetch 3, so the padding holds a 1 like an opaque alpha
+        if (componentCount == 3 && (format == NvVertexAttribFormat::FLOAT16 ||
+            format == NvVertexAttribFormat::UNORM16 || format == NvVertexAttribFormat::UNORM8))
+        {
+            static const float s_one = 1.0f;
+            uint32_t componentSize = (format == NvVertexAttribFormat::UNORM8) ? 1 : 2;
+            PackAttrib(format, &s_one, 1, pDest + 3 * componentSize);
+        }
+
+        switch (format)
+        {
+        case NvVertexAttribFormat::FLOAT16:
+            for (int32_t c = 0; c < componentCount; c++)
+            {
+                uint16_t value = nv::floatToHalf(pSrc[c]);
+                memcpy(pDest + c * sizeof(uint16_t), &value, sizeof(uint16_t));
+            }
+            break;
+        case NvVertexAttribFormat::UNORM16:
+            for (int32_t c = 0; c < componentCount; c++)
+            {
+                uint16_t value = uint16_t(Clamp(pSrc[c], 0.0f, 1.0f) * 65535.0f + 0.5f);
+                memcpy(pDest + c * sizeof(uint16_t), &value, sizeof(uint16_t));
+            }
+            break;
+        case NvVertexAttribFormat::UNORM8:
+            for (int32_t c = 0; c < componentCount; c++)
+            {
+                pDest[c] = uint8_t(Clamp(pSrc[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+            break;
+        case NvVertexAttribFormat::UINT8:
+            for (int32_t c = 0; c < componentCount; c++)
+            {
+                uint32_t value;
+                memcpy(&value, pSrc + c, sizeof(uint32_t));
+                pDest[c] = uint8_t(value);
+            }
+            break;
+        case NvVertexAttribFormat::SNORM16_OCT:
+            {
+                int16_t encoded[2];
+                EncodeOctahedral(pSrc, encoded);
+                memcpy(pDest, encoded, sizeof(encoded));
+            }
+            break;
+        case NvVertexAttribFormat::FLOAT32:
+        default:
+            memcpy(pDest, pSrc, componentCount * sizeof(float));
+            break;
+        }
+    }
+
+    static void UnpackAttrib(uint32_t format, const uint8_t* pSrc, int32_t componentCount, float* pDest)
+    {
+        switch (format)
+        {
+        case NvVertexAttribFormat::FLOAT16:
+            for (int32_t c = 0; c < componentCount; c++)
+            {
+                uint16_t value;
+                memcpy(&value, pSrc + c * sizeof(uint16_t), sizeof(uint16_t));
+                pDest[c] = nv::halfToFloat(value);
+            }
+            break;
+        case NvVertexAttribFormat::UNORM16:
+            for (int32_t c = 0; c < componentCount; c++)
+            {
+                uint16_t value;
+                memcpy(&value, pSrc + c * sizeof(uint16_t), sizeof(uint16_t));
+                pDest[c] = value / 65535.0f;
+            }
+            break;
+        case NvVertexAttribFormat::UNORM8:
+            for (int32_t c = 0; c < componentCount; c++)
+            {
+                pDest[c] = pSrc[c] / 255.0f;
+            }
+            break;
+        case NvVertexAttribFormat::UINT8:
+            for (int32_t c = 0; c < componentCount; c++)
+            {
+                uint32_t value = pSrc[c];
+                memcpy(pDest + c, &value, sizeof(uint32_t));
+            }
+            break;
+        case NvVertexAttribFormat::SNORM16_OCT:
+            {
+                int16_t encoded[2];
+                memcpy(encoded, pSrc, sizeof(encoded));
+                DecodeOctahedral(encoded, pDest);
+            }
+            break;
+        case NvVertexAttribFormat::FLOAT32:
+        default:
+            memcpy(pDest, pSrc, componentCount * sizeof(float));
+            break;
+        }
+    }
+
+    NvPackedVertexFormat::NvPackedVertexFormat() :
+        m_floatVertexSize(0),
+        m_packedVertexSize(0)
+    {
+        for (int32_t a = 0; a < NvVertexAttrib::COUNT; a++)
+        {
+            m_attribs[a].m_format = NvVertexAttribFormat::FLOAT32;
+            m_attribs[a].m_componentCount = 0;
+            m_attribs[a].m_floatOffset = -1;
+            m_attribs[a].m_packedOffset = -1;
+        }
+    }
+
+    void NvPackedVertexFormat::Init(const SubMesh& mesh, const NvVertexAttribFormat::Enum* formats)
+    {
+        int32_t floatOffsets[NvVertexAttrib::COUNT];
+        floatOffsets[NvVertexAttrib::POSITION] = mesh.getPositionOffset();
+        floatOffsets[NvVertexAttrib::NORMAL] = mesh.getNormalOffset();
+        floatOffsets[NvVertexAttrib::TEXCOORD] = mesh.getTexCoordOffset();
+        floatOffsets[NvVertexAttrib::TANGENT] = mesh.getTangentOffset();
+        floatOffsets[NvVertexAttrib::COLOR] = mesh.getColorOffset();
+        floatOffsets[NvVertexAttrib::BONE_INDEX] = mesh.getBoneIndexOffset();
+        floatOffsets[NvVertexAttrib::BONE_WEIGHT] = mesh.getBoneWeightOffset();
+
+        // Only positions may start the vertex; the other attributes are absent
+        // when their offset is zero or -1
+        m_floatVertexSize = mesh.getVertexSize();
+        for (int32_t a = 0; a < NvVertexAttrib::COUNT; a++)
+        {
+            Attrib& attrib = m_attribs[a];
+            bool present = (a == NvVertexAttrib::POSITION) || (floatOffsets[a] > 0);
+            attrib.m_floatOffset = present ? floatOffsets[a] : -1;
+            attrib.m_format = (present && formats) ? formats[a] : NvVertexAttribFormat::FLOAT32;
+        }
+
+        for (int32_t a = 0; a < NvVertexAttrib::COUNT; a++)
+        {
+            Attrib& attrib = m_attribs[a];
+            attrib.m_componentCount = 0;
+            if (attrib.m_floatOffset < 0)
+            {
+                continue;
+            }
+
+            int32_t end = m_floatVertexSize;
+            for (int32_t b = 0; b < NvVertexAttrib::COUNT; b++)
+            {
+                int32_t offset = m_attribs[b].m_floatOffset;
+                if (offset > attrib.m_floatOffset && offset < end)
+                {
+                    end = offset;
+                }
+            }
+            attrib.m_componentCount = end - attrib.m_floatOffset;
+            NV_ASSERT(attrib.m_format != NvVertexAttribFormat::SNORM16_OCT || attrib.m_componentCount == 3);
+        }
+
+        ComputeOffsets();
+    }
+
+    void NvPackedVertexFormat::InitCompact(const SubMesh& mesh)
+    {
+        Init(mesh, NULL);
+
+        NvVertexAttribFormat::Enum formats[NvVertexAttrib::COUNT];
+        for (int32_t a = 0; a < NvVertexAttrib::COUNT; a++)
+        {
+            formats[a] = NvVertexAttribFormat::FLOAT32;
+        }
+
+        if (m_attribs[NvVertexAttrib::NORMAL].m_componentCount == 3)
+        {
+            formats[NvVertexAttrib::NORMAL] = NvVertexAttribFormat::SNORM16_OCT;
+        }
+
+        if (m_attribs[NvVertexAttrib::TANGENT].m_componentCount == 3)
+        {
+            formats[NvVertexAttrib::TANGENT] = NvVertexAttribFormat::SNORM16_OCT;
+        }
+
+        const Attrib& texCoord = m_attribs[NvVertexAttrib::TEXCOORD];
+        if (texCoord.m_componentCount > 0)
+        {
+            if (IsAttribInRange(mesh, texCoord.m_floatOffset, texCoord.m_componentCount, 0.0f, 1.0f))
+            {
+                formats[NvVertexAttrib::TEXCOORD] = NvVertexAttribFormat::UNORM16;
+            }
+            else if (IsAttribInRange(mesh, texCoord.m_floatOffset, texCoord.m_componentCount, -MAX_HALF_TEXCOORD, MAX_HALF_TEXCOORD))
+            {
+                formats[NvVertexAttrib::TEXCOORD] = NvVertexAttribFormat::FLOAT16;
+            }
+        }
+
+        const Attrib& color = m_attribs[NvVertexAttrib::COLOR];
+        if (color.m_componentCount > 0)
+        {
+            if (IsAttribInRange(mesh, color.m_floatOffset, color.m_componentCount, 0.0f, 1.0f))
+            {
+                formats[NvVertexAttrib::COLOR] = NvVertexAttribFormat::UNORM8;
+            }
+            else if (IsAttribInRange(mesh, color.m_floatOffset, color.m_componentCount, -MAX_HALF, MAX_HALF))
+            {
+                formats[NvVertexAttrib::COLOR] = NvVertexAttribFormat::FLOAT16;
+            }
+        }
+
+        const Attrib& boneWeight = m_attribs[NvVertexAttrib::BONE_WEIGHT];
+        if (boneWeight.m_componentCount > 0 &&
+            IsAttribInRange(mesh, boneWeight.m_floatOffset, boneWeight.m_componentCount, 0.0f, 1.0f))
+        {
+            formats[NvVertexAttrib::BONE_WEIGHT] = NvVertexAttribFormat::UNORM8;
+        }
+
+        // Bone indices are integers held in the floats' bits
+        const Attrib& boneIndex = m_attribs[NvVertexAttrib::BONE_INDEX];
+        if (boneIndex.m_componentCount > 0)
+        {
+            bool fitsInByte = true;
+            for (uint32_t v = 0; v < mesh.m_vertexCount && fitsInByte; v++)
+            {
+                const float* pValues = mesh.m_vertices + v * mesh.m_vertSize + boneIndex.m_floatOffset;
+                for (int32_t c = 0; c < boneIndex.m_componentCount; c++)
+                {
+                    uint32_t value;
+                    memcpy(&value, pValues + c, sizeof(uint32_t));
+                    fitsInByte = fitsInByte && (value < 256);
+                }
+            }
+            if (fitsInByte)
+            {
+                formats[NvVertexAttrib::BONE_INDEX] = NvVertexAttribFormat::UINT8;
+            }
+        }
+
+        Init(mesh, formats);
+    }
+
+    bool NvPackedVertexFormat::IsPacked() const
+    {
+        for (int32_t a = 0; a < NvVertexAttrib::COUNT; a++)
+        {
+            if (m_attribs[a].m_componentCount > 0 && m_attribs[a].m_format != NvVertexAttribFormat::FLOAT32)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void NvPackedVertexFormat::ComputeOffsets()
+    {
+        // Keep the attributes in the order of the float vertex
+        m_packedVertexSize = 0;
+        int32_t lastOffset = -1;
+        for (;;)
+        {
+            int32_t next = -1;
+            for (int32_t a = 0; a < NvVertexAttrib::COUNT; a++)
+            {
+                int32_t offset = m_attribs[a].m_floatOffset;
+                if (m_attribs[a].m_componentCount > 0 && offset > lastOffset &&
+                    (next < 0 || offset < m_attribs[next].m_floatOffset))
+                {
+                    next = a;
+                }
+            }
+            if (next < 0)
+            {
+                break;
+            }
+
+            Attrib& attrib = m_attribs[next];
+            attrib.m_packedOffset = m_packedVertexSize;
+            m_packedVertexSize += GetPackedAttribSize(attrib.m_format, attrib.m_componentCount);
+            lastOffset = attrib.m_floatOffset;
+        }
+
+        for (int32_t a = 0; a < NvVertexAttrib::COUNT; a++)
+        {
+            if (m_attribs[a].m_componentCount == 0)
+            {
+                m_attribs[a].m_packedOffset = -1;
+            }
+        }
+    }
+
+    void NvPackedVertexFormat::Pack(const float* pSrc, uint32_t vertexCount, uint8_t* pDest) const
+    {
+        memset(pDest, 0, vertexCount * m_packedVertexSize);
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            const float* pSrcVertex = pSrc + v * m_floatVertexSize;
+            uint8_t* pDestVertex = pDest + v * m_packedVertexSize;
+            for (int32_t a = 0; a < NvVertexAttrib::COUNT; a++)
+            {
+                const Attrib& attrib = m_attribs[a];
+                if (attrib.m_componentCount > 0)
+                {
+                    PackAttrib(attrib.m_format, pSrcVertex + attrib.m_floatOffset, attrib.m_componentCount,
+                        pDestVertex + attrib.m_packedOffset);
+                }
+            }
+        }
+    }
+
+    void NvPackedVertexFormat::Unpack(const uint8_t* pSrc, uint32_t vertexCount, float* pDest) const
+    {
+        memset(pDest, 0, vertexCount * m_floatVertexSize * sizeof(float));
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            const uint8_t* pSrcVertex = pSrc + v * m_packedVertexSize;
+            float* pDestVertex = pDest + v * m_floatVertexSize;
+            for (int32_t a = 0; a < NvVertexAttrib::COUNT; a++)
+            {
+                const Attrib& attrib = m_attribs[a];
+                if (attrib.m_componentCount > 0)
+                {
+                    UnpackAttrib(attrib.m_format, pSrcVertex + attrib.m_packedOffset, attrib.m_componentCount,
+                        pDestVertex + attrib.m_floatOffset);
+                }
+            }
+        }
+    }
+}
@@ -33,6 +33,7 @@
 //----------------------------------------------------------------------------------
 #include "NvVkUtil/NvPlatformVK.h"
 #include "NvVkUtil/NvGPUTimerVK.h"
+#include "NvVkUtil/NvGPUProfilerVK.h"
 #include "NvAppContextVK.h"
 #include "NV/NvLogs.h"
 #include <NvAssert.h>
@@ -727,20 +728,41 @@ bool NvAppContextVK::initializeDevice(PFN_vkGetProcAddressNV getProc)
 			return false;
 	}
 
-	mStaging.init(this);
+	mAllocator.init(_device, _physicalDeviceMemoryProperties, _physicalDeviceLimits);
+	mStaging.init(this, MAX_BUFFERED_FRAMES);
+	mUniforms.init(this, MAX_BUFFERED_FRAMES);
+
+	if (!initPipelineCache())
+		return false;
 
 	// fences
 	for (int i = 0; i < MAX_BUFFERED_FRAMES; i++) {
 		mFrames[i].mFence = VK_NULL_HANDLE;
+		mFrames[i].mSerial = 0;
 
 		mFrames[i].mCmdBuffers = createCmdBuffer(mTempCmdPool, true);
 		mFrames[i].mOpen = false;
+
+		// one-shot command buffers are recycled by resetting the whole pool
+		VkCommandPoolCreateInfo cmdPoolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+		cmdPoolInfo.queueFamilyIndex = _queueFamilyIndex;
+		cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		result = vkCreateCommandPool(_device, &cmdPoolInfo, NULL, &mFrames[i].mTempCmdPool);
+		if (result != VK_SUCCESS)
+			return false;
+		mFrames[i].mTempCmdBuffersUsed = 0;
+		mFrames[i].mTempCmdSerial = 0;
 	}
 
 	mCurrFrameIndex = 0;
+	mCompletedSerial = 0;
 
 	m_frameTimer = new NvGPUTimerVK;
 	m_frameTimer->init(*this);
 
+	// stays disabled (no queries) unless the app turns it on
+	m_profiler = new NvGPUProfilerVK;
+	m_profiler->init(*this, MAX_BUFFERED_FRAMES);
+
 	return true;
 }
@@ -207,7 +207,7 @@ public:
 	NvVkBuffer m_vbo;
 	NvBitFontVertex* m_vboMapping;
 
-	static NvSimpleUBO<NvBitFontUBO, 1024> ms_ubo;
+	static NvSimpleUBO<NvBitFontUBO> ms_ubo;
 
 	static NvVkBuffer ms_ibo;
 
@@ -227,7 +227,7 @@ public:
 	static VkSampler ms_sampler;
 };
 
-NvSimpleUBO<NvBitFontUBO, 1024> NvBFTextRenderVK::ms_ubo;
+NvSimpleUBO<NvBitFontUBO> NvBFTextRenderVK::ms_ubo;
 NvVkBuffer NvBFTextRenderVK::ms_ibo;
 VkVertexInputAttributeDescription NvBFTextRenderVK::ms_attributes[3];
 VkVertexInputBindingDescription NvBFTextRenderVK::ms_vertexBindings;
@@ -384,6 +384,7 @@ int32_t NvBFTextRenderVK::StaticInit() {
 #endif
 
 	InitPipeline(stageCount, stages, &ms_pipelineText);
+	vk.releaseShaders(stages, stageCount);
 
 #if USE_SOURCE_SHADERS
 	stageCount = vk.createShadersFromSourceString(s_fontOutlineShader, stages, 2);
@@ -392,6 +393,7 @@ int32_t NvBFTextRenderVK::StaticInit() {
 #endif
 
 	InitPipeline(stageCount, stages, &ms_pipelineOutline);
+	vk.releaseShaders(stages, stageCount);
 
 	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
 	descriptorSetAllocateInfo.descriptorPool = ms_descriptorPool;
@@ -507,7 +509,7 @@ void NvBFTextRenderVK::InitPipeline(uint32_t shaderCount,
 
 	pipelineInfo.layout = ms_pipelineLayout;
 
-	result = vkCreateGraphicsPipelines(vk.device(), VK_NULL_HANDLE, 1, &pipelineInfo, NULL,
+	result = vkCreateGraphicsPipelines(vk.device(), vk.pipelineCache(), 1, &pipelineInfo, NULL,
 		pipeline);
 	CHECK_VK_RESULT();
 }
@@ -565,7 +567,6 @@ NvBitFontRender* NvBitFontRenderVK::Create(NvImage *image)
 NvBFTextRenderVK::NvBFTextRenderVK() //: m_vbo(0)
 {
 	NvVkContext& vk = *NvUIVKctx().mVk;
-	VkResult result;
 
 	int32_t bufferSize = MAX_CHARS * VERT_PER_QUAD * sizeof(NvBitFontVertex);
 	if (VK_SUCCESS != vk.createAndFillBuffer(bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 
@@ -575,10 +576,7 @@ NvBFTextRenderVK::NvBFTextRenderVK() //: m_vbo(0)
 		return;
 	}
 
-	result = vkMapMemory(vk.device(), m_vbo.mem, 0, bufferSize, 0, (void**)&m_vboMapping);
-	if (result != VK_SUCCESS) {
-		m_vboMapping = NULL;
-	}
+	m_vboMapping = (NvBitFontVertex*)m_vbo.mapped();
 }
 
 //========================================================================
@@ -654,11 +652,7 @@ void NvBFTextRenderVK::UpdateText(int count, const BFVert* data, bool midrender)
 		return;
 
 	memcpy(m_vboMapping, data, count * VERT_PER_QUAD * sizeof(NvBitFontVertex));
-	VkMappedMemoryRange range = { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
-	range.memory = m_vbo.mem;
-	range.offset = 0;
-	range.size = count * VERT_PER_QUAD * sizeof(NvBitFontVertex);
-	vkFlushMappedMemoryRanges(NvUIVKctx().mVk->device(), 1, &range);
+	NvUIVKctx().mVk->flushBuffer(m_vbo, 0, count * VERT_PER_QUAD * sizeof(NvBitFontVertex));
 }
 
 void NvBFTextRenderVK::RenderDone()
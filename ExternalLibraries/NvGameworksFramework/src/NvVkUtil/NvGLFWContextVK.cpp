@@ -98,8 +98,7 @@ bool NvGLFWContextVK::readFramebufferRGBX32(uint8_t *dest, int32_t& w, int32_t&
 
 		vkDeviceWaitIdle(device());
 
-		uint8_t* ptr = NULL;
-		result = vkMapMemory(device(), dstBuffer.mem, 0, size, 0, (void**)&ptr);
+		uint8_t* ptr = (uint8_t*)dstBuffer.mapped();
 
 		uint32_t rowSize = w * 4;
 		ptr += rowSize * (h - 1);
@@ -110,6 +109,8 @@ bool NvGLFWContextVK::readFramebufferRGBX32(uint8_t *dest, int32_t& w, int32_t&
 			ptr -= rowSize;
 		}
 
+		destroyBuffer(dstBuffer);
+
 		return true;
 	}
 
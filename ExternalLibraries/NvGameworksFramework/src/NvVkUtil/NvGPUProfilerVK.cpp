@@ -0,0 +1,327 @@
+//----------------------------------------------------------------------------------
+// File:        NvVkUtil/NvGPUProfilerVK.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvVkUtil/NvGPUProfilerVK.h"
+#include "NvVkUtil/NvVkContext.h"
+#include "NV/NvLogs.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+static const uint32_t NO_PARENT = 0xffffffff;
+
+NvGPUProfilerVK::NvGPUProfilerVK() :
+	mDevice(VK_NULL_HANDLE),
+	mPool(VK_NULL_HANDLE),
+	mMaxScopes(0),
+	mPeriodMs(0.0),
+	mTimestampMask(0),
+	mEnabled(false),
+	mCurrentSlot(-1),
+	mCurrentCmd(VK_NULL_HANDLE),
+	mTraceOrigin(0)
+{
+}
+
+NvGPUProfilerVK::~NvGPUProfilerVK()
+{
+	deinit();
+}
+
+bool NvGPUProfilerVK::init(NvVkContext& vk, uint32_t frameSlots, uint32_t maxScopesPerFrame)
+{
+	mDevice = vk.device();
+	mMaxScopes = maxScopesPerFrame;
+	mSlots.resize(frameSlots);
+
+	// timestampPeriod = ns / tick; we want ms / tick
+	mPeriodMs = 1e-6 * double(vk.physicalDeviceLimits().timestampPeriod);
+
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(vk.physicalDevice(), &familyCount, NULL);
+	std::vector<VkQueueFamilyProperties> families(familyCount);
+	if (familyCount)
+		vkGetPhysicalDeviceQueueFamilyProperties(vk.physicalDevice(), &familyCount, &families[0]);
+
+	uint32_t validBits = (vk.queueFamilyIndex() < familyCount) ? families[vk.queueFamilyIndex()].timestampValidBits : 0;
+	if (!validBits) {
+		LOGI("GPU profiler disabled: the queue does not support timestamps");
+		return false;
+	}
+	mTimestampMask = (validBits >= 64) ? ~0ULL : ((1ULL << validBits) - 1);
+
+	VkQueryPoolCreateInfo queryInfo = { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+	queryInfo.queryCount = frameSlots * mMaxScopes * 2;
+	queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	VkResult result = vkCreateQueryPool(mDevice, &queryInfo, NULL, &mPool);
+	if (result != VK_SUCCESS) {
+		mPool = VK_NULL_HANDLE;
+		return false;
+	}
+
+	return true;
+}
+
+void NvGPUProfilerVK::deinit()
+{
+	if (mPool != VK_NULL_HANDLE) {
+		vkDestroyQueryPool(mDevice, mPool, NULL);
+		mPool = VK_NULL_HANDLE;
+	}
+	mSlots.clear();
+	mCurrentSlot = -1;
+}
+
+uint32_t NvGPUProfilerVK::findStat(uint32_t parent, const char* name)
+{
+	std::string path = (parent == NO_PARENT) ? std::string(name) : (mStats[parent].path + "/" + name);
+
+	std::map<std::string, uint32_t>::iterator iter = mStatIndices.find(path);
+	if (iter != mStatIndices.end())
+		return iter->second;
+
+	ScopeStats stats;
+	stats.name = name;
+	stats.path = path;
+	stats.depth = (parent == NO_PARENT) ? 0 : mStats[parent].depth + 1;
+
+	uint32_t index = (uint32_t)mStats.size();
+	mStats.push_back(stats);
+	mStatIndices[path] = index;
+	return index;
+}
+
+void NvGPUProfilerVK::beginFrame(VkCommandBuffer cmd, uint32_t slot)
+{
+	if (slot >= mSlots.size())
+		return;
+
+	collect(slot);
+
+	if (!mEnabled || mPool == VK_NULL_HANDLE) {
+		mCurrentSlot = -1;
+		mCurrentCmd = VK_NULL_HANDLE;
+		return;
+	}
+
+	// The one reset of the frame; it must precede every timestamp of the slot
+	vkCmdResetQueryPool(cmd, mPool, slot * mMaxScopes * 2, mMaxScopes * 2);
+
+	mCurrentSlot = (int32_t)slot;
+	mCurrentCmd = cmd;
+	mOpenScopes.clear();
+
+	beginScope(cmd, "Frame");
+}
+
+void NvGPUProfilerVK::endFrame(VkCommandBuffer cmd)
+{
+	if (mCurrentSlot < 0 || cmd != mCurrentCmd)
+		return;
+
+	while (!mOpenScopes.empty())
+		endScope(cmd);
+
+	mCurrentSlot = -1;
+	mCurrentCmd = VK_NULL_HANDLE;
+}
+
+void NvGPUProfilerVK::beginScope(VkCommandBuffer cmd, const char* name)
+{
+	if (mCurrentSlot < 0 || cmd != mCurrentCmd)
+		return;
+
+	std::vector<Scope>& scopes = mSlots[mCurrentSlot].scopes;
+	if (scopes.size() >= mMaxScopes) {
+		mOpenScopes.push_back(-1);
+		return;
+	}
+
+	uint32_t parent = NO_PARENT;
+	for (size_t i = mOpenScopes.size(); i > 0; i--) {
+		if (mOpenScopes[i - 1] >= 0) {
+			parent = scopes[mOpenScopes[i - 1]].stat;
+			break;
+		}
+	}
+
+	Scope scope;
+	scope.stat = findStat(parent, name);
+	scope.closed = false;
+
+	uint32_t index = (uint32_t)scopes.size();
+	scopes.push_back(scope);
+	mOpenScopes.push_back((int32_t)index);
+
+	vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mPool, (mCurrentSlot * mMaxScopes + index) * 2);
+}
+
+void NvGPUProfilerVK::endScope(VkCommandBuffer cmd)
+{
+	if (mCurrentSlot < 0 || cmd != mCurrentCmd || mOpenScopes.empty())
+		return;
+
+	int32_t index = mOpenScopes.back();
+	mOpenScopes.pop_back();
+	if (index < 0)
+		return;
+
+	vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mPool, (mCurrentSlot * mMaxScopes + index) * 2 + 1);
+	mSlots[mCurrentSlot].scopes[index].closed = true;
+}
+
+void NvGPUProfilerVK::collect(uint32_t slot)
+{
+	std::vector<Scope>& scopes = mSlots[slot].scopes;
+	if (scopes.empty())
+		return;
+
+	uint32_t count = (uint32_t)scopes.size();
+	std::vector<uint64_t> times(count * 2);
+
+	// The slot's frame has retired, so this never waits; a frame that was cut
+	// short (unclosed scopes) reports not ready and is dropped
+	VkResult result = vkGetQueryPoolResults(mDevice, mPool, slot * mMaxScopes * 2, count * 2,
+		times.size() * sizeof(uint64_t), &times[0], sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+	if (result == VK_SUCCESS) {
+		for (uint32_t i = 0; i < count; i++) {
+			if (!scopes[i].closed)
+				continue;
+
+			uint64_t begin = times[i * 2];
+			uint64_t end = times[i * 2 + 1];
+			double ms = double((end - begin) & mTimestampMask) * mPeriodMs;
+
+			ScopeStats& stats = mStats[scopes[i].stat];
+			if (!stats.count) {
+				stats.minMs = ms;
+				stats.maxMs = ms;
+			}
+			else {
+				stats.minMs = std::min(stats.minMs, ms);
+				stats.maxMs = std::max(stats.maxMs, ms);
+			}
+			stats.totalMs += ms;
+			stats.count++;
+
+			if (mTrace.size() < MAX_TRACE_EVENTS) {
+				if (mTrace.empty())
+					mTraceOrigin = begin;
+
+				TraceEvent event;
+				event.stat = scopes[i].stat;
+				event.begin = begin;
+				event.end = end;
+				mTrace.push_back(event);
+			}
+		}
+	}
+
+	scopes.clear();
+}
+
+void NvGPUProfilerVK::collectAll()
+{
+	for (uint32_t i = 0; i < mSlots.size(); i++) {
+		if ((int32_t)i != mCurrentSlot)
+			collect(i);
+	}
+}
+
+void NvGPUProfilerVK::clear()
+{
+	for (size_t i = 0; i < mStats.size(); i++) {
+		ScopeStats& stats = mStats[i];
+		stats.count = 0;
+		stats.minMs = 0.0;
+		stats.maxMs = 0.0;
+		stats.totalMs = 0.0;
+	}
+	mTrace.clear();
+	mTraceOrigin = 0;
+}
+
+void NvGPUProfilerVK::logStats() const
+{
+	for (size_t i = 0; i < mStats.size(); i++) {
+		const ScopeStats& stats = mStats[i];
+		if (!stats.count)
+			continue;
+		LOGI("GPU %*s%s: avg %.3f ms, min %.3f ms, max %.3f ms (%u samples)", stats.depth * 2, "",
+			stats.name.c_str(), stats.avgMs(), stats.minMs, stats.maxMs, stats.count);
+	}
+}
+
+static void writeJSONString(FILE* fp, const std::string& str)
+{
+	fputc('"', fp);
+	for (size_t i = 0; i < str.size(); i++) {
+		char c = str[i];
+		if (c == '"' || c == '\\')
+			fputc('\\', fp);
+		if ((unsigned char)c >= 0x20)
+			fputc(c, fp);
+	}
+	fputc('"', fp);
+}
+
+bool NvGPUProfilerVK::writeChromeTrace(const char* filename) const
+{
+	FILE* fp = fopen(filename, "w");
+	if (!fp) {
+		LOGE("Cannot write GPU trace %s", filename);
+		return false;
+	}
+
+	double periodUs = mPeriodMs * 1000.0;
+
+	fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (size_t i = 0; i < mTrace.size(); i++) {
+		const TraceEvent& event = mTrace[i];
+		const ScopeStats& stats = mStats[event.stat];
+
+		fprintf(fp, "%s{\"name\":", i ? ",\n" : "");
+		writeJSONString(fp, stats.name);
+		fprintf(fp, ",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"path\":",
+			double((event.begin - mTraceOrigin) & mTimestampMask) * periodUs,
+			double((event.end - event.begin) & mTimestampMask) * periodUs);
+		writeJSONString(fp, stats.path);
+		fprintf(fp, "}}");
+	}
+	fprintf(fp, "\n]}\n");
+
+	bool ok = !ferror(fp);
+	fclose(fp);
+	return ok;
+}
@@ -41,6 +41,8 @@
 
 namespace Nv
 {
+	bool NvMeshExtVK::ms_octahedralNormals = false;
+
 	NvMeshExtVK::NvMeshExtVK() :
 		m_pSrcMesh(NULL),
 		m_materialID(-1),
@@ -61,7 +63,8 @@ namespace Nv
 		m_boneIndexOffset(-1),
 		m_weightSize(0),
 		m_weightOffset(-1),
-		m_parentNode(-1)
+		m_parentNode(-1),
+		m_indexType(VK_INDEX_TYPE_UINT32)
 	{
 	}
 
@@ -86,7 +89,9 @@ namespace Nv
 		m_weightSize(other.m_weightSize),
 		m_weightOffset(other.m_weightOffset),
 		m_parentNode(other.m_parentNode),
-		m_offsetMatrix(other.m_offsetMatrix)
+		m_offsetMatrix(other.m_offsetMatrix),
+		m_indexType(other.m_indexType),
+		m_vertexFormat(other.m_vertexFormat)
 	{
 	}
 
@@ -110,6 +115,38 @@ namespace Nv
 		}
 	}
 
+	// Returns the format of a packed attribute; integer attributes are read as
+	// such rather than normalized
+	static VkFormat getPackedComponentFormat(NvVertexAttribFormat::Enum format, uint32_t count, bool integer) {
+		static const VkFormat float32Formats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+		static const VkFormat uint32Formats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+		static const VkFormat float16Formats[] = { VK_FORMAT_R16_SFLOAT, VK_FORMAT_R16G16_SFLOAT, VK_FORMAT_R16G16B16_SFLOAT, VK_FORMAT_R16G16B16A16_SFLOAT };
+		static const VkFormat unorm16Formats[] = { VK_FORMAT_R16_UNORM, VK_FORMAT_R16G16_UNORM, VK_FORMAT_R16G16B16_UNORM, VK_FORMAT_R16G16B16A16_UNORM };
+		static const VkFormat unorm8Formats[] = { VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_R8G8B8A8_UNORM };
+		static const VkFormat uint8Formats[] = { VK_FORMAT_R8_UINT, VK_FORMAT_R8G8_UINT, VK_FORMAT_R8G8B8_UINT, VK_FORMAT_R8G8B8A8_UINT };
+
+		if (format == NvVertexAttribFormat::SNORM16_OCT)
+			return VK_FORMAT_R16G16_SNORM;
+		if (count == 3 && format != NvVertexAttribFormat::FLOAT32)
+			count = 4; // padded, see NvPackedVertexFormat
+		if (count < 1 || count > 4)
+			return VK_FORMAT_UNDEFINED;
+
+		switch (format) {
+		case NvVertexAttribFormat::FLOAT16:
+			return float16Formats[count - 1];
+		case NvVertexAttribFormat::UNORM16:
+			return unorm16Formats[count - 1];
+		case NvVertexAttribFormat::UNORM8:
+			return unorm8Formats[count - 1];
+		case NvVertexAttribFormat::UINT8:
+			return uint8Formats[count - 1];
+		case NvVertexAttribFormat::FLOAT32:
+		default:
+			return integer ? uint32Formats[count - 1] : float32Formats[count - 1];
+		}
+	}
+
 	bool NvMeshExtVK::InitFromSubmesh(NvVkContext& vk,
 		NvModelExt* pModel, uint32_t subMeshID)
 	{
@@ -132,25 +169,54 @@ namespace Nv
 		// them first in the vertex layout
 		m_positionOffset = 0;
 
-		// Account for normals, if there are any
-		m_normalOffset = m_pSrcMesh->m_normalOffset * sizeof(float);
+		// Vertices loaded packed stay packed on the GPU, but for octahedral
+		// normals and tangents, which only shaders that decode them can use
+		m_vertexFormat = m_pSrcMesh->m_packedFormat;
+		if (m_vertexFormat.IsPacked() && !ms_octahedralNormals)
+		{
+			NvVertexAttribFormat::Enum formats[NvVertexAttrib::COUNT];
+			for (int32_t i = 0; i < NvVertexAttrib::COUNT; i++)
+			{
+				formats[i] = m_vertexFormat.GetFormat(NvVertexAttrib::Enum(i));
+				if (formats[i] == NvVertexAttribFormat::SNORM16_OCT)
+					formats[i] = NvVertexAttribFormat::FLOAT32;
+			}
+			m_vertexFormat.Init(*m_pSrcMesh, formats);
+		}
 
-		// Account for texture coordinates, if there are any
-		m_texCoordOffset = m_pSrcMesh->m_texCoordOffset * sizeof(float);
+		const NvPackedVertexFormat& packedFormat = m_vertexFormat;
+		bool packed = packedFormat.IsPacked();
+		if (packed)
+		{
+			m_normalOffset = packedFormat.GetOffset(NvVertexAttrib::NORMAL);
+			m_texCoordOffset = packedFormat.GetOffset(NvVertexAttrib::TEXCOORD);
+			m_tangentOffset = packedFormat.GetOffset(NvVertexAttrib::TANGENT);
+			m_colorOffset = packedFormat.GetOffset(NvVertexAttrib::COLOR);
+			m_boneIndexOffset = packedFormat.GetOffset(NvVertexAttrib::BONE_INDEX);
+			m_weightOffset = packedFormat.GetOffset(NvVertexAttrib::BONE_WEIGHT);
+		}
+		else
+		{
+			// Account for normals, if there are any
+			m_normalOffset = m_pSrcMesh->m_normalOffset * sizeof(float);
+
+			// Account for texture coordinates, if there are any
+			m_texCoordOffset = m_pSrcMesh->m_texCoordOffset * sizeof(float);
 
-		// Account for tangents, if there are any
-		m_tangentOffset = m_pSrcMesh->m_tangentOffset * sizeof(float);
+			// Account for tangents, if there are any
+			m_tangentOffset = m_pSrcMesh->m_tangentOffset * sizeof(float);
 
-		// Account for colors, if there are any
-		m_colorOffset = m_pSrcMesh->m_colorOffset * sizeof(float);
+			// Account for colors, if there are any
+			m_colorOffset = m_pSrcMesh->m_colorOffset * sizeof(float);
 
-		// Account for bone indices, if there are any
-		m_boneIndexOffset = m_pSrcMesh->m_boneIndexOffset * sizeof(uint32_t);
+			// Account for bone indices, if there are any
+			m_boneIndexOffset = m_pSrcMesh->m_boneIndexOffset * sizeof(uint32_t);
 
-		// Account for bone weights, if there are any
-		m_weightOffset = m_pSrcMesh->m_boneWeightOffset * sizeof(float);
+			// Account for bone weights, if there are any
+			m_weightOffset = m_pSrcMesh->m_boneWeightOffset * sizeof(float);
+		}
 
-		uint32_t vertBytes = sizeof(float) * m_vertexSize;
+		uint32_t vertBytes = packed ? packedFormat.GetVertexSize() : sizeof(float) * m_vertexSize;
 
 		// Allocate a large enough vertex buffer to hold all vertices in the mesh
 		m_vertexCount = m_pSrcMesh->m_vertexCount;
@@ -159,21 +225,41 @@ namespace Nv
 
 		// Create a vertex buffer and fill it with data
 		uint32_t vboBytes = vertBytes * m_vertexCount;
-
+		std::vector<uint8_t> packedVertices;
+		const void* pVertexData = m_pSrcMesh->m_vertices;
+		if (packed && vboBytes > 0)
+		{
+			packedVertices.resize(vboBytes);
+			packedFormat.Pack(m_pSrcMesh->m_vertices, m_vertexCount, &packedVertices[0]);
+			pVertexData = &packedVertices[0];
+		}
 
 		// Allocate a large enough index buffer to hold the indices for all primitives in the mesh
 		m_indexCount = m_pSrcMesh->m_indexCount;
 
+		// Indices into at most 65535 vertices fit in 16 bits
+		std::vector<uint16_t> shortIndices;
+		const void* pIndexData = m_pSrcMesh->m_indices;
+		uint32_t indexBytes = sizeof(uint32_t) * m_indexCount;
+		m_indexType = VK_INDEX_TYPE_UINT32;
+		if (m_vertexCount <= 0xFFFF && m_indexCount > 0)
+		{
+			shortIndices.assign(m_pSrcMesh->m_indices, m_pSrcMesh->m_indices + m_indexCount);
+			pIndexData = &shortIndices[0];
+			indexBytes = sizeof(uint16_t) * m_indexCount;
+			m_indexType = VK_INDEX_TYPE_UINT16;
+		}
+
 		// Create the vertex buffer
 		VkResult result = vk.createAndFillBuffer(vboBytes,
             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			mVBO, m_pSrcMesh->m_vertices);
+			mVBO, pVertexData);
 		CHECK_VK_RESULT();
 
 		// Create the index buffer
-		result = vk.createAndFillBuffer(sizeof(uint32_t) * m_indexCount,
+		result = vk.createAndFillBuffer(indexBytes,
             VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			mIBO, m_pSrcMesh->m_indices);
+			mIBO, pIndexData);
 		CHECK_VK_RESULT();
 
 		// Create static state info for the mPipeline.
@@ -208,16 +294,24 @@ namespace Nv
 	bool NvMeshExtVK::InitVertexState() {
 		mAttribCount = 0;
 
+		// Packed vertices take their formats from the vertex buffer's layout;
+		// octahedral normals and tangents, if kept, reach the shader as two
+		// components to decode
+		const NvPackedVertexFormat& packedFormat = m_vertexFormat;
+		bool packed = packedFormat.IsPacked();
+
 		mAttributes[0].location = 0;
 		mAttributes[mAttribCount].binding = 0;
-		mAttributes[mAttribCount].format = getComponentFormat(3);
+		mAttributes[mAttribCount].format = packed ?
+			getPackedComponentFormat(packedFormat.GetFormat(NvVertexAttrib::POSITION), 3, false) : getComponentFormat(3);
 		mAttributes[mAttribCount].offset = 0;
 		mAttribCount++;
 
 		if (m_pSrcMesh->HasNormals()) {
 			mAttributes[mAttribCount].location = 1;
 			mAttributes[mAttribCount].binding = 0;
-			mAttributes[mAttribCount].format = getComponentFormat(3);
+			mAttributes[mAttribCount].format = packed ?
+				getPackedComponentFormat(packedFormat.GetFormat(NvVertexAttrib::NORMAL), 3, false) : getComponentFormat(3);
 			mAttributes[mAttribCount].offset = m_normalOffset;
 			mAttribCount++;
 		}
@@ -225,7 +319,8 @@ namespace Nv
 		if (m_pSrcMesh->HasTexCoords()) {
 			mAttributes[mAttribCount].location = 2;
 			mAttributes[mAttribCount].binding = 0;
-			mAttributes[mAttribCount].format = getComponentFormat(2);
+			mAttributes[mAttribCount].format = packed ?
+				getPackedComponentFormat(packedFormat.GetFormat(NvVertexAttrib::TEXCOORD), 2, false) : getComponentFormat(2);
 			mAttributes[mAttribCount].offset = m_texCoordOffset;
 			mAttribCount++;
 		}
@@ -233,7 +328,8 @@ namespace Nv
 		if (m_pSrcMesh->HasTangents()) {
 			mAttributes[mAttribCount].location = 3;
 			mAttributes[mAttribCount].binding = 0;
-			mAttributes[mAttribCount].format = getComponentFormat(3);
+			mAttributes[mAttribCount].format = packed ?
+				getPackedComponentFormat(packedFormat.GetFormat(NvVertexAttrib::TANGENT), 3, false) : getComponentFormat(3);
 			mAttributes[mAttribCount].offset = m_tangentOffset;
 			mAttribCount++;
 		}
@@ -241,7 +337,8 @@ namespace Nv
 		if (m_pSrcMesh->HasColors()) {
 			mAttributes[mAttribCount].location = 4;
 			mAttributes[mAttribCount].binding = 0;
-			mAttributes[mAttribCount].format = getComponentFormat(4);
+			mAttributes[mAttribCount].format = packed ?
+				getPackedComponentFormat(packedFormat.GetFormat(NvVertexAttrib::COLOR), 4, false) : getComponentFormat(4);
 			mAttributes[mAttribCount].offset = m_colorOffset;
 			mAttribCount++;
 		}
@@ -249,12 +346,14 @@ namespace Nv
 		if (m_pSrcMesh->HasBoneWeights()) {
 			mAttributes[mAttribCount].location = 5;
 			mAttributes[mAttribCount].binding = 0;
-			mAttributes[mAttribCount].format = VK_FORMAT_R32G32B32A32_UINT;
+			mAttributes[mAttribCount].format = packed ?
+				getPackedComponentFormat(packedFormat.GetFormat(NvVertexAttrib::BONE_INDEX), 4, true) : VK_FORMAT_R32G32B32A32_UINT;
 			mAttributes[mAttribCount].offset = m_boneIndexOffset;
 			mAttribCount++;
 			mAttributes[mAttribCount].location = 6;
 			mAttributes[mAttribCount].binding = 0;
-			mAttributes[mAttribCount].format = getComponentFormat(4);
+			mAttributes[mAttribCount].format = packed ?
+				getPackedComponentFormat(packedFormat.GetFormat(NvVertexAttrib::BONE_WEIGHT), 4, false) : getComponentFormat(4);
 			mAttributes[mAttribCount].offset = m_weightOffset;
 			mAttribCount++;
 		}
@@ -301,7 +400,7 @@ namespace Nv
 		// Bind the vertex and index buffers
 		VkDeviceSize offsets[] = { 0 };
 		vkCmdBindVertexBuffers(cmd, 0, 1, &mVBO(), offsets);
-		vkCmdBindIndexBuffer(cmd, mIBO(), 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindIndexBuffer(cmd, mIBO(), 0, m_indexType);
 
 		// Draw the triangle
 		vkCmdDrawIndexed(cmd, m_indexCount, instanceCount, 0, 0, firstInst);
@@ -33,13 +33,14 @@
 //----------------------------------------------------------------------------------
 
 #include "NvVkUtil/NvModelExtVK.h"
+#include "NvVkUtil/NvVkTextureManager.h"
 #include "NvModel/NvModelExt.h"
 #include "../../src/NvModel/NvModelExtObj.h"
 
 namespace Nv
 {
 
-	NvModelExtVK* NvModelExtVK::Create(NvVkContext& vk, NvModelExt* pSourceModel)
+	NvModelExtVK* NvModelExtVK::Create(NvVkContext& vk, NvModelExt* pSourceModel, NvVkTextureManager* pTextures)
 	{
 		if (NULL == pSourceModel)
 		{
@@ -48,16 +49,19 @@ namespace Nv
 
 		NvModelExtVK* model = new NvModelExtVK(pSourceModel);
 		model->m_pSourceModel = pSourceModel;
+		model->m_pTextureManager = pTextures;
 		model->PrepareForRendering(vk, pSourceModel);
 		return model;
 	}
 
 	void NvModelExtVK::Release(NvVkContext& vk)
 	{
+		ReleaseManagedTextures();
 	}
 
 	NvModelExtVK::NvModelExtVK(NvModelExt* pSourceModel) :
 		m_pSourceModel(pSourceModel),
+		m_pTextureManager(NULL),
 		m_instanced(false)
 	{
 		NV_ASSERT(NULL != pSourceModel);
@@ -65,12 +69,34 @@ namespace Nv
 
 	NvModelExtVK::~NvModelExtVK()
 	{
+		ReleaseManagedTextures();
+
 		if (m_pSourceModel)
 		{
 			delete m_pSourceModel;
 		}
 	};
 
+	void NvModelExtVK::MarkTexturesUsed()
+	{
+		for (size_t textureIndex = 0; textureIndex < m_managedTextures.size(); ++textureIndex)
+		{
+			if (m_managedTextures[textureIndex])
+				m_pTextureManager->markUsed(m_managedTextures[textureIndex]);
+		}
+	}
+
+	void NvModelExtVK::ReleaseManagedTextures()
+	{
+		for (size_t textureIndex = 0; textureIndex < m_managedTextures.size(); ++textureIndex)
+		{
+			if (m_managedTextures[textureIndex])
+				m_pTextureManager->release(m_managedTextures[textureIndex]);
+			m_textures[textureIndex] = NULL;
+		}
+		m_managedTextures.clear();
+	}
+
 	bool NvModelExtVK::UpdateBoneTransforms()
 	{
 		std::vector<NvMeshExtVK*>::iterator meshIt = m_meshes.begin();
@@ -108,14 +134,31 @@ namespace Nv
 		// Get GL usable versions of all the textures used by the model
 		uint32_t textureCount = m_pSourceModel->GetTextureCount();
 		m_textures.resize(textureCount);
-		for (uint32_t textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+		if (m_pTextureManager)
+		{
+			// Shared textures, whose NvVkTexture the manager keeps current
+			m_managedTextures.resize(textureCount);
+			for (uint32_t textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+			{
+				NvVkManagedTexture* t = m_pTextureManager->acquire(m_pSourceModel->GetTextureName(textureIndex).c_str());
+				m_managedTextures[textureIndex] = t;
+				m_textures[textureIndex] = t ? &t->getTexture() : NULL;
+			}
+		}
+		else
 		{
-			NvVkTexture* t = new NvVkTexture;
-			if (vk.uploadTextureFromDDSFile(m_pSourceModel->GetTextureName(textureIndex).c_str(), *t)) {
-				m_textures[textureIndex] = t;
+			for (uint32_t textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+			{
+				NvVkTexture* t = new NvVkTexture;
+				if (vk.uploadTextureFromDDSFile(m_pSourceModel->GetTextureName(textureIndex).c_str(), *t)) {
+					m_textures[textureIndex] = t;
+				}
 			}
 		}
 
+		// One submit for all of the model's textures
+		vk.submitUploads();
+
 		// Get VK usable versions of all the materials in the model
 		uint32_t materialCount = pModel->GetMaterialCount();
 		m_materials.resize(materialCount);
@@ -33,6 +33,7 @@
 //----------------------------------------------------------------------------------
 #include "NvSampleAppVK.h"
 #include "NvAppWrapperContextVK.h"
+#include "NvVkUtil/NvGPUProfilerVK.h"
 #include "NV/NvLogs.h"
 #include "NvAppBase/NvFramerateCounter.h"
 #include "NvAppBase/NvInputTransformer.h"
@@ -47,6 +48,7 @@
 
 #include <stdarg.h>
 #include <sstream>
+#include <thread>
 
 #if defined(ANDROID)
 #include "../NvEGLUtil/NvEGLUtil.h"
@@ -60,7 +62,13 @@
 #endif
 
 NvSampleAppVK::NvSampleAppVK() :
-	  mUseWSI(true)
+	  mStartupTimer(NULL)
+	, mRecorder(NULL)
+	, mRecordingThreads(0)
+	, mMaxTextureSize(0)
+	, mTextureBudgetMB(0)
+	, mGPUProfile(false)
+	, mUseWSI(true)
 	, mUseGLUI(false)
 	, mWrapperContext(NULL)
 	, mGLCallbacks(NULL)
@@ -69,9 +77,17 @@ NvSampleAppVK::NvSampleAppVK() :
 
 NvSampleAppVK::~NvSampleAppVK()
 {
+	delete mStartupTimer;
+	delete mRecorder;
 }
 
 bool NvSampleAppVK::platformInitRendering(void) {
+	// Covers device creation, pipeline cache load and the app's initRendering
+	if (!mStartupTimer)
+		mStartupTimer = createStopWatch();
+	mStartupTimer->reset();
+	mStartupTimer->start();
+
 	if (!mContext->initialize()) {
 		showDialog("Fatal: Vulkan Not Available", 
 			"Cannot find required Vulkan components.\nPlease visit http://developer.nvidia.com\n"
@@ -81,6 +97,18 @@ bool NvSampleAppVK::platformInitRendering(void) {
 		return false;
 	}
 
+	// Block-compressed DDS files are expanded on the CPU only if the device
+	// cannot sample them
+	vk().configureTextureExpansion();
+
+	// "-maxtexturesize" and "-texturebudget" shrink textures as they are uploaded
+	vk().setTextureBudget(mMaxTextureSize, (VkDeviceSize)mTextureBudgetMB << 20);
+
+	// Profiling adds timestamp writes to every scope, so test mode only
+	// reports per-scope GPU timings when asked to with "-gpuprofile"
+	if (mGPUProfile)
+		vk().gpuProfiler().setEnabled(true);
+
 	if (!mUseWSI && mGLSupported) {
 		if (!strstr((const char*)glGetString(GL_EXTENSIONS), "GL_NV_draw_vulkan_image")) {
 			mGLSupported = false;
@@ -92,12 +120,71 @@ bool NvSampleAppVK::platformInitRendering(void) {
 
 void NvSampleAppVK::platformInitUI(void) {
 	mContext->initUI();
+
+	mStartupTimer->stop();
+	LOGI("Startup took %.1f ms (%u bytes of pipeline cache reused)", mStartupTimer->getTime() * 1000.0f,
+		(uint32_t)vk().pipelineCacheLoadedBytes());
+}
+
+void NvSampleAppVK::platformShutdownRendering(void) {
+	if (mRecorder) {
+		vkDeviceWaitIdle(device());
+		delete mRecorder;
+		mRecorder = NULL;
+	}
+
+	vk().savePipelineCache();
+
+	if (vk().textureStats().reducedCount)
+		vk().logTextureStats();
+
+	if (vk().gpuProfiler().isEnabled()) {
+		vkDeviceWaitIdle(device());
+		vk().gpuProfiler().collectAll();
+		vk().gpuProfiler().logStats();
+		if (!mGPUTraceFile.empty())
+			vk().gpuProfiler().writeChromeTrace(mGPUTraceFile.c_str());
+	}
+}
+
+uint32_t NvSampleAppVK::recordingThreadCount() {
+	if (!mRecordingThreads) {
+		uint32_t cores = std::thread::hardware_concurrency();
+		mRecordingThreads = (cores == 0) ? 1 : ((cores > 8) ? 8 : cores);
+	}
+
+	return mRecordingThreads;
+}
+
+bool NvSampleAppVK::recordParallel(VkCommandBuffer cmd, VkRenderPass renderPass, VkFramebuffer framebuffer,
+	uint32_t itemCount, NvVkParallelRecorder::Job& job, uint32_t minItemsPerSlice) {
+	if (!mRecorder) {
+		mRecorder = new NvVkParallelRecorder;
+		if (!mRecorder->init(vk(), getThreadManagerInstance(), recordingThreadCount() - 1)) {
+			LOGE("Failed to start the command buffer recording threads");
+			delete mRecorder;
+			mRecorder = NULL;
+			return false;
+		}
+	}
+
+	VkCommandBufferInheritanceInfo inheritInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+	inheritInfo.renderPass = renderPass;
+	inheritInfo.subpass = 0;
+	inheritInfo.framebuffer = framebuffer;
+
+	return mRecorder->record(cmd, inheritInfo, itemCount, job, minItemsPerSlice);
 }
 
 bool NvSampleAppVK::initialize(const NvPlatformInfo& platform, int32_t width, int32_t height) {
 	NvVKConfiguration vkConfig;
 	configurationCallback(vkConfig);
 
+#ifndef ANDROID
+	if (vkConfig.pipelineCacheFile.empty())
+		vkConfig.pipelineCacheFile = getAppTitle() + ".vkpipelinecache";
+#endif
+
 	const std::vector<std::string>& cmd = getCommandLine();
 	std::vector<std::string>::const_iterator iter = cmd.begin();
 
@@ -124,6 +211,24 @@ bool NvSampleAppVK::initialize(const NvPlatformInfo& platform, int32_t width, in
 			useLoaderDebug = true;
 		else if (*iter == "-apidump")
 			useApiDump = true;
+		else if (*iter == "-gpuprofile")
+			mGPUProfile = true;
+		else if (*iter == "-gputrace" && (iter + 1) != cmd.end()) {
+			mGPUProfile = true;
+			mGPUTraceFile = *(++iter);
+		}
+		else if (*iter == "-recordthreads" && (iter + 1) != cmd.end()) {
+			iter++;
+			std::stringstream(*iter) >> mRecordingThreads;
+		}
+		else if (*iter == "-maxtexturesize" && (iter + 1) != cmd.end()) {
+			iter++;
+			std::stringstream(*iter) >> mMaxTextureSize;
+		}
+		else if (*iter == "-texturebudget" && (iter + 1) != cmd.end()) {
+			iter++;
+			std::stringstream(*iter) >> mTextureBudgetMB;
+		}
     }
 
 #if defined(_WIN32) || defined(LINUX)
@@ -262,6 +367,51 @@ bool NvSampleAppVK::initialize(const NvPlatformInfo& platform, int32_t width, in
 }
 
 void NvSampleAppVK::platformLogTestResults(float frameRate, int32_t frames) {
+	writeLogFile(mTestName, true, "Startup %.1f ms, %u bytes of pipeline cache reused\n",
+		mStartupTimer ? mStartupTimer->getTime() * 1000.0f : 0.0f, (uint32_t)vk().pipelineCacheLoadedBytes());
+
+	// Test mode exits without shutting down rendering
+	vk().savePipelineCache();
+
+	const NvVkStagingStats& staging = vk().stagingBuffer().getStats();
+	writeLogFile(mTestName, true, "Staging ring %llu KB, high water %llu KB, %llu KB staged, %u dedicated uploads (%llu KB)\n",
+		(unsigned long long)(staging.ringSize >> 10), (unsigned long long)(staging.highWaterMark >> 10),
+		(unsigned long long)(staging.totalBytes >> 10), staging.dedicatedCount,
+		(unsigned long long)(staging.dedicatedBytes >> 10));
+
+	writeLogFile(mTestName, true, "Shader modules: %u created, %u shared\n",
+		vk().shaderCacheMisses(), vk().shaderCacheHits());
+
+	const NvVkUniformStats& uniforms = vk().uniformAllocator().getStats();
+	writeLogFile(mTestName, true, "Uniforms: %u allocations (%llu KB), high water %llu KB, %u flushes, %u failed\n",
+		uniforms.allocCount, (unsigned long long)(uniforms.totalBytes >> 10),
+		(unsigned long long)(uniforms.highWaterMark >> 10), uniforms.flushCount, uniforms.failedCount);
+
+	writeLogFile(mTestName, true, "Temp command buffers: %u requested, %u allocated\n",
+		vk().tempCmdBufferRequests(), vk().tempCmdBufferCount());
+
+	const NvVkTextureStats& textures = vk().textureStats();
+	writeLogFile(mTestName, true, "Textures: %llu KB resident, high water %llu KB, %u reduced (%llu KB saved)\n",
+		(unsigned long long)(textures.residentBytes >> 10), (unsigned long long)(textures.highWaterMark >> 10),
+		textures.reducedCount, (unsigned long long)(textures.savedBytes >> 10));
+
+	NvGPUProfilerVK& profiler = vk().gpuProfiler();
+	if (!profiler.isEnabled())
+		return;
+
+	vkDeviceWaitIdle(device());
+	profiler.collectAll();
+
+	const std::vector<NvGPUProfilerVK::ScopeStats>& scopes = profiler.getStats();
+	for (size_t i = 0; i < scopes.size(); i++) {
+		const NvGPUProfilerVK::ScopeStats& scope = scopes[i];
+		if (scope.count)
+			writeLogFile(mTestName, true, "GPU %s: avg %.3f ms, min %.3f ms, max %.3f ms\n",
+				scope.path.c_str(), scope.avgMs(), scope.minMs, scope.maxMs);
+	}
+
+	if (!mGPUTraceFile.empty())
+		profiler.writeChromeTrace(mGPUTraceFile.c_str());
 }
 
 
@@ -54,7 +54,7 @@ NvUIGraphicRender* NvUIGraphicRenderVK::Create(NvUIGraphic* graphic) {
 
 //======================================================================
 //======================================================================
-NvSimpleUBO<NvGraphicUBO, 1024> NvUIGraphicRenderBaseVK::ms_ubo;
+NvSimpleUBO<NvGraphicUBO> NvUIGraphicRenderBaseVK::ms_ubo;
 
 NvVkBuffer NvUIGraphicRenderBaseVK::ms_vbo;
 NvVkBuffer NvUIGraphicRenderBaseVK::ms_ibo;
@@ -317,7 +317,7 @@ void NvUIGraphicRenderBaseVK::InitPipeline(uint32_t shaderCount,
 
 	pipelineInfo.layout = ms_pipelineLayout;
 
-	result = vkCreateGraphicsPipelines(vk.device(), VK_NULL_HANDLE, 1, &pipelineInfo, NULL,
+	result = vkCreateGraphicsPipelines(vk.device(), vk.pipelineCache(), 1, &pipelineInfo, NULL,
 		pipeline);
 	CHECK_VK_RESULT();
 }
@@ -87,11 +87,10 @@ static char s_graphicShader[] =
 void NvGraphicShaderVK::Load()
 {
 	NvVkContext& vk = *NvUIVKctx().mVk;
-	uint32_t stageCount = 0;
 #if USE_SOURCE_SHADERS
-	stageCount = vk.createShadersFromSourceString(s_graphicShader, mStages, MAX_STAGES);
+	mStageCount = vk.createShadersFromSourceString(s_graphicShader, mStages, MAX_STAGES);
 #else
-	stageCount = vk.createShadersFromBinaryBlob((uint32_t*)graphicData, graphicLength, mStages, MAX_STAGES);
+	mStageCount = vk.createShadersFromBinaryBlob((uint32_t*)graphicData, graphicLength, mStages, MAX_STAGES);
 #endif
 }
 
@@ -72,6 +72,7 @@ void NvUIRenderPrepVK()
 	renderPassBeginInfo.pClearValues = clearValues;
 	renderPassBeginInfo.clearValueCount = 2;
 
+	vk.beginScope(cmd, "UI");
 	vkCmdBeginRenderPass(cmd, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 }
 
@@ -79,6 +80,7 @@ void NvUIRenderPrepVK()
 void NvUIRenderDoneVK()
 {
 	vkCmdEndRenderPass(s_drawCtx.mCmd);
+	s_drawCtx.mVk->endScope(s_drawCtx.mCmd);
 
 	s_drawCtx.mVk->submitMainCommandBuffer(NvVkContext::CMD_UI_FRAMEWORK);
 }
@@ -57,7 +57,7 @@ public:
 		VkPipelineColorBlendStateCreateInfo* pBlendState,
 		VkPipeline* pipeline);
 
-	static NvSimpleUBO<NvGraphicUBO, 1024> ms_ubo;
+	static NvSimpleUBO<NvGraphicUBO> ms_ubo;
 
 	static NvVkBuffer ms_vbo;
 	static NvVkBuffer ms_ibo;
@@ -35,6 +35,7 @@
 #include "NvAssetLoader/NvAssetLoader.h"
 #include "NvImage/NvImage.h"
 #include "NvVkUtil/NvGPUTimerVK.h"
+#include "NvVkUtil/NvGPUProfilerVK.h"
 
 #include "NV/NvLogs.h"
 #include <NvAssert.h>
@@ -42,7 +43,9 @@
 #include <vector>
 #include <string>
 #include <set>
+#include <map>
 #include <algorithm>
+#include <stdio.h>
 
 using std::vector;
 using std::string;
@@ -50,6 +53,16 @@ using std::set;
 
 #define ARRAY_SIZE(a) ( sizeof(a) / sizeof( (a)[0] ))
 
+NvVkContext::~NvVkContext() {
+	if (_device)
+		vkDeviceWaitIdle(_device);
+
+	// both rings return their buffers to the allocator, so it goes last
+	mUniforms.deinit();
+	mStaging.deinit();
+	mAllocator.deinit();
+}
+
 bool NvVkContext::reshape(int32_t& w, int32_t& h) {
 	VkResult result;
 
@@ -68,6 +81,10 @@ bool NvVkContext::nextFrame() {
 
 	VkCommandBuffer cmd = mFrames[current].mCmdBuffers;
 
+	// Textures queued during the frame must be resident before it executes
+	submitUploads();
+	retireUploads();
+
 	if (mFrames[current].mFence == VK_NULL_HANDLE) {
 		VkFenceCreateInfo info = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
 		VkResult result = vkCreateFence(_device, &info, NULL, &mFrames[current].mFence);
@@ -78,6 +95,8 @@ bool NvVkContext::nextFrame() {
 	VkSemaphore* wait = NULL;
 	VkSemaphore* signal = NULL;
 
+	m_profiler->endFrame(cmd);
+
 	VkResult result = vkEndCommandBuffer(cmd);
 	CHECK_VK_RESULT();
 	if (result != VK_SUCCESS)
@@ -102,18 +121,24 @@ bool NvVkContext::nextFrame() {
 	if (submitInfo.waitSemaphoreCount + submitInfo.signalSemaphoreCount)
 		submitInfo.pWaitDstStageMask = waitStageFlags;
 
+	// One flush covers every uniform written while recording the frame
+	mUniforms.endFrame(current);
+
 	result = vkQueueSubmit(queue(), 1, &submitInfo, VK_NULL_HANDLE);
 	CHECK_VK_RESULT();
 	if (result != VK_SUCCESS)
 		return false;
 
+	// Staging done so far is released when this frame's fence signals
+	mStaging.endFrame(current);
+
 	// Fence was rest in getMainCmdBuffer
 	result = vkQueueSubmit(queue(), 0, NULL, mFrames[current].mFence);
 	CHECK_VK_RESULT();
 	if (result != VK_SUCCESS)
 		return false;
+	mFrames[current].mSerial = currentSubmissionSerial();
 
-	destroyPastFrameCmdBuffers();
 	mCurrFrameIndex++;
 	return true;
 }
@@ -138,8 +163,13 @@ VkCommandBuffer NvVkContext::getMainCommandBuffer(CmdBufferIndex index)
 				}
 			}
 
+			mCompletedSerial = std::max(mCompletedSerial, mFrames[current].mSerial);
+
 			result = vkResetFences(device(), 1, &(mFrames[current].mFence));
 			CHECK_VK_RESULT();
+
+			mStaging.retireFrame(current);
+			mUniforms.retireFrame(current);
 		}
 
 		// Record the commands (resets the buffer)
@@ -154,11 +184,52 @@ VkCommandBuffer NvVkContext::getMainCommandBuffer(CmdBufferIndex index)
 
 
 		m_frameTimer->start(cmd);
+		m_profiler->beginFrame(cmd, current);
 	}
 
 	return cmd;
 }
 
+bool NvVkContext::isSubmissionComplete(uint64_t serial)
+{
+	if (serial <= mCompletedSerial)
+		return true;
+
+	// Not submitted yet
+	if (serial >= currentSubmissionSerial())
+		return false;
+
+	FrameInfo& frame = mFrames[(serial - 1) % MAX_BUFFERED_FRAMES];
+
+	// The slot has been reused, which only happens after its fence was waited on
+	if (frame.mSerial != serial)
+		return true;
+
+	if (vkGetFenceStatus(device(), frame.mFence) != VK_SUCCESS)
+		return false;
+
+	mCompletedSerial = serial;
+	return true;
+}
+
+bool NvVkContext::waitForSubmission(uint64_t serial)
+{
+	if (isSubmissionComplete(serial))
+		return true;
+
+	if (serial >= currentSubmissionSerial())
+		return false;
+
+	FrameInfo& frame = mFrames[(serial - 1) % MAX_BUFFERED_FRAMES];
+	VkResult result = vkWaitForFences(device(), 1, &frame.mFence, VK_TRUE, UINT64_MAX);
+	CHECK_VK_RESULT();
+	if (result != VK_SUCCESS)
+		return false;
+
+	mCompletedSerial = serial;
+	return true;
+}
+
 // Submits this frame's main command buffer and does any end-of-frame sync
 bool NvVkContext::submitMainCommandBuffer(CmdBufferIndex index)
 {
@@ -172,6 +243,60 @@ bool NvVkContext::submitMainCommandBuffer(CmdBufferIndex index)
 	return true;
 }
 
+// Hands out a one-shot command buffer from the current frame's pool.  The pool is
+// reset as a whole the first time the frame slot is used again, once the frame that
+// last used it has retired, and its buffers are then handed out again
+VkCommandBuffer NvVkContext::acquireTempCmdBuffer()
+{
+	FrameInfo& frame = mFrames[mCurrFrameIndex % MAX_BUFFERED_FRAMES];
+	uint64_t serial = currentSubmissionSerial();
+
+	if (frame.mTempCmdSerial != serial) {
+		if (frame.mTempCmdBuffersUsed) {
+			// Normally retired long ago: the frame's fence was waited on to reuse the slot
+			if (!waitForSubmission(frame.mTempCmdSerial))
+				return 0;
+
+			VkResult result = vkResetCommandPool(_device, frame.mTempCmdPool, 0);
+			CHECK_VK_RESULT();
+			if (result != VK_SUCCESS)
+				return 0;
+
+			frame.mTempCmdBuffersUsed = 0;
+		}
+		frame.mTempCmdSerial = serial;
+	}
+
+	mTempCmdBufferRequests++;
+
+	if (frame.mTempCmdBuffersUsed < frame.mTempCmdBuffers.size())
+		return frame.mTempCmdBuffers[frame.mTempCmdBuffersUsed++];
+
+	VkCommandBuffer cmd = createCmdBuffer(frame.mTempCmdPool, true);
+	if (!cmd)
+		return 0;
+
+	frame.mTempCmdBuffers.push_back(cmd);
+	frame.mTempCmdBuffersUsed++;
+	mTempCmdBufferCount++;
+
+	return cmd;
+}
+
+void NvVkContext::beginScope(VkCommandBuffer cmd, const char* name) const
+{
+	debugMarkerBegin(cmd, name);
+	if (m_profiler)
+		m_profiler->beginScope(cmd, name);
+}
+
+void NvVkContext::endScope(VkCommandBuffer cmd) const
+{
+	if (m_profiler)
+		m_profiler->endScope(cmd);
+	debugMarkerEnd(cmd);
+}
+
 VkCommandBuffer NvVkContext::createCmdBuffer(VkCommandPool pool, bool primary)
 {
 	VkResult result;
@@ -193,52 +318,302 @@ VkCommandBuffer NvVkContext::createCmdBuffer(VkCommandPool pool, bool primary)
 	return cmd;
 }
 
-size_t NvVkStagingBuffer::append(size_t sz, const void* data)
+void NvVkStagingBuffer::init(NvVkContext* vk, uint32_t frameCount, size_t ringSize)
 {
-	if (mUsed + sz > mAllocated){
-		size_t oldsize = mAllocated;
+	mVk = vk;
+	mFrames.resize(frameCount);
+	mAllocated = ringSize;
+	mHead = 0;
+	mTail = 0;
+	mStats = NvVkStagingStats();
+
+	if (!createRing())
+		mAllocated = 0;
 
-		if (mAllocated){
-			deinit();
-		}
+	mStats.ringSize = mAllocated;
+}
 
-		mAllocated = std::max(sz, std::min(oldsize * 2, size_t(1024 * 1024 * 32)));
+bool NvVkStagingBuffer::createRing()
+{
+	VkResult result;
+	// Create staging buffer
+	VkBufferCreateInfo bufferStageInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+	bufferStageInfo.size = mAllocated;
+	bufferStageInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	bufferStageInfo.flags = 0;
 
-		VkResult result;
-		// Create staging buffer
-		VkBufferCreateInfo bufferStageInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-		bufferStageInfo.size = mAllocated;
-		bufferStageInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-		bufferStageInfo.flags = 0;
+	result = vkCreateBuffer(mVk->device(), &bufferStageInfo, NULL, &mBuffer());
+	if (result != VK_SUCCESS)
+		return false;
 
-		result = vkCreateBuffer(mVk->device(), &bufferStageInfo, NULL, &mBuffer());
-		if (result != VK_SUCCESS)
-			return -1;
+	result = mVk->allocMemAndBindBuffer(mBuffer, (VkFlags)VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+	if (result != VK_SUCCESS) {
+		mVk->destroyBuffer(mBuffer);
+		return false;
+	}
 
-		result = mVk->allocMemAndBindBuffer(mBuffer, (VkFlags)VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-		if (result != VK_SUCCESS)
-			return -1;
+	mMapping = (char*)mBuffer.mapped();
+	return true;
+}
 
-		result = vkMapMemory(mVk->device(), mBuffer.mem, 0, mAllocated, 0, (void**)&mMapping);
-		if (result != VK_SUCCESS)
-			return -1;
+bool NvVkStagingBuffer::allocDedicated(size_t sz, NvVkStagingRegion& region)
+{
+	NvVkBuffer buffer;
+
+	VkBufferCreateInfo bufferStageInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+	bufferStageInfo.size = sz;
+	bufferStageInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	bufferStageInfo.flags = 0;
+
+	VkResult result = vkCreateBuffer(mVk->device(), &bufferStageInfo, NULL, &buffer());
+	if (result != VK_SUCCESS)
+		return false;
+
+	result = mVk->allocMemAndBindBuffer(buffer, (VkFlags)VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+	if (result != VK_SUCCESS) {
+		mVk->destroyBuffer(buffer);
+		return false;
+	}
+
+	// Released along with the ring space of the frame it was staged in
+	mPending.push_back(buffer);
+
+	region.buffer = buffer();
+	region.offset = 0;
+	region.size = sz;
+	region.mapping = buffer.mapped();
+	region.mem = buffer.mem;
+
+	mStats.dedicatedBytes += sz;
+	mStats.dedicatedCount++;
+	return true;
+}
+
+bool NvVkStagingBuffer::alloc(size_t sz, size_t alignment, NvVkStagingRegion& region)
+{
+	if (!alignment)
+		alignment = 1;
+
+	// Oversized uploads would monopolize the ring, so they always get a buffer of their own
+	if (!mAllocated || sz > mAllocated / 2)
+		return allocDedicated(sz, region);
+
+	uint64_t start = mHead;
+	size_t ringOffset = (size_t)(start % mAllocated);
+	size_t alignedOffset = (ringOffset + alignment - 1) / alignment * alignment;
+
+	if (alignedOffset + sz > mAllocated) {
+		// Skip the end of the ring; offset 0 satisfies any alignment
+		start += mAllocated - ringOffset;
+		ringOffset = 0;
+		alignedOffset = 0;
+	}
+
+	uint64_t end = start + (alignedOffset - ringOffset) + sz;
+
+	// Not enough space retired yet: never wait, stage through a dedicated buffer instead
+	if (end - mTail > mAllocated)
+		return allocDedicated(sz, region);
+
+	mHead = end;
+	mStats.totalBytes += sz;
+	mStats.highWaterMark = std::max(mStats.highWaterMark, (VkDeviceSize)(mHead - mTail));
+
+	region.buffer = mBuffer();
+	region.offset = alignedOffset;
+	region.size = sz;
+	region.mapping = mMapping + alignedOffset;
+	region.mem = mBuffer.mem;
+	return true;
+}
+
+bool NvVkStagingBuffer::append(size_t sz, const void* data, NvVkStagingRegion& region)
+{
+	if (!alloc(sz, 4, region))
+		return false;
+
+	memcpy(region.mapping, data, sz);
+	flush(region);
+
+	return true;
+}
 
-		mUsed = 0;
+void NvVkStagingBuffer::flush(const NvVkStagingRegion& region)
+{
+	mVk->memoryAllocator().flush(region.mem, region.offset, region.size);
+}
+
+void NvVkStagingBuffer::endFrame(uint32_t slot)
+{
+	FrameRegion& frame = mFrames[slot];
+	frame.mEnd = mHead;
+	frame.mDedicated.insert(frame.mDedicated.end(), mPending.begin(), mPending.end());
+	mPending.clear();
+}
+
+void NvVkStagingBuffer::retireFrame(uint32_t slot)
+{
+	FrameRegion& frame = mFrames[slot];
+
+	// Fences signal in submission order, so everything before this frame's end is free
+	mTail = std::max(mTail, frame.mEnd);
+
+	for (size_t i = 0; i < frame.mDedicated.size(); i++)
+		mVk->destroyBuffer(frame.mDedicated[i]);
+	frame.mDedicated.clear();
+}
+
+void NvVkStagingBuffer::retireAll()
+{
+	for (uint32_t i = 0; i < mFrames.size(); i++) {
+		retireFrame(i);
 	}
 
-	size_t offset = mUsed;
-	memcpy(&mMapping[offset], data, sz);
-	mUsed += sz;
+	for (size_t i = 0; i < mPending.size(); i++)
+		mVk->destroyBuffer(mPending[i]);
+	mPending.clear();
+
+	mTail = mHead;
+}
 
-	return offset;
+void NvVkStagingBuffer::logStats() const
+{
+	LOGI("Staging ring: %llu KB, high water %llu KB, %llu KB staged; %u dedicated uploads (%llu KB)",
+		(unsigned long long)(mStats.ringSize >> 10), (unsigned long long)(mStats.highWaterMark >> 10),
+		(unsigned long long)(mStats.totalBytes >> 10), mStats.dedicatedCount,
+		(unsigned long long)(mStats.dedicatedBytes >> 10));
 }
 
 void NvVkStagingBuffer::deinit()
 {
+	if (!mVk)
+		return;
+
+	retireAll();
+	mFrames.clear();
+
 	if (mAllocated){
-		vkUnmapMemory(mVk->device(), mBuffer.mem);
-		vkDestroyBuffer(mVk->device(), mBuffer(), NULL);
-		vkFreeMemory(mVk->device(), mBuffer.mem, NULL);
+		mVk->destroyBuffer(mBuffer);
+		mMapping = NULL;
+		mAllocated = 0;
+	}
+}
+
+void NvVkUniformAllocator::init(NvVkContext* vk, uint32_t frameCount, uint32_t ringSize)
+{
+	mVk = vk;
+	mFrameEnds.assign(frameCount, 0);
+	// keep regions at least vec4 aligned on the CPU side too
+	mAlignment = std::max((uint32_t)vk->physicalDeviceLimits().minUniformBufferOffsetAlignment, 16u);
+	mAllocated = ringSize / mAlignment * mAlignment;
+	mHead = 0;
+	mTail = 0;
+	mFlushed = 0;
+	mStats = NvVkUniformStats();
+
+	VkResult result = vk->createAndFillBuffer(mAllocated, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, mBuffer);
+	if (result != VK_SUCCESS) {
+		LOGE("Failed to create the %u byte uniform buffer", mAllocated);
+		mAllocated = 0;
+		return;
+	}
+
+	mMapping = (char*)mBuffer.mapped();
+	mStats.ringSize = mAllocated;
+}
+
+bool NvVkUniformAllocator::alloc(uint32_t sz, NvVkUniformRegion& region)
+{
+	uint32_t size = (sz + mAlignment - 1) / mAlignment * mAlignment;
+
+	// Offsets are always aligned, so the only padding is skipping the end of the buffer
+	uint64_t start = mHead;
+	uint32_t offset = mAllocated ? (uint32_t)(start % mAllocated) : 0;
+	if (offset + size > mAllocated) {
+		start += mAllocated - offset;
+		offset = 0;
+	}
+
+	uint64_t end = start + size;
+
+	// Regions have to stay in the one buffer bound to the descriptors, so there is
+	// nowhere else to go; the buffer must hold all the frames in flight
+	if (!mAllocated || size > mAllocated || end - mTail > mAllocated) {
+		mStats.failedCount++;
+		return false;
+	}
+
+	mHead = end;
+	mStats.totalBytes += sz;
+	mStats.allocCount++;
+	mStats.highWaterMark = std::max(mStats.highWaterMark, (VkDeviceSize)(mHead - mTail));
+
+	region.buffer = mBuffer();
+	region.offset = offset;
+	region.size = size;
+	region.mapping = mMapping + offset;
+	return true;
+}
+
+bool NvVkUniformAllocator::append(uint32_t sz, const void* data, NvVkUniformRegion& region)
+{
+	if (!alloc(sz, region))
+		return false;
+
+	memcpy(region.mapping, data, sz);
+
+	return true;
+}
+
+void NvVkUniformAllocator::flush()
+{
+	if (mFlushed == mHead)
+		return;
+
+	uint64_t start = mFlushed;
+	mFlushed = mHead;
+	mStats.flushCount++;
+
+	// Everything older than the head is at most one buffer behind it
+	uint32_t begin = (uint32_t)(start % mAllocated);
+	uint64_t length = mHead - start;
+	if (begin + length > mAllocated) {
+		mVk->memoryAllocator().flush(mBuffer.mem, begin, mAllocated - begin);
+		mVk->memoryAllocator().flush(mBuffer.mem, 0, begin + length - mAllocated);
+	}
+	else {
+		mVk->memoryAllocator().flush(mBuffer.mem, begin, length);
+	}
+}
+
+void NvVkUniformAllocator::endFrame(uint32_t slot)
+{
+	flush();
+	mFrameEnds[slot] = mHead;
+}
+
+void NvVkUniformAllocator::retireFrame(uint32_t slot)
+{
+	// Fences signal in submission order, so everything before this frame's end is free
+	mTail = std::max(mTail, mFrameEnds[slot]);
+}
+
+void NvVkUniformAllocator::retireAll()
+{
+	flush();
+	mTail = mHead;
+}
+
+void NvVkUniformAllocator::deinit()
+{
+	if (!mVk)
+		return;
+
+	mFrameEnds.clear();
+
+	if (mAllocated) {
+		mVk->destroyBuffer(mBuffer);
 		mMapping = NULL;
 		mAllocated = 0;
 	}
@@ -276,10 +651,9 @@ void checkVkResult(const char* file, int32_t line, VkResult result)
 	}
 }
 
-VkResult NvVkContext::allocMemAndBindImage(NvVkImage& image, VkFlags memProps)
+VkResult NvVkContext::allocMemAndBindImage(NvVkImage& image, VkFlags memProps, bool linear)
 {
 	VkResult result;
-	VkPhysicalDeviceMemoryProperties& memoryProperties = physicalDeviceMemoryProperties();
 
 	VkMemoryRequirements  memReqs;
 	vkGetImageMemoryRequirements(device(), image(), &memReqs);
@@ -288,31 +662,12 @@ VkResult NvVkContext::allocMemAndBindImage(NvVkImage& image, VkFlags memProps)
 		return VK_SUCCESS;
 	}
 
-	// Find an available memory type that satisfies the requested properties.
-	uint32_t memoryTypeIndex;
-	for (memoryTypeIndex = 0; memoryTypeIndex < memoryProperties.memoryTypeCount; ++memoryTypeIndex) {
-		if (((memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & memProps) == memProps) &&
-			((memReqs.memoryTypeBits >> memoryTypeIndex) & 1))  {
-			break;
-		}
-	}
-	if (memoryTypeIndex >= memoryProperties.memoryTypeCount) {
-		return VK_ERROR_FORMAT_NOT_SUPPORTED;
-	}
-
-	VkMemoryAllocateInfo memInfo = {
-		VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,             // sType
-		0,                                               // pNext
-		memReqs.size,                                    // allocationSize
-		memoryTypeIndex,                                 // memoryTypeIndex
-	};
-
-	result = vkAllocateMemory(device(), &memInfo, NULL, &image.mem);
+	result = mAllocator.alloc(memReqs, memProps, linear, image.mem);
 	if (result != VK_SUCCESS) {
 		return result;
 	}
 
-	result = vkBindImageMemory(device(), image(), image.mem, 0);
+	result = vkBindImageMemory(device(), image(), image.mem.mem, image.mem.offset);
 	if (result != VK_SUCCESS) {
 		return result;
 	}
@@ -327,13 +682,27 @@ VkResult NvVkContext::createImage(VkImageCreateInfo& info, NvVkImage& image, VkF
 	if (result != VK_SUCCESS)
 		return result;
 
-	result = allocMemAndBindImage(image, memProps);
+	result = allocMemAndBindImage(image, memProps, info.tiling == VK_IMAGE_TILING_LINEAR);
 	if (result != VK_SUCCESS)
 		return result;
 
 	return result;
 }
 
+void NvVkContext::destroyImage(NvVkImage& image) {
+	std::map<VkImage, VkDeviceSize>::iterator texture = mTextureBytes.find(image());
+	if (texture != mTextureBytes.end()) {
+		mTextureStats.residentBytes -= texture->second;
+		mTextureBytes.erase(texture);
+	}
+
+	if (image() != VK_NULL_HANDLE) {
+		vkDestroyImage(device(), image(), NULL);
+		image() = VK_NULL_HANDLE;
+	}
+	mAllocator.free(image.mem);
+}
+
 void imageBarrierCreate(
 	VkCommandBuffer& inCmd,
 	VkImageLayout inOldLayout,
@@ -435,6 +804,38 @@ VkFormat NvVkContext::pickOptimalFormat(uint32_t count, const VkFormat *formats,
 	return format;
 }
 
+bool NvVkContext::isTextureFormatSupported(VkFormat format)
+{
+	VkFormatProperties formatProps = {};
+	vkGetPhysicalDeviceFormatProperties(physicalDevice(), format, &formatProps);
+	return (formatProps.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+}
+
+bool NvVkContext::configureTextureExpansion()
+{
+	// the block formats NvImage can expand as it loads
+	static const VkFormat expandableFormats[] = {
+		VK_FORMAT_BC1_RGBA_UNORM_BLOCK,
+		VK_FORMAT_BC2_UNORM_BLOCK,
+		VK_FORMAT_BC3_UNORM_BLOCK,
+		VK_FORMAT_BC6H_UFLOAT_BLOCK,
+		VK_FORMAT_BC6H_SFLOAT_BLOCK,
+		VK_FORMAT_BC7_UNORM_BLOCK,
+		VK_FORMAT_BC7_SRGB_BLOCK
+	};
+
+	// BC formats can only be sampled if the feature was enabled at device creation
+	bool native = (_physicalDeviceFeaturesEnabled.textureCompressionBC == VK_TRUE);
+	for (uint32_t i = 0; native && i < sizeof(expandableFormats) / sizeof(expandableFormats[0]); i++)
+		native = isTextureFormatSupported(expandableFormats[i]);
+
+	if (!native)
+		LOGI("Device cannot sample BC textures - enabling DXT/BC6H/BC7 expansion");
+
+	NvImage::setDXTExpansion(!native);
+	return native;
+}
+
 bool NvVkContext::isExtensionSupported(const char * ext)
 {
 	return mCombinedExtensionNames.find(ext) != mCombinedExtensionNames.end();
@@ -448,7 +849,6 @@ bool NvVkContext::isLayerSupported(const char * layer)
 VkResult NvVkContext::allocMemAndBindBuffer(NvVkBuffer& buffer, VkFlags memProps)
 {
 	VkResult result;
-	VkPhysicalDeviceMemoryProperties& memoryProperties = physicalDeviceMemoryProperties();
 
 	VkMemoryRequirements  memReqs;
 	vkGetBufferMemoryRequirements(device(), buffer(), &memReqs);
@@ -457,31 +857,12 @@ VkResult NvVkContext::allocMemAndBindBuffer(NvVkBuffer& buffer, VkFlags memProps
 		return VK_SUCCESS;
 	}
 
-	// Find an available memory type that satisfies the requested properties.
-	uint32_t memoryTypeIndex;
-	for (memoryTypeIndex = 0; memoryTypeIndex < memoryProperties.memoryTypeCount; ++memoryTypeIndex) {
-		if (((memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & memProps) == memProps) &&
-			((memReqs.memoryTypeBits >> memoryTypeIndex) & 1))  {
-			break;
-		}
-	}
-	if (memoryTypeIndex >= memoryProperties.memoryTypeCount) {
-		return VK_ERROR_FORMAT_NOT_SUPPORTED;
-	}
-
-	VkMemoryAllocateInfo memInfo = {
-		VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,             // sType
-		0,                                               // pNext
-		memReqs.size,                                    // allocationSize
-		memoryTypeIndex,                                 // memoryTypeIndex
-	};
-
-	result = vkAllocateMemory(device(), &memInfo, NULL, &buffer.mem);
+	result = mAllocator.alloc(memReqs, memProps, true, buffer.mem);
 	if (result != VK_SUCCESS) {
 		return result;
 	}
 
-	result = vkBindBufferMemory(device(), buffer(), buffer.mem, 0);
+	result = vkBindBufferMemory(device(), buffer(), buffer.mem.mem, buffer.mem.offset);
 	if (result != VK_SUCCESS) {
 		return result;
 	}
@@ -489,25 +870,32 @@ VkResult NvVkContext::allocMemAndBindBuffer(NvVkBuffer& buffer, VkFlags memProps
 	return VK_SUCCESS;
 }
 
+void NvVkContext::destroyBuffer(NvVkBuffer& buffer)
+{
+	if (buffer() != VK_NULL_HANDLE) {
+		vkDestroyBuffer(device(), buffer(), NULL);
+		buffer() = VK_NULL_HANDLE;
+	}
+	mAllocator.free(buffer.mem);
+}
+
 VkResult NvVkContext::fillBuffer(NvVkStagingBuffer* staging, NvVkBuffer& buffer, size_t offset, size_t size, const void* data)
 {
 	if (!staging) {
 		staging = &stagingBuffer();
 	}
 
-	if (staging->needSync(size)){
-		purgeTempCmdBuffers();
-	}
-
-	size_t offsetsrc = staging->append(size, data);
+	NvVkStagingRegion region;
+	if (!staging->append(size, data, region))
+		return VK_ERROR_OUT_OF_DEVICE_MEMORY;
 
 	VkCommandBuffer cmd = beginTempCmdBuffer();
 
 	VkBufferCopy copy;
 	copy.size = size;
 	copy.dstOffset = offset;
-	copy.srcOffset = offsetsrc;
-	vkCmdCopyBuffer(cmd, staging->getBuffer(), buffer(), 1, &copy);
+	copy.srcOffset = region.offset;
+	vkCmdCopyBuffer(cmd, region.buffer, buffer(), 1, &copy);
 
 	return doneWithTempCmdBufferSubmit(cmd);
 }
@@ -531,21 +919,41 @@ VkResult NvVkContext::createAndFillBuffer(size_t size, VkFlags usage, VkFlags me
 		return result;
 
 	if (data){
-		result = fillBuffer(staging, buffer, 0, size, data);
+		if (buffer.mapped()) {
+			// A new host visible buffer is not in use yet, so it can be written directly
+			memcpy(buffer.mapped(), data, size);
+			result = flushBuffer(buffer, 0, size);
+		}
+		else {
+			result = fillBuffer(staging, buffer, 0, size, data);
+		}
 	}
 
-	return VK_SUCCESS;
+	return result;
 }
 
 
 // TODO  cleanup of resources
 
-VkShaderModule NvVkContext::createShader(const char* shaderSource, VkShaderStageFlagBits inStage)
+// 64-bit FNV-1a, seeded with the stage so identical code used by two stages gets two modules
+static uint64_t hashShaderCode(const void* code, size_t size, VkShaderStageFlagBits stage)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	hash = (hash ^ (uint64_t)stage) * 1099511628211ULL;
+	hash = (hash ^ (uint64_t)size) * 1099511628211ULL;
+
+	const uint8_t* bytes = (const uint8_t*)code;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ULL;
+
+	return hash;
+}
+
+VkShaderModule NvVkContext::createShader(const void* code, size_t size, VkShaderStageFlagBits inStage)
 {
-	VkResult result;
 	VkShaderModuleCreateInfo shaderModuleInfo = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
-	shaderModuleInfo.codeSize = strlen(shaderSource);
-	shaderModuleInfo.pCode = (uint32_t*)shaderSource;
+	shaderModuleInfo.codeSize = size;
+	shaderModuleInfo.pCode = (const uint32_t*)code;
 
 #if 1
 	// Workaround for LunarG shader preamble
@@ -557,12 +965,55 @@ VkShaderModule NvVkContext::createShader(const char* shaderSource, VkShaderStage
 	}
 #endif
 
-	VkShaderModule shaderModule;
-	result = vkCreateShaderModule(device(), &shaderModuleInfo, NULL, &shaderModule);
+	uint64_t key = hashShaderCode(shaderModuleInfo.pCode, shaderModuleInfo.codeSize, inStage);
+
+	const uint8_t* codeBytes = (const uint8_t*)shaderModuleInfo.pCode;
+	std::map<uint64_t, ShaderModuleEntry>::iterator iter;
+	while ((iter = mShaderModules.find(key)) != mShaderModules.end()) {
+		ShaderModuleEntry& cached = iter->second;
+		if (cached.stage == inStage && cached.code.size() == shaderModuleInfo.codeSize &&
+			!memcmp(&cached.code[0], codeBytes, shaderModuleInfo.codeSize)) {
+			cached.refCount++;
+			mShaderCacheHits++;
+			return cached.module;
+		}
+		key++;
+	}
+
+	VkShaderModule shaderModule = VK_NULL_HANDLE;
+	VkResult result = vkCreateShaderModule(device(), &shaderModuleInfo, NULL, &shaderModule);
+	CHECK_VK_RESULT();
+	if (result != VK_SUCCESS)
+		return VK_NULL_HANDLE;
+
+	ShaderModuleEntry entry;
+	entry.module = shaderModule;
+	entry.refCount = 1;
+	entry.stage = inStage;
+	entry.code.assign(codeBytes, codeBytes + shaderModuleInfo.codeSize);
+	mShaderModules[key] = entry;
+	mShaderModuleKeys[shaderModule] = key;
+	mShaderCacheMisses++;
 
 	return shaderModule;
 }
 
+void NvVkContext::releaseShaders(const VkPipelineShaderStageCreateInfo* shaders, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++) {
+		std::map<VkShaderModule, uint64_t>::iterator keyIter = mShaderModuleKeys.find(shaders[i].module);
+		if (keyIter == mShaderModuleKeys.end())
+			continue;
+
+		std::map<uint64_t, ShaderModuleEntry>::iterator iter = mShaderModules.find(keyIter->second);
+		if (--iter->second.refCount == 0) {
+			vkDestroyShaderModule(device(), iter->second.module, NULL);
+			mShaderModules.erase(iter);
+			mShaderModuleKeys.erase(keyIter);
+		}
+	}
+}
+
 static const char VS_TAG[] = "GLSL_VS";
 static const uint32_t VS_INDEX = 0;
 static const char FS_TAG[] = "GLSL_FS";
@@ -589,64 +1040,71 @@ uint32_t NvVkContext::createShadersFromSourceString(const std::string& sourceTex
 	const int32_t MAX_STAGES = 6;
 
 	const char* infiles[MAX_STAGES];
-	for (uint32_t i = 0; i < MAX_STAGES; i++)
+	size_t lengths[MAX_STAGES];
+	for (uint32_t i = 0; i < MAX_STAGES; i++) {
 		infiles[i] = NULL;
+		lengths[i] = 0;
+	}
 
-	// walk the file, looking for tags.  when we find a tag, change the hash to a null char
-	// and grab the pointer to the start of the next line for the desired shader
-
-	// we leak this copy for now...
-	uint32_t length = sourceText.length() + 1;
-	char* ptr = new char[length];
-	strncpy(ptr, sourceText.c_str(), length);
+	// walk the file, looking for tags.  when we find a tag, the previous shader ends
+	// at its leading hash and the next one starts at the end of the tag's line.
+	// The source is never modified, so each stage is a range within sourceText
+	const char* ptr = sourceText.c_str();
+	int32_t current = -1;
 	while (ptr[0]) {
 		while (ptr[0] && ptr[0] != '#') {
 			ptr++;
 		}
 
 		if (ptr[0] == '#') {
-			char* hash = ptr;
-			char* tag = ptr + 1;
-			const char** shaderPtrAddr = NULL;
+			const char* hash = ptr;
+			const char* tag = ptr + 1;
+			int32_t index = -1;
 			// found hash.  But is it a shader tag?
 			if (!strncmp(tag, VS_TAG, strlen(VS_TAG))) {
-				shaderPtrAddr = infiles + VS_INDEX;
+				index = VS_INDEX;
 			}
 			else if (!strncmp(tag, FS_TAG, strlen(FS_TAG))) {
-				shaderPtrAddr = infiles + FS_INDEX;
+				index = FS_INDEX;
 			}
 			else if (!strncmp(tag, GS_TAG, strlen(GS_TAG))) {
-				shaderPtrAddr = infiles + GS_INDEX;
+				index = GS_INDEX;
 			}
 			else if (!strncmp(tag, TCS_TAG, strlen(TCS_TAG))) {
-				shaderPtrAddr = infiles + TCS_INDEX;
+				index = TCS_INDEX;
 			}
 			else if (!strncmp(tag, TES_TAG, strlen(TES_TAG))) {
-				shaderPtrAddr = infiles + TES_INDEX;
+				index = TES_INDEX;
 			}
 			else if (!strncmp(tag, CS_TAG, strlen(CS_TAG))) {
-				shaderPtrAddr = infiles + CS_INDEX;
+				index = CS_INDEX;
 			}
 
 			// advance the ptr to the end of the line or the end of the string, whichever is first
 			while (ptr[0] && ptr[0] != '\n' && ptr[0] != '\r')
 				ptr++;
 
-			if (shaderPtrAddr)
-				*shaderPtrAddr = ptr;
-
-			// if it is a valid tag, then null out the leading # to close the previous shader
-			if (shaderPtrAddr)
-				hash[0] = '\0';
+			// if it is a valid tag, then the leading # closes the previous shader
+			if (index >= 0) {
+				if (current >= 0)
+					lengths[current] = hash - infiles[current];
+				infiles[index] = ptr;
+				current = index;
+			}
 		}
 	}
 
+	if (current >= 0)
+		lengths[current] = ptr - infiles[current];
+
 	uint32_t numStages = 0;
 
 	for (uint32_t i = 0; i < MAX_STAGES; i++) {
 		if (infiles[i]) {
-			if (numStages >= maxShaders)
+			if (numStages >= maxShaders) {
+				releaseShaders(shaders, numStages);
 				return 0;
+			}
 
 			VkPipelineShaderStageCreateInfo& stage = shaders[numStages];
 
@@ -654,7 +1112,7 @@ uint32_t NvVkContext::createShadersFromSourceString(const std::string& sourceTex
 			stage.pNext = NULL;
 			stage.stage = stageFlags[i];
 			stage.pName = "main";
-			stage.module = createShader(infiles[i], stageFlags[i]);
+			stage.module = createShader(infiles[i], lengths[i], stageFlags[i]);
 			stage.pSpecializationInfo = NULL;
 			stage.flags = 0;
 
@@ -698,23 +1156,7 @@ uint32_t NvVkContext::createShadersFromBinaryBlob(uint32_t* data, uint32_t leng,
 		stage.pSpecializationInfo = NULL;
 		stage.flags = 0;
 
-		{
-			VkResult result;
-			VkShaderModuleCreateInfo shaderModuleInfo = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
-			shaderModuleInfo.codeSize = entry.size;
-			shaderModuleInfo.pCode = (uint32_t*)(((uint8_t*)data) + entry.offset);
-
-#if 1
-			// Workaround for LunarG shader preamble
-			const unsigned int* pCode = (const unsigned int*)shaderModuleInfo.pCode;
-			if (pCode[0] == 0x07230203 && pCode[0] == 0)
-			{
-				shaderModuleInfo.codeSize -= sizeof(unsigned int) * 3;
-				shaderModuleInfo.pCode = &pCode[3];
-			}
-#endif
-			result = vkCreateShaderModule(device(), &shaderModuleInfo, NULL, &stage.module);
-		}
+		stage.module = createShader(((uint8_t*)data) + entry.offset, entry.size, entry.kind);
 	}
 
 
@@ -723,26 +1165,37 @@ uint32_t NvVkContext::createShadersFromBinaryBlob(uint32_t* data, uint32_t leng,
 
 static VkFormat TranslateNvFormat(const NvImage &i);
 
-bool NvVkContext::uploadTextureFromDDSFile(const char* filename, NvVkTexture& tex) {
+bool NvVkContext::uploadTextureFromDDSFile(const char* filename, NvVkTexture& tex, NvVkUploadTicket* ticket,
+	const NvVkTextureLimits* limits) {
 	int32_t len;
 	char* ddsData = NvAssetLoaderRead(filename, len);
 
 	if (!ddsData)
 		return 0;
 
-	bool success = uploadTextureFromDDSData(ddsData, len, tex);
+	// the file buffer is ours until freed, so the image can be a view into it
+	// and the texels are copied only once, into the staging buffer
+	NvImage* image = new NvImage;
+
+	bool success = false;
+	if (image->loadImageFromFileDataInPlace((uint8_t*)ddsData, len, "dds")) {
+		success = uploadTexture(image, tex, ticket, limits);
+	}
+
+	delete image;
 
 	NvAssetLoaderFree(ddsData);
 
 	return success;
 }
 
-bool NvVkContext::uploadTextureFromDDSData(const char* ddsData, int32_t length, NvVkTexture& tex) {
+bool NvVkContext::uploadTextureFromDDSData(const char* ddsData, int32_t length, NvVkTexture& tex, NvVkUploadTicket* ticket,
+	const NvVkTextureLimits* limits) {
 	NvImage* image = new NvImage;
 
 	bool success = false;
 	if (image->loadImageFromFileData((const uint8_t*)ddsData, length, "dds")) {
-		success = uploadTexture(image, tex);
+		success = uploadTexture(image, tex, ticket, limits);
 	}
 
 	delete image;
@@ -750,19 +1203,112 @@ bool NvVkContext::uploadTextureFromDDSData(const char* ddsData, int32_t length,
 	return success;
 }
 
-bool NvVkContext::uploadTexture(const NvImage* image, NvVkTexture& tex) {
-	VkResult result;
+// Texel bytes of an image once its largest levels are dropped, with the
+// number of levels NvImage::downscale leaves
+static VkDeviceSize downscaledBytes(const NvImage& image, int32_t drop)
+{
+	int32_t levels = image.getMipLevels();
+	int32_t kept = levels - drop;
+	if (kept <= 0) {
+		int32_t chain = 1;
+		while ((image.getWidth() >> chain) || (image.getHeight() >> chain))
+			chain++;
+		drop = std::min(drop, chain - 1);
+		kept = std::min(levels, chain - drop);
+	}
+
+	VkDeviceSize bytes = 0;
+	for (int32_t level = drop; level < drop + kept; level++)
+		bytes += image.getImageSize(level);
+	return bytes * image.getLayers();
+}
+
+// Number of largest levels to drop for an image to fit the limits.  Compressed
+// images stop at their smallest level and uncompressed ones at 1x1
+static int32_t levelsToDrop(const NvImage& image, uint32_t maxDimension, VkDeviceSize maxBytes)
+{
+	int32_t lastLevel = image.getMipLevels() - 1;
+	if (!image.isCompressed()) {
+		while ((image.getWidth() >> (lastLevel + 1)) || (image.getHeight() >> (lastLevel + 1)))
+			lastLevel++;
+	}
+
+	int32_t drop = 0;
+	for (; drop < lastLevel; drop++) {
+		uint32_t w = std::max(image.getWidth() >> drop, 1);
+		uint32_t h = std::max(image.getHeight() >> drop, 1);
+		if ((!maxDimension || (w <= maxDimension && h <= maxDimension)) &&
+			downscaledBytes(image, drop) <= maxBytes)
+			break;
+	}
 
+	return drop;
+}
+
+bool NvVkContext::uploadTexture(const NvImage* image, NvVkTexture& tex, NvVkUploadTicket* ticket,
+	const NvVkTextureLimits* limits) {
 	if (!image)
 		return false;
 
+	// the tighter of this texture's limits and the global ones; the budget
+	// only has room for what the live textures leave
+	uint32_t maxDimension = mTextureMaxDimension;
+	VkDeviceSize maxBytes = ~(VkDeviceSize)0;
+	if (mTextureBudgetBytes) {
+		maxBytes = (mTextureStats.residentBytes < mTextureBudgetBytes) ?
+			(mTextureBudgetBytes - mTextureStats.residentBytes) : 0;
+	}
+	if (limits) {
+		if (limits->maxDimension && (!maxDimension || limits->maxDimension < maxDimension))
+			maxDimension = limits->maxDimension;
+		if (limits->maxBytes && limits->maxBytes < maxBytes)
+			maxBytes = limits->maxBytes;
+	}
+
+	int32_t drop = levelsToDrop(*image, maxDimension, maxBytes);
+	if (!drop)
+		return createTexture(image, 0, tex, ticket);
+
+	bool success;
+	if (drop < image->getMipLevels()) {
+		// the dropped levels are never staged
+		success = createTexture(image, drop, tex, ticket);
+	} else {
+		NvImage downscaled;
+		if (image->downscale(downscaled, drop)) {
+			success = createTexture(&downscaled, 0, tex, ticket);
+		} else {
+			// formats the filter does not take keep their smallest level
+			drop = image->getMipLevels() - 1;
+			success = createTexture(image, drop, tex, ticket);
+		}
+	}
+
+	if (success && drop) {
+		mTextureStats.savedBytes += downscaledBytes(*image, 0) - downscaledBytes(*image, drop);
+		mTextureStats.reducedCount++;
+	}
+
+	return success;
+}
+
+void NvVkContext::logTextureStats() const
+{
+	LOGI("Textures: %llu KB resident, high water %llu KB; %u reduced to fit the limits, saving %llu KB",
+		(unsigned long long)(mTextureStats.residentBytes >> 10), (unsigned long long)(mTextureStats.highWaterMark >> 10),
+		mTextureStats.reducedCount, (unsigned long long)(mTextureStats.savedBytes >> 10));
+}
+
+bool NvVkContext::createTexture(const NvImage* image, int32_t firstLevel, NvVkTexture& tex, NvVkUploadTicket* ticket) {
+	VkResult result;
+
 	VkFormat fmt = TranslateNvFormat(*image);
 
 	if (fmt == VK_FORMAT_UNDEFINED)
 		return false;
 
-	int32_t w = image->getWidth();
-	int32_t h = image->getHeight();
+	int32_t w = std::max(image->getWidth() >> firstLevel, 1);
+	int32_t h = std::max(image->getHeight() >> firstLevel, 1);
 
 	VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
 	info.imageType = VK_IMAGE_TYPE_2D;
@@ -770,7 +1316,7 @@ bool NvVkContext::uploadTexture(const NvImage* image, NvVkTexture& tex) {
 	info.extent.width = w;
 	info.extent.height = h;
 	info.extent.depth = 1;
-	info.mipLevels = image->getMipLevels();
+	info.mipLevels = image->getMipLevels() - firstLevel;
 	info.flags = 0;
 	info.samples = VK_SAMPLE_COUNT_1_BIT;
 	info.tiling = VK_IMAGE_TILING_OPTIMAL;
@@ -778,6 +1324,7 @@ bool NvVkContext::uploadTexture(const NvImage* image, NvVkTexture& tex) {
 	info.pQueueFamilyIndices = NULL;
 
 	if (image->isCubeMap()) {
+		info.flags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
 		info.arrayLayers = 6;
 	}
 	else {
@@ -788,136 +1335,376 @@ bool NvVkContext::uploadTexture(const NvImage* image, NvVkTexture& tex) {
 	if (result != VK_SUCCESS)
 		return false;
 
-	// Create a buffer to hold the texture data before we copy it to the image.
-	VkBufferCreateInfo texBufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-	texBufferInfo.size = image->getDataBlockSize();
-	texBufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-	texBufferInfo.flags = 0;
-	NvVkBuffer texBuffer;
-	result = vkCreateBuffer(device(), &texBufferInfo, 0, &texBuffer());
-	if (result != VK_SUCCESS)
+	mTextureBytes[tex.image()] = tex.image.mem.size;
+	mTextureStats.residentBytes += tex.image.mem.size;
+	mTextureStats.highWaterMark = std::max(mTextureStats.highWaterMark, mTextureStats.residentBytes);
+
+	VkImageSubresourceRange range;
+	range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	range.baseMipLevel = 0;
+	range.levelCount = info.mipLevels;
+	range.baseArrayLayer = 0;
+	range.layerCount = info.arrayLayers;
+
+	if (firstLevel) {
+		// the dropped levels are skipped by staging the rest level by level
+		if (!uploadTextureLevels(image, tex(), firstLevel, 0, info.mipLevels, ticket)) {
+			destroyImage(tex());
+			return false;
+		}
+	} else {
+		// Stage the texture data; bufferImageCopy offsets must be a multiple of 4 and of the
+		// texel or block size, and 48 is a multiple of every size up to 16 bytes including 3 and 12
+		NvVkStagingRegion staging;
+		if (!mStaging.alloc(image->getDataBlockSize(), 48, staging)) {
+			destroyImage(tex());
+			return false;
+		}
+
+		memcpy(staging.mapping, image->getDataBlock(), image->getDataBlockSize());
+		mStaging.flush(staging);
+
+		TextureUpload upload;
+		upload.image = tex.image();
+		upload.buffer = staging.buffer;
+		upload.range = range;
+		upload.firstRegion = (uint32_t)mPendingUploadRegions.size();
+		upload.regionCount = info.arrayLayers * info.mipLevels;
+
+		for (uint32_t layer = 0; layer < info.arrayLayers; layer++) {
+			uint32_t width = image->getWidth();
+			uint32_t height = image->getHeight();
+			for (uint32_t mip = 0; mip < info.mipLevels; mip++) {
+				VkBufferImageCopy rgn;
+				memset(&rgn, 0, sizeof(rgn));
+				rgn.bufferOffset = staging.offset + image->getLayerLevelOffset(mip, layer);
+				rgn.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				rgn.imageSubresource.baseArrayLayer = layer;
+				rgn.imageSubresource.mipLevel = mip;
+				rgn.imageSubresource.layerCount = 1;
+				rgn.imageExtent.width = width;
+				rgn.imageExtent.height = height;
+				rgn.imageExtent.depth = 1;
+				mPendingUploadRegions.push_back(rgn);
+				height >>= 1;
+				width >>= 1;
+				height = height ? height : 1;
+				width = width ? width : 1;
+			}
+		}
+
+		mPendingUploads.push_back(upload);
+
+		if (ticket)
+			*ticket = mNextUploadTicket;
+	}
+
+	VkImageViewCreateInfo texViewCreateInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+	texViewCreateInfo.image = tex.image();
+	texViewCreateInfo.viewType = image->isCubeMap() ? VK_IMAGE_VIEW_TYPE_CUBE : VK_IMAGE_VIEW_TYPE_2D;
+	texViewCreateInfo.format = fmt;
+	texViewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_R;
+	texViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_G;
+	texViewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_B;
+	texViewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_A;
+	texViewCreateInfo.subresourceRange = range;
+
+	result = vkCreateImageView(device(), &texViewCreateInfo, 0, &tex.view);
+	if (result != VK_SUCCESS) {
 		return false;
+	}
 
-	result = allocMemAndBindBuffer(texBuffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-	if (result != VK_SUCCESS)
+	return true;
+}
+
+bool NvVkContext::uploadTextureLevels(const NvImage* image, NvVkImage& dst, uint32_t srcLevel, uint32_t dstLevel,
+	uint32_t levelCount, NvVkUploadTicket* ticket) {
+	if (!image || !levelCount || srcLevel + levelCount > (uint32_t)image->getMipLevels())
 		return false;
 
-	void* destPtr = NULL;
-	result = vkMapMemory(device(), texBuffer.mem, 0, texBufferInfo.size, 0, &destPtr);
-	if (result != VK_SUCCESS)
+	uint32_t layers = image->isCubeMap() ? 6 : 1;
+
+	// Every level starts on a 48 byte boundary; see uploadTexture
+	VkDeviceSize size = 0;
+	for (uint32_t mip = srcLevel; mip < srcLevel + levelCount; mip++)
+		size += layers * ((image->getImageSize(mip) + 47) / 48 * 48);
+
+	NvVkStagingRegion staging;
+	if (!mStaging.alloc(size, 48, staging))
 		return false;
 
-	memcpy(destPtr, image->getDataBlock(), texBufferInfo.size);
+	TextureUpload upload;
+	upload.image = dst.image;
+	upload.buffer = staging.buffer;
+	upload.range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	upload.range.baseMipLevel = dstLevel;
+	upload.range.levelCount = levelCount;
+	upload.range.baseArrayLayer = 0;
+	upload.range.layerCount = layers;
+	upload.firstRegion = (uint32_t)mPendingUploadRegions.size();
+	upload.regionCount = layers * levelCount;
+
+	VkDeviceSize offset = 0;
+	for (uint32_t layer = 0; layer < layers; layer++) {
+		for (uint32_t mip = 0; mip < levelCount; mip++) {
+			uint32_t level = srcLevel + mip;
+			uint32_t bytes = image->getImageSize(level);
+			memcpy((uint8_t*)staging.mapping + offset, image->getLayerLevel(level, layer), bytes);
+
+			uint32_t width = image->getWidth() >> level;
+			uint32_t height = image->getHeight() >> level;
+
+			VkBufferImageCopy rgn;
+			memset(&rgn, 0, sizeof(rgn));
+			rgn.bufferOffset = staging.offset + offset;
+			rgn.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			rgn.imageSubresource.baseArrayLayer = layer;
+			rgn.imageSubresource.mipLevel = dstLevel + mip;
+			rgn.imageSubresource.layerCount = 1;
+			rgn.imageExtent.width = width ? width : 1;
+			rgn.imageExtent.height = height ? height : 1;
+			rgn.imageExtent.depth = 1;
+			mPendingUploadRegions.push_back(rgn);
+
+			offset += (bytes + 47) / 48 * 48;
+		}
+	}
 
-	vkUnmapMemory(device(), texBuffer.mem);
-	
-	uint32_t regionCount = info.arrayLayers * info.mipLevels;
-	VkBufferImageCopy* texCopyRegions 
-		= new VkBufferImageCopy[regionCount];
-	VkBufferImageCopy* rgn = texCopyRegions;
-
-	memset(texCopyRegions, 0, sizeof(VkBufferImageCopy) * regionCount);
-
-	for (uint32_t layer = 0; layer < info.arrayLayers; layer++) {
-		uint32_t width = image->getWidth();
-		uint32_t height = image->getHeight();
-		for (uint32_t mip = 0; mip < info.mipLevels; mip++) {
-			rgn->bufferOffset = image->getLayerLevelOffset(mip, layer);
-			rgn->imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			rgn->imageSubresource.baseArrayLayer = layer;
-			rgn->imageSubresource.mipLevel = mip;
-			rgn->imageSubresource.layerCount = 1;
-			rgn->imageOffset.x = 0;
-			rgn->imageOffset.y = 0;
-			rgn->imageOffset.z = 0;
-			rgn->imageExtent.width = width;
-			rgn->imageExtent.height = height;
-			rgn->imageExtent.depth = 1;
-			rgn++;
-			height >>= 1;
-			width >>= 1;
-			height = height ? height : 1;
-			width = width ? width : 1;
+	mStaging.flush(staging);
+
+	mPendingUploads.push_back(upload);
+
+	if (ticket)
+		*ticket = mNextUploadTicket;
+
+	return true;
+}
+
+VkFormat NvVkContext::getTextureFormat(const NvImage& image) {
+	return TranslateNvFormat(image);
+}
+
+// Header written by the driver at the start of vkGetPipelineCacheData
+struct PipelineCacheHeader {
+	uint32_t length;
+	uint32_t version;
+	uint32_t vendorID;
+	uint32_t deviceID;
+	uint8_t uuid[VK_UUID_SIZE];
+};
+
+bool NvVkContext::initPipelineCache() {
+	std::vector<uint8_t> data;
+
+	if (!mConfiguration.pipelineCacheFile.empty()) {
+		FILE* fp = fopen(mConfiguration.pipelineCacheFile.c_str(), "rb");
+		if (fp) {
+			fseek(fp, 0, SEEK_END);
+			long len = ftell(fp);
+			fseek(fp, 0, SEEK_SET);
+			if (len > 0) {
+				data.resize(len);
+				if (fread(&data[0], 1, len, fp) != (size_t)len)
+					data.clear();
+			}
+			fclose(fp);
 		}
 	}
 
-	VkCommandBuffer cmd = beginTempCmdBuffer();
-	{
-		// Transition the texture from undefined to transfer destination
-		VkImageSubresourceRange subresourceRange = {};
-		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		subresourceRange.baseMipLevel = 0;
-		subresourceRange.levelCount = info.mipLevels; // TODO fetch from actual image
-		subresourceRange.baseArrayLayer = 0;
-		subresourceRange.layerCount = info.arrayLayers; // TODO fetch from actual image
-
-		VkImageMemoryBarrier memBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+	// Drivers are required to reject foreign data, but not all of them do, so check the
+	// header ourselves and start from scratch if the GPU or driver has changed
+	if (!data.empty()) {
+		PipelineCacheHeader header;
+		bool valid = data.size() >= sizeof(header);
+		if (valid) {
+			memcpy(&header, &data[0], sizeof(header));
+			valid = header.length >= sizeof(header) &&
+				header.version == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+				header.vendorID == _physicalDeviceProperties.vendorID &&
+				header.deviceID == _physicalDeviceProperties.deviceID &&
+				!memcmp(header.uuid, _physicalDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+		}
+
+		if (!valid) {
+			LOGI("Ignoring stale pipeline cache %s", mConfiguration.pipelineCacheFile.c_str());
+			data.clear();
+		}
+	}
+
+	VkPipelineCacheCreateInfo info = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+	info.initialDataSize = data.size();
+	info.pInitialData = data.empty() ? NULL : &data[0];
+
+	VkResult result = vkCreatePipelineCache(device(), &info, NULL, &mPipelineCache);
+	if (result != VK_SUCCESS && !data.empty()) {
+		info.initialDataSize = 0;
+		info.pInitialData = NULL;
+		data.clear();
+		result = vkCreatePipelineCache(device(), &info, NULL, &mPipelineCache);
+	}
+	CHECK_VK_RESULT();
+
+	mPipelineCacheLoadedBytes = data.size();
+
+	return result == VK_SUCCESS;
+}
+
+bool NvVkContext::savePipelineCache() {
+	if (mPipelineCache == VK_NULL_HANDLE || mConfiguration.pipelineCacheFile.empty())
+		return false;
+
+	size_t size = 0;
+	VkResult result = vkGetPipelineCacheData(device(), mPipelineCache, &size, NULL);
+	if (result != VK_SUCCESS || !size)
+		return false;
+
+	std::vector<uint8_t> data(size);
+	result = vkGetPipelineCacheData(device(), mPipelineCache, &size, &data[0]);
+	if (result != VK_SUCCESS)
+		return false;
+
+	const std::string& path = mConfiguration.pipelineCacheFile;
+	std::string tmpPath = path + ".tmp";
+
+	FILE* fp = fopen(tmpPath.c_str(), "wb");
+	if (!fp)
+		return false;
+
+	bool written = fwrite(&data[0], 1, size, fp) == size;
+	written = (fclose(fp) == 0) && written;
+	if (!written) {
+		remove(tmpPath.c_str());
+		return false;
+	}
+
+#ifdef _WIN32
+	// rename does not replace existing files on Windows
+	remove(path.c_str());
+#endif
+	if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+		remove(tmpPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+NvVkUploadTicket NvVkContext::submitUploads() {
+	if (mPendingUploads.empty())
+		return mNextUploadTicket - 1;
+
+	VkResult result;
+	uint32_t count = (uint32_t)mPendingUploads.size();
+	std::vector<VkImageMemoryBarrier> barriers(count);
+
+	VkCommandBuffer cmd = acquireTempCmdBuffer();
+	if (!cmd)
+		return mNextUploadTicket - 1;
+
+	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(cmd, &beginInfo);
+
+	// Transition every texture from undefined to transfer destination
+	for (uint32_t i = 0; i < count; i++) {
+		VkImageMemoryBarrier& memBarrier = barriers[i];
+		memBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		memBarrier.pNext = NULL;
 		memBarrier.srcAccessMask = 0;
 		memBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 		memBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		memBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-		memBarrier.image = tex.image();
-		memBarrier.subresourceRange = subresourceRange;
-		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, 0, 0, 0, 1, &memBarrier);
+		memBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		memBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		memBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		memBarrier.image = mPendingUploads[i].image;
+		memBarrier.subresourceRange = mPendingUploads[i].range;
 	}
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, 0, 0, 0, count, &barriers[0]);
 
-	vkCmdCopyBufferToImage(cmd, texBuffer(), tex.image(), VK_IMAGE_LAYOUT_GENERAL, regionCount, texCopyRegions);
-
-	delete[] texCopyRegions;
+	for (uint32_t i = 0; i < count; i++) {
+		const TextureUpload& upload = mPendingUploads[i];
+		vkCmdCopyBufferToImage(cmd, upload.buffer, upload.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			upload.regionCount, &mPendingUploadRegions[upload.firstRegion]);
+	}
 
-	// Transition the texture to the shader read state
-	{
-		VkImageSubresourceRange subresourceRange = {};
-		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		subresourceRange.baseMipLevel = 0;
-		subresourceRange.levelCount = 1; // TODO fetch from actual image
-		subresourceRange.baseArrayLayer = 0;
-		subresourceRange.layerCount = 1; // TODO fetch from actual image
-
-		VkImageMemoryBarrier memBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+	// Transition every texture to the shader read state
+	for (uint32_t i = 0; i < count; i++) {
+		VkImageMemoryBarrier& memBarrier = barriers[i];
 		memBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 		memBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-		memBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+		memBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 		memBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		memBarrier.image = tex.image();
-		memBarrier.subresourceRange = subresourceRange;
-		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, 0, 0, 0, 1, &memBarrier);
 	}
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, 0, 0, 0, 0, 0, count, &barriers[0]);
 
-	VkFence copyFence;
-	VkFenceCreateInfo fenceInfo;
-	memset(&fenceInfo, 0, sizeof(fenceInfo));
-	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	result = vkCreateFence(device(), &fenceInfo, NULL, &copyFence);
+	mPendingUploads.clear();
+	mPendingUploadRegions.clear();
 
-	doneWithTempCmdBufferSubmit(cmd, &copyFence);
+	result = vkEndCommandBuffer(cmd);
+	CHECK_VK_RESULT();
 
-	vkQueueWaitIdle(queue());
-	vkWaitForFences(device(), 1, &copyFence, VK_TRUE, 100000000000);
+	UploadBatch batch;
+	batch.ticket = mNextUploadTicket++;
+	batch.fence = VK_NULL_HANDLE;
 
-	vkDestroyBuffer(device(), texBuffer(), NULL);
-	vkFreeMemory(device(), texBuffer.mem, NULL);
+	VkFenceCreateInfo fenceInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+	result = vkCreateFence(device(), &fenceInfo, NULL, &batch.fence);
+	CHECK_VK_RESULT();
 
-	VkImageViewCreateInfo texViewCreateInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
-	texViewCreateInfo.image = tex.image();
-	texViewCreateInfo.viewType = image->isCubeMap() ? VK_IMAGE_VIEW_TYPE_CUBE : VK_IMAGE_VIEW_TYPE_2D;
-	texViewCreateInfo.format = fmt;
-	texViewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_R;
-	texViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_G;
-	texViewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_B;
-	texViewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_A;
-	texViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	texViewCreateInfo.subresourceRange.baseMipLevel = 0;
-	texViewCreateInfo.subresourceRange.levelCount = info.mipLevels;
-	texViewCreateInfo.subresourceRange.baseArrayLayer = 0;
-	texViewCreateInfo.subresourceRange.layerCount = info.arrayLayers;
+	VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &cmd;
 
-	result = vkCreateImageView(device(), &texViewCreateInfo, 0, &tex.view);
-	if (result != VK_SUCCESS) {
+	result = vkQueueSubmit(queue(), 1, &submitInfo, batch.fence);
+	CHECK_VK_RESULT();
+
+	mSubmittedUploads.push_back(batch);
+
+	return batch.ticket;
+}
+
+void NvVkContext::retireUploads() {
+	// Batches complete in submission order, so retire from the front
+	while (!mSubmittedUploads.empty()) {
+		UploadBatch& batch = mSubmittedUploads.front();
+		if (vkGetFenceStatus(device(), batch.fence) != VK_SUCCESS)
+			break;
+
+		vkDestroyFence(device(), batch.fence, NULL);
+		mCompletedUploadTicket = batch.ticket;
+		mSubmittedUploads.erase(mSubmittedUploads.begin());
+	}
+}
+
+bool NvVkContext::isUploadComplete(NvVkUploadTicket ticket) {
+	retireUploads();
+	return ticket <= mCompletedUploadTicket;
+}
+
+bool NvVkContext::waitForUpload(NvVkUploadTicket ticket) {
+	// Queued uploads are handed the ticket of the batch still being gathered
+	if (ticket > mNextUploadTicket)
 		return false;
+
+	if (isUploadComplete(ticket))
+		return true;
+
+	if (ticket == mNextUploadTicket) {
+		if (mPendingUploads.empty() || submitUploads() != ticket)
+			return false;
 	}
 
-	return true;
+	for (size_t i = 0; i < mSubmittedUploads.size(); i++) {
+		if (mSubmittedUploads[i].ticket == ticket) {
+			VkResult result = vkWaitForFences(device(), 1, &mSubmittedUploads[i].fence, VK_TRUE, UINT64_MAX);
+			CHECK_VK_RESULT();
+			if (result != VK_SUCCESS)
+				return false;
+			break;
+		}
+	}
+
+	return isUploadComplete(ticket);
 }
 
 //
@@ -1381,16 +2168,38 @@ static VkFormat TranslateNvFormat(const NvImage &i) {
 	case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1:
 		return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
 
+	case NVIMAGE_COMPRESSED_RGB_S3TC_DXT1:
+		return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+
 	case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT3:
-		return VK_FORMAT_BC3_UNORM_BLOCK;
+		return VK_FORMAT_BC2_UNORM_BLOCK;
 
 	case NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5:
-		return VK_FORMAT_BC5_UNORM_BLOCK;
+		return VK_FORMAT_BC3_UNORM_BLOCK;
 
 	case NVIMAGE_COMPRESSED_RED_RGTC1:
+		return VK_FORMAT_BC4_UNORM_BLOCK;
+
 	case NVIMAGE_COMPRESSED_SIGNED_RED_RGTC1:
+		return VK_FORMAT_BC4_SNORM_BLOCK;
+
 	case NVIMAGE_COMPRESSED_RG_RGTC2:
+		return VK_FORMAT_BC5_UNORM_BLOCK;
+
 	case NVIMAGE_COMPRESSED_SIGNED_RG_RGTC2:
+		return VK_FORMAT_BC5_SNORM_BLOCK;
+
+	case NVIMAGE_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+		return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+
+	case NVIMAGE_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+		return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+
+	case NVIMAGE_COMPRESSED_RGBA_BPTC_UNORM:
+		return VK_FORMAT_BC7_UNORM_BLOCK;
+
+	case NVIMAGE_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+		return VK_FORMAT_BC7_SRGB_BLOCK;
 
 	case NVIMAGE_COMPRESSED_RGBA_ASTC_4x4:
 	case NVIMAGE_COMPRESSED_RGBA_ASTC_5x4:
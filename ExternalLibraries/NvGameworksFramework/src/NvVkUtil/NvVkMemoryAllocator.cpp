@@ -0,0 +1,368 @@
+//----------------------------------------------------------------------------------
+// File:        NvVkUtil/NvVkMemoryAllocator.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvVkUtil/NvVkMemoryAllocator.h"
+#include "NV/NvLogs.h"
+#include <NvAssert.h>
+
+#include <map>
+#include <algorithm>
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+/// One VkDeviceMemory object and the list of its free ranges
+class NvVkMemoryBlock {
+public:
+	VkDeviceMemory mem;
+	VkDeviceSize size;
+	VkDeviceSize used;
+	uint8_t* mapped;
+	uint32_t memoryTypeIndex;
+	uint32_t pool;
+	uint32_t allocationCount;
+	bool dedicated;
+
+	// free ranges, keyed by offset and holding the size, so that neighbours can be found on release
+	std::map<VkDeviceSize, VkDeviceSize> freeRanges;
+
+	bool suballoc(VkDeviceSize allocSize, VkDeviceSize alignment, VkDeviceSize& offset) {
+		std::map<VkDeviceSize, VkDeviceSize>::iterator it = freeRanges.begin();
+		for (; it != freeRanges.end(); ++it) {
+			VkDeviceSize rangeStart = it->first;
+			VkDeviceSize rangeEnd = it->first + it->second;
+			VkDeviceSize aligned = alignUp(rangeStart, alignment);
+
+			if (aligned + allocSize > rangeEnd)
+				continue;
+
+			freeRanges.erase(it);
+
+			// the alignment padding and the tail stay free
+			if (aligned > rangeStart)
+				freeRanges[rangeStart] = aligned - rangeStart;
+			if (aligned + allocSize < rangeEnd)
+				freeRanges[aligned + allocSize] = rangeEnd - (aligned + allocSize);
+
+			offset = aligned;
+			used += allocSize;
+			allocationCount++;
+			return true;
+		}
+		return false;
+	}
+
+	void release(VkDeviceSize offset, VkDeviceSize allocSize) {
+		VkDeviceSize start = offset;
+		VkDeviceSize end = offset + allocSize;
+
+		// merge with the following range
+		std::map<VkDeviceSize, VkDeviceSize>::iterator next = freeRanges.lower_bound(start);
+		if (next != freeRanges.end() && next->first == end) {
+			end += next->second;
+			freeRanges.erase(next++);
+		}
+
+		// merge with the preceding range
+		if (next != freeRanges.begin()) {
+			std::map<VkDeviceSize, VkDeviceSize>::iterator prev = next;
+			--prev;
+			if (prev->first + prev->second == start) {
+				start = prev->first;
+				freeRanges.erase(prev);
+			}
+		}
+
+		freeRanges[start] = end - start;
+		used -= allocSize;
+		allocationCount--;
+	}
+};
+
+NvVkMemoryAllocator::NvVkMemoryAllocator() :
+	mDevice(VK_NULL_HANDLE),
+	mBufferImageGranularity(1),
+	mNonCoherentAtomSize(1),
+	mMaxAllocationCount(0),
+	mDeviceAllocationCount(0)
+{
+	memset(&mMemProps, 0, sizeof(mMemProps));
+}
+
+NvVkMemoryAllocator::~NvVkMemoryAllocator()
+{
+	// blocks are released by deinit, which ~NvVkContext calls while the device is still alive
+}
+
+void NvVkMemoryAllocator::init(VkDevice device, const VkPhysicalDeviceMemoryProperties& memProps, const VkPhysicalDeviceLimits& limits)
+{
+	mDevice = device;
+	mMemProps = memProps;
+	mBufferImageGranularity = std::max(limits.bufferImageGranularity, VkDeviceSize(1));
+	mNonCoherentAtomSize = std::max(limits.nonCoherentAtomSize, VkDeviceSize(1));
+	mMaxAllocationCount = limits.maxMemoryAllocationCount;
+	mDeviceAllocationCount = 0;
+}
+
+void NvVkMemoryAllocator::deinit()
+{
+	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES * 2; i++) {
+		std::vector<NvVkMemoryBlock*>& pool = mPools[i];
+		while (!pool.empty()) {
+			if (pool.back()->allocationCount)
+				LOGI("NvVkMemoryAllocator: freeing block with %u live allocations", pool.back()->allocationCount);
+			destroyBlock(pool.back());
+		}
+	}
+}
+
+uint32_t NvVkMemoryAllocator::findMemoryType(uint32_t typeBits, VkFlags memProps) const
+{
+	// Find an available memory type that satisfies the requested properties.
+	for (uint32_t i = 0; i < mMemProps.memoryTypeCount; ++i) {
+		if (((mMemProps.memoryTypes[i].propertyFlags & memProps) == memProps) &&
+			((typeBits >> i) & 1)) {
+			return i;
+		}
+	}
+	return VK_MAX_MEMORY_TYPES;
+}
+
+VkDeviceSize NvVkMemoryAllocator::blockSizeForType(uint32_t memoryTypeIndex) const
+{
+	VkDeviceSize heapSize = mMemProps.memoryHeaps[mMemProps.memoryTypes[memoryTypeIndex].heapIndex].size;
+	return std::min(VkDeviceSize(DEFAULT_BLOCK_SIZE), std::max(heapSize / 8, VkDeviceSize(1024 * 1024)));
+}
+
+NvVkMemoryBlock* NvVkMemoryAllocator::createBlock(uint32_t memoryTypeIndex, uint32_t pool, VkDeviceSize size, bool dedicated)
+{
+	if (mMaxAllocationCount && mDeviceAllocationCount >= mMaxAllocationCount) {
+		LOGE("NvVkMemoryAllocator: maxMemoryAllocationCount (%u) reached", mMaxAllocationCount);
+		return NULL;
+	}
+
+	VkMemoryAllocateInfo memInfo = {
+		VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,             // sType
+		0,                                               // pNext
+		size,                                            // allocationSize
+		memoryTypeIndex,                                 // memoryTypeIndex
+	};
+
+	VkDeviceMemory mem;
+	VkResult result = vkAllocateMemory(mDevice, &memInfo, NULL, &mem);
+	if (result != VK_SUCCESS)
+		return NULL;
+
+	void* mapped = NULL;
+	if (mMemProps.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		result = vkMapMemory(mDevice, mem, 0, VK_WHOLE_SIZE, 0, &mapped);
+		if (result != VK_SUCCESS) {
+			vkFreeMemory(mDevice, mem, NULL);
+			return NULL;
+		}
+	}
+
+	NvVkMemoryBlock* block = new NvVkMemoryBlock;
+	block->mem = mem;
+	block->size = size;
+	block->used = 0;
+	block->mapped = (uint8_t*)mapped;
+	block->memoryTypeIndex = memoryTypeIndex;
+	block->pool = pool;
+	block->allocationCount = 0;
+	block->dedicated = dedicated;
+	block->freeRanges[0] = size;
+
+	mPools[pool].push_back(block);
+	mDeviceAllocationCount++;
+
+	return block;
+}
+
+void NvVkMemoryAllocator::destroyBlock(NvVkMemoryBlock* block)
+{
+	std::vector<NvVkMemoryBlock*>& pool = mPools[block->pool];
+	pool.erase(std::find(pool.begin(), pool.end(), block));
+
+	if (block->mapped)
+		vkUnmapMemory(mDevice, block->mem);
+	vkFreeMemory(mDevice, block->mem, NULL);
+	mDeviceAllocationCount--;
+
+	delete block;
+}
+
+VkResult NvVkMemoryAllocator::alloc(const VkMemoryRequirements& reqs, VkFlags memProps, bool linear, NvVkAllocation& allocation)
+{
+	allocation = NvVkAllocation();
+
+	if (!reqs.size)
+		return VK_SUCCESS;
+
+	uint32_t memoryTypeIndex = findMemoryType(reqs.memoryTypeBits, memProps);
+	if (memoryTypeIndex >= mMemProps.memoryTypeCount)
+		return VK_ERROR_FORMAT_NOT_SUPPORTED;
+
+	VkDeviceSize alignment = std::max(reqs.alignment, VkDeviceSize(1));
+	VkDeviceSize size = reqs.size;
+
+	// Host visible ranges are flushed individually, so they must not share an atom with a neighbour
+	if (mMemProps.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		alignment = alignUp(alignment, mNonCoherentAtomSize);
+		size = alignUp(size, mNonCoherentAtomSize);
+	}
+
+	uint32_t pool = memoryTypeIndex * 2;
+	if (!linear && mBufferImageGranularity > 1)
+		pool++;
+
+	NvVkMemoryBlock* block = NULL;
+	VkDeviceSize offset = 0;
+	VkDeviceSize blockSize = blockSizeForType(memoryTypeIndex);
+
+	if (size > blockSize / 2) {
+		// Large resources (render targets, big textures) get a block of their own
+		block = createBlock(memoryTypeIndex, pool, size, true);
+		if (!block)
+			return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+		block->suballoc(size, alignment, offset);
+	}
+	else {
+		std::vector<NvVkMemoryBlock*>& blocks = mPools[pool];
+		for (size_t i = 0; i < blocks.size(); i++) {
+			if (!blocks[i]->dedicated && blocks[i]->suballoc(size, alignment, offset)) {
+				block = blocks[i];
+				break;
+			}
+		}
+
+		if (!block) {
+			block = createBlock(memoryTypeIndex, pool, blockSize, false);
+			if (!block)
+				return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+			block->suballoc(size, alignment, offset);
+		}
+	}
+
+	allocation.mem = block->mem;
+	allocation.offset = offset;
+	allocation.size = size;
+	allocation.mapped = block->mapped ? block->mapped + offset : NULL;
+	allocation.block = block;
+
+	return VK_SUCCESS;
+}
+
+void NvVkMemoryAllocator::free(NvVkAllocation& allocation)
+{
+	NvVkMemoryBlock* block = allocation.block;
+	if (!block)
+		return;
+
+	block->release(allocation.offset, allocation.size);
+	allocation = NvVkAllocation();
+
+	if (block->allocationCount)
+		return;
+
+	// Keep one empty shared block per pool around to avoid thrashing the driver
+	bool keep = !block->dedicated;
+	if (keep) {
+		std::vector<NvVkMemoryBlock*>& blocks = mPools[block->pool];
+		for (size_t i = 0; i < blocks.size(); i++) {
+			if (blocks[i] != block && !blocks[i]->dedicated && !blocks[i]->allocationCount) {
+				keep = false;
+				break;
+			}
+		}
+	}
+
+	if (!keep)
+		destroyBlock(block);
+}
+
+VkResult NvVkMemoryAllocator::flush(const NvVkAllocation& allocation, VkDeviceSize offset, VkDeviceSize size)
+{
+	NvVkMemoryBlock* block = allocation.block;
+	if (!block || !block->mapped)
+		return VK_SUCCESS;
+
+	if (mMemProps.memoryTypes[block->memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+		return VK_SUCCESS;
+
+	// The allocation itself is atom aligned, so widening the range never touches a neighbour
+	VkDeviceSize start = allocation.offset + offset;
+	VkDeviceSize end = std::min(alignUp(start + size, mNonCoherentAtomSize), allocation.offset + allocation.size);
+	start = start / mNonCoherentAtomSize * mNonCoherentAtomSize;
+
+	VkMappedMemoryRange range = { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
+	range.memory = block->mem;
+	range.offset = start;
+	range.size = end - start;
+	return vkFlushMappedMemoryRanges(mDevice, 1, &range);
+}
+
+void NvVkMemoryAllocator::getHeapStats(uint32_t heapIndex, NvVkMemoryHeapStats& stats) const
+{
+	stats = NvVkMemoryHeapStats();
+
+	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES * 2; i++) {
+		const std::vector<NvVkMemoryBlock*>& blocks = mPools[i];
+		for (size_t j = 0; j < blocks.size(); j++) {
+			const NvVkMemoryBlock* block = blocks[j];
+			if (mMemProps.memoryTypes[block->memoryTypeIndex].heapIndex != heapIndex)
+				continue;
+
+			stats.blockBytes += block->size;
+			stats.usedBytes += block->used;
+			stats.blockCount++;
+			stats.allocationCount += block->allocationCount;
+		}
+	}
+}
+
+void NvVkMemoryAllocator::logStats() const
+{
+	for (uint32_t heap = 0; heap < mMemProps.memoryHeapCount; heap++) {
+		NvVkMemoryHeapStats stats;
+		getHeapStats(heap, stats);
+		if (!stats.blockCount)
+			continue;
+
+		LOGI("VK memory heap %u%s: %u allocations in %u blocks, %.2f of %.2f MB used",
+			heap, (mMemProps.memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " (device local)" : "",
+			stats.allocationCount, stats.blockCount,
+			stats.usedBytes / (1024.0 * 1024.0), stats.blockBytes / (1024.0 * 1024.0));
+	}
+}
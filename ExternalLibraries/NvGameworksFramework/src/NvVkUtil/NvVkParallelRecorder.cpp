@@ -0,0 +1,305 @@
+//----------------------------------------------------------------------------------
+// File:        NvVkUtil/NvVkParallelRecorder.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvVkUtil/NvVkParallelRecorder.h"
+#include "NV/NvLogs.h"
+
+#include <algorithm>
+
+NvVkParallelRecorder::NvVkParallelRecorder() :
+	mVk(NULL),
+	mThreadManager(NULL),
+	mMutex(NULL),
+	mWorkCond(NULL),
+	mDoneCond(NULL),
+	mGeneration(0),
+	mDoneCount(0),
+	mQuit(false),
+	mJob(NULL),
+	mInheritance(NULL),
+	mItemCount(0),
+	mSliceCount(0),
+	mFailed(false)
+{
+}
+
+NvVkParallelRecorder::~NvVkParallelRecorder()
+{
+	deinit();
+}
+
+bool NvVkParallelRecorder::init(NvVkContext& vk, NvThreadManager* threads, uint32_t workerCount)
+{
+	mVk = &vk;
+	mThreadManager = threads;
+	if (!mThreadManager)
+		workerCount = 0;
+
+	if (workerCount) {
+		mMutex = mThreadManager->initializeMutex(false, 0);
+		mWorkCond = mThreadManager->initializeConditionVariable();
+		mDoneCond = mThreadManager->initializeConditionVariable();
+	}
+
+	mGeneration = 0;
+	mQuit = false;
+
+	// Thread 0 is the calling thread
+	for (uint32_t i = 0; i <= workerCount; i++) {
+		ThreadState* state = new ThreadState;
+		state->owner = this;
+		state->index = i;
+		state->thread = NULL;
+		state->cmd = VK_NULL_HANDLE;
+		state->generation = 0;
+		// Cleared before any pool is created, so deinit can skip the
+		// slots of a failed init
+		for (uint32_t slot = 0; slot < FRAME_SLOTS; slot++) {
+			state->pools[slot] = VK_NULL_HANDLE;
+			state->used[slot] = 0;
+			state->serials[slot] = 0;
+		}
+		mThreads.push_back(state);
+
+		for (uint32_t slot = 0; slot < FRAME_SLOTS; slot++) {
+			VkCommandPoolCreateInfo cmdPoolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+			cmdPoolInfo.queueFamilyIndex = vk.queueFamilyIndex();
+			cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			VkResult result = vkCreateCommandPool(vk.device(), &cmdPoolInfo, NULL, &state->pools[slot]);
+			if (result != VK_SUCCESS) {
+				state->pools[slot] = VK_NULL_HANDLE;
+				deinit();
+				return false;
+			}
+		}
+	}
+
+	for (uint32_t i = 1; i <= workerCount; i++) {
+		ThreadState* state = mThreads[i];
+		state->thread = mThreadManager->createThread(workerEntry, state, NULL, 256 * 1024,
+			NvThread::DefaultThreadPriority);
+		if (!state->thread) {
+			deinit();
+			return false;
+		}
+		state->thread->startThread();
+	}
+
+	return true;
+}
+
+void NvVkParallelRecorder::deinit()
+{
+	if (mMutex) {
+		mMutex->lockMutex();
+		mQuit = true;
+		mWorkCond->broadcastConditionVariable();
+		mMutex->unlockMutex();
+	}
+
+	for (size_t i = 0; i < mThreads.size(); i++) {
+		ThreadState* state = mThreads[i];
+		if (state->thread) {
+			state->thread->waitThread();
+			mThreadManager->destroyThread(state->thread);
+		}
+
+		for (uint32_t slot = 0; slot < FRAME_SLOTS; slot++) {
+			if (state->pools[slot] != VK_NULL_HANDLE)
+				vkDestroyCommandPool(mVk->device(), state->pools[slot], NULL);
+		}
+		delete state;
+	}
+	mThreads.clear();
+
+	if (mMutex) {
+		mThreadManager->finalizeConditionVariable(mDoneCond);
+		mThreadManager->finalizeConditionVariable(mWorkCond);
+		mThreadManager->finalizeMutex(mMutex);
+		mDoneCond = NULL;
+		mWorkCond = NULL;
+		mMutex = NULL;
+	}
+}
+
+#ifdef _WIN32
+DWORD WINAPI NvVkParallelRecorder::workerEntry(LPVOID arg)
+{
+	ThreadState* state = (ThreadState*)arg;
+	state->owner->workerLoop(*state);
+	return 0;
+}
+#else
+void* NvVkParallelRecorder::workerEntry(void* arg)
+{
+	ThreadState* state = (ThreadState*)arg;
+	state->owner->workerLoop(*state);
+	return NULL;
+}
+#endif
+
+void NvVkParallelRecorder::workerLoop(ThreadState& state)
+{
+	while (true) {
+		mMutex->lockMutex();
+		while (!mQuit && state.generation == mGeneration)
+			mWorkCond->waitConditionVariable(mMutex);
+		bool quit = mQuit;
+		state.generation = mGeneration;
+		mMutex->unlockMutex();
+
+		if (quit)
+			break;
+
+		bool ok = (state.index < mSliceCount) ? recordSlice(state) : true;
+
+		mMutex->lockMutex();
+		if (!ok)
+			mFailed = true;
+		mDoneCount++;
+		mDoneCond->signalConditionVariable();
+		mMutex->unlockMutex();
+	}
+}
+
+// Called on the recording thread only, before the job is handed out
+VkCommandBuffer NvVkParallelRecorder::acquireBuffer(ThreadState& state, uint64_t serial)
+{
+	uint32_t slot = (uint32_t)(serial % FRAME_SLOTS);
+
+	if (state.serials[slot] != serial) {
+		if (state.used[slot]) {
+			// FRAME_SLOTS frames back, which the context has already waited for
+			if (!mVk->waitForSubmission(state.serials[slot]))
+				return VK_NULL_HANDLE;
+
+			VkResult result = vkResetCommandPool(mVk->device(), state.pools[slot], 0);
+			if (result != VK_SUCCESS)
+				return VK_NULL_HANDLE;
+
+			state.used[slot] = 0;
+		}
+		state.serials[slot] = serial;
+	}
+
+	std::vector<VkCommandBuffer>& buffers = state.buffers[slot];
+	if (state.used[slot] < buffers.size())
+		return buffers[state.used[slot]++];
+
+	VkCommandBuffer cmd = mVk->createCmdBuffer(state.pools[slot], false);
+	if (!cmd)
+		return VK_NULL_HANDLE;
+
+	buffers.push_back(cmd);
+	state.used[slot]++;
+	return cmd;
+}
+
+bool NvVkParallelRecorder::recordSlice(ThreadState& state)
+{
+	// Spread the remainder over the first slices
+	uint32_t base = mItemCount / mSliceCount;
+	uint32_t extra = mItemCount % mSliceCount;
+	uint32_t first = state.index * base + std::min(state.index, extra);
+	uint32_t count = base + ((state.index < extra) ? 1 : 0);
+
+	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = mInheritance;
+
+	if (vkBeginCommandBuffer(state.cmd, &beginInfo) != VK_SUCCESS)
+		return false;
+
+	mJob->record(state.cmd, first, count, state.index);
+
+	return vkEndCommandBuffer(state.cmd) == VK_SUCCESS;
+}
+
+bool NvVkParallelRecorder::record(VkCommandBuffer primary, const VkCommandBufferInheritanceInfo& inheritance,
+	uint32_t itemCount, Job& job, uint32_t minItemsPerSlice)
+{
+	if (!itemCount || mThreads.empty())
+		return true;
+
+	if (!minItemsPerSlice)
+		minItemsPerSlice = 1;
+
+	uint32_t sliceCount = std::min((uint32_t)mThreads.size(),
+		(itemCount + minItemsPerSlice - 1) / minItemsPerSlice);
+
+	uint64_t serial = mVk->currentSubmissionSerial();
+	std::vector<VkCommandBuffer> secondaries(sliceCount);
+	for (uint32_t i = 0; i < sliceCount; i++) {
+		secondaries[i] = acquireBuffer(*mThreads[i], serial);
+		if (!secondaries[i])
+			return false;
+		mThreads[i]->cmd = secondaries[i];
+	}
+
+	mJob = &job;
+	mInheritance = &inheritance;
+	mItemCount = itemCount;
+	mSliceCount = sliceCount;
+	mFailed = false;
+
+	// Wake the workers only when there is a slice for one of them
+	uint32_t workerCount = (uint32_t)mThreads.size() - 1;
+	bool parallel = sliceCount > 1;
+	if (parallel) {
+		mMutex->lockMutex();
+		mDoneCount = 0;
+		mGeneration++;
+		mWorkCond->broadcastConditionVariable();
+		mMutex->unlockMutex();
+	}
+
+	bool ok = recordSlice(*mThreads[0]);
+
+	if (parallel) {
+		mMutex->lockMutex();
+		while (mDoneCount < workerCount)
+			mDoneCond->waitConditionVariable(mMutex);
+		if (mFailed)
+			ok = false;
+		mMutex->unlockMutex();
+	}
+
+	mJob = NULL;
+	mInheritance = NULL;
+
+	if (!ok)
+		return false;
+
+	vkCmdExecuteCommands(primary, sliceCount, &secondaries[0]);
+	return true;
+}
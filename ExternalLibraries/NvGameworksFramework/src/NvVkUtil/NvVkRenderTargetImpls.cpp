@@ -226,15 +226,12 @@ bool NvVkMultibufferedRenderTarget::resize(int32_t& w, int32_t& h) {
 
 		while (!_memory.empty())
 		{
-			VkDeviceMemory mem = _memory.front();
-
-			vkFreeMemory(_vk.device(), mem, NULL);
+			_vk.freeMemory(_memory.front());
 
 			_memory.pop();
 		}
 
-		vkDestroyImage(vk().device(), _depthStencil(), NULL);
-		_depthStencil() = VK_NULL_HANDLE;
+		_vk.destroyImage(_depthStencil);
 
 		_frames.clear();
 		result = vkDeviceWaitIdle(vk().device());
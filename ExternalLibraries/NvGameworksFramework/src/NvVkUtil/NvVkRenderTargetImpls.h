@@ -96,7 +96,7 @@ protected:
 
 	std::vector<Frame> _frames;
 	std::queue<BackBuffer> _backBuffers;
-	std::queue<VkDeviceMemory> _memory;
+	std::queue<NvVkAllocation> _memory;
 
 	BackBuffer _currentBuffer;
 
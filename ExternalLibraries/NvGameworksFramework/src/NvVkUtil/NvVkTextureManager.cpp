@@ -0,0 +1,487 @@
+//----------------------------------------------------------------------------------
+// File:        NvVkUtil/NvVkTextureManager.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvVkUtil/NvVkTextureManager.h"
+#include "NvAssetLoader/NvAssetLoader.h"
+#include "NvImage/NvImage.h"
+#include "NV/NvLogs.h"
+
+#include <algorithm>
+
+// The larger dimension of a mip level
+static uint32_t levelSize(uint32_t width, uint32_t height, uint32_t level) {
+	uint32_t size = std::max(width, height) >> level;
+	return size ? size : 1;
+}
+
+NvVkManagedTexture::NvVkManagedTexture() :
+	mStream(NULL),
+	mTail(NULL),
+	mViewVersion(0),
+	mRefCount(0),
+	mLastUsedFrame(0),
+	mEvicted(false),
+	mLoading(false),
+	mLoadFailed(false)
+{
+	mTexture.view = VK_NULL_HANDLE;
+}
+
+NvVkManagedTexture::~NvVkManagedTexture()
+{
+	delete mTail;
+}
+
+NvVkTextureManager::NvVkTextureManager() :
+	mVk(NULL),
+	mBudget(0),
+	mIdleFrames(DEFAULT_IDLE_FRAMES),
+	mFrame(0),
+	mChangedCount(0),
+	mThreadManager(NULL),
+	mLoader(NULL),
+	mMutex(NULL),
+	mLoadCond(NULL),
+	mQuit(false),
+	mActive(NULL)
+{
+}
+
+NvVkTextureManager::~NvVkTextureManager()
+{
+	deinit();
+}
+
+bool NvVkTextureManager::init(NvVkContext& vk, VkDeviceSize budgetBytes, NvThreadManager* threads,
+	size_t frameBudget, uint32_t tailSize)
+{
+	mVk = &vk;
+	mBudget = budgetBytes;
+	mFrame = 0;
+	mQuit = false;
+	mStreamer.init(vk, frameBudget, tailSize);
+
+	mThreadManager = threads;
+	if (mThreadManager) {
+		mMutex = mThreadManager->initializeMutex(false, 0);
+		mLoadCond = mThreadManager->initializeConditionVariable();
+		mLoader = mThreadManager->createThread(loaderEntry, this, NULL, 256 * 1024,
+			NvThread::DefaultThreadPriority);
+		if (!mLoader) {
+			deinit();
+			return false;
+		}
+		mLoader->startThread();
+	}
+
+	return true;
+}
+
+void NvVkTextureManager::deinit()
+{
+	if (!mVk)
+		return;
+
+	if (mLoader) {
+		mMutex->lockMutex();
+		mQuit = true;
+		mLoadCond->broadcastConditionVariable();
+		mMutex->unlockMutex();
+
+		mLoader->waitThread();
+		mThreadManager->destroyThread(mLoader);
+		mLoader = NULL;
+	}
+
+	if (mMutex) {
+		mThreadManager->finalizeConditionVariable(mLoadCond);
+		mThreadManager->finalizeMutex(mMutex);
+		mLoadCond = NULL;
+		mMutex = NULL;
+	}
+
+	// The loader has stopped, so whatever it was given only needs freeing
+	mQueued.insert(mQueued.end(), mLoaded.begin(), mLoaded.end());
+	if (mActive)
+		mQueued.push_back(mActive);
+	for (size_t i = 0; i < mQueued.size(); i++) {
+		mQueued[i]->tex = NULL;
+		finishLoad(mQueued[i]);
+	}
+	mQueued.clear();
+	mLoaded.clear();
+	mActive = NULL;
+
+	// The streamer destroys the images
+	for (std::map<std::string, NvVkManagedTexture*>::iterator it = mTextures.begin(); it != mTextures.end(); ++it)
+		delete it->second;
+	mTextures.clear();
+	mStreamer.deinit();
+
+	mStats = NvVkTextureManagerStats();
+	mVk = NULL;
+}
+
+NvVkManagedTexture* NvVkTextureManager::acquire(const char* filename)
+{
+	if (!mVk || !filename)
+		return NULL;
+
+	std::map<std::string, NvVkManagedTexture*>::iterator it = mTextures.find(filename);
+	if (it != mTextures.end()) {
+		it->second->mRefCount++;
+		return it->second;
+	}
+
+	LoadRequest request;
+	request.tex = NULL;
+	request.name = filename;
+	load(request);
+	if (!request.image) {
+		LOGE("Could not load texture %s", filename);
+		return NULL;
+	}
+
+	// Keep a copy of the mip tail, so evicting the texture needs no loading.  Compressed
+	// images without the levels cannot be evicted
+	NvImage* tail = NULL;
+	uint32_t tailLevel = 0;
+	while (levelSize(request.image->getWidth(), request.image->getHeight(), tailLevel) > mStreamer.getTailSize())
+		tailLevel++;
+	if (tailLevel) {
+		tail = new NvImage;
+		if (!request.image->downscale(*tail, tailLevel)) {
+			delete tail;
+			tail = NULL;
+		}
+	}
+
+	NvVkStreamingTexture* stream = mStreamer.createTextureFromFileData(request.image, request.data);
+	if (!stream) {
+		delete tail;
+		return NULL;
+	}
+
+	NvVkManagedTexture* tex = new NvVkManagedTexture;
+	tex->mName = filename;
+	tex->mStream = stream;
+	tex->mTail = tail;
+	tex->mTexture = stream->getTexture();
+	tex->mRefCount = 1;
+	// Counts as unused until it is first marked, so it may be evicted right away
+	tex->mLastUsedFrame = mFrame - mIdleFrames;
+	mTextures[tex->mName] = tex;
+
+	enforceBudget();
+	updateStats();
+
+	return tex;
+}
+
+void NvVkTextureManager::release(NvVkManagedTexture* tex)
+{
+	if (!tex || --tex->mRefCount)
+		return;
+
+	mTextures.erase(tex->mName);
+
+	// A reload in progress is discarded when it finishes
+	if (tex->mLoading) {
+		if (mMutex)
+			mMutex->lockMutex();
+		for (size_t i = 0; i < mQueued.size(); ) {
+			if (mQueued[i]->tex == tex) {
+				delete mQueued[i];
+				mQueued.erase(mQueued.begin() + i);
+			} else {
+				i++;
+			}
+		}
+		if (mActive && mActive->tex == tex)
+			mActive->tex = NULL;
+		for (size_t i = 0; i < mLoaded.size(); i++) {
+			if (mLoaded[i]->tex == tex)
+				mLoaded[i]->tex = NULL;
+		}
+		if (mMutex)
+			mMutex->unlockMutex();
+	}
+
+	mStreamer.destroyTexture(tex->mStream);
+	delete tex;
+
+	updateStats();
+}
+
+void NvVkTextureManager::markUsed(NvVkManagedTexture* tex)
+{
+	if (!tex)
+		return;
+
+	tex->mLastUsedFrame = mFrame;
+
+	if (!tex->mEvicted || tex->mLoading || tex->mLoadFailed)
+		return;
+
+	LoadRequest* request = new LoadRequest;
+	request->tex = tex;
+	request->name = tex->mName;
+	request->image = NULL;
+	request->data = NULL;
+	tex->mLoading = true;
+
+	if (mMutex) {
+		mMutex->lockMutex();
+		mQueued.push_back(request);
+		mLoadCond->signalConditionVariable();
+		mMutex->unlockMutex();
+	} else {
+		mQueued.push_back(request);
+	}
+}
+
+uint32_t NvVkTextureManager::update()
+{
+	mFrame++;
+
+	std::vector<LoadRequest*> loaded;
+	if (mMutex) {
+		mMutex->lockMutex();
+		loaded.swap(mLoaded);
+		mMutex->unlockMutex();
+	} else if (!mQueued.empty()) {
+		// Without a loader thread, one file is read per frame to bound the hitch
+		loaded.push_back(mQueued.front());
+		mQueued.erase(mQueued.begin());
+		load(*loaded.back());
+	}
+
+	for (size_t i = 0; i < loaded.size(); i++)
+		finishLoad(loaded[i]);
+
+	enforceBudget();
+
+	// Pick up the views widened by the streamer
+	mStreamer.update();
+	for (std::map<std::string, NvVkManagedTexture*>::iterator it = mTextures.begin(); it != mTextures.end(); ++it) {
+		NvVkManagedTexture* tex = it->second;
+		if (tex->mTexture.view != tex->mStream->getView()) {
+			tex->mTexture = tex->mStream->getTexture();
+			tex->mViewVersion++;
+			mChangedCount++;
+		}
+	}
+
+	updateStats();
+
+	uint32_t changed = mChangedCount;
+	mChangedCount = 0;
+	return changed;
+}
+
+void NvVkTextureManager::logStats() const
+{
+	LOGI("Managed textures: %u (%u evicted), %llu KB resident, budget %llu KB; %u evictions, %u reloads",
+		mStats.textureCount, mStats.evictedCount, (unsigned long long)(mStats.residentBytes >> 10),
+		(unsigned long long)(mBudget >> 10), mStats.evictions, mStats.reloads);
+}
+
+#ifdef _WIN32
+DWORD WINAPI NvVkTextureManager::loaderEntry(LPVOID arg)
+{
+	((NvVkTextureManager*)arg)->loaderLoop();
+	return 0;
+}
+#else
+void* NvVkTextureManager::loaderEntry(void* arg)
+{
+	((NvVkTextureManager*)arg)->loaderLoop();
+	return NULL;
+}
+#endif
+
+void NvVkTextureManager::loaderLoop()
+{
+	while (true) {
+		mMutex->lockMutex();
+		while (!mQuit && mQueued.empty())
+			mLoadCond->waitConditionVariable(mMutex);
+		if (mQuit) {
+			mMutex->unlockMutex();
+			break;
+		}
+		LoadRequest* request = mQueued.front();
+		mQueued.erase(mQueued.begin());
+		mActive = request;
+		mMutex->unlockMutex();
+
+		// Only the name is read here; the texture pointer belongs to the calling thread
+		load(*request);
+
+		mMutex->lockMutex();
+		mActive = NULL;
+		mLoaded.push_back(request);
+		mMutex->unlockMutex();
+	}
+}
+
+void NvVkTextureManager::load(LoadRequest& request)
+{
+	request.image = NULL;
+
+	int32_t length;
+	request.data = NvAssetLoaderRead(request.name.c_str(), length);
+	if (!request.data)
+		return;
+
+	NvImage* image = new NvImage;
+	if (!image->loadImageFromFileDataInPlace((uint8_t*)request.data, length, "dds")) {
+		delete image;
+		NvAssetLoaderFree(request.data);
+		request.data = NULL;
+		return;
+	}
+
+	request.image = image;
+}
+
+void NvVkTextureManager::finishLoad(LoadRequest* request)
+{
+	NvVkManagedTexture* tex = request->tex;
+	if (!tex) {
+		delete request->image;
+		if (request->data)
+			NvAssetLoaderFree(request->data);
+		delete request;
+		return;
+	}
+
+	tex->mLoading = false;
+
+	// The streamer takes the image and data either way
+	NvVkStreamingTexture* stream = request->image ?
+		mStreamer.createTextureFromFileData(request->image, request->data) : NULL;
+	if (stream) {
+		replaceStream(tex, stream);
+		tex->mEvicted = false;
+		mStats.reloads++;
+	} else {
+		LOGE("Could not reload texture %s", tex->mName.c_str());
+		tex->mLoadFailed = true;
+	}
+
+	delete request;
+}
+
+bool NvVkTextureManager::evict(NvVkManagedTexture* tex)
+{
+	// The streamer takes ownership of the copy
+	NvImage* image = new NvImage;
+	if (!tex->mTail->downscale(*image, 0)) {
+		delete image;
+		return false;
+	}
+
+	NvVkStreamingTexture* stream = mStreamer.createTexture(image);
+	if (!stream)
+		return false;
+
+	replaceStream(tex, stream);
+	tex->mEvicted = true;
+	tex->mLoadFailed = false;
+	mStats.evictions++;
+
+	return true;
+}
+
+void NvVkTextureManager::enforceBudget()
+{
+	if (!mBudget)
+		return;
+
+	VkDeviceSize resident = residentBytes();
+	while (resident > mBudget) {
+		// Ages rather than frames are compared, as unused textures date from before frame 0
+		NvVkManagedTexture* victim = NULL;
+		for (std::map<std::string, NvVkManagedTexture*>::iterator it = mTextures.begin(); it != mTextures.end(); ++it) {
+			NvVkManagedTexture* tex = it->second;
+			uint64_t age = mFrame - tex->mLastUsedFrame;
+			if (tex->mEvicted || !tex->mTail || age < mIdleFrames)
+				continue;
+			if (!victim || age > mFrame - victim->mLastUsedFrame)
+				victim = tex;
+		}
+
+		if (!victim)
+			break;
+
+		VkDeviceSize before = victim->mStream->getTexture().image.mem.size;
+		if (!evict(victim)) {
+			// Not tried again
+			delete victim->mTail;
+			victim->mTail = NULL;
+			continue;
+		}
+
+		resident = resident - before + victim->mStream->getTexture().image.mem.size;
+	}
+}
+
+void NvVkTextureManager::replaceStream(NvVkManagedTexture* tex, NvVkStreamingTexture* stream)
+{
+	// The old image outlives the frames that may still sample it
+	mStreamer.destroyTexture(tex->mStream);
+	tex->mStream = stream;
+	tex->mTexture = stream->getTexture();
+	tex->mViewVersion++;
+	mChangedCount++;
+}
+
+VkDeviceSize NvVkTextureManager::residentBytes() const
+{
+	VkDeviceSize bytes = 0;
+	for (std::map<std::string, NvVkManagedTexture*>::const_iterator it = mTextures.begin(); it != mTextures.end(); ++it)
+		bytes += it->second->mStream->getTexture().image.mem.size;
+	return bytes;
+}
+
+void NvVkTextureManager::updateStats()
+{
+	mStats.residentBytes = residentBytes();
+	mStats.textureCount = (uint32_t)mTextures.size();
+	mStats.evictedCount = 0;
+	for (std::map<std::string, NvVkManagedTexture*>::const_iterator it = mTextures.begin(); it != mTextures.end(); ++it) {
+		if (it->second->mEvicted)
+			mStats.evictedCount++;
+	}
+}
@@ -0,0 +1,383 @@
+//----------------------------------------------------------------------------------
+// File:        NvVkUtil/NvVkTextureStreamer.cpp
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "NvVkUtil/NvVkTextureStreamer.h"
+#include "NvAssetLoader/NvAssetLoader.h"
+#include "NvImage/NvImage.h"
+#include "NV/NvLogs.h"
+
+#include <algorithm>
+
+// The larger dimension of a mip level
+static uint32_t levelSize(uint32_t width, uint32_t height, uint32_t level) {
+	uint32_t size = std::max(width, height) >> level;
+	return size ? size : 1;
+}
+
+NvVkStreamingTexture::NvVkStreamingTexture() :
+	mImage(NULL),
+	mFileData(NULL),
+	mFormat(VK_FORMAT_UNDEFINED),
+	mCubeMap(false),
+	mLevelCount(0),
+	mTopLevel(0),
+	mQueuedLevel(0),
+	mResidentLevel(0),
+	mViewVersion(0),
+	mDestroySerial(0)
+{
+	mTexture.view = VK_NULL_HANDLE;
+}
+
+NvVkStreamingTexture::~NvVkStreamingTexture()
+{
+}
+
+NvVkTextureStreamer::NvVkTextureStreamer() :
+	mVk(NULL),
+	mFrameBudget(DEFAULT_FRAME_BUDGET),
+	mTailSize(DEFAULT_TAIL_SIZE)
+{
+}
+
+NvVkTextureStreamer::~NvVkTextureStreamer()
+{
+	deinit();
+}
+
+void NvVkTextureStreamer::init(NvVkContext& vk, size_t frameBudget, uint32_t tailSize)
+{
+	mVk = &vk;
+	mFrameBudget = frameBudget;
+	mTailSize = tailSize;
+}
+
+void NvVkTextureStreamer::deinit()
+{
+	if (!mVk)
+		return;
+
+	for (size_t i = 0; i < mTextures.size(); i++) {
+		releaseSource(mTextures[i]);
+		releaseTexture(mTextures[i]);
+	}
+	mTextures.clear();
+
+	for (size_t i = 0; i < mDestroyed.size(); i++)
+		releaseTexture(mDestroyed[i]);
+	mDestroyed.clear();
+
+	for (size_t i = 0; i < mRetiredViews.size(); i++)
+		vkDestroyImageView(mVk->device(), mRetiredViews[i].view, NULL);
+	mRetiredViews.clear();
+
+	mVk = NULL;
+}
+
+NvVkStreamingTexture* NvVkTextureStreamer::createTexture(NvImage* image, uint32_t maxSize)
+{
+	return create(image, NULL, maxSize);
+}
+
+NvVkStreamingTexture* NvVkTextureStreamer::createTextureFromDDSFile(const char* filename, uint32_t maxSize)
+{
+	int32_t length;
+	char* data = NvAssetLoaderRead(filename, length);
+
+	if (!data)
+		return NULL;
+
+	NvImage* image = new NvImage;
+	if (!image->loadImageFromFileDataInPlace((uint8_t*)data, length, "dds")) {
+		LOGE("Could not load texture %s", filename);
+		delete image;
+		NvAssetLoaderFree(data);
+		return NULL;
+	}
+
+	return create(image, data, maxSize);
+}
+
+NvVkStreamingTexture* NvVkTextureStreamer::createTextureFromFileData(NvImage* image, char* fileData, uint32_t maxSize)
+{
+	return create(image, fileData, maxSize);
+}
+
+NvVkStreamingTexture* NvVkTextureStreamer::create(NvImage* image, char* fileData, uint32_t maxSize)
+{
+	NvVkStreamingTexture* tex = new NvVkStreamingTexture;
+	tex->mImage = image;
+	tex->mFileData = fileData;
+
+	VkFormat format = image ? NvVkContext::getTextureFormat(*image) : VK_FORMAT_UNDEFINED;
+	if (!mVk || format == VK_FORMAT_UNDEFINED) {
+		releaseSource(tex);
+		delete tex;
+		return NULL;
+	}
+
+	uint32_t width = image->getWidth();
+	uint32_t height = image->getHeight();
+
+	tex->mFormat = format;
+	tex->mCubeMap = image->isCubeMap();
+	tex->mLevelCount = image->getMipLevels();
+
+	// Levels above the cap are never uploaded, so they are not allocated either
+	while (maxSize && tex->mTopLevel + 1 < tex->mLevelCount &&
+		levelSize(width, height, tex->mTopLevel) > maxSize)
+		tex->mTopLevel++;
+
+	// The tail is every level within the tail size, and at least the smallest level
+	uint32_t tail = tex->mLevelCount - 1;
+	while (tail > tex->mTopLevel && levelSize(width, height, tail - 1) <= mTailSize)
+		tail--;
+
+	VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+	info.imageType = VK_IMAGE_TYPE_2D;
+	info.format = format;
+	info.extent.width = std::max(width >> tex->mTopLevel, 1U);
+	info.extent.height = std::max(height >> tex->mTopLevel, 1U);
+	info.extent.depth = 1;
+	info.mipLevels = tex->mLevelCount - tex->mTopLevel;
+	info.flags = tex->mCubeMap ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+	info.arrayLayers = tex->mCubeMap ? 6 : 1;
+	info.samples = VK_SAMPLE_COUNT_1_BIT;
+	info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	info.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+	if (mVk->createImage(info, tex->mTexture.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != VK_SUCCESS) {
+		releaseSource(tex);
+		delete tex;
+		return NULL;
+	}
+
+	// As with uploadTexture, queue order makes the tail ready before any
+	// frame that samples it, so it is resident as soon as it is queued
+	tex->mQueuedLevel = tail;
+	tex->mResidentLevel = tail;
+	if (!mVk->uploadTextureLevels(image, tex->mTexture.image, tail, tail - tex->mTopLevel,
+		tex->mLevelCount - tail) || !createView(tex)) {
+		// The upload may already be queued, so the image outlives the current frame
+		releaseSource(tex);
+		tex->mDestroySerial = mVk->currentSubmissionSerial();
+		mDestroyed.push_back(tex);
+		return NULL;
+	}
+
+	if (tex->mQueuedLevel == tex->mTopLevel)
+		releaseSource(tex);
+
+	mTextures.push_back(tex);
+
+	return tex;
+}
+
+void NvVkTextureStreamer::destroyTexture(NvVkStreamingTexture* tex)
+{
+	std::vector<NvVkStreamingTexture*>::iterator it = std::find(mTextures.begin(), mTextures.end(), tex);
+	if (it == mTextures.end())
+		return;
+
+	mTextures.erase(it);
+
+	// Queued uploads are submitted ahead of the current frame, so its
+	// completion also covers them
+	releaseSource(tex);
+	tex->mDestroySerial = mVk->currentSubmissionSerial();
+	mDestroyed.push_back(tex);
+}
+
+uint32_t NvVkTextureStreamer::update()
+{
+	uint32_t changed = 0;
+
+	// Publish the levels that have arrived; uploads complete in queue order
+	for (size_t i = 0; i < mTextures.size(); i++) {
+		NvVkStreamingTexture* tex = mTextures[i];
+		uint32_t resident = tex->mResidentLevel;
+		while (!tex->mUploads.empty() && mVk->isUploadComplete(tex->mUploads.front().ticket)) {
+			resident = tex->mUploads.front().level;
+			tex->mUploads.erase(tex->mUploads.begin());
+		}
+
+		if (resident != tex->mResidentLevel) {
+			tex->mResidentLevel = resident;
+			if (createView(tex))
+				changed++;
+		}
+	}
+
+	for (size_t i = 0; i < mRetiredViews.size(); ) {
+		if (mVk->isSubmissionComplete(mRetiredViews[i].serial)) {
+			vkDestroyImageView(mVk->device(), mRetiredViews[i].view, NULL);
+			mRetiredViews[i] = mRetiredViews.back();
+			mRetiredViews.pop_back();
+		} else {
+			i++;
+		}
+	}
+
+	for (size_t i = 0; i < mDestroyed.size(); ) {
+		if (mVk->isSubmissionComplete(mDestroyed[i]->mDestroySerial)) {
+			releaseTexture(mDestroyed[i]);
+			mDestroyed[i] = mDestroyed.back();
+			mDestroyed.pop_back();
+		} else {
+			i++;
+		}
+	}
+
+	// Queue levels smallest first across all textures, so they gain detail evenly
+	size_t budget = mFrameBudget;
+	bool queued = false;
+	for (;;) {
+		NvVkStreamingTexture* next = NULL;
+		uint32_t nextBytes = 0;
+		for (size_t i = 0; i < mTextures.size(); i++) {
+			NvVkStreamingTexture* tex = mTextures[i];
+			if (!tex->mImage)
+				continue;
+
+			uint32_t bytes = levelBytes(tex, tex->mQueuedLevel - 1);
+			if (!next || bytes < nextBytes) {
+				next = tex;
+				nextBytes = bytes;
+			}
+		}
+
+		// A level larger than the whole budget goes alone, so it is never starved
+		if (!next || (queued && nextBytes > budget))
+			break;
+
+		if (!queueNextLevel(next))
+			break;
+
+		queued = true;
+		budget = (nextBytes < budget) ? budget - nextBytes : 0;
+	}
+
+	return changed;
+}
+
+size_t NvVkTextureStreamer::getPendingBytes() const
+{
+	size_t bytes = 0;
+	for (size_t i = 0; i < mTextures.size(); i++) {
+		const NvVkStreamingTexture* tex = mTextures[i];
+		if (!tex->mImage)
+			continue;
+
+		for (uint32_t level = tex->mTopLevel; level < tex->mQueuedLevel; level++)
+			bytes += levelBytes(tex, level);
+	}
+
+	return bytes;
+}
+
+bool NvVkTextureStreamer::queueNextLevel(NvVkStreamingTexture* tex)
+{
+	NvVkStreamingTexture::LevelUpload upload;
+	upload.level = tex->mQueuedLevel - 1;
+
+	if (!mVk->uploadTextureLevels(tex->mImage, tex->mTexture.image, upload.level,
+		upload.level - tex->mTopLevel, 1, &upload.ticket))
+		return false;
+
+	tex->mUploads.push_back(upload);
+	tex->mQueuedLevel = upload.level;
+
+	if (tex->mQueuedLevel == tex->mTopLevel)
+		releaseSource(tex);
+
+	return true;
+}
+
+bool NvVkTextureStreamer::createView(NvVkStreamingTexture* tex)
+{
+	VkImageViewCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+	info.image = tex->mTexture.image();
+	info.viewType = tex->mCubeMap ? VK_IMAGE_VIEW_TYPE_CUBE : VK_IMAGE_VIEW_TYPE_2D;
+	info.format = tex->mFormat;
+	info.components.r = VK_COMPONENT_SWIZZLE_R;
+	info.components.g = VK_COMPONENT_SWIZZLE_G;
+	info.components.b = VK_COMPONENT_SWIZZLE_B;
+	info.components.a = VK_COMPONENT_SWIZZLE_A;
+	info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	info.subresourceRange.baseMipLevel = tex->mResidentLevel - tex->mTopLevel;
+	info.subresourceRange.levelCount = tex->mLevelCount - tex->mResidentLevel;
+	info.subresourceRange.baseArrayLayer = 0;
+	info.subresourceRange.layerCount = tex->mCubeMap ? 6 : 1;
+
+	VkImageView view;
+	if (vkCreateImageView(mVk->device(), &info, NULL, &view) != VK_SUCCESS)
+		return false;
+
+	// Frames recorded so far may still use the old view
+	if (tex->mTexture.view != VK_NULL_HANDLE) {
+		RetiredView retired;
+		retired.view = tex->mTexture.view;
+		retired.serial = mVk->currentSubmissionSerial();
+		mRetiredViews.push_back(retired);
+	}
+
+	tex->mTexture.view = view;
+	tex->mViewVersion++;
+
+	return true;
+}
+
+void NvVkTextureStreamer::releaseSource(NvVkStreamingTexture* tex)
+{
+	delete tex->mImage;
+	tex->mImage = NULL;
+
+	if (tex->mFileData) {
+		NvAssetLoaderFree(tex->mFileData);
+		tex->mFileData = NULL;
+	}
+}
+
+void NvVkTextureStreamer::releaseTexture(NvVkStreamingTexture* tex)
+{
+	if (tex->mTexture.view != VK_NULL_HANDLE)
+		vkDestroyImageView(mVk->device(), tex->mTexture.view, NULL);
+	mVk->destroyImage(tex->mTexture.image);
+
+	delete tex;
+}
+
+uint32_t NvVkTextureStreamer::levelBytes(const NvVkStreamingTexture* tex, uint32_t level) const
+{
+	return tex->mImage->getImageSize(level) * (tex->mCubeMap ? 6 : 1);
+}
@@ -0,0 +1,267 @@
+//----------------------------------------------------------------------------------
+// File:        AssetTools/AssetTools.cpp
+// SDK Version: v3.00
+// Email:       emmanuel.villagomez@gmail.com
+// Site:        http://www.victoresite.net/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "AssetTools.h"
+#include "NvAssetLoader/NvAssetLoader.h"
+#include "NvModel/NvModel.h"
+#include "NV/NvLogs.h"
+#include <stdarg.h>
+#include <string.h>
+#include <chrono>
+
+// The tools run without the application framework, so they log to the console
+void NVPlatformLog(const char* fmt, ...) {
+	va_list ap;
+
+	va_start(ap, fmt);
+	vfprintf(stdout, fmt, ap);
+	fprintf(stdout, "\n");
+	va_end(ap);
+}
+
+class ChronoStopWatch : public NvStopWatch
+{
+public:
+	ChronoStopWatch() : m_elapsed(0.0) { }
+
+	virtual void start() {
+		m_startTime = std::chrono::steady_clock::now();
+		m_running = true;
+	}
+
+	virtual void stop() {
+		m_elapsed += secondsSinceStart();
+		m_running = false;
+	}
+
+	virtual void reset() {
+		m_elapsed = 0.0;
+		if (m_running)
+			m_startTime = std::chrono::steady_clock::now();
+	}
+
+	virtual const float getTime() const {
+		return (float)(m_running ? (m_elapsed + secondsSinceStart()) : m_elapsed);
+	}
+
+private:
+	double secondsSinceStart() const {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+	}
+
+	std::chrono::steady_clock::time_point m_startTime;
+	double m_elapsed;
+};
+
+const char* g_textureNames[] = {
+	"textures/nvidia_logo.dds",
+	"textures/windmill_diffuse.dds"
+};
+
+const uint32_t g_textureCount = ARRAY_SIZE(g_textureNames);
+
+NvStopWatch* createStopWatch()
+{
+	return new ChronoStopWatch;
+}
+
+NvModel* loadDragon()
+{
+	int32_t length;
+	char* modelData = NvAssetLoaderRead("models/dragon.nvm", length);
+	if (!modelData)
+		return NULL;
+	NvModel* dragon = NvModel::CreateFromPreprocessed((uint8_t*)modelData);
+	NvAssetLoaderFree(modelData);
+	return dragon;
+}
+
+char* MemoryObjLoader::LoadDataFromFile(const char* fileName)
+{
+	char* data = new char[mText.size() + 1];
+	memcpy(data, mText.c_str(), mText.size() + 1);
+	return data;
+}
+
+void buildObjText(const NvModel& model, uint32_t copies, std::string& text)
+{
+	const float* verts = model.getCompiledVertices();
+	int32_t vertSize = model.getCompiledVertexSize();
+	int32_t vertCount = model.getCompiledVertexCount();
+	int32_t posOffset = model.getCompiledPositionOffset();
+	int32_t normalOffset = model.getCompiledNormalOffset();
+	NvModelPrimType::Enum prim;
+	const uint32_t* indices = model.getCompiledIndices(prim);
+	int32_t indexCount = model.getCompiledIndexCount(prim);
+
+	float minY = 0.0f;
+	float maxY = 0.0f;
+	for (int32_t i = 0; i < vertCount; i++) {
+		float y = verts[i * vertSize + posOffset + 1];
+		minY = (i == 0 || y < minY) ? y : minY;
+		maxY = (i == 0 || y > maxY) ? y : maxY;
+	}
+
+	char line[128];
+	text.clear();
+	for (uint32_t copy = 0; copy < copies; copy++) {
+		float offsetY = copy * (maxY - minY);
+		for (int32_t i = 0; i < vertCount; i++) {
+			const float* v = verts + i * vertSize;
+			sprintf(line, "v %f %f %f\n", v[posOffset], v[posOffset + 1] + offsetY, v[posOffset + 2]);
+			text += line;
+			if (normalOffset >= 0) {
+				nv::vec3f n = normalize(nv::vec3f(v[normalOffset], v[normalOffset + 1], v[normalOffset + 2]));
+				sprintf(line, "vn %f %f %f\n", n.x, n.y, n.z);
+				text += line;
+			}
+		}
+
+		uint32_t base = copy * vertCount + 1;
+		for (int32_t i = 0; i + 2 < indexCount; i += 3) {
+			uint32_t a = indices[i] + base;
+			uint32_t b = indices[i + 1] + base;
+			uint32_t c = indices[i + 2] + base;
+			if (normalOffset >= 0)
+				sprintf(line, "f %u//%u %u//%u %u//%u\n", a, a, b, b, c, c);
+			else
+				sprintf(line, "f %u %u %u\n", a, b, c);
+			text += line;
+		}
+	}
+}
+
+void readBackFile(FILE* fp, std::vector<uint8_t>& bytes)
+{
+	bytes.resize(ftell(fp));
+	rewind(fp);
+	if (!bytes.empty() && fread(&bytes[0], 1, bytes.size(), fp) != bytes.size())
+		bytes.clear();
+}
+
+bool samePreprocessedModels(Nv::NvModelExt* a, Nv::NvModelExt* b)
+{
+	FILE* files[2] = { tmpfile(), tmpfile() };
+	bool same = false;
+	if (files[0] && files[1] && a->WritePreprocessedModel(files[0]) && b->WritePreprocessedModel(files[1])) {
+		std::vector<uint8_t> bytes[2];
+		readBackFile(files[0], bytes[0]);
+		readBackFile(files[1], bytes[1]);
+		same = !bytes[0].empty() && bytes[0] == bytes[1];
+	}
+	for (int32_t i = 0; i < 2; i++) {
+		if (files[i])
+			fclose(files[i]);
+	}
+	return same;
+}
+
+struct Benchmark {
+	const char* flag;
+	void (*run)();
+};
+
+// Flags may name several benchmarks, which run in the order listed
+static const Benchmark s_benchmarks[] = {
+	{ "-dxtbench", benchmarkDXTExpansion },
+	{ "-dxtbench", benchmarkDXTCompression },
+	{ "-flipbench", benchmarkSurfaceTransforms },
+	{ "-halfbench", benchmarkHalfConversion },
+	{ "-weldbench", benchmarkVertexWelding },
+	{ "-objbench", benchmarkObjLoading },
+	{ "-tokenbench", benchmarkNumberParsing },
+	{ "-meshbench", benchmarkMeshOptimization },
+	{ "-packbench", benchmarkVertexPacking }
+};
+
+static void printUsage(const char* program)
+{
+	LOGI("Usage: %s [-compress [file ...]] [-bptccheck] [-all]", program);
+	const char* previous = NULL;
+	for (uint32_t i = 0; i < ARRAY_SIZE(s_benchmarks); i++) {
+		if (!previous || strcmp(previous, s_benchmarks[i].flag))
+			LOGI("       [%s]", s_benchmarks[i].flag);
+		previous = s_benchmarks[i].flag;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	NvAssetLoaderInit(NULL);
+
+	// The benchmarks build their inputs from the sample's assets, and the
+	// compressor falls back to them for names that are not paths
+	NvAssetLoaderAddSearchPath("LoadingAssets");
+
+	if (argc < 2) {
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	for (int32_t arg = 1; arg < argc; arg++) {
+		if (!strcmp(argv[arg], "-compress")) {
+			std::vector<std::string> names;
+			while (arg + 1 < argc && argv[arg + 1][0] != '-')
+				names.push_back(argv[++arg]);
+			if (names.empty())
+				names.assign(g_textureNames, g_textureNames + g_textureCount);
+			if (!compressTextures(names))
+				return 1;
+			continue;
+		}
+
+		if (!strcmp(argv[arg], "-bptccheck")) {
+			if (!checkBPTCDecoding())
+				return 1;
+			continue;
+		}
+
+		bool all = !strcmp(argv[arg], "-all");
+		bool found = false;
+		for (uint32_t i = 0; i < ARRAY_SIZE(s_benchmarks); i++) {
+			if (all || !strcmp(argv[arg], s_benchmarks[i].flag)) {
+				s_benchmarks[i].run();
+				found = true;
+			}
+		}
+
+		if (!found) {
+			LOGI("Unknown option %s", argv[arg]);
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	NvAssetLoaderShutdown();
+	return 0;
+}
@@ -0,0 +1,160 @@
+//----------------------------------------------------------------------------------
+// File:        AssetTools/AssetTools.h
+// SDK Version: v3.00
+// Email:       emmanuel.villagomez@gmail.com
+// Site:        http://www.victoresite.net/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#ifndef ASSET_TOOLS_H
+#define ASSET_TOOLS_H
+
+#include <NvSimpleTypes.h>
+#include "NV/NvStopWatch.h"
+#include "NvModel/NvModelExt.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/// \file
+/// The shared harness of the asset tools: the offline texture compressor, and
+/// the benchmarks with the stand-in inputs they build from the LoadingAssets
+/// sample's assets and the checks they share
+
+#define ARRAY_SIZE(a) ( sizeof(a) / sizeof( (a)[0] ))
+
+class NvModel;
+
+/// The sample's textures, which the DXT benchmarks use and the compressor
+/// compresses unless given others
+extern const char* g_textureNames[];
+
+/// The number of names in #g_textureNames
+extern const uint32_t g_textureCount;
+
+/// Creates a wall-clock timer; delete it when done
+NvStopWatch* createStopWatch();
+
+/// Loads the sample's dragon, whose compiled meshes the model benchmarks
+/// write out as OBJ data
+/// \return the model, or NULL if it could not be loaded; delete it when done
+NvModel* loadDragon();
+
+/// Serves OBJ data held in memory to the model importer, whatever file it asks for
+class MemoryObjLoader : public Nv::NvModelFileLoader
+{
+public:
+	MemoryObjLoader(const std::string& text) : mText(text) {}
+
+	virtual char* LoadDataFromFile(const char* fileName);
+	virtual void ReleaseData(char* pData) { delete[] pData; }
+
+private:
+	const std::string& mText;
+};
+
+/// Writes the model's compiled triangles as OBJ data, repeated the given number of
+/// times with each copy stacked above the last.  Compiled vertices split wherever
+/// the normals do, so the positions hold the duplicates that welding removes.
+/// Normals are written at unit length, as exporters write them.
+/// \param[in] model the model to write
+/// \param[in] copies the number of copies to stack
+/// \param[out] text the OBJ data
+void buildObjText(const NvModel& model, uint32_t copies, std::string& text);
+
+/// Reads back everything written to the file
+/// \param[in] fp a file open for update, positioned at its end
+/// \param[out] bytes the file's contents, or nothing if it could not be read
+void readBackFile(FILE* fp, std::vector<uint8_t>& bytes);
+
+/// Returns true if both models write the same preprocessed model file
+bool samePreprocessedModels(Nv::NvModelExt* a, Nv::NvModelExt* b);
+
+/// Writes block-compressed copies of DDS textures to the working directory as
+/// an offline preprocessing step: name.dds becomes name_bc3.dds if it has
+/// alpha and name_bc1.dds if not; run with -compress [file ...]
+/// \param[in] names the textures' paths, or their paths in the assets tree
+/// \return true if every texture was compressed and written
+bool compressTextures(const std::vector<std::string>& names);
+
+/// Expands known-answer blocks of every BC7 mode and every BC6H mode, both
+/// unsigned and signed, through NvImage and checks every texel; run with
+/// -bptccheck
+/// \return true if every block decoded as expected
+bool checkBPTCDecoding();
+
+/// Times DXT expansion of block-compressed stand-ins for the sample's
+/// textures by NvImage's row decoder against a reference block decoder, and
+/// checks that both decode the same texels; run with -dxtbench
+void benchmarkDXTExpansion();
+
+/// Times compression of the sample's textures to BC1/3/4/5 in fast and
+/// quality modes and reports the PSNR of each; run with -dxtbench
+void benchmarkDXTCompression();
+
+/// Times loading synthetic textures of every format NvImage flips with a
+/// plain copy and with its fused single pass flip and swap, both copied and
+/// in place, against a reference that flips and swaps the copy one pass at
+/// a time, and checks that both give the same data; run with -flipbench
+void benchmarkSurfaceTransforms();
+
+/// Times loading a synthetic RGBA32F texture as floats and converted to
+/// half floats, and the conversion back, against converting one value at a
+/// time with the scalar conversions; checks that both give the same values
+/// and reports the error of the round trip; run with -halfbench
+void benchmarkHalfConversion();
+
+/// Times welding the positions and normals of the dragon, and of a tall
+/// stack of copies of it, with the OBJ importer's hashed grid against the
+/// original search of the vertices sorted along x, and checks that both
+/// weld the same vertices; run with -weldbench
+void benchmarkVertexWelding();
+
+/// Times importing the dragon, and stacks of copies of it, as OBJ data in a
+/// single pass and in chunks parsed on several threads, and checks that
+/// both write the same preprocessed model; run with -objbench
+void benchmarkObjLoading();
+
+/// Times reading the numbers of the dragon, and of a stack of copies of
+/// it, written as OBJ data with the tokenizer against copying each token
+/// and converting it with strtod, and checks that both read the same
+/// values; run with -tokenbench
+void benchmarkNumberParsing();
+
+/// Imports the dragon as OBJ data as it is, reordered for the vertex cache
+/// and also reordered for overdraw, and reports each mesh's ACMR and ATVR
+/// with the import time; run with -meshbench
+void benchmarkMeshOptimization();
+
+/// Writes the dragon, imported as OBJ data, as preprocessed models with
+/// float and with packed vertices, loads both back and reports their
+/// vertex and index sizes, normal error, file size and load time; run
+/// with -packbench
+void benchmarkVertexPacking();
+
+#endif
@@ -0,0 +1,426 @@
+//----------------------------------------------------------------------------------
+// File:        AssetTools/BPTCCheck.cpp
+// SDK Version: v3.00
+// Email:       emmanuel.villagomez@gmail.com
+// Site:        http://www.victoresite.net/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "AssetTools.h"
+#include "NvImage/NvImage.h"
+#include "NV/NvLogs.h"
+#include <string.h>
+
+// Known-answer vectors for the BC7 and BC6H decoders NvImage expands with.
+// The BC7 texels match Pillow's decoder exactly, but for the reserved mode,
+// which decodes to transparent black as D3D specifies.  Pillow only decodes
+// BC6H to 8 bits, which the BC6H_UF16 halves agree with to within a step.
+// Its signed interpolation departs from the D3D specification, so the
+// BC6H_SF16 halves are this decoder's, with its signed unquantization and
+// rounding checked against the specification.
+
+struct BC7Vector {
+	const char* name;
+	uint8_t block[16];
+	uint32_t texels[16];
+};
+
+struct BC6HVector {
+	const char* name;
+	uint8_t block[16];
+	uint16_t texels[48];
+};
+
+// One block of each BC7 mode, then one of the reserved mode, with the texels
+// each decodes to as Color32 (red in the low byte)
+static const BC7Vector s_bc7Vectors[] = {
+	{ "mode 0",
+		{ 0x63, 0xbb, 0xd8, 0xc5, 0x2f, 0xc7, 0x8d, 0xca, 0xa0, 0xb7, 0xe3, 0x22, 0xf4, 0x9b, 0x22, 0xbf },
+		{ 0xff4aefbd, 0xff5273d6, 0xff4cccc4, 0xff6b9c5a,
+		  0xff4bdec1, 0xff4fa7cb, 0xff1647be, 0xff0839ce,
+		  0xffd8dbd2, 0xffcdb498, 0xff4f807b, 0xff5d8e6a,
+		  0xffd2c8b5, 0xffbb773e, 0xffb56321, 0xff2455ad } },
+	{ "mode 1",
+		{ 0xf6, 0xc9, 0xf7, 0xdc, 0xb9, 0x1a, 0x15, 0x91, 0x3e, 0x97, 0x68, 0xcd, 0x06, 0xa0, 0x38, 0xe4 },
+		{ 0xff72d43d, 0xffd2b170, 0xffbd3769, 0xff9d1bc6,
+		  0xffa3c257, 0xffbbba63, 0xffc53d53, 0xffcd443c,
+		  0xffcd443c, 0xffad2899, 0xffbd3769, 0xffad2899,
+		  0xff8acc49, 0xff44e524, 0xff5bdd30, 0xffe9a97c } },
+	{ "mode 2",
+		{ 0xe4, 0x2a, 0x74, 0x55, 0xa0, 0xe7, 0x55, 0x2b, 0x3c, 0x1a, 0x91, 0x63, 0x9c, 0xdf, 0x90, 0xd2 },
+		{ 0xff6ea4a0, 0xff6ea4a0, 0xff8ca932, 0xff8ce742,
+		  0xffce6bad, 0xff4e5a86, 0xff31f784, 0xff8c2910,
+		  0xff105273, 0xff90639a, 0xff8c7bad, 0xff8c6720,
+		  0xff6ea4a0, 0xff4fce91, 0xff8ca932, 0xff8c6720 } },
+	{ "mode 3",
+		{ 0xe8, 0x2c, 0x1e, 0x0b, 0x66, 0x2b, 0xe0, 0xa5, 0xca, 0x03, 0xa0, 0xea, 0x67, 0x7f, 0xc4, 0x40 },
+		{ 0xff9b3e1a, 0xffe55b17, 0xff03031f, 0xff4d201c,
+		  0xffaba999, 0xffaba999, 0xffaba999, 0xff41bd17,
+		  0xff88b06e, 0xff41bd17, 0xff88b06e, 0xff64b642,
+		  0xff41bd17, 0xff41bd17, 0xff88b06e, 0xff41bd17 } },
+	{ "mode 4",
+		{ 0xb0, 0x18, 0xbf, 0xd1, 0x5a, 0x38, 0x1e, 0x4d, 0x62, 0x7c, 0x6f, 0xa6, 0x52, 0xb1, 0x80, 0xf0 },
+		{ 0xc66b5189, 0xc66b348e, 0xc66b6d86, 0xc66b518b,
+		  0xc66b5f8b, 0xc66b3489, 0xc66b428b, 0xc66b5f86,
+		  0xc66b6d89, 0xc66b2686, 0xc66b5f8e, 0xc66b7b86,
+		  0xc66b7b8b, 0xc66b6d8e, 0xc66b428e, 0xc66b188b } },
+	{ "mode 5",
+		{ 0xe0, 0x72, 0x12, 0x29, 0x9c, 0x12, 0x8e, 0x4f, 0xa9, 0xdf, 0x05, 0xf4, 0x22, 0x69, 0xcb, 0xf1 },
+		{ 0x52b448e5, 0x63e370b1, 0x638270b1, 0x85e3c348,
+		  0x85b4c348, 0x8582c348, 0x74829b7c, 0x85b4c348,
+		  0x74539b7c, 0x528248e5, 0x52e348e5, 0x525348e5,
+		  0x74b49b7c, 0x74e39b7c, 0x8553c348, 0x635370b1 } },
+	{ "mode 6",
+		{ 0xc0, 0x95, 0x1a, 0x83, 0xf8, 0xcc, 0x56, 0xe5, 0x0a, 0x36, 0x1e, 0x4f, 0x7d, 0xb4, 0x82, 0x7a },
+		{ 0x7d4c2680, 0x573f3157, 0x864f248a, 0x6e472a70,
+		  0xc36412cc, 0x5e412f5f, 0xca6610d4, 0x76492878,
+		  0xba6115c2, 0x8d512292, 0x76492878, 0xab5c19b3,
+		  0x67442c69, 0x94541f99, 0xa4591bab, 0x8d512292 } },
+	{ "mode 7",
+		{ 0x80, 0x9b, 0x42, 0xe8, 0xef, 0x0f, 0xcf, 0x10, 0x08, 0x08, 0x58, 0x3f, 0xff, 0x9f, 0xa4, 0x72 },
+		{ 0x3515e64c, 0x8210fb41, 0xc9306e82, 0xff043cff,
+		  0x8210fb41, 0xff043cff, 0xc9306e82, 0x5d13f146,
+		  0x1018db51, 0xc9306e82, 0xe41954c2, 0x5d13f146,
+		  0xe41954c2, 0xae458645, 0x8210fb41, 0x3515e64c } },
+	{ "reserved",
+		{ 0x00, 0x9a, 0x7f, 0x39, 0x5c, 0xe7, 0xbf, 0xf4, 0x2e, 0x9d, 0x6d, 0x2c, 0x96, 0x53, 0x8f, 0x85 },
+		{ 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+		  0x00000000, 0x00000000, 0x00000000, 0x00000000,
+		  0x00000000, 0x00000000, 0x00000000, 0x00000000,
+		  0x00000000, 0x00000000, 0x00000000, 0x00000000 } }
+};
+
+// One BC6H_UF16 block of each BC6H mode, numbered as in the D3D specification,
+// then one of a reserved mode, with the red, green and blue halves each
+// texel decodes to
+static const BC6HVector s_bc6hUnsignedVectors[] = {
+	{ "mode 1",
+		{ 0xd4, 0x38, 0xd4, 0xea, 0xfa, 0xab, 0x3f, 0x39, 0x50, 0xa6, 0x61, 0x3c, 0xe3, 0xf3, 0x29, 0x04 },
+		{ 0x3709, 0x3367, 0x2d3a, 0x36ee, 0x3317, 0x2bc5, 0x3709, 0x3367, 0x2d3a, 0x36ea, 0x330a, 0x2b88,
+		  0x3705, 0x335a, 0x2cfd, 0x36fc, 0x3340, 0x2c83, 0x36f7, 0x3331, 0x2c3f, 0x36ea, 0x330a, 0x2b88,
+		  0x3812, 0x321b, 0x2d2d, 0x387d, 0x3250, 0x2c23, 0x3835, 0x322c, 0x2cd6, 0x3824, 0x3223, 0x2d02,
+		  0x3812, 0x321b, 0x2d2d, 0x3849, 0x3236, 0x2ca6, 0x3801, 0x3212, 0x2d59, 0x3801, 0x3212, 0x2d59 } },
+	{ "mode 2",
+		{ 0x5d, 0x15, 0xde, 0x5f, 0x38, 0xb6, 0x1d, 0xdf, 0xc0, 0x84, 0x16, 0x14, 0xfe, 0xb7, 0x50, 0xd3 },
+		{ 0x2a20, 0x3805, 0x2dbe, 0x2a20, 0x3805, 0x2dbe, 0x0a2c, 0x35c4, 0x14d4, 0x1557, 0x3396, 0x1d46,
+		  0x2a20, 0x3805, 0x2dbe, 0x2d17, 0x2ff7, 0x2ce5, 0x2ff4, 0x2834, 0x2c14, 0x31e4, 0x2e04, 0x32dc,
+		  0x2ff4, 0x2834, 0x2c14, 0x2eff, 0x2aca, 0x2c59, 0x2b14, 0x356e, 0x2d78, 0x292c, 0x3a9c, 0x2e04,
+		  0x2e0b, 0x2d61, 0x2c9f, 0x2eff, 0x2aca, 0x2c59, 0x2d17, 0x2ff7, 0x2ce5, 0x2eff, 0x2aca, 0x2c59 } },
+	{ "mode 3",
+		{ 0xc2, 0x60, 0x97, 0xf1, 0x16, 0x94, 0xfc, 0xf4, 0x71, 0xe3, 0x9d, 0xa0, 0xa7, 0x1e, 0x49, 0x6f },
+		{ 0x2ef1, 0x316a, 0x359e, 0x2ee9, 0x3159, 0x35bc, 0x2ee9, 0x3159, 0x35bc, 0x2ee4, 0x3150, 0x35cb,
+		  0x2efb, 0x317d, 0x357d, 0x2f03, 0x318e, 0x355f, 0x2ef6, 0x3174, 0x358d, 0x2eed, 0x3162, 0x35ad,
+		  0x2f03, 0x318e, 0x355f, 0x2ee9, 0x3159, 0x35bc, 0x2eed, 0x3162, 0x35ad, 0x2eed, 0x3162, 0x35ad,
+		  0x2ea5, 0x3109, 0x35df, 0x2f41, 0x3141, 0x3638, 0x2f04, 0x312b, 0x3615, 0x2e87, 0x30fe, 0x35cd } },
+	{ "mode 4",
+		{ 0xe6, 0xec, 0xbb, 0x85, 0x75, 0x1c, 0x13, 0x51, 0xce, 0x7e, 0x2e, 0x6b, 0x1d, 0x63, 0xff, 0x1a },
+		{ 0x34b7, 0x3587, 0x2ad3, 0x3505, 0x35ae, 0x2ad4, 0x3505, 0x35ae, 0x2ad4, 0x34c1, 0x35c9, 0x2ab9,
+		  0x34a9, 0x3551, 0x2ae1, 0x34bb, 0x3599, 0x2acf, 0x3495, 0x35db, 0x2aa7, 0x3530, 0x359d, 0x2ae5,
+		  0x34b7, 0x3587, 0x2ad3, 0x34b2, 0x3574, 0x2ad8, 0x34ad, 0x3563, 0x2add, 0x3495, 0x35db, 0x2aa7,
+		  0x34a5, 0x3540, 0x2ae5, 0x34ad, 0x3563, 0x2add, 0x34a9, 0x3551, 0x2ae1, 0x34c4, 0x35bc, 0x2ac6 } },
+	{ "mode 5",
+		{ 0x4a, 0xef, 0x74, 0x09, 0x57, 0xc3, 0xa9, 0x0b, 0xef, 0xdf, 0xcb, 0xc9, 0xf2, 0x86, 0xc5, 0xe0 },
+		{ 0x35d0, 0x2d1a, 0x365e, 0x360f, 0x2d56, 0x363f, 0x3622, 0x2d4c, 0x3630, 0x360f, 0x2d56, 0x363f,
+		  0x35b4, 0x2d11, 0x3635, 0x35a7, 0x2d0c, 0x3621, 0x35b4, 0x2d11, 0x3635, 0x35db, 0x2d70, 0x3666,
+		  0x35ec, 0x2d68, 0x3659, 0x35ea, 0x2d23, 0x3685, 0x359a, 0x2d08, 0x360e, 0x35d0, 0x2d1a, 0x365e,
+		  0x360f, 0x2d56, 0x363f, 0x3645, 0x2d3b, 0x3616, 0x3657, 0x2d32, 0x3609, 0x358d, 0x2d04, 0x35fa } },
+	{ "mode 6",
+		{ 0x8e, 0x9a, 0x5c, 0x5a, 0x91, 0x49, 0xef, 0xf1, 0x6d, 0x17, 0x91, 0xde, 0x0d, 0xb7, 0x68, 0xe9 },
+		{ 0x3377, 0x2ced, 0x2a05, 0x32fc, 0x2cb8, 0x2a1f, 0x3107, 0x2be1, 0x2a8a, 0x3013, 0x2b79, 0x2abf,
+		  0x308d, 0x2bad, 0x2aa4, 0x3107, 0x2be1, 0x2a8a, 0x32fc, 0x2cb8, 0x2a1f, 0x3181, 0x2c15, 0x2a70,
+		  0x3208, 0x2c50, 0x2a53, 0x3208, 0x2c50, 0x2a53, 0x32fc, 0x2cb8, 0x2a1f, 0x32ad, 0x2d6a, 0x2da7,
+		  0x3208, 0x2c50, 0x2a53, 0x32fc, 0x2cb8, 0x2a1f, 0x3538, 0x2cad, 0x2da7, 0x337e, 0x2d2d, 0x2da7 } },
+	{ "mode 7",
+		{ 0x52, 0x6c, 0x3d, 0xe4, 0xd6, 0xc0, 0x0f, 0x28, 0xad, 0xc8, 0x36, 0x8b, 0x14, 0x50, 0x3c, 0x19 },
+		{ 0x317b, 0x3b33, 0x365f, 0x3506, 0x3aed, 0x3431, 0x3a88, 0x3a80, 0x30cd, 0x3340, 0x3b10, 0x3548,
+		  0x36fd, 0x3ac6, 0x32fb, 0x36fd, 0x3ac6, 0x32fb, 0x3340, 0x3b10, 0x3548, 0x2fb6, 0x3b56, 0x3776,
+		  0x3a5e, 0x3b56, 0x3412, 0x3340, 0x3b10, 0x3548, 0x317b, 0x3b33, 0x365f, 0x3a88, 0x3a80, 0x30cd,
+		  0x3958, 0x3845, 0x3412, 0x39af, 0x394a, 0x3412, 0x3a88, 0x3a80, 0x30cd, 0x2fb6, 0x3b56, 0x3776 } },
+	{ "mode 8",
+		{ 0x76, 0x2e, 0x31, 0xc1, 0x8c, 0x48, 0xd0, 0xab, 0xc0, 0x03, 0x76, 0x94, 0x84, 0xcb, 0xd4, 0xf1 },
+		{ 0x36ec, 0x2fd8, 0x2e21, 0x30ae, 0x30ae, 0x2a62, 0x37f2, 0x2fb6, 0x2ebe, 0x32b9, 0x3068, 0x2b9b,
+		  0x39e7, 0x3699, 0x2caf, 0x33be, 0x3045, 0x2c38, 0x37f2, 0x2fb6, 0x2ebe, 0x31b3, 0x308b, 0x2afe,
+		  0x3a61, 0x35ea, 0x2b98, 0x39e7, 0x3699, 0x2caf, 0x386c, 0x38b7, 0x3013, 0x32b9, 0x3068, 0x2b9b,
+		  0x3adb, 0x353c, 0x2a81, 0x386c, 0x38b7, 0x3013, 0x3adb, 0x353c, 0x2a81, 0x3960, 0x375a, 0x2de5 } },
+	{ "mode 9",
+		{ 0x9a, 0x4c, 0x3b, 0xb4, 0x48, 0x09, 0x60, 0x4a, 0x3a, 0xa0, 0xff, 0x01, 0x0e, 0x27, 0xe3, 0x80 },
+		{ 0x3284, 0x3966, 0x2fec, 0x350a, 0x3966, 0x3586, 0x3284, 0x3966, 0x2fec, 0x30ae, 0x3966, 0x2bd6,
+		  0x2f3a, 0x3b56, 0x348e, 0x3079, 0x3801, 0x2d0f, 0x2f6e, 0x3aca, 0x3354, 0x3011, 0x3918, 0x2f83,
+		  0x2fd6, 0x39b3, 0x30e0, 0x3011, 0x3918, 0x2f83, 0x3011, 0x3918, 0x2f83, 0x2f6e, 0x3aca, 0x3354,
+		  0x346d, 0x3966, 0x3429, 0x314a, 0x3966, 0x2d32, 0x30ae, 0x3966, 0x2bd6, 0x3333, 0x3966, 0x316f } },
+	{ "mode 10",
+		{ 0xde, 0xa3, 0xc9, 0x9c, 0xd8, 0xde, 0x8b, 0x2c, 0x1e, 0xc6, 0x9b, 0xc3, 0xb0, 0xf2, 0x5b, 0xb0 },
+		{ 0x3975, 0x2bc6, 0x2216, 0x1d36, 0x22ef, 0x398c, 0x1b94, 0x2cbe, 0x2ad6, 0x1d36, 0x22ef, 0x398c,
+		  0x37bb, 0x321a, 0x286a, 0x3a46, 0x28c7, 0x1f17, 0x37bb, 0x321a, 0x286a, 0x19da, 0x3719, 0x1b4e,
+		  0x1c65, 0x27d7, 0x3231, 0x3619, 0x3818, 0x2e68, 0x3548, 0x3b18, 0x3168, 0x36ea, 0x3519, 0x2b69,
+		  0x19da, 0x3719, 0x1b4e, 0x1e08, 0x1e08, 0x40e8, 0x1aab, 0x3231, 0x22a9, 0x36ea, 0x3519, 0x2b69 } },
+	{ "mode 11",
+		{ 0xe3, 0x2b, 0x42, 0x0a, 0xa3, 0xad, 0xc9, 0x14, 0x27, 0x18, 0xa0, 0x31, 0xb9, 0x36, 0x43, 0x30 },
+		{ 0x2ca7, 0x1b49, 0x3333, 0x2c03, 0x17d3, 0x31f5, 0x3008, 0x2d71, 0x39b7, 0x2b35, 0x1380, 0x3068,
+		  0x2a90, 0x100b, 0x2f2a, 0x317a, 0x3539, 0x3c82, 0x2b35, 0x1380, 0x3068, 0x2ca7, 0x1b49, 0x3333,
+		  0x30ad, 0x30e7, 0x3af5, 0x321f, 0x38af, 0x3dc0, 0x2ebe, 0x2686, 0x373b, 0x2ca7, 0x1b49, 0x3333,
+		  0x2ca7, 0x1b49, 0x3333, 0x2d4c, 0x1ebe, 0x3470, 0x2a90, 0x100b, 0x2f2a, 0x2ca7, 0x1b49, 0x3333 } },
+	{ "mode 12",
+		{ 0x87, 0x56, 0x9f, 0xdb, 0xc5, 0x25, 0x39, 0x14, 0x4a, 0x21, 0xa9, 0x3a, 0x1d, 0x57, 0xfc, 0xfb },
+		{ 0x2d95, 0x3131, 0x2e2c, 0x2ce3, 0x3166, 0x2e05, 0x2aa0, 0x3213, 0x2d88, 0x2b7e, 0x31d1, 0x2db8,
+		  0x308b, 0x304e, 0x2ed1, 0x3169, 0x300c, 0x2f01, 0x3169, 0x300c, 0x2f01, 0x2c31, 0x319b, 0x2ddf,
+		  0x3380, 0x2f6c, 0x2f76, 0x2aa0, 0x3213, 0x2d88, 0x2f26, 0x30b9, 0x2e83, 0x2d95, 0x3131, 0x2e2c,
+		  0x32ce, 0x2fa1, 0x2f4f, 0x3511, 0x2ef4, 0x2fcd, 0x321c, 0x2fd6, 0x2f28, 0x3511, 0x2ef4, 0x2fcd } },
+	{ "mode 13",
+		{ 0x2b, 0x53, 0x5f, 0x6f, 0xbb, 0x91, 0xdd, 0x08, 0xef, 0x1b, 0xd4, 0x83, 0xda, 0xf9, 0x13, 0x0c },
+		{ 0x33ed, 0x33fb, 0x2c8c, 0x34b5, 0x33b3, 0x2cc9, 0x345e, 0x33d2, 0x2caf, 0x3340, 0x343a, 0x2c56,
+		  0x3396, 0x341b, 0x2c71, 0x3493, 0x33bf, 0x2cbf, 0x337c, 0x3424, 0x2c68, 0x3408, 0x33f2, 0x2c94,
+		  0x3443, 0x33dc, 0x2ca6, 0x3493, 0x33bf, 0x2cbf, 0x3422, 0x33e8, 0x2c9c, 0x34cf, 0x33a9, 0x2cd1,
+		  0x337c, 0x3424, 0x2c68, 0x3340, 0x343a, 0x2c56, 0x3479, 0x33c8, 0x2cb7, 0x3325, 0x3444, 0x2c4e } },
+	{ "mode 14",
+		{ 0x8f, 0xf2, 0x42, 0x1c, 0x38, 0x3b, 0xcd, 0x71, 0x6a, 0xab, 0x3f, 0x77, 0x5f, 0x45, 0x12, 0x26 },
+		{ 0x360c, 0x30af, 0x3647, 0x360d, 0x30ae, 0x3647, 0x360e, 0x30ae, 0x3647, 0x360e, 0x30ae, 0x3647,
+		  0x360f, 0x30ad, 0x3648, 0x360c, 0x30af, 0x3647, 0x360d, 0x30ae, 0x3647, 0x360d, 0x30ae, 0x3647,
+		  0x360f, 0x30ad, 0x3648, 0x360c, 0x30af, 0x3647, 0x360c, 0x30af, 0x3647, 0x360c, 0x30af, 0x3647,
+		  0x360c, 0x30af, 0x3646, 0x360b, 0x30b0, 0x3646, 0x360d, 0x30ae, 0x3647, 0x360c, 0x30af, 0x3646 } },
+	{ "reserved",
+		{ 0x73, 0x29, 0x54, 0x62, 0x8f, 0xcb, 0x3f, 0x0f, 0x38, 0x2a, 0xbe, 0xf6, 0x47, 0x72, 0x83, 0x82 },
+		{ 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 } }
+};
+
+// One BC6H_SF16 block of each BC6H mode, numbered as in the D3D specification,
+// then one of a reserved mode, with the red, green and blue halves each
+// texel decodes to
+static const BC6HVector s_bc6hSignedVectors[] = {
+	{ "mode 1",
+		{ 0x28, 0x0f, 0x8e, 0xb7, 0x99, 0x75, 0x3c, 0x7d, 0xbf, 0xb4, 0x26, 0x78, 0x29, 0x93, 0x76, 0x6b },
+		{ 0x1cfb, 0xb73c, 0x34f4, 0x1c8a, 0xb722, 0x34c0, 0x1d6d, 0xb757, 0x3529, 0x1ab8, 0xb6b7, 0x33e9,
+		  0x1e34, 0xb6db, 0x3595, 0x1cfb, 0xb73c, 0x34f4, 0x1b29, 0xb6d1, 0x341d, 0x1b9b, 0xb6eb, 0x3451,
+		  0x1d86, 0xb590, 0x347e, 0x1ddd, 0xb636, 0x350a, 0x1c8a, 0xb722, 0x34c0, 0x1c18, 0xb708, 0x348c,
+		  0x1f9b, 0xb985, 0x37d3, 0x1f43, 0xb8df, 0x3747, 0x1ddd, 0xb636, 0x350a, 0x1c18, 0xb708, 0x348c } },
+	{ "mode 2",
+		{ 0x0d, 0xde, 0xf5, 0x30, 0x05, 0xdf, 0x8e, 0xbf, 0xac, 0x58, 0x2a, 0xa1, 0xb4, 0xdc, 0x45, 0x7e },
+		{ 0xb168, 0xaf1b, 0x2eec, 0xb168, 0xaf1b, 0x2eec, 0xb168, 0xaf1b, 0x2eec, 0x9ff8, 0xa9a8, 0x2f78,
+		  0xcc88, 0xb795, 0x2e13, 0xc3d0, 0xb4db, 0x2e59, 0xd540, 0xba4e, 0x2dcd, 0xb168, 0xaf1b, 0x2eec,
+		  0x881d, 0xb811, 0x2ff4, 0xba20, 0xb1d4, 0x2ea6, 0xddf8, 0xbd08, 0x2d88, 0xb168, 0xaf1b, 0x2eec,
+		  0x9df8, 0xa482, 0x46f6, 0x9df8, 0xa482, 0x46f6, 0xbd08, 0x88b8, 0x67a8, 0xba20, 0xb1d4, 0x2ea6 } },
+	{ "mode 3",
+		{ 0x82, 0x3b, 0x37, 0x49, 0x1f, 0xd2, 0xab, 0xfa, 0x3b, 0xfb, 0x8f, 0x57, 0xfa, 0x24, 0x21, 0xbb },
+		{ 0x39db, 0xb0d7, 0x8af1, 0x39b3, 0xb0bd, 0x8b33, 0x38fb, 0xb0f9, 0x8b93, 0x38fb, 0xb0f9, 0x8b93,
+		  0x38ba, 0xb08b, 0x8bc1, 0x39e9, 0xb0e1, 0x8ad9, 0x3a03, 0xb0f2, 0x8aad, 0x387d, 0xb022, 0x8bed,
+		  0x38d9, 0xb0bf, 0x8bab, 0x39e9, 0xb0e1, 0x8ad9, 0x39e9, 0xb0e1, 0x8ad9, 0x3956, 0xb196, 0x8b52,
+		  0x3919, 0xb12d, 0x8b7e, 0x389c, 0xb056, 0x8bd7, 0x3a03, 0xb0f2, 0x8aad, 0x39f6, 0xb0ea, 0x8ac4 } },
+	{ "mode 4",
+		{ 0x46, 0xc0, 0xdf, 0x24, 0x95, 0x44, 0x83, 0x99, 0x0a, 0x8f, 0x27, 0xb7, 0x5f, 0xb8, 0x4c, 0x02 },
+		{ 0xbdc8, 0x3616, 0xac53, 0xbdc0, 0x35fc, 0xac47, 0xbd9c, 0x3590, 0xac11, 0xbdd2, 0x35b6, 0xac12,
+		  0xbda4, 0x35aa, 0xac1e, 0xbe0f, 0x3630, 0xac23, 0xbd91, 0x3535, 0xabff, 0xbd54, 0x34bb, 0xabee,
+		  0xbd36, 0x347e, 0xabe5, 0xbe0f, 0x3630, 0xac23, 0xbd73, 0x34f8, 0xabf6, 0xbd9c, 0x3590, 0xac11,
+		  0xbdb3, 0x3579, 0xac09, 0xbdad, 0x35c4, 0xac2b, 0xbdd1, 0x3630, 0xac61, 0xbdd1, 0x3630, 0xac61 } },
+	{ "mode 5",
+		{ 0x2a, 0x23, 0x25, 0xff, 0x22, 0x79, 0x2f, 0xaa, 0x04, 0x4d, 0x6b, 0xde, 0xc9, 0x65, 0x9b, 0x07 },
+		{ 0x2239, 0xb545, 0x2e07, 0x217f, 0xb4a5, 0x2cb0, 0x2254, 0xb595, 0x2d1b, 0x2292, 0xb5b4, 0x2cfc,
+		  0x226f, 0xb588, 0x2d65, 0x21eb, 0xb51f, 0x2ce7, 0x220e, 0xb547, 0x2cf8, 0x2281, 0xb59e, 0x2d30,
+		  0x226f, 0xb588, 0x2d65, 0x21c5, 0xb4f3, 0x2cd3, 0x21a2, 0xb4cc, 0x2cc2, 0x226f, 0xb588, 0x2d65,
+		  0x2227, 0xb52e, 0x2e3c, 0x215c, 0xb47e, 0x2c9f, 0x2231, 0xb56d, 0x2d0a, 0x2216, 0xb519, 0x2e70 } },
+	{ "mode 6",
+		{ 0x2e, 0xf3, 0x20, 0xd5, 0x50, 0x2a, 0xde, 0xec, 0xcc, 0x10, 0xb0, 0xb1, 0x56, 0xf4, 0x83, 0xb0 },
+		{ 0xb222, 0x1fba, 0x3396, 0xb016, 0x1ca9, 0x3227, 0xb03f, 0x1ee4, 0x33b8, 0xb0a0, 0x208f, 0x3563,
+		  0xaea6, 0x1a81, 0x3126, 0xadf8, 0x197b, 0x30ac, 0xafe8, 0x1d65, 0x3239, 0xaf91, 0x1be5, 0x30b9,
+		  0xb0c5, 0x1dae, 0x32a1, 0xad4a, 0x1876, 0x3032, 0xb1a6, 0x250e, 0x39e2, 0xaf3a, 0x1a66, 0x2f3a,
+		  0xaf55, 0x1b86, 0x31a0, 0xb222, 0x1fba, 0x3396, 0xb14e, 0x238e, 0x3862, 0xafe8, 0x1d65, 0x3239 } },
+	{ "mode 7",
+		{ 0xf2, 0x90, 0x67, 0x5b, 0x60, 0xb2, 0x90, 0xc0, 0xd2, 0xb0, 0xf9, 0xf0, 0x97, 0xbe, 0x22, 0x88 },
+		{ 0xf26f, 0xae97, 0x2c59, 0xea14, 0xab1c, 0x2d0c, 0xf411, 0xaf45, 0x2c36, 0xeefb, 0xad27, 0x2ca3,
+		  0xea14, 0xab1c, 0x2d0c, 0xea14, 0xab1c, 0x2d0c, 0xf26f, 0xae97, 0x2c59, 0xf26f, 0xae97, 0x2c59,
+		  0x653c, 0xae04, 0x2c14, 0x69b7, 0xb30e, 0x2f70, 0x676a, 0xb077, 0x2db6, 0x6cfc, 0xb6bc, 0x31e4,
+		  0x6be5, 0xb582, 0x3112, 0x6cfc, 0xb6bc, 0x31e4, 0x6be5, 0xb582, 0x3112, 0x6ace, 0xb448, 0x3041 } },
+	{ "mode 8",
+		{ 0xb6, 0xe9, 0xe6, 0x77, 0xe8, 0xca, 0x37, 0x6d, 0xa8, 0xca, 0xdc, 0x6b, 0xb2, 0xa3, 0xd5, 0x59 },
+		{ 0x49da, 0xb2b5, 0x3730, 0x48fd, 0xb348, 0x3576, 0x482c, 0xb3d4, 0x33d4, 0x3fb9, 0xb7ea, 0x30dc,
+		  0x49da, 0xb2b5, 0x3730, 0x4a42, 0xb26f, 0x3801, 0x4049, 0xae64, 0x38b3, 0x4049, 0xae64, 0x38b3,
+		  0x4aab, 0xb229, 0x38d2, 0x3fb9, 0xb7ea, 0x30dc, 0x3fdc, 0xb599, 0x32c4, 0x4026, 0xb0b5, 0x36cb,
+		  0x4049, 0xae64, 0x38b3, 0x3f96, 0xba3b, 0x2ef4, 0x3fdc, 0xb599, 0x32c4, 0x3f96, 0xba3b, 0x2ef4 } },
+	{ "mode 9",
+		{ 0x7a, 0xbc, 0x16, 0x94, 0x67, 0xcd, 0x60, 0x25, 0x72, 0x6e, 0xad, 0x3e, 0x0a, 0xdd, 0x14, 0x4d },
+		{ 0x97ac, 0x2e87, 0xb0b5, 0x994f, 0x2db6, 0xb212, 0x9439, 0x3041, 0xadd5, 0x90f4, 0x31e4, 0xab1c,
+		  0x9af1, 0x2ce5, 0xb36f, 0x994f, 0x2db6, 0xb212, 0x9af1, 0x2ce5, 0xb36f, 0x95db, 0x2f70, 0xaf32,
+		  0x9296, 0x3112, 0xac78, 0x9439, 0x3041, 0xadd5, 0x9af1, 0x2ce5, 0xb36f, 0xa145, 0x2aed, 0xbb7c,
+		  0x9c94, 0x2c14, 0xb4cc, 0xa145, 0x2aed, 0xbb7c, 0xa2f3, 0x3087, 0xb553, 0xa2f3, 0x3087, 0xb553 } },
+	{ "mode 10",
+		{ 0x9e, 0xc8, 0x42, 0x3c, 0x66, 0x76, 0xa7, 0xbc, 0x8a, 0x26, 0xe5, 0x8c, 0x00, 0x08, 0xc3, 0x23 },
+		{ 0x15cc, 0x0f51, 0x617b, 0x2c14, 0x8f51, 0x885b, 0x19ac, 0x3177, 0xaf49, 0x2264, 0x3b46, 0xb4bc,
+		  0x235c, 0x8354, 0x210f, 0x1550, 0x2c90, 0xac90, 0x1550, 0x2c90, 0xac90, 0x1550, 0x2c90, 0xac90,
+		  0x273c, 0x40b9, 0xb7c3, 0x1550, 0x2c90, 0xac90, 0x2ff4, 0x4a88, 0xbd36, 0x1550, 0x2c90, 0xac90,
+		  0x2ff4, 0x4a88, 0xbd36, 0x2264, 0x3b46, 0xb4bc, 0x273c, 0x40b9, 0xb7c3, 0x1550, 0x2c90, 0xac90 } },
+	{ "mode 11",
+		{ 0x43, 0x66, 0x54, 0x12, 0xe8, 0x17, 0x18, 0xf5, 0x7b, 0x13, 0xde, 0xa6, 0x99, 0xec, 0xce, 0x90 },
+		{ 0xb639, 0x2ab7, 0x803e, 0xb807, 0x2b88, 0x8155, 0xb49e, 0x29fd, 0x00ba, 0xb2d0, 0x292c, 0x01d1,
+		  0xbe0b, 0x2e42, 0x84f7, 0xbd0a, 0x2dcd, 0x845c, 0xb739, 0x2b2b, 0x80d9, 0xbaa2, 0x2cb6, 0x82e8,
+		  0xb9a2, 0x2c42, 0x824d, 0xb9a2, 0x2c42, 0x824d, 0xbc3d, 0x2d70, 0x83e0, 0xbe0b, 0x2e42, 0x84f7,
+		  0xbe0b, 0x2e42, 0x84f7, 0xbc3d, 0x2d70, 0x83e0, 0xb203, 0x28cf, 0x024d, 0xb9a2, 0x2c42, 0x824d } },
+	{ "mode 12",
+		{ 0x47, 0x36, 0x13, 0x1d, 0x07, 0x01, 0xca, 0x43, 0xa0, 0xe4, 0x36, 0xfa, 0x37, 0xbe, 0x41, 0x0c },
+		{ 0x349d, 0xb975, 0x6e41, 0x3738, 0xb2f3, 0xad77, 0x35a5, 0xb6e2, 0x30b0, 0x383f, 0xb060, 0xeb08,
+		  0x3630, 0xb586, 0x1019, 0x3567, 0xb77d, 0x3f2d, 0x3738, 0xb2f3, 0xad77, 0x387d, 0xafc5, 0xf984,
+		  0x366e, 0xb4eb, 0x019c, 0x3567, 0xb77d, 0x3f2d, 0x383f, 0xb060, 0xeb08, 0x3776, 0xb258, 0xbbf3,
+		  0x34db, 0xb8da, 0x5fc5, 0x35a5, 0xb6e2, 0x30b0, 0x37b4, 0xb1bd, 0xca70, 0x349d, 0xb975, 0x6e41 } },
+	{ "mode 13",
+		{ 0x6b, 0xf6, 0xcd, 0x57, 0x18, 0x69, 0x95, 0x83, 0xf5, 0x0f, 0x4b, 0xf1, 0x63, 0xcb, 0x9a, 0xd7 },
+		{ 0xc264, 0x3731, 0xbb5d, 0xc092, 0x32c4, 0xbb00, 0xc092, 0x32c4, 0xbb00, 0xc2b1, 0x37ea, 0xbb6d,
+		  0xc123, 0x3422, 0xbb1d, 0xc220, 0x368c, 0xbb50, 0xc28f, 0x3797, 0xbb66, 0xc092, 0x32c4, 0xbb00,
+		  0xc242, 0x36de, 0xbb56, 0xc1d4, 0x35d3, 0xbb40, 0xc123, 0x3422, 0xbb1d, 0xc101, 0x33d0, 0xbb17,
+		  0xc145, 0x3474, 0xbb24, 0xc16e, 0x34dc, 0xbb2c, 0xc1b2, 0x3581, 0xbb39, 0xc0df, 0x337d, 0xbb10 } },
+	{ "mode 14",
+		{ 0x8f, 0x41, 0x00, 0x51, 0xb7, 0xb9, 0x66, 0xa4, 0xff, 0x21, 0x18, 0xe2, 0xcd, 0x5d, 0xc8, 0x2b },
+		{ 0xb061, 0xb06e, 0x2e26, 0xb05e, 0xb06b, 0x2e23, 0xb064, 0xb070, 0x2e2a, 0xb063, 0xb06f, 0x2e29,
+		  0xb061, 0xb06d, 0x2e26, 0xb064, 0xb070, 0x2e2a, 0xb063, 0xb06f, 0x2e29, 0xb05e, 0xb06b, 0x2e23,
+		  0xb05f, 0xb06c, 0x2e23, 0xb05f, 0xb06c, 0x2e24, 0xb05f, 0xb06c, 0x2e23, 0xb062, 0xb06e, 0x2e27,
+		  0xb061, 0xb06d, 0x2e26, 0xb05f, 0xb06c, 0x2e24, 0xb060, 0xb06c, 0x2e24, 0xb063, 0xb06f, 0x2e29 } },
+	{ "reserved",
+		{ 0x73, 0x29, 0x54, 0x62, 0x8f, 0xcb, 0x3f, 0x0f, 0x38, 0x2a, 0xbe, 0xf6, 0x47, 0x72, 0x83, 0x82 },
+		{ 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000 } }
+};
+
+// Builds an in-memory DX10 DDS file of the given format holding the blocks
+// side by side, one row of blocks high
+static void buildBlockRowFile(std::vector<uint8_t>& file, uint32_t dxgiFormat,
+	const uint8_t* const* blocks, uint32_t count)
+{
+	uint32_t header[37] = { 0 };
+	header[0] = 0x20534444;  // "DDS "
+	header[1] = 124;         // header size
+	header[2] = 0x00081007;  // caps | height | width | pixel format | linear size
+	header[3] = 4;
+	header[4] = 4 * count;
+	header[5] = 16 * count;
+	header[19] = 32;         // pixel format size
+	header[20] = 0x4;        // four CC
+	memcpy(&header[21], "DX10", 4);
+	header[27] = 0x1000;     // texture
+	header[32] = dxgiFormat;
+	header[33] = 3;          // texture 2D
+	header[35] = 1;          // array size
+
+	file.assign((const uint8_t*)header, (const uint8_t*)header + sizeof(header));
+	for (uint32_t b = 0; b < count; b++)
+		file.insert(file.end(), blocks[b], blocks[b] + 16);
+}
+
+// Loads the file with expansion on and returns its level, or NULL if it did
+// not load as the given expanded type
+static const uint8_t* expandBlockRow(NvImage& image, const std::vector<uint8_t>& file, uint32_t type)
+{
+	if (!image.loadImageFromFileData(&file[0], file.size(), "dds") ||
+		image.getFormat() != NVIMAGE_RGBA || image.getType() != type)
+		return NULL;
+	return (const uint8_t*)image.getLevel(0);
+}
+
+static bool checkBC7()
+{
+	const uint32_t count = ARRAY_SIZE(s_bc7Vectors);
+	std::vector<const uint8_t*> blocks(count);
+	for (uint32_t b = 0; b < count; b++)
+		blocks[b] = s_bc7Vectors[b].block;
+
+	std::vector<uint8_t> file;
+	buildBlockRowFile(file, 98, &blocks[0], count);  // DXGI_FORMAT_BC7_UNORM
+
+	NvImage image;
+	const uint8_t* texels = expandBlockRow(image, file, NVIMAGE_UNSIGNED_BYTE);
+	if (!texels) {
+		LOGI("BC7: the vectors did not load");
+		return false;
+	}
+
+	bool passed = true;
+	for (uint32_t b = 0; b < count; b++) {
+		uint32_t wrong = 0;
+		for (uint32_t i = 0; i < 16; i++) {
+			uint32_t texel;
+			memcpy(&texel, texels + 4 * ((i / 4) * 4 * count + 4 * b + (i % 4)), sizeof(texel));
+			wrong += (texel != s_bc7Vectors[b].texels[i]);
+		}
+		if (wrong)
+			LOGI("BC7 %s: %d of 16 texels wrong", s_bc7Vectors[b].name, wrong);
+		passed = passed && !wrong;
+	}
+	return passed;
+}
+
+static bool checkBC6H(const BC6HVector* vectors, uint32_t count, bool isSigned)
+{
+	const char* name = isSigned ? "BC6H_SF16" : "BC6H_UF16";
+	std::vector<const uint8_t*> blocks(count);
+	for (uint32_t b = 0; b < count; b++)
+		blocks[b] = vectors[b].block;
+
+	std::vector<uint8_t> file;
+	buildBlockRowFile(file, isSigned ? 96 : 95, &blocks[0], count);  // DXGI_FORMAT_BC6H_SF16 or _UF16
+
+	NvImage image;
+	const uint8_t* texels = expandBlockRow(image, file, NVIMAGE_HALF_FLOAT);
+	if (!texels) {
+		LOGI("%s: the vectors did not load", name);
+		return false;
+	}
+
+	bool passed = true;
+	for (uint32_t b = 0; b < count; b++) {
+		uint32_t wrong = 0;
+		for (uint32_t i = 0; i < 16; i++) {
+			uint16_t texel[4];
+			memcpy(texel, texels + 8 * ((i / 4) * 4 * count + 4 * b + (i % 4)), sizeof(texel));
+			wrong += (memcmp(texel, &vectors[b].texels[3 * i], 3 * sizeof(uint16_t)) || texel[3] != 0x3C00);
+		}
+		if (wrong)
+			LOGI("%s %s: %d of 16 texels wrong", name, vectors[b].name, wrong);
+		passed = passed && !wrong;
+	}
+	return passed;
+}
+
+bool checkBPTCDecoding()
+{
+	bool flip = NvImage::GetVerticalFlip();
+	bool expand = NvImage::getDXTExpansion();
+	NvImage::VerticalFlip(false);
+	NvImage::setDXTExpansion(true);
+
+	bool bc7 = checkBC7();
+	bool bc6hUnsigned = checkBC6H(s_bc6hUnsignedVectors, ARRAY_SIZE(s_bc6hUnsignedVectors), false);
+	bool bc6hSigned = checkBC6H(s_bc6hSignedVectors, ARRAY_SIZE(s_bc6hSignedVectors), true);
+
+	NvImage::setDXTExpansion(expand);
+	NvImage::VerticalFlip(flip);
+
+	LOGI("BPTC decoding: BC7 %s, BC6H_UF16 %s, BC6H_SF16 %s", bc7 ? "passed" : "FAILED",
+		bc6hUnsigned ? "passed" : "FAILED", bc6hSigned ? "passed" : "FAILED");
+	return bc7 && bc6hUnsigned && bc6hSigned;
+}
@@ -0,0 +1,699 @@
+//----------------------------------------------------------------------------------
+// File:        AssetTools/ImageBenches.cpp
+// SDK Version: v3.00
+// Email:       emmanuel.villagomez@gmail.com
+// Site:        http://www.victoresite.net/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "AssetTools.h"
+#include "NvAssetLoader/NvAssetLoader.h"
+#include "NvImage/NvImage.h"
+#include "NV/NvHalfFloat.h"
+#include "NV/NvLogs.h"
+#include <math.h>
+#include <string.h>
+
+// The formats the DXT compression benchmark compresses to
+static const uint32_t s_compressedFormats[] = {
+	NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1,
+	NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5,
+	NVIMAGE_COMPRESSED_RED_RGTC1,
+	NVIMAGE_COMPRESSED_RG_RGTC2
+};
+
+static const char* s_compressedFormatNames[] = { "BC1", "BC3", "BC4", "BC5" };
+
+// Builds an in-memory DDS file holding a full mip chain of pseudo-random
+// DXT1/3/5 blocks.  Every bit pattern is a valid block, so this exercises all
+// of the decoder's palette modes
+static void buildDXTFile(std::vector<uint8_t>& file, uint32_t width, uint32_t height,
+	const char* fourCC, uint32_t blockBytes, uint32_t seed)
+{
+	uint32_t levels = 1;
+	while ((width >> levels) || (height >> levels))
+		levels++;
+
+	uint32_t header[32] = { 0 };
+	header[0] = 0x20534444;  // "DDS "
+	header[1] = 124;         // header size
+	header[2] = 0x000A1007;  // caps | height | width | pixel format | mip count | linear size
+	header[3] = height;
+	header[4] = width;
+	header[5] = ((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+	header[7] = levels;
+	header[19] = 32;         // pixel format size
+	header[20] = 0x4;        // four CC
+	memcpy(&header[21], fourCC, 4);
+	header[27] = 0x401008;   // texture | mipmap | complex
+
+	file.assign((const uint8_t*)header, (const uint8_t*)header + sizeof(header));
+
+	for (uint32_t level = 0; level < levels; level++) {
+		uint32_t w = (width >> level) ? (width >> level) : 1;
+		uint32_t h = (height >> level) ? (height >> level) : 1;
+		size_t bytes = ((w + 3) / 4) * ((h + 3) / 4) * blockBytes;
+		for (size_t i = 0; i < bytes; i++) {
+			seed = seed * 1664525 + 1013904223;
+			file.push_back((uint8_t)(seed >> 24));
+		}
+	}
+}
+
+// The reference DXT decoder, which decodes one block at a time with none of
+// the library decoder's shortcuts.  Texels are RGBA8 with red in the low byte.
+
+// Bit-expands a 565 color to 888
+static uint32_t referenceExpand565(uint32_t c)
+{
+	uint32_t r = (c >> 11) & 0x1F;
+	uint32_t g = (c >> 5) & 0x3F;
+	uint32_t b = c & 0x1F;
+	r = (r << 3) | (r >> 2);
+	g = (g << 2) | (g >> 4);
+	b = (b << 3) | (b >> 2);
+	return r | (g << 8) | (b << 16);
+}
+
+// Per-channel (wa * a + wb * b) / (wa + wb) of two 888 colors
+static uint32_t referenceMix(uint32_t a, uint32_t b, uint32_t wa, uint32_t wb)
+{
+	uint32_t mixed = 0;
+	for (uint32_t shift = 0; shift < 24; shift += 8) {
+		uint32_t channel = (((a >> shift) & 0xFF) * wa + ((b >> shift) & 0xFF) * wb) / (wa + wb);
+		mixed |= channel << shift;
+	}
+	return mixed;
+}
+
+// Decodes a DXT1, DXT3 or DXT5 block (of 8, 16 and 16 bytes) to 16 texels
+static void referenceDecodeDXT(const uint8_t* block, const char* fourCC, uint32_t texels[16])
+{
+	const uint8_t* color = block + (strcmp(fourCC, "DXT1") ? 8 : 0);
+	uint32_t c0 = color[0] | (color[1] << 8);
+	uint32_t c1 = color[2] | (color[3] << 8);
+	uint32_t p0 = referenceExpand565(c0);
+	uint32_t p1 = referenceExpand565(c1);
+
+	// four colors, or three and transparent black
+	uint32_t palette[4];
+	palette[0] = p0 | 0xFF000000;
+	palette[1] = p1 | 0xFF000000;
+	if (c0 > c1) {
+		palette[2] = referenceMix(p0, p1, 2, 1) | 0xFF000000;
+		palette[3] = referenceMix(p0, p1, 1, 2) | 0xFF000000;
+	} else {
+		palette[2] = referenceMix(p0, p1, 1, 1) | 0xFF000000;
+		palette[3] = 0;
+	}
+
+	for (uint32_t i = 0; i < 16; i++) {
+		uint32_t index = (color[4 + i / 4] >> (2 * (i % 4))) & 3;
+		texels[i] = palette[index];
+	}
+
+	if (!strcmp(fourCC, "DXT3")) {
+		// explicit 4-bit alphas
+		for (uint32_t i = 0; i < 16; i++) {
+			uint32_t alpha = (block[i / 2] >> (4 * (i % 2))) & 0xF;
+			texels[i] = (texels[i] & 0x00FFFFFF) | (((alpha << 4) | alpha) << 24);
+		}
+	} else if (!strcmp(fourCC, "DXT5")) {
+		// eight alphas, or six and fully transparent and opaque
+		uint32_t a0 = block[0];
+		uint32_t a1 = block[1];
+		uint32_t alphas[8] = { a0, a1 };
+		if (a0 > a1) {
+			for (uint32_t i = 1; i < 7; i++)
+				alphas[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+		} else {
+			for (uint32_t i = 1; i < 5; i++)
+				alphas[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+			alphas[6] = 0x00;
+			alphas[7] = 0xFF;
+		}
+
+		for (uint32_t i = 0; i < 16; i++) {
+			uint32_t bit = 16 + 3 * i;
+			uint32_t index = ((block[bit / 8] | (block[bit / 8 + 1] << 8)) >> (bit % 8)) & 7;
+			texels[i] = (texels[i] & 0x00FFFFFF) | (alphas[index] << 24);
+		}
+	}
+}
+
+// Decodes every level of a file built by buildDXTFile, unflipped, into the
+// levels of texels one after another
+static void referenceExpandDXT(const std::vector<uint8_t>& file, const char* fourCC,
+	uint32_t blockBytes, std::vector<uint32_t>& image)
+{
+	const uint32_t* header = (const uint32_t*)&file[0];
+	uint32_t width = header[4];
+	uint32_t height = header[3];
+	uint32_t levels = header[7];
+	const uint8_t* block = &file[32 * sizeof(uint32_t)];
+
+	image.clear();
+	for (uint32_t level = 0; level < levels; level++) {
+		uint32_t w = (width >> level) ? (width >> level) : 1;
+		uint32_t h = (height >> level) ? (height >> level) : 1;
+		size_t base = image.size();
+		image.resize(base + (size_t)w * h);
+
+		for (uint32_t by = 0; by < h; by += 4) {
+			for (uint32_t bx = 0; bx < w; bx += 4, block += blockBytes) {
+				uint32_t texels[16];
+				referenceDecodeDXT(block, fourCC, texels);
+				for (uint32_t y = 0; y < 4 && by + y < h; y++) {
+					for (uint32_t x = 0; x < 4 && bx + x < w; x++)
+						image[base + (size_t)(by + y) * w + bx + x] = texels[4 * y + x];
+				}
+			}
+		}
+	}
+}
+
+void benchmarkDXTExpansion()
+{
+	// The sample's textures ship uncompressed, so each one stands in for a
+	// block-compressed texture of the same size
+	const char* fourCCs[] = { "DXT1", "DXT3", "DXT5" };
+	const uint32_t blockBytes[] = { 8, 16, 16 };
+	const int32_t passes = 10;
+
+	bool flip = NvImage::GetVerticalFlip();
+	bool expand = NvImage::getDXTExpansion();
+	uint32_t threads = NvImage::getDXTExpansionThreads();
+	NvImage::VerticalFlip(false);
+	NvImage::setDXTExpansion(true);
+
+	NvStopWatch* timer = createStopWatch();
+
+	for (uint32_t t = 0; t < g_textureCount; t++) {
+		int32_t length;
+		char* data = NvAssetLoaderRead(g_textureNames[t], length);
+		if (!data)
+			continue;
+
+		NvImage texture;
+		bool loaded = texture.loadImageFromFileData((const uint8_t*)data, length, "dds");
+		NvAssetLoaderFree(data);
+		if (!loaded)
+			continue;
+
+		for (uint32_t f = 0; f < ARRAY_SIZE(fourCCs); f++) {
+			std::vector<uint8_t> file;
+			buildDXTFile(file, texture.getWidth(), texture.getHeight(), fourCCs[f], blockBytes[f], t * 3 + f + 1);
+
+			// the reference decoder, then loads with the row decoder on one
+			// thread and on all
+			float times[3];
+			std::vector<uint32_t> reference;
+			timer->reset();
+			timer->start();
+			for (int32_t pass = 0; pass < passes; pass++)
+				referenceExpandDXT(file, fourCCs[f], blockBytes[f], reference);
+			timer->stop();
+			times[0] = 1000.0f * timer->getTime() / passes;
+
+			bool identical = true;
+			for (int32_t mode = 1; mode < 3; mode++) {
+				NvImage image;
+				NvImage::setDXTExpansionThreads((mode == 2) ? 0 : 1);
+
+				timer->reset();
+				timer->start();
+				for (int32_t pass = 0; pass < passes; pass++)
+					image.loadImageFromFileData(&file[0], file.size(), "dds");
+				timer->stop();
+				times[mode] = 1000.0f * timer->getTime() / passes;
+
+				identical = identical &&
+					(image.getDataBlockSize() == reference.size() * sizeof(uint32_t)) &&
+					!memcmp(image.getDataBlock(), &reference[0], image.getDataBlockSize());
+			}
+
+			LOGI("DXT expansion %s %dx%d (%s): reference %.2fms, row decoder %.2fms (%.1fx), threaded %.2fms (%.1fx)%s",
+				fourCCs[f], texture.getWidth(), texture.getHeight(), g_textureNames[t],
+				times[0], times[1], times[0] / times[1], times[2], times[0] / times[2],
+				identical ? "" : " MISMATCH");
+		}
+	}
+
+	delete timer;
+
+	NvImage::setDXTExpansionThreads(threads);
+	NvImage::setDXTExpansion(expand);
+	NvImage::VerticalFlip(flip);
+}
+
+void benchmarkDXTCompression()
+{
+	const int32_t passes = 3;
+
+	NvStopWatch* timer = createStopWatch();
+
+	for (uint32_t t = 0; t < g_textureCount; t++) {
+		int32_t length;
+		char* data = NvAssetLoaderRead(g_textureNames[t], length);
+		if (!data)
+			continue;
+
+		for (uint32_t f = 0; f < ARRAY_SIZE(s_compressedFormats); f++) {
+			for (int32_t quality = 0; quality < 2; quality++) {
+				// every pass compresses a freshly loaded image; only the
+				// compression itself is timed
+				float psnr = 0.0f;
+				int32_t texels = 0;
+				bool compressed = true;
+				timer->reset();
+				for (int32_t pass = 0; pass < passes && compressed; pass++) {
+					NvImage image;
+					if (!image.loadImageFromFileData((const uint8_t*)data, length, "dds")) {
+						compressed = false;
+						break;
+					}
+					for (int32_t level = 0; level < image.getMipLevels(); level++) {
+						int32_t w = image.getWidth() >> level, h = image.getHeight() >> level;
+						texels += ((w > 1) ? w : 1) * ((h > 1) ? h : 1);
+					}
+
+					timer->start();
+					compressed = image.compress(s_compressedFormats[f], quality != 0, 0, &psnr);
+					timer->stop();
+				}
+
+				if (!compressed) {
+					LOGI("DXT compression %s (%s): unsupported source format",
+						s_compressedFormatNames[f], g_textureNames[t]);
+					continue;
+				}
+
+				float ms = 1000.0f * timer->getTime() / passes;
+				LOGI("DXT compression %s %s (%s): %.2fms, %.1f MTexels/s, PSNR %.2fdB",
+					s_compressedFormatNames[f], quality ? "quality" : "fast", g_textureNames[t],
+					ms, texels / (1000.0f * 1000.0f * timer->getTime()), psnr);
+			}
+		}
+
+		NvAssetLoaderFree(data);
+	}
+
+	delete timer;
+}
+
+// Builds an in-memory DDS file holding one level of pseudo-random
+// uncompressed texels with the given pixel format flags, size and masks
+static void buildTexelFile(std::vector<uint8_t>& file, uint32_t width, uint32_t height,
+	uint32_t flags, uint32_t bitCount, const uint32_t masks[4], uint32_t seed)
+{
+	uint32_t header[32] = { 0 };
+	header[0] = 0x20534444;  // "DDS "
+	header[1] = 124;         // header size
+	header[2] = 0x0000100F;  // caps | height | width | pitch | pixel format
+	header[3] = height;
+	header[4] = width;
+	header[5] = width * bitCount / 8;
+	header[19] = 32;         // pixel format size
+	header[20] = flags;
+	header[22] = bitCount;
+	memcpy(&header[23], masks, 4 * sizeof(uint32_t));
+	header[27] = 0x1000;     // texture
+
+	file.assign((const uint8_t*)header, (const uint8_t*)header + sizeof(header));
+
+	size_t bytes = (size_t)width * height * bitCount / 8;
+	for (size_t i = 0; i < bytes; i++) {
+		seed = seed * 1664525 + 1013904223;
+		file.push_back((uint8_t)(seed >> 24));
+	}
+}
+
+// The block layouts the reference surface transform flips
+enum ReferenceLayout {
+	REFERENCE_TEXELS,
+	REFERENCE_DXT1,
+	REFERENCE_DXT3,
+	REFERENCE_DXT5,
+	REFERENCE_BC4,
+	REFERENCE_BC5
+};
+
+// Reverses the rows of the 3-bit indices of a DXT5 alpha or BC4 block
+static void referenceFlipInterpolated(uint8_t* block)
+{
+	uint8_t indices[16];
+
+	for (int32_t half = 0; half < 2; half++) {
+		const uint8_t* bytes = block + 2 + 3 * half;
+		uint32_t bits = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16);
+		for (int32_t i = 0; i < 8; i++)
+			indices[8 * half + i] = (bits >> (3 * i)) & 7;
+	}
+
+	for (int32_t half = 0; half < 2; half++) {
+		uint8_t* bytes = block + 2 + 3 * half;
+		uint32_t bits = 0;
+		for (int32_t i = 0; i < 8; i++) {
+			int32_t row = 3 - (2 * half + i / 4);
+			bits |= (uint32_t)indices[4 * row + (i & 3)] << (3 * i);
+		}
+		bytes[0] = (uint8_t)bits;
+		bytes[1] = (uint8_t)(bits >> 8);
+		bytes[2] = (uint8_t)(bits >> 16);
+	}
+}
+
+// Reverses the rows of 2-bit indices of a DXT color block
+static void referenceFlipColor(uint8_t* block)
+{
+	uint8_t temp = block[4];
+	block[4] = block[7];
+	block[7] = temp;
+	temp = block[5];
+	block[5] = block[6];
+	block[6] = temp;
+}
+
+// Reverses the 16-bit rows of a DXT3 alpha block
+static void referenceFlipExplicitAlpha(uint8_t* block)
+{
+	for (int32_t row = 0; row < 2; row++) {
+		for (int32_t i = 0; i < 2; i++) {
+			uint8_t temp = block[2 * row + i];
+			block[2 * row + i] = block[2 * (3 - row) + i];
+			block[2 * (3 - row) + i] = temp;
+		}
+	}
+}
+
+// Flips each block of a row in place
+static void referenceFlipBlocks(ReferenceLayout layout, uint8_t* row, size_t bytes)
+{
+	size_t blockBytes = (layout == REFERENCE_DXT1 || layout == REFERENCE_BC4) ? 8 : 16;
+
+	for (uint8_t* block = row; block < row + bytes; block += blockBytes) {
+		switch (layout) {
+		case REFERENCE_DXT1:
+			referenceFlipColor(block);
+			break;
+		case REFERENCE_DXT3:
+			referenceFlipExplicitAlpha(block);
+			referenceFlipColor(block + 8);
+			break;
+		case REFERENCE_DXT5:
+			referenceFlipInterpolated(block);
+			referenceFlipColor(block + 8);
+			break;
+		case REFERENCE_BC4:
+			referenceFlipInterpolated(block);
+			break;
+		case REFERENCE_BC5:
+			referenceFlipInterpolated(block);
+			referenceFlipInterpolated(block + 8);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+// Flips every level of an unflipped 2D image's data in place one pass at a
+// time: the blocks of each row, then the rows through a temporary row, then
+// the red and blue channels of each texel if swap is set.  elementBytes is
+// the size of a block, or of a texel for REFERENCE_TEXELS
+static void referenceTransform(const NvImage& image, ReferenceLayout layout, uint32_t elementBytes,
+	bool swap, std::vector<uint8_t>& data)
+{
+	for (int32_t level = 0; level < image.getMipLevels(); level++) {
+		int32_t w = (image.getWidth() >> level) ? (image.getWidth() >> level) : 1;
+		int32_t h = (image.getHeight() >> level) ? (image.getHeight() >> level) : 1;
+		size_t rowBytes = (layout == REFERENCE_TEXELS) ? (size_t)w * elementBytes : ((w + 3) / 4) * elementBytes;
+		int32_t rows = (layout == REFERENCE_TEXELS) ? h : (h + 3) / 4;
+		uint8_t* surface = &data[image.getLevelOffset(level)];
+
+		if (layout != REFERENCE_TEXELS) {
+			for (int32_t row = 0; row < rows; row++)
+				referenceFlipBlocks(layout, surface + row * rowBytes, rowBytes);
+		}
+
+		std::vector<uint8_t> temp(rowBytes);
+		for (int32_t top = 0, bottom = rows - 1; top < bottom; top++, bottom--) {
+			memcpy(&temp[0], surface + top * rowBytes, rowBytes);
+			memcpy(surface + top * rowBytes, surface + bottom * rowBytes, rowBytes);
+			memcpy(surface + bottom * rowBytes, &temp[0], rowBytes);
+		}
+
+		if (swap) {
+			for (uint8_t* texel = surface; texel < surface + rowBytes * rows; texel += elementBytes) {
+				uint8_t tmp = texel[0];
+				texel[0] = texel[2];
+				texel[2] = tmp;
+			}
+		}
+	}
+}
+
+void benchmarkSurfaceTransforms()
+{
+	struct TransformFormat {
+		const char* name;
+		ReferenceLayout layout;
+		const char* fourCC;      // NULL for uncompressed formats
+		uint32_t blockBytes;
+		uint32_t flags;
+		uint32_t bitCount;
+		uint32_t masks[4];
+	};
+
+	const TransformFormat formats[] = {
+		{ "DXT1", REFERENCE_DXT1, "DXT1", 8, 0, 0, { 0, 0, 0, 0 } },
+		{ "DXT3", REFERENCE_DXT3, "DXT3", 16, 0, 0, { 0, 0, 0, 0 } },
+		{ "DXT5", REFERENCE_DXT5, "DXT5", 16, 0, 0, { 0, 0, 0, 0 } },
+		{ "BC4", REFERENCE_BC4, "ATI1", 8, 0, 0, { 0, 0, 0, 0 } },
+		{ "BC5", REFERENCE_BC5, "ATI2", 16, 0, 0, { 0, 0, 0, 0 } },
+		{ "BGRA8", REFERENCE_TEXELS, NULL, 0, 0x41, 32, { 0xff0000, 0xff00, 0xff, 0xff000000 } },
+		{ "RGBA8", REFERENCE_TEXELS, NULL, 0, 0x41, 32, { 0xff, 0xff00, 0xff0000, 0xff000000 } },
+		{ "BGR8", REFERENCE_TEXELS, NULL, 0, 0x40, 24, { 0xff0000, 0xff00, 0xff, 0 } },
+		{ "L8", REFERENCE_TEXELS, NULL, 0, 0x20000, 8, { 0xff, 0, 0, 0 } }
+	};
+	const uint32_t size = 2048;
+	const int32_t passes = 10;
+
+	bool flip = NvImage::GetVerticalFlip();
+	bool bgr = NvImage::getSupportsBGR();
+	bool expand = NvImage::getDXTExpansion();
+	NvImage::setDXTExpansion(false);
+
+	NvStopWatch* timer = createStopWatch();
+
+	for (uint32_t f = 0; f < ARRAY_SIZE(formats); f++) {
+		std::vector<uint8_t> file;
+		if (formats[f].fourCC)
+			buildDXTFile(file, size, size, formats[f].fourCC, formats[f].blockBytes, f + 1);
+		else
+			buildTexelFile(file, size, size, formats[f].flags, formats[f].bitCount, formats[f].masks, f + 1);
+
+		// a plain copy, the fused pass, and the fused pass applied in place to
+		// the file data
+		float times[3];
+		NvImage images[2];
+		std::vector<uint8_t> inPlace = file;
+		for (int32_t mode = 0; mode < 3; mode++) {
+			NvImage::VerticalFlip(mode != 0);
+			NvImage::setSupportsBGR(mode == 0);
+
+			timer->reset();
+			timer->start();
+			for (int32_t pass = 0; pass < passes; pass++) {
+				if (mode < 2) {
+					images[mode].loadImageFromFileData(&file[0], file.size(), "dds");
+				} else {
+					NvImage image;
+					image.loadImageFromFileDataInPlace(&inPlace[0], inPlace.size(), "dds");
+				}
+			}
+			timer->stop();
+			times[mode] = 1000.0f * timer->getTime() / passes;
+		}
+
+		// the reference flips and swaps the plain copy's data, and is timed
+		// as the copy plus its passes so that it compares with the fused load
+		bool swap = (images[0].getFormat() != images[1].getFormat());
+		std::vector<uint8_t> reference;
+		timer->reset();
+		timer->start();
+		for (int32_t pass = 0; pass < passes; pass++) {
+			reference.assign(images[0].getDataBlock(), images[0].getDataBlock() + images[0].getDataBlockSize());
+			referenceTransform(images[0], formats[f].layout,
+				formats[f].fourCC ? formats[f].blockBytes : formats[f].bitCount / 8, swap, reference);
+		}
+		timer->stop();
+		float referenceTime = times[0] + 1000.0f * timer->getTime() / passes;
+
+		bool identical = (images[1].getDataBlockSize() == reference.size()) &&
+			!memcmp(images[1].getDataBlock(), &reference[0], reference.size());
+		float gigabytes = images[0].getDataBlockSize() / (1024.0f * 1024.0f * 1024.0f);
+
+		LOGI("Surface transform %s %dx%d: copy %.2fms, reference %.2fms, fused %.2fms (%.1fx, %.1f GB/s), in place %.2fms%s",
+			formats[f].name, size, size, times[0], referenceTime, times[1], referenceTime / times[1],
+			1000.0f * gigabytes / times[1], times[2], identical ? "" : " MISMATCH");
+	}
+
+	delete timer;
+
+	NvImage::setDXTExpansion(expand);
+	NvImage::setSupportsBGR(bgr);
+	NvImage::VerticalFlip(flip);
+}
+
+// Builds an in-memory DDS file holding one level of pseudo-random RGBA32F
+// texels with magnitudes from 2^-8 to 2^9, the range of typical HDR content
+static void buildFloatFile(std::vector<uint8_t>& file, uint32_t width, uint32_t height, uint32_t seed)
+{
+	uint32_t header[32] = { 0 };
+	header[0] = 0x20534444;  // "DDS "
+	header[1] = 124;         // header size
+	header[2] = 0x00001007;  // caps | height | width | pixel format
+	header[3] = height;
+	header[4] = width;
+	header[19] = 32;         // pixel format size
+	header[20] = 0x4;        // four CC
+	header[21] = 116;        // D3DFMT_A32B32G32R32F
+	header[27] = 0x1000;     // texture
+
+	file.assign((const uint8_t*)header, (const uint8_t*)header + sizeof(header));
+
+	size_t count = (size_t)width * height * 4;
+	file.resize(sizeof(header) + count * sizeof(float));
+	float* texels = (float*)&file[sizeof(header)];
+	for (size_t i = 0; i < count; i++) {
+		seed = seed * 1664525 + 1013904223;
+		texels[i] = ldexpf(1.0f + (seed & 0xFFFF) / 65536.0f, (int32_t)((seed >> 16) % 17) - 8);
+	}
+}
+
+void benchmarkHalfConversion()
+{
+	const uint32_t size = 2048;
+	const int32_t passes = 10;
+
+	bool flip = NvImage::GetVerticalFlip();
+	bool convert = NvImage::getHalfFloatConversion();
+	NvImage::VerticalFlip(false);
+
+	std::vector<uint8_t> file;
+	buildFloatFile(file, size, size, 1);
+
+	NvStopWatch* timer = createStopWatch();
+
+	// a plain float load, then a load converting to half floats
+	float times[2];
+	NvImage images[2];
+	for (int32_t mode = 0; mode < 2; mode++) {
+		NvImage::setHalfFloatConversion(mode != 0);
+
+		timer->reset();
+		timer->start();
+		for (int32_t pass = 0; pass < passes; pass++)
+			images[mode].loadImageFromFileData(&file[0], file.size(), "dds");
+		timer->stop();
+		times[mode] = 1000.0f * timer->getTime() / passes;
+	}
+
+	// the reference converts the float load's texels one value at a time
+	size_t count = (size_t)size * size * 4;
+	const float* source = (const float*)images[0].getLevel(0);
+	std::vector<uint16_t> referenceHalves(count);
+	timer->reset();
+	timer->start();
+	for (int32_t pass = 0; pass < passes; pass++) {
+		for (size_t i = 0; i < count; i++)
+			referenceHalves[i] = nv::floatToHalf(source[i]);
+	}
+	timer->stop();
+	float referenceTime = 1000.0f * timer->getTime() / passes;
+
+	bool identical = (images[1].getDataBlockSize() == count * sizeof(uint16_t)) &&
+		!memcmp(images[1].getDataBlock(), &referenceHalves[0], count * sizeof(uint16_t));
+
+	// widening back to floats, timed apart from copying the half image
+	std::vector<float> referenceFloats(count);
+	timer->reset();
+	timer->start();
+	for (int32_t pass = 0; pass < passes; pass++) {
+		for (size_t i = 0; i < count; i++)
+			referenceFloats[i] = nv::halfToFloat(referenceHalves[i]);
+	}
+	timer->stop();
+	float referenceWidenTime = 1000.0f * timer->getTime() / passes;
+
+	float widenTime = 0.0f;
+	NvImage widened;
+	for (int32_t pass = 0; pass < passes; pass++) {
+		images[1].downscale(widened, 0);
+		timer->reset();
+		timer->start();
+		widened.convertToFloat();
+		timer->stop();
+		widenTime += 1000.0f * timer->getTime() / passes;
+	}
+
+	bool widenedIdentical = (widened.getDataBlockSize() == count * sizeof(float)) &&
+		!memcmp(widened.getDataBlock(), &referenceFloats[0], count * sizeof(float));
+
+	// relative error against the source; rounding to nearest bounds it by 2^-11
+	const float* result = (const float*)widened.getLevel(0);
+	double maxError = 0.0;
+	double sumSquares = 0.0;
+	for (size_t i = 0; i < count; i++) {
+		double error = fabs((double)result[i] - source[i]) / fabs(source[i]);
+		maxError = (error > maxError) ? error : maxError;
+		sumSquares += error * error;
+	}
+
+	// the conversion's share of the load is what it adds to the float load
+	float gigabytes = images[0].getDataBlockSize() / (1024.0f * 1024.0f * 1024.0f);
+	float vectorTime = times[1] - times[0];
+
+	LOGI("Half conversion RGBA32F %dx%d: float load %.2fms, converting load %.2fms",
+		size, size, times[0], times[1]);
+	if (vectorTime > 0.0f) {
+		LOGI("Half conversion: reference %.2fms (%.1f GB/s), vectorized %.2fms (%.1f GB/s, %.1fx)%s",
+			referenceTime, 1000.0f * gigabytes / referenceTime, vectorTime, 1000.0f * gigabytes / vectorTime,
+			referenceTime / vectorTime, identical ? "" : " MISMATCH");
+	}
+	LOGI("Half widening: reference %.2fms, vectorized %.2fms (%.1fx)%s",
+		referenceWidenTime, widenTime, referenceWidenTime / widenTime, widenedIdentical ? "" : " MISMATCH");
+	LOGI("Half round trip relative error: max %.3g, RMS %.3g (bound %.3g)",
+		maxError, sqrt(sumSquares / count), 1.0 / 2048.0);
+
+	delete timer;
+
+	NvImage::setHalfFloatConversion(convert);
+	NvImage::VerticalFlip(flip);
+}
@@ -0,0 +1,443 @@
+//----------------------------------------------------------------------------------
+// File:        AssetTools/ModelBenches.cpp
+// SDK Version: v3.00
+// Email:       emmanuel.villagomez@gmail.com
+// Site:        http://www.victoresite.net/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "AssetTools.h"
+#include "NvModel/NvModel.h"
+#include "NvModel/NvModelExt.h"
+#include "NvModel/NvModelSubMesh.h"
+#include "NvModel/NvModelOptimizer.h"
+#include "NvModelVectorCompactor.h"
+#include "NV/NvLogs.h"
+#include "NV/NvTokenizer.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+
+// The original vertex welding, which keeps the welded vectors sorted along x
+// and compares each new vector with every one whose x is within epsilon of
+// its own.  The closest that the comparator merges with, the earliest added
+// of equals, takes its place, as the compactor's grid picks them.
+// \param[in] vecs the vectors, in the order they are added
+// \param[in] epsilon the tolerance the comparator merges by
+// \param[out] remap per vector, the index of the welded vector it became
+// \return the number of welded vectors
+template <class T, class Cmp>
+static uint32_t referenceWeld(const std::vector<T>& vecs, float epsilon, std::vector<int32_t>& remap)
+{
+	typedef std::multimap<float, int32_t> SortedMap;
+
+	Cmp comp;
+	std::vector<T> welded;
+	SortedMap sorted;
+
+	remap.resize(vecs.size());
+	for (size_t i = 0; i < vecs.size(); i++) {
+		const T& v = vecs[i];
+		SortedMap::iterator rangeStart = sorted.lower_bound(v[0] - epsilon);
+		SortedMap::iterator rangeEnd = sorted.upper_bound(v[0] + epsilon);
+
+		int32_t closest = -1;
+		float bestDist2 = 0.0f;
+		for (SortedMap::iterator it = rangeStart; it != rangeEnd; ++it) {
+			float dist2 = comp.Diff(v, welded[it->second]);
+			if ((closest == -1) || (dist2 < bestDist2) || ((dist2 == bestDist2) && (it->second < closest))) {
+				bestDist2 = dist2;
+				closest = it->second;
+			}
+		}
+
+		if ((closest == -1) || !comp.ShouldMerge(bestDist2, epsilon)) {
+			closest = (int32_t)welded.size();
+			welded.push_back(v);
+			sorted.insert(rangeStart, SortedMap::value_type(v[0], closest));
+		}
+		remap[i] = closest;
+	}
+	return (uint32_t)welded.size();
+}
+
+// Welds the vectors with the original welding and with the compactor the
+// OBJ importer welds with, timing both
+// \param[out] welded the number of welded vectors
+// \param[out] times the milliseconds taken by the original welding, then
+// by the compactor
+// \return true if both weld the same vectors
+template <class Compactor, class Cmp, class T>
+static bool compareWelding(const std::vector<T>& vecs, float epsilon, NvStopWatch* timer,
+	uint32_t& welded, float times[2])
+{
+	std::vector<int32_t> remap;
+	timer->reset();
+	timer->start();
+	welded = referenceWeld<T, Cmp>(vecs, epsilon, remap);
+	timer->stop();
+	times[0] = 1000.0f * timer->getTime();
+
+	Compactor compactor(epsilon, (uint32_t)vecs.size());
+	timer->reset();
+	timer->start();
+	for (size_t i = 0; i < vecs.size(); i++)
+		compactor.Append(vecs[i]);
+	timer->stop();
+	times[1] = 1000.0f * timer->getTime();
+
+	if (compactor.GetVectorCount() != welded)
+		return false;
+	for (size_t i = 0; i < vecs.size(); i++) {
+		if (compactor.Remap((int32_t)i) != remap[i])
+			return false;
+	}
+	return true;
+}
+
+void benchmarkVertexWelding()
+{
+	NvModel* dragon = loadDragon();
+	if (!dragon)
+		return;
+
+	const float* verts = dragon->getCompiledVertices();
+	int32_t vertSize = dragon->getCompiledVertexSize();
+	int32_t vertCount = dragon->getCompiledVertexCount();
+	int32_t posOffset = dragon->getCompiledPositionOffset();
+	int32_t normalOffset = dragon->getCompiledNormalOffset();
+
+	float minY = 0.0f;
+	float maxY = 0.0f;
+	for (int32_t i = 0; i < vertCount; i++) {
+		float y = verts[i * vertSize + posOffset + 1];
+		minY = (i == 0 || y < minY) ? y : minY;
+		maxY = (i == 0 || y > maxY) ? y : maxY;
+	}
+
+	NvStopWatch* timer = createStopWatch();
+
+	// the dragon as it is, then a tall stack of copies whose vertices crowd
+	// into the same narrow range of x.  Compiled vertices split wherever the
+	// normals do, so the positions hold duplicates; the tolerances are the
+	// OBJ importer's defaults
+	const uint32_t copyCounts[] = { 1, 16 };
+	for (uint32_t test = 0; test < ARRAY_SIZE(copyCounts); test++) {
+		std::vector<nv::vec4f> positions;
+		std::vector<nv::vec3f> normals;
+		for (uint32_t copy = 0; copy < copyCounts[test]; copy++) {
+			float offsetY = copy * (maxY - minY);
+			for (int32_t i = 0; i < vertCount; i++) {
+				const float* v = verts + i * vertSize;
+				positions.push_back(nv::vec4f(v[posOffset], v[posOffset + 1] + offsetY, v[posOffset + 2], 1.0f));
+				if (normalOffset >= 0)
+					normals.push_back(normalize(nv::vec3f(v[normalOffset], v[normalOffset + 1], v[normalOffset + 2])));
+			}
+		}
+
+		uint32_t welded[2] = { 0, 0 };
+		float positionTimes[2];
+		float normalTimes[2] = { 0.0f, 0.0f };
+		bool same = compareWelding<Nv::NvModelVectorCompactor<nv::vec4f>::Positions,
+			Nv::Difference_Position<nv::vec4f> >(positions, 0.01f, timer, welded[0], positionTimes);
+		if (!normals.empty()) {
+			same = compareWelding<Nv::NvModelVectorCompactor<nv::vec3f>::Normals,
+				Nv::Difference_Normal<nv::vec3f> >(normals, 0.001f, timer, welded[1], normalTimes) && same;
+		}
+
+		float times[2] = { positionTimes[0] + normalTimes[0], positionTimes[1] + normalTimes[1] };
+		LOGI("Vertex welding %d x dragon (%d vertices in, %d positions and %d normals welded): sorted %.1fms, grid %.1fms (%.1fx)%s",
+			copyCounts[test], (int32_t)positions.size(), welded[0], welded[1],
+			times[0], times[1], times[0] / times[1], same ? "" : " MISMATCH");
+	}
+
+	delete timer;
+	delete dragon;
+}
+
+void benchmarkObjLoading()
+{
+	NvModel* dragon = loadDragon();
+	if (!dragon)
+		return;
+
+	std::string text;
+	MemoryObjLoader loader(text);
+	Nv::NvModelFileLoader* previousLoader = Nv::NvModelExt::GetFileLoader();
+	Nv::NvModelExt::SetFileLoader(&loader);
+
+	uint32_t previousThreads = Nv::NvModelExt::GetObjLoadThreads();
+
+	NvStopWatch* timer = createStopWatch();
+
+	const uint32_t copyCounts[] = { 1, 16, 64 };
+	for (uint32_t test = 0; test < sizeof(copyCounts) / sizeof(copyCounts[0]); test++) {
+		buildObjText(*dragon, copyCounts[test], text);
+
+		// a single pass, then as many threads as the hardware runs
+		float times[2];
+		Nv::NvModelExt* models[2];
+		for (int32_t mode = 0; mode < 2; mode++) {
+			Nv::NvModelExt::SetObjLoadThreads(mode == 0 ? 1 : 0);
+
+			timer->reset();
+			timer->start();
+			models[mode] = Nv::NvModelExt::CreateFromObj("objbench.obj", -1.0f, false, false);
+			timer->stop();
+			times[mode] = 1000.0f * timer->getTime();
+		}
+
+		LOGI("OBJ loading %d x dragon (%.1f MB): single pass %.1fms, chunked %.1fms (%.1fx)%s",
+			copyCounts[test], text.size() / (1024.0f * 1024.0f), times[0], times[1], times[0] / times[1],
+			samePreprocessedModels(models[0], models[1]) ? "" : " MISMATCH");
+
+		delete models[0];
+		delete models[1];
+	}
+
+	delete timer;
+	delete dragon;
+
+	Nv::NvModelExt::SetObjLoadThreads(previousThreads);
+	Nv::NvModelExt::SetFileLoader(previousLoader);
+}
+
+// Returns true for the OBJ keywords whose lines hold only numbers
+static bool isVectorKeyword(const char* keyword, uint32_t length)
+{
+	return (length == 1 && keyword[0] == 'v') ||
+		(length == 2 && keyword[0] == 'v' && (keyword[1] == 'n' || keyword[1] == 't'));
+}
+
+// Reads the numbers of every vector line of OBJ data by copying each token
+// out of the text and converting it with strtod, as the tokenizer once did
+static void referenceParseVectors(const std::string& text, std::vector<float>& values)
+{
+	char token[NV_MAX_TOKEN_LEN];
+	const char* p = text.c_str();
+
+	values.clear();
+	while (*p) {
+		const char* keyword = p;
+		while (*p && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+			p++;
+		bool vector = isVectorKeyword(keyword, (uint32_t)(p - keyword));
+
+		while (vector && *p && *p != '\n' && *p != '\r') {
+			while (*p == ' ' || *p == '\t')
+				p++;
+			uint32_t length = 0;
+			while (*p && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') {
+				if (length < NV_MAX_TOKEN_LEN - 1)
+					token[length++] = *p;
+				p++;
+			}
+			token[length] = 0;
+			if (length)
+				values.push_back((float)strtod(token, NULL));
+		}
+
+		while (*p && *p != '\n' && *p != '\r')
+			p++;
+		while (*p == '\n' || *p == '\r')
+			p++;
+	}
+}
+
+// Reads the numbers of every vector line of OBJ data with the tokenizer
+static void parseVectors(const std::string& text, std::vector<float>& values)
+{
+	NvTokenizer tok(text.c_str());
+
+	values.clear();
+	while (!tok.atEOF()) {
+		if (tok.readToken() && isVectorKeyword(tok.getLastTokenPtr(), tok.getLastTokenLen())) {
+			float value;
+			while (tok.getTokenFloat(value))
+				values.push_back(value);
+		}
+		tok.consumeToEOL();
+	}
+}
+
+void benchmarkNumberParsing()
+{
+	NvModel* dragon = loadDragon();
+	if (!dragon)
+		return;
+
+	std::string text;
+	NvStopWatch* timer = createStopWatch();
+
+	const uint32_t copyCounts[] = { 1, 16 };
+	for (uint32_t test = 0; test < ARRAY_SIZE(copyCounts); test++) {
+		buildObjText(*dragon, copyCounts[test], text);
+
+		float times[2];
+		std::vector<float> values[2];
+		for (int32_t mode = 0; mode < 2; mode++) {
+			timer->reset();
+			timer->start();
+			if (mode == 0)
+				referenceParseVectors(text, values[mode]);
+			else
+				parseVectors(text, values[mode]);
+			timer->stop();
+			times[mode] = 1000.0f * timer->getTime();
+		}
+
+		// compared bit for bit, as the tokenizer promises strtod's rounding
+		bool identical = (values[0].size() == values[1].size()) && !values[0].empty() &&
+			!memcmp(&values[0][0], &values[1][0], values[0].size() * sizeof(float));
+
+		LOGI("OBJ number parsing %d x dragon (%.1f MB, %d values): copied tokens and strtod %.1fms, tokenizer %.1fms (%.1fx)%s",
+			copyCounts[test], text.size() / (1024.0f * 1024.0f), (int32_t)values[1].size(),
+			times[0], times[1], times[0] / times[1], identical ? "" : " MISMATCH");
+	}
+
+	delete timer;
+	delete dragon;
+}
+
+void benchmarkMeshOptimization()
+{
+	NvModel* dragon = loadDragon();
+	if (!dragon)
+		return;
+
+	std::string text;
+	buildObjText(*dragon, 1, text);
+	MemoryObjLoader loader(text);
+	Nv::NvModelFileLoader* previousLoader = Nv::NvModelExt::GetFileLoader();
+	Nv::NvModelExt::SetFileLoader(&loader);
+
+	bool previousOptimization = Nv::NvModelOptimizer::GetMeshOptimization();
+	float previousThreshold = Nv::NvModelOptimizer::GetOverdrawThreshold();
+
+	NvStopWatch* timer = createStopWatch();
+
+	// as imported, reordered for the vertex cache and fetch, and additionally
+	// for overdraw
+	const char* modeNames[] = { "unoptimized", "vertex cache", "vertex cache and overdraw" };
+	const float overdrawThresholds[] = { 0.0f, 0.0f, 1.05f };
+	for (int32_t mode = 0; mode < 3; mode++) {
+		Nv::NvModelOptimizer::SetMeshOptimization(mode > 0);
+		Nv::NvModelOptimizer::SetOverdrawThreshold(overdrawThresholds[mode]);
+
+		timer->reset();
+		timer->start();
+		Nv::NvModelExt* model = Nv::NvModelExt::CreateFromObj("meshbench.obj", -1.0f, true, true);
+		timer->stop();
+		if (!model)
+			continue;
+
+		for (uint32_t i = 0; i < model->GetMeshCount(); i++) {
+			Nv::SubMesh* mesh = model->GetSubMesh(i);
+			Nv::NvModelCacheStats stats = Nv::NvModelOptimizer::MeasureVertexCache(mesh->getIndices(),
+				mesh->getIndexCount(), mesh->getVertexCount());
+			LOGI("Dragon mesh %d %s: ACMR %.3f, ATVR %.3f (import %.1fms)", i, modeNames[mode],
+				stats.m_acmr, stats.m_atvr, 1000.0f * timer->getTime());
+		}
+		delete model;
+	}
+
+	delete timer;
+	delete dragon;
+
+	Nv::NvModelOptimizer::SetMeshOptimization(previousOptimization);
+	Nv::NvModelOptimizer::SetOverdrawThreshold(previousThreshold);
+	Nv::NvModelExt::SetFileLoader(previousLoader);
+}
+
+void benchmarkVertexPacking()
+{
+	NvModel* dragon = loadDragon();
+	if (!dragon)
+		return;
+
+	// the loader serves the OBJ text first, then each preprocessed file
+	std::string text;
+	buildObjText(*dragon, 1, text);
+	MemoryObjLoader loader(text);
+	Nv::NvModelFileLoader* previousLoader = Nv::NvModelExt::GetFileLoader();
+	Nv::NvModelExt::SetFileLoader(&loader);
+	bool previousPacking = Nv::NvModelExt::GetVertexPacking();
+
+	NvStopWatch* timer = createStopWatch();
+
+	Nv::NvModelExt* model = Nv::NvModelExt::CreateFromObj("packbench.obj", -1.0f, true, true);
+	for (int32_t pack = 0; model && pack < 2; pack++) {
+		Nv::NvModelExt::SetVertexPacking(pack == 1);
+
+		std::vector<uint8_t> bytes;
+		FILE* fp = tmpfile();
+		if (fp && model->WritePreprocessedModel(fp))
+			readBackFile(fp, bytes);
+		if (fp)
+			fclose(fp);
+		text.assign(bytes.begin(), bytes.end());
+
+		timer->reset();
+		timer->start();
+		Nv::NvModelExt* loaded = Nv::NvModelExt::CreateFromPreprocessed("packbench.nvm");
+		timer->stop();
+		if (!loaded)
+			continue;
+
+		for (uint32_t i = 0; i < loaded->GetMeshCount() && i < model->GetMeshCount(); i++) {
+			Nv::SubMesh* original = model->GetSubMesh(i);
+			Nv::SubMesh* mesh = loaded->GetSubMesh(i);
+			int32_t vertexBytes = mesh->m_packedFormat.IsPacked() ?
+				mesh->m_packedFormat.GetVertexSize() : mesh->getVertexSize() * sizeof(float);
+			int32_t indexBytes = (mesh->getVertexCount() <= 0xFFFF) ? sizeof(uint16_t) : sizeof(uint32_t);
+
+			// angle between the original and loaded normals
+			float maxNormalError = 0.0f;
+			int32_t normalOffset = mesh->getNormalOffset();
+			for (int32_t v = 0; normalOffset > 0 && v < mesh->getVertexCount(); v++) {
+				nv::vec3f a(original->getVertices() + v * original->getVertexSize() + normalOffset);
+				nv::vec3f b(mesh->getVertices() + v * mesh->getVertexSize() + normalOffset);
+				float error = atan2f(nv::length(cross(a, b)), nv::dot(a, b));
+				maxNormalError = (error > maxNormalError) ? error : maxNormalError;
+			}
+
+			LOGI("Dragon mesh %d %s: %d-byte vertices, %d-byte indices, normals within %.3f degrees; %d byte file loaded in %.1fms",
+				i, pack ? "packed" : "float", vertexBytes, indexBytes, maxNormalError * 180.0f / NV_PI,
+				(int32_t)bytes.size(), 1000.0f * timer->getTime());
+		}
+		delete loaded;
+	}
+
+	delete model;
+	delete timer;
+	delete dragon;
+
+	Nv::NvModelExt::SetVertexPacking(previousPacking);
+	Nv::NvModelExt::SetFileLoader(previousLoader);
+}
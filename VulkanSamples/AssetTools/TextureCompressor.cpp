@@ -0,0 +1,101 @@
+//----------------------------------------------------------------------------------
+// File:        AssetTools/TextureCompressor.cpp
+// SDK Version: v3.00
+// Email:       emmanuel.villagomez@gmail.com
+// Site:        http://www.victoresite.net/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#include "AssetTools.h"
+#include "NvAssetLoader/NvAssetLoader.h"
+#include "NvImage/NvImage.h"
+#include "NV/NvLogs.h"
+
+// Reads a file given by its path, or failing that, from the assets tree
+static bool readTexture(const std::string& name, std::vector<uint8_t>& bytes)
+{
+	FILE* fp = fopen(name.c_str(), "rb");
+	if (fp) {
+		fseek(fp, 0, SEEK_END);
+		readBackFile(fp, bytes);
+		fclose(fp);
+		return !bytes.empty();
+	}
+
+	int32_t length;
+	char* data = NvAssetLoaderRead(name.c_str(), length);
+	if (!data)
+		return false;
+	bytes.assign((const uint8_t*)data, (const uint8_t*)data + length);
+	NvAssetLoaderFree(data);
+	return true;
+}
+
+bool compressTextures(const std::vector<std::string>& names)
+{
+	bool succeeded = true;
+	for (size_t t = 0; t < names.size(); t++) {
+		NvImage image;
+		std::vector<uint8_t> source;
+		if (!readTexture(names[t], source) ||
+			!image.loadImageFromFileData(&source[0], source.size(), "dds")) {
+			LOGI("Could not load %s", names[t].c_str());
+			succeeded = false;
+			continue;
+		}
+
+		// path/name.dds is written as name_bc1.dds or name_bc3.dds
+		std::string name = names[t];
+		name = name.substr(name.find_last_of("/\\") + 1);
+		name = name.substr(0, name.find_last_of('.'));
+
+		uint32_t format = image.hasAlpha() ? NVIMAGE_COMPRESSED_RGBA_S3TC_DXT5 : NVIMAGE_COMPRESSED_RGBA_S3TC_DXT1;
+		name += image.hasAlpha() ? "_bc3.dds" : "_bc1.dds";
+
+		float psnr;
+		std::vector<uint8_t> file;
+		if (!image.compress(format, true, 0, &psnr) || !image.saveImageToFileData(file, "dds")) {
+			LOGI("Could not compress %s", names[t].c_str());
+			succeeded = false;
+			continue;
+		}
+
+		FILE* fp = fopen(name.c_str(), "wb");
+		if (!fp) {
+			LOGI("Could not open %s for writing", name.c_str());
+			succeeded = false;
+			continue;
+		}
+		bool written = fwrite(&file[0], 1, file.size(), fp) == file.size();
+		fclose(fp);
+
+		LOGI("%s %s (PSNR %.2fdB)", written ? "Wrote" : "Failed to write", name.c_str(), psnr);
+		succeeded = succeeded && written;
+	}
+	return succeeded;
+}
@@ -208,6 +208,7 @@ void HelloVulkan::initRendering(void) {
 		char* data = NvAssetLoaderRead("shaders/simple.nvs", length);
 		shaderCount = vk().createShadersFromBinaryBlob((uint32_t*)data,
 			length, shaderStages, 2);
+		NvAssetLoaderFree(data);
 	}
 #endif
 
@@ -242,8 +243,10 @@ void HelloVulkan::initRendering(void) {
 	
 	pipelineInfo.layout = pipelineLayout;
 
-	result = vkCreateGraphicsPipelines(device(), VK_NULL_HANDLE, 1, &pipelineInfo, NULL, &mPipeline);
+	result = vkCreateGraphicsPipelines(device(), vk().pipelineCache(), 1, &pipelineInfo, NULL, &mPipeline);
     CHECK_VK_RESULT();
+
+	vk().releaseShaders(shaderStages, shaderCount);
 }
 
 
@@ -255,18 +258,10 @@ void HelloVulkan::shutdownRendering(void) {
     // destroy other resources here
 	vkDestroyPipeline(device(), mPipeline, NULL);
 
-    if (mVertexBuffer() != VK_NULL_HANDLE)
-		vkDestroyBuffer(device(), mVertexBuffer(), NULL);
-    if (mIndexBuffer()  != VK_NULL_HANDLE)
-		vkDestroyBuffer(device(), mIndexBuffer(), NULL);
+	vk().destroyBuffer(mVertexBuffer);
+	vk().destroyBuffer(mIndexBuffer);
 
 	vkDestroyCommandPool(device(), mCmdPool, NULL);
-
-    if (mVertexBuffer.mem != VK_NULL_HANDLE)
-		vkFreeMemory(device(), mVertexBuffer.mem, NULL);
-
-	if (mIndexBuffer.mem != VK_NULL_HANDLE)
-		vkFreeMemory(device(), mIndexBuffer.mem, NULL);
 }
 
 void HelloVulkan::initUI(void) {
@@ -35,16 +35,65 @@
 #include "NvAppBase/NvInputTransformer.h"
 #include "NvAssetLoader/NvAssetLoader.h"
 #include "NvVkUtil/NvModelVK.h"
+#include "NvVkUtil/NvModelExtVK.h"
 #include "NvUI/NvTweakBar.h"
 #include "NV/NvLogs.h"
+#include "NvImage/NvImage.h"
+#include <assert.h>
+#include <string.h>
+#include <string>
 
 #define ARRAY_SIZE(a) ( sizeof(a) / sizeof( (a)[0] ))
 
 enum {
-	CYCLE_MODEL = 1024
+	CYCLE_MODEL = 1024,
+	CYCLE_TEXTURE
 };
 
+// Reads the files the OBJ importer asks for, the models and the material
+// libraries they name, from the models directory
+class ModelFileLoader : public Nv::NvModelFileLoader
+{
+public:
+	virtual char* LoadDataFromFile(const char* fileName) {
+		int32_t length;
+		std::string path = std::string("models/") + fileName;
+		return NvAssetLoaderRead(path.c_str(), length);
+	}
+
+	virtual void ReleaseData(char* pData) { NvAssetLoaderFree(pData); }
+};
+
+static ModelFileLoader s_modelLoader;
+
+// Device memory the models' textures may hold together; small enough that
+// the textures of models not being drawn are evicted
+static const VkDeviceSize TEXTURE_BUDGET = 1024 * 1024;
+
+// Bytes of streamed levels uploaded per frame; small enough that the
+// textures' larger levels arrive over several frames
+static const size_t STREAM_FRAME_BUDGET = 64 * 1024;
+
+static const char* s_streamedTextureNames[] = {
+	"textures/nvidia_logo.dds",
+	"textures/windmill_diffuse.dds"
+};
+
+// Returns true if every mesh of the model has a diffuse texture to draw with
+static bool hasDiffuseTextures(Nv::NvModelExtVK* model)
+{
+	for (uint32_t i = 0; i < model->GetMeshCount(); i++) {
+		Nv::NvMaterialVK* material = model->GetMaterial(model->GetMesh(i)->GetMaterialID());
+		if (!material || !model->GetManagedTexture(material->m_diffuseTexture))
+			return false;
+	}
+
+	return model->GetMeshCount() > 0;
+}
+
 AssetViewer::AssetViewer() 
+	: mCurrentTexture(0)
+	, mDrawJob(*this)
 {
 	m_transformer->setTranslationVec(nv::vec3f(0.0f, 0.0f, -3.0f));
 	m_transformer->setRotationVec(nv::vec3f(NV_PI*0.35f, 0.0f, 0.0f));
@@ -75,45 +124,110 @@ void AssetViewer::initRendering(void) {
 	//////////////
 	// Load Models
 
-	mModelCount = 2;
+	const char* modelNames[] = {
+		"cow.nvm",
+		"dragon.nvm",
+		"logo_cube.obj"
+	};
+
+	mModelCount = ARRAY_SIZE(modelNames);
 	mModels = new NvModelVK*[mModelCount];
+	mMeshModels = new Nv::NvModelExtVK*[mModelCount];
 	mCurrentModel = 0;
 
-	const char* nvmNames[2] = {
-		"models/cow.nvm",
-		"models/dragon.nvm"
-	};
+	Nv::NvModelExt::SetFileLoader(&s_modelLoader);
+
+	// Textures are reloaded on the loader thread after they are evicted
+	mTextures.init(vk(), TEXTURE_BUDGET, getThreadManagerInstance());
 
 	for (uint32_t i = 0; i < mModelCount; i++) {
-		int32_t length;
-		char *modelData = NvAssetLoaderRead(nvmNames[i], length);
-		NvModelVK* model = NvModelVK::CreateFromPreprocessed(vk(), (uint8_t *)modelData);
-		mModels[i] = model;
-		NvAssetLoaderFree(modelData);
+		mModels[i] = NULL;
+		mMeshModels[i] = NULL;
+
+		if (strstr(modelNames[i], ".obj")) {
+			Nv::NvModelExt* model = Nv::NvModelExt::CreateFromObj(modelNames[i], 1.0f, false, false);
+			if (model)
+				mMeshModels[i] = Nv::NvModelExtVK::Create(vk(), model, &mTextures);
+		} else {
+			std::string path = std::string("models/") + modelNames[i];
+			int32_t length;
+			char *modelData = NvAssetLoaderRead(path.c_str(), length);
+			NvModelVK* model = NvModelVK::CreateFromPreprocessed(vk(), (uint8_t *)modelData);
+			mModels[i] = model;
+			NvAssetLoaderFree(modelData);
+		}
+	}
+
+	// Each texture is usable as soon as its mip tail is uploaded, and sharpens
+	// as the streamer uploads its larger levels
+	mStreamer.init(vk(), STREAM_FRAME_BUDGET);
+	for (uint32_t i = 0; i < ARRAY_SIZE(s_streamedTextureNames); i++) {
+		NvVkStreamingTexture* tex = mStreamer.createTextureFromDDSFile(s_streamedTextureNames[i]);
+		if (tex)
+			mStreamedTextures.push_back(tex);
+		else
+			LOGE("Failed to load %s", s_streamedTextureNames[i]);
+	}
+
+	// A queued upload holds the ticket of the batch still being gathered;
+	// waiting on it must submit that batch and see it complete
+	NvImage* checkImage = NvImage::CreateFromDDSFile(s_streamedTextureNames[0]);
+	if (checkImage) {
+		NvVkTexture checkTex;
+		NvVkUploadTicket ticket;
+		if (vk().uploadTexture(checkImage, checkTex, &ticket)) {
+			bool uploaded = vk().waitForUpload(ticket);
+			if (!uploaded)
+				LOGE("Waiting for the upload of %s failed", s_streamedTextureNames[0]);
+			assert(uploaded);
+			vkDestroyImageView(device(), checkTex.view, NULL);
+			vk().destroyImage(checkTex.image);
+		}
+		delete checkImage;
+	}
+
+	// Models whose meshes all have diffuse textures are drawn textured
+	mTextureDescriptors = new std::vector<TextureDescriptors>[mModelCount];
+	uint32_t textureSetCount = 0;
+	for (uint32_t i = 0; i < mModelCount; i++) {
+		if (mMeshModels[i] && hasDiffuseTextures(mMeshModels[i])) {
+			mTextureDescriptors[i].resize(mMeshModels[i]->GetTextureCount());
+			textureSetCount += mMeshModels[i]->GetTextureCount() * NvVkContext::MAX_BUFFERED_FRAMES;
+		}
 	}
+	mStreamedDescriptors.resize(mStreamedTextures.size());
+	textureSetCount += (uint32_t)mStreamedTextures.size() * NvVkContext::MAX_BUFFERED_FRAMES;
 
 	// Create descriptor layout to match the shader resources
-	VkDescriptorSetLayoutBinding binding[1];
+	VkDescriptorSetLayoutBinding binding[2];
 	binding[0].binding = 0;
 	binding[0].descriptorCount = 1;
 	binding[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 	binding[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	binding[0].pImmutableSamplers = NULL;
+	binding[1].binding = 1;
+	binding[1].descriptorCount = 1;
+	binding[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	binding[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	binding[1].pImmutableSamplers = NULL;
 
 	VkDescriptorSetLayoutCreateInfo descriptorSetEntry = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
-	descriptorSetEntry.bindingCount = 1;
+	descriptorSetEntry.bindingCount = 2;
 	descriptorSetEntry.pBindings = binding;
 	result = vkCreateDescriptorSetLayout(device(), &descriptorSetEntry, 0, &mDescriptorSetLayout);
 	CHECK_VK_RESULT();
 
-	// Create descriptor region and set
-	VkDescriptorPoolSize descriptorPoolInfo[1];
+	// Create descriptor region and sets; the untextured models' set leaves
+	// the texture unwritten
+	VkDescriptorPoolSize descriptorPoolInfo[2];
 	descriptorPoolInfo[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-	descriptorPoolInfo[0].descriptorCount = 1;
+	descriptorPoolInfo[0].descriptorCount = 1 + textureSetCount;
+	descriptorPoolInfo[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorPoolInfo[1].descriptorCount = textureSetCount ? textureSetCount : 1;
 
 	VkDescriptorPoolCreateInfo descriptorRegionInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
-	descriptorRegionInfo.maxSets = 1;
-	descriptorRegionInfo.poolSizeCount = 1;
+	descriptorRegionInfo.maxSets = 1 + textureSetCount;
+	descriptorRegionInfo.poolSizeCount = 2;
 	descriptorRegionInfo.pPoolSizes = descriptorPoolInfo;
 	VkDescriptorPool descriptorRegion;
 	result = vkCreateDescriptorPool(device(), &descriptorRegionInfo, NULL, &descriptorRegion);
@@ -126,6 +240,41 @@ void AssetViewer::initRendering(void) {
 	result = vkAllocateDescriptorSets(device(), &descriptorSetAllocateInfo, &mDescriptorSet);
 	CHECK_VK_RESULT();
 
+	// The streamed textures' sets follow the models' in the same list
+	std::vector<TextureDescriptors*> textureSets;
+	for (uint32_t i = 0; i < mModelCount; i++) {
+		for (uint32_t t = 0; t < mTextureDescriptors[i].size(); t++)
+			textureSets.push_back(&mTextureDescriptors[i][t]);
+	}
+	for (uint32_t t = 0; t < mStreamedDescriptors.size(); t++)
+		textureSets.push_back(&mStreamedDescriptors[t]);
+
+	for (uint32_t t = 0; t < textureSets.size(); t++) {
+		for (uint32_t f = 0; f < NvVkContext::MAX_BUFFERED_FRAMES; f++) {
+			result = vkAllocateDescriptorSets(device(), &descriptorSetAllocateInfo, &textureSets[t]->sets[f]);
+			CHECK_VK_RESULT();
+			// Forces the texture to be written on first use
+			textureSets[t]->viewVersions[f] = ~0u;
+		}
+	}
+
+	// The streamed textures are shown whole, so their edges are clamped
+	VkSamplerCreateInfo samplerCreateInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+	samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
+	samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
+	samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerCreateInfo.mipLodBias = 0.0;
+	samplerCreateInfo.maxAnisotropy = 1;
+	samplerCreateInfo.compareOp = VK_COMPARE_OP_NEVER;
+	samplerCreateInfo.minLod = 0.0;
+	samplerCreateInfo.maxLod = 16.0;
+	samplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	result = vkCreateSampler(device(), &samplerCreateInfo, 0, &mTextureSampler);
+	CHECK_VK_RESULT();
+
 	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
 	pipelineLayoutCreateInfo.setLayoutCount = 1;
 	pipelineLayoutCreateInfo.pSetLayouts = &mDescriptorSetLayout;
@@ -192,6 +341,17 @@ void AssetViewer::initRendering(void) {
 		char* data = NvAssetLoaderRead("shaders/base_model.nvs", length);
 		shaderCount = vk().createShadersFromBinaryBlob((uint32_t*)data,
 			length, shaderStages, 2);
+		NvAssetLoaderFree(data);
+	}
+
+	VkPipelineShaderStageCreateInfo texturedShaderStages[2];
+	uint32_t texturedShaderCount = 0;
+	{
+		int32_t length;
+		char* data = NvAssetLoaderRead("shaders/textured_model.nvs", length);
+		texturedShaderCount = vk().createShadersFromBinaryBlob((uint32_t*)data,
+			length, texturedShaderStages, 2);
+		NvAssetLoaderFree(data);
 	}
 
 	mModelPipelines = new VkPipeline[mModelCount];
@@ -199,8 +359,15 @@ void AssetViewer::initRendering(void) {
 	for (uint32_t i = 0; i < mModelCount; i++) {
 		// Create mPipeline state VI-IA-VS-VP-RS-FS-CB
 		VkGraphicsPipelineCreateInfo pipelineInfo = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
-		pipelineInfo.pVertexInputState = &mModels[i]->getVIInfo();
-		pipelineInfo.pInputAssemblyState = &mModels[i]->getIAInfo();
+		if (mMeshModels[i]) {
+			// The meshes of an OBJ model share its vertex layout
+			Nv::NvMeshExtVK* mesh = mMeshModels[i]->GetMesh(0);
+			pipelineInfo.pVertexInputState = &mesh->getVIInfo();
+			pipelineInfo.pInputAssemblyState = &mesh->getIAInfo();
+		} else {
+			pipelineInfo.pVertexInputState = &mModels[i]->getVIInfo();
+			pipelineInfo.pInputAssemblyState = &mModels[i]->getIAInfo();
+		}
 		pipelineInfo.pViewportState = &vpStateInfo;
 		pipelineInfo.pRasterizationState = &rsStateInfo;
 		pipelineInfo.pColorBlendState = &cbStateInfo;
@@ -209,19 +376,73 @@ void AssetViewer::initRendering(void) {
 		pipelineInfo.pTessellationState = &tessStateInfo;
 		pipelineInfo.pDynamicState = &dynStateInfo;
 
-		pipelineInfo.stageCount = shaderCount;
-		pipelineInfo.pStages = shaderStages;
+		if (mTextureDescriptors[i].empty()) {
+			pipelineInfo.stageCount = shaderCount;
+			pipelineInfo.pStages = shaderStages;
+		} else {
+			pipelineInfo.stageCount = texturedShaderCount;
+			pipelineInfo.pStages = texturedShaderStages;
+		}
 
 		pipelineInfo.renderPass = vk().mainRenderTarget()->clearRenderPass();
 		pipelineInfo.subpass = 0;
 
 		pipelineInfo.layout = mPipelineLayout;
 
-		result = vkCreateGraphicsPipelines(device(), VK_NULL_HANDLE, 1, &pipelineInfo, NULL,
+		result = vkCreateGraphicsPipelines(device(), vk().pipelineCache(), 1, &pipelineInfo, NULL,
 			(mModelPipelines + i));
 		CHECK_VK_RESULT();
 	}
 
+	// The streamed texture is drawn over the models as a quad covering its
+	// viewport, generated from the vertex index
+	VkPipelineShaderStageCreateInfo viewShaderStages[2];
+	uint32_t viewShaderCount = 0;
+	{
+		int32_t length;
+		char* data = NvAssetLoaderRead("shaders/texture_view.nvs", length);
+		viewShaderCount = vk().createShadersFromBinaryBlob((uint32_t*)data,
+			length, viewShaderStages, 2);
+		NvAssetLoaderFree(data);
+	}
+
+	{
+		VkPipelineVertexInputStateCreateInfo viStateInfo = { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+
+		VkPipelineInputAssemblyStateCreateInfo iaStateInfo = { VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
+		iaStateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+		iaStateInfo.primitiveRestartEnable = VK_FALSE;
+
+		rsStateInfo.cullMode = VK_CULL_MODE_NONE;
+		dsStateInfo.depthTestEnable = VK_FALSE;
+		dsStateInfo.depthWriteEnable = VK_FALSE;
+
+		VkGraphicsPipelineCreateInfo pipelineInfo = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+		pipelineInfo.pVertexInputState = &viStateInfo;
+		pipelineInfo.pInputAssemblyState = &iaStateInfo;
+		pipelineInfo.pViewportState = &vpStateInfo;
+		pipelineInfo.pRasterizationState = &rsStateInfo;
+		pipelineInfo.pColorBlendState = &cbStateInfo;
+		pipelineInfo.pDepthStencilState = &dsStateInfo;
+		pipelineInfo.pMultisampleState = &msStateInfo;
+		pipelineInfo.pTessellationState = &tessStateInfo;
+		pipelineInfo.pDynamicState = &dynStateInfo;
+		pipelineInfo.stageCount = viewShaderCount;
+		pipelineInfo.pStages = viewShaderStages;
+		pipelineInfo.renderPass = vk().mainRenderTarget()->copyRenderPass();
+		pipelineInfo.subpass = 0;
+		pipelineInfo.layout = mPipelineLayout;
+
+		result = vkCreateGraphicsPipelines(device(), vk().pipelineCache(), 1, &pipelineInfo, NULL,
+			&mTexturePipeline);
+		CHECK_VK_RESULT();
+	}
+
+	// the pipelines hold their own copy of the code; drop our module references
+	vk().releaseShaders(shaderStages, shaderCount);
+	vk().releaseShaders(texturedShaderStages, texturedShaderCount);
+	vk().releaseShaders(viewShaderStages, viewShaderCount);
+
 	mUBO.Initialize(vk());
 
 	m_transformer->update(0.1f);
@@ -248,6 +469,13 @@ void AssetViewer::initRendering(void) {
 	writeDescriptorSets[0].pBufferInfo = uboDescriptorInfo;
 	writeDescriptorSets[1] = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
 	vkUpdateDescriptorSets(device(), 1, writeDescriptorSets, 0, 0);
+
+	for (uint32_t t = 0; t < textureSets.size(); t++) {
+		for (uint32_t f = 0; f < NvVkContext::MAX_BUFFERED_FRAMES; f++) {
+			writeDescriptorSets[0].dstSet = textureSets[t]->sets[f];
+			vkUpdateDescriptorSets(device(), 1, writeDescriptorSets, 0, 0);
+		}
+	}
 }
 
 
@@ -256,6 +484,15 @@ void AssetViewer::shutdownRendering(void) {
 
     vkDeviceWaitIdle(device());
 
+	// The models hand their textures back before the manager destroys them
+	for (uint32_t i = 0; i < mModelCount; i++) {
+		if (mMeshModels[i])
+			mMeshModels[i]->Release(vk());
+	}
+	mTextures.deinit();
+	mStreamer.deinit();
+	vkDestroySampler(device(), mTextureSampler, NULL);
+
     // destroy other resources here like the pipelines, vertex buffers and command pools
 }
 
@@ -265,12 +502,25 @@ void AssetViewer::initUI(void) {
 		NvTweakVarBase *var = mTweakBar->addButton("Change Model", CYCLE_MODEL);
 		addTweakButtonBind(var, NvGamepad::BUTTON_Y);
 
+		if (!mStreamedTextures.empty()) {
+			var = mTweakBar->addButton("Change Texture", CYCLE_TEXTURE);
+			addTweakButtonBind(var, NvGamepad::BUTTON_X);
+		}
+
         mTweakBar->syncValues();
     }
 }
 
 NvUIEventResponse AssetViewer::handleReaction(const NvUIReaction &react)
 {
+	switch (react.code) {
+	case CYCLE_MODEL:
+		mCurrentModel = (mCurrentModel + 1) % mModelCount;
+		return nvuiEventHandled;
+	case CYCLE_TEXTURE:
+		mCurrentTexture = (mCurrentTexture + 1) % mStreamedTextures.size();
+		return nvuiEventHandled;
+	}
 	return nvuiEventNotHandled;
 }
 
@@ -360,6 +610,14 @@ void AssetViewer::draw(void)
 
 	VkCommandBuffer cmd = vk().getMainCommandBuffer();
 
+	// Only the drawn model's textures are in use, so the others may be
+	// evicted; reloads and streamed levels change the views it samples
+	if (mMeshModels[mCurrentModel])
+		mMeshModels[mCurrentModel]->MarkTexturesUsed();
+	mTextures.update();
+	mStreamer.update();
+	updateTextureDescriptors();
+
 	VkRenderPassBeginInfo renderPassBeginInfo = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
 
 	renderPassBeginInfo.renderPass = vk().mainRenderTarget()->clearRenderPass();
@@ -381,39 +639,151 @@ void AssetViewer::draw(void)
 	renderPassBeginInfo.pClearValues = clearValues;
 	renderPassBeginInfo.clearValueCount = 2;
 
-	vkCmdBeginRenderPass(cmd, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	mUBOOffset = mUBO.getDynamicOffset();
+
 	{
+		NvVkContext::DebugMarkerScope scope(vk(), cmd, "Models");
+
+		// The draws are recorded into secondary command buffers, split
+		// between the recording threads mesh by mesh
+		vkCmdBeginRenderPass(cmd, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+		uint32_t drawCount = mMeshModels[mCurrentModel] ? mMeshModels[mCurrentModel]->GetMeshCount() : 1;
+		if (!recordParallel(cmd, renderPassBeginInfo.renderPass, renderPassBeginInfo.framebuffer, drawCount, mDrawJob))
+			LOGE("Failed to record the model draws");
+
+		vkCmdEndRenderPass(cmd);
+	}
+
+	if (!mStreamedTextures.empty()) {
+		NvVkContext::DebugMarkerScope scope(vk(), cmd, "Texture");
+
+		// Keeps the models' image and shows the texture in a square in the
+		// bottom left corner
+		renderPassBeginInfo.renderPass = vk().mainRenderTarget()->copyRenderPass();
+		vkCmdBeginRenderPass(cmd, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+		int32_t size = (m_width < m_height ? m_width : m_height) / 3;
+
 		VkViewport vp;
 		VkRect2D sc;
 		vp.x = 0;
-		vp.y = 0;
-		vp.height = (float)(m_height);
-		vp.width = (float)(m_width);
+		vp.y = (float)(m_height - size);
+		vp.height = (float)size;
+		vp.width = (float)size;
 		vp.minDepth = 0.0f;
 		vp.maxDepth = 1.0f;
 
-		sc.offset.x = 0;
-		sc.offset.y = 0;
-		sc.extent.width = vp.width;
-		sc.extent.height = vp.height;
+		sc.offset.x = (int32_t)vp.x;
+		sc.offset.y = (int32_t)vp.y;
+		sc.extent.width = size;
+		sc.extent.height = size;
 
 		vkCmdSetViewport(cmd, 0, 1, &vp);
 		vkCmdSetScissor(cmd, 0, 1, &sc);
 
-		// Bind the mPipeline state
-		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mModelPipelines[mCurrentModel]);
-		uint32_t offset[2];
-		offset[0] = mUBO.getDynamicOffset();
-		offset[1] = 0;
-		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout, 0, 1, &mDescriptorSet, 1, offset);
+		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mTexturePipeline);
+		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout, 0, 1,
+			&mStreamedDescriptors[mCurrentTexture].sets[mFrameSlot], 1, &mUBOOffset);
+		vkCmdDraw(cmd, 4, 1, 0, 0);
 
-		mModels[mCurrentModel]->Draw(cmd);
+		vkCmdEndRenderPass(cmd);
 	}
-	vkCmdEndRenderPass(cmd);
 
 	vk().submitMainCommandBuffer();
 }
 
+void AssetViewer::updateTextureDescriptors()
+{
+	// The main command buffer has waited for the frame that last used this
+	// slot's sets, so they can be rewritten
+	mFrameSlot = (uint32_t)((vk().currentSubmissionSerial() - 1) % NvVkContext::MAX_BUFFERED_FRAMES);
+
+	Nv::NvModelExtVK* model = mMeshModels[mCurrentModel];
+	std::vector<TextureDescriptors>& textures = mTextureDescriptors[mCurrentModel];
+	for (uint32_t t = 0; t < textures.size(); t++) {
+		NvVkManagedTexture* tex = model->GetManagedTexture(t);
+		if (tex)
+			writeTextureDescriptor(textures[t], model->GetSampler(), tex->getView(), tex->getViewVersion());
+	}
+
+	// The streamed texture's view widens as its larger levels arrive
+	if (!mStreamedTextures.empty()) {
+		NvVkStreamingTexture* tex = mStreamedTextures[mCurrentTexture];
+		writeTextureDescriptor(mStreamedDescriptors[mCurrentTexture], mTextureSampler,
+			tex->getView(), tex->getViewVersion());
+	}
+}
+
+void AssetViewer::writeTextureDescriptor(TextureDescriptors& descriptors, VkSampler sampler,
+	VkImageView view, uint32_t viewVersion)
+{
+	uint32_t& version = descriptors.viewVersions[mFrameSlot];
+	if (version == viewVersion)
+		return;
+
+	VkDescriptorImageInfo texDescriptorInfo = {};
+	texDescriptorInfo.sampler = sampler;
+	texDescriptorInfo.imageView = view;
+	texDescriptorInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkWriteDescriptorSet writeDescriptorSet = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	writeDescriptorSet.dstSet = descriptors.sets[mFrameSlot];
+	writeDescriptorSet.dstBinding = 1;
+	writeDescriptorSet.dstArrayElement = 0;
+	writeDescriptorSet.descriptorCount = 1;
+	writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	writeDescriptorSet.pImageInfo = &texDescriptorInfo;
+	vkUpdateDescriptorSets(device(), 1, &writeDescriptorSet, 0, 0);
+
+	version = viewVersion;
+}
+
+void AssetViewer::recordModelSlice(VkCommandBuffer cmd, uint32_t first, uint32_t count)
+{
+	// Secondary command buffers inherit no state, so every slice sets its own
+	VkViewport vp;
+	VkRect2D sc;
+	vp.x = 0;
+	vp.y = 0;
+	vp.height = (float)(m_height);
+	vp.width = (float)(m_width);
+	vp.minDepth = 0.0f;
+	vp.maxDepth = 1.0f;
+
+	sc.offset.x = 0;
+	sc.offset.y = 0;
+	sc.extent.width = vp.width;
+	sc.extent.height = vp.height;
+
+	vkCmdSetViewport(cmd, 0, 1, &vp);
+	vkCmdSetScissor(cmd, 0, 1, &sc);
+
+	// Bind the mPipeline state
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mModelPipelines[mCurrentModel]);
+
+	const std::vector<TextureDescriptors>& textures = mTextureDescriptors[mCurrentModel];
+	if (textures.empty())
+		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout, 0, 1, &mDescriptorSet, 1, &mUBOOffset);
+
+	Nv::NvModelExtVK* meshModel = mMeshModels[mCurrentModel];
+	if (!meshModel) {
+		mModels[mCurrentModel]->Draw(cmd);
+		return;
+	}
+
+	for (uint32_t i = first; i < first + count; i++) {
+		Nv::NvMeshExtVK* mesh = meshModel->GetMesh(i);
+		if (!textures.empty()) {
+			// Bind this frame's set of the mesh's diffuse texture
+			uint32_t texture = meshModel->GetMaterial(mesh->GetMaterialID())->m_diffuseTexture;
+			vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout, 0, 1,
+				&textures[texture].sets[mFrameSlot], 1, &mUBOOffset);
+		}
+		mesh->Draw(cmd);
+	}
+}
+
 NvAppBase* NvAppFactory() {
     return new AssetViewer();
 }
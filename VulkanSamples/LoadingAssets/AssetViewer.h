@@ -35,9 +35,15 @@
 
 #include "KHR/khrplatform.h"
 #include "NvVkUtil/NvSimpleUBO.h"
+#include "NvVkUtil/NvVkTextureManager.h"
+#include "NvVkUtil/NvVkTextureStreamer.h"
 #include "NvGamepad/NvGamepad.h"
 #include "NV/NvMath.h"
+#include <vector>
 class NvModelVK;
+namespace Nv {
+	class NvModelExtVK;
+}
 
 class AssetViewer : public NvSampleAppVK
 {
@@ -56,6 +62,20 @@ public:
 
 private:
 
+	// Records slices of the current model's draws on the recording threads
+	class ModelDrawJob : public NvVkParallelRecorder::Job
+	{
+	public:
+		ModelDrawJob(AssetViewer& viewer) : mViewer(viewer) {}
+
+		virtual void record(VkCommandBuffer cmd, uint32_t first, uint32_t count, uint32_t slice) {
+			mViewer.recordModelSlice(cmd, first, count);
+		}
+
+	private:
+		AssetViewer& mViewer;
+	};
+
 	typedef struct {
 		nv::matrix4f mModelViewMatrix;
 		nv::matrix4f mProjectionMatrix;
@@ -64,17 +84,55 @@ private:
 		float mModelLight[3];
 	} UniformBlock;
 
+	// The descriptor sets that bind one of a model's textures, one per
+	// buffered frame.  A frame's set is rewritten before it is used whenever
+	// the texture's view has changed since, as the previous frame's set may
+	// still be in use
+	struct TextureDescriptors {
+		VkDescriptorSet sets[NvVkContext::MAX_BUFFERED_FRAMES];
+		uint32_t viewVersions[NvVkContext::MAX_BUFFERED_FRAMES];
+	};
+
 	NvSimpleUBO<UniformBlock> mUBO;
 
+	// Shared by the models' textures, which are evicted while their models
+	// are not drawn once they exceed its budget
+	NvVkTextureManager mTextures;
+
+	// Each model is either a single mesh loaded from an NVM file or, for
+	// OBJ files, a mesh per material; the other pointer is NULL
 	NvModelVK** mModels;
+	Nv::NvModelExtVK** mMeshModels;
+	// Indexed by texture; empty for models drawn untextured
+	std::vector<TextureDescriptors>* mTextureDescriptors;
 	uint32_t mCurrentModel;
 	uint32_t mModelCount;
 
+	// The sample's textures, streamed in a few levels a frame and shown in
+	// a corner of the screen as their detail arrives
+	NvVkTextureStreamer mStreamer;
+	std::vector<NvVkStreamingTexture*> mStreamedTextures;
+	std::vector<TextureDescriptors> mStreamedDescriptors;
+	uint32_t mCurrentTexture;
+	VkSampler mTextureSampler;
+	VkPipeline mTexturePipeline;
+
 	VkDescriptorSetLayout mDescriptorSetLayout;
 	VkDescriptorSet mDescriptorSet;
 	VkPipelineLayout mPipelineLayout;
 	VkPipeline* mModelPipelines;
 
+	// Dynamic offset of the frame's uniforms and the frame's slot of the
+	// texture descriptor sets, read by every recording thread
+	uint32_t mUBOOffset;
+	uint32_t mFrameSlot;
+	ModelDrawJob mDrawJob;
+
+	void updateTextureDescriptors();
+	void writeTextureDescriptor(TextureDescriptors& descriptors, VkSampler sampler,
+		VkImageView view, uint32_t viewVersion);
+	void recordModelSlice(VkCommandBuffer cmd, uint32_t first, uint32_t count);
+
 	//void updateRenderCommands();
 
     // basic rendering resources
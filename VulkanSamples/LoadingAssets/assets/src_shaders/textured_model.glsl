@@ -0,0 +1,69 @@
+//----------------------------------------------------------------------------------
+// File:        LoadingAssets\assets\src_shaders/textured_model.glsl
+// SDK Version: v3.00 
+// Email:       gameworks@nvidia.com
+// Site:        http://developer.nvidia.com/
+//
+// Copyright (c) 2014-2015, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------------
+#GLSL_VS
+#version 440 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec2 texcoord;
+
+layout(binding = 0) uniform Block {
+    mat4 mModelViewMatrix;
+    mat4 mProjectionMatrix;
+    mat4 mInvModelViewMatrix;
+    mat4 mInvProjectionMatrix;
+    vec3 mModelLight;
+};
+
+out IO { vec2 uv; float diffuse; };
+
+void main() {
+  gl_Position = mProjectionMatrix * mModelViewMatrix * vec4(position.xyz, 1.0);
+  uv = texcoord;
+  // the light is given in model space
+  diffuse = 0.3 + 0.7 * max(dot(normalize(normal), mModelLight), 0.0);
+}
+
+#GLSL_FS
+#version 440 core
+
+layout(binding = 1) uniform sampler2D diffuseTex;
+
+in IO { vec2 uv; float diffuse; };
+
+layout(location = 0) out vec4 colorOut;
+
+void main() {
+  colorOut = vec4(texture(diffuseTex, uv).rgb * diffuse, 1.0);
+}